@@ -20,6 +20,7 @@
 #include "Files/FFmaGenericLoader.hpp"      // particle loader
 #include "Files/FMpiFmaGenericLoader.hpp"   // particle loader
 #include "Files/FMpiTreeBuilder.hpp"        // tree builder
+#include "Files/FTreeBuilder.hpp"           // bulk insertion
 
 #include "Utils/FLeafBalance.hpp"
 
@@ -226,13 +227,18 @@ const std::string defaultFile(SCALFMMDataPath+"unitCubeXYZF31329.bfma");  // cre
   // Free temporary array memory.
   delete[] particles;
 
-  // Insert final particles into tree.
-
-  for(FSize idx = 0 ; idx < finalParticles.getSize(); ++idx){
-      tree.insert(finalParticles[idx].position,
-                  finalParticles[idx].index,
-                  finalParticles[idx].physicalValue);
-    }
+  // Insert final particles into tree (leaves creation and copy in parallel),
+  // the distributed particles are already in Morton order.
+  FTreeBuilder<FReal, OctreeClass, LeafClass>::
+      BuildTreeFromParticles(&tree,
+                             finalParticles.data(),
+                             finalParticles.getSize(),
+                             [](LeafClass* leaf, const TestParticle& particle){
+                               leaf->push(particle.position,
+                                          particle.index,
+                                          particle.physicalValue);
+                             },
+                             true);
 
   time.tac();
 // ---------------------- particles inserted into tree -----------------------------------
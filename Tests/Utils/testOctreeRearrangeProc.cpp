@@ -62,12 +62,16 @@ public:
 
 // Simply create particles and try the kernels
 int main(int argc, char ** argv){
+    const FParameterNames LocalOptionMigrate {
+        {"-migrate"},
+        "Move the particles of less than a leaf width and use the migration between neighbor processes"
+    };
     FHelpDescribeAndExit(argc, argv,
                          "In distributed!\n"
                          "Put the particles into a tree, then change the position of some particles and update the tree.\n"
                          "This method should be used to avoid the tree reconstruction.",
                          FParameterDefinitions::NbParticles, FParameterDefinitions::OctreeHeight,
-                         FParameterDefinitions::OctreeSubHeight);
+                         FParameterDefinitions::OctreeSubHeight, LocalOptionMigrate);
 
     typedef double FReal;
 
@@ -86,6 +90,7 @@ int main(int argc, char ** argv){
     const int NbLevels          = FParameters::getValue(argc,argv,FParameterDefinitions::OctreeHeight.options, 7);
     const int SizeSubLevels     = FParameters::getValue(argc,argv,FParameterDefinitions::OctreeSubHeight.options, 3);
     const FSize NbPart            = FParameters::getValue(argc,argv,FParameterDefinitions::NbParticles.options, FSize(20000));
+    const bool useMigration       = FParameters::existParameter(argc, argv, LocalOptionMigrate.options);
 
     FTic counter;
 
@@ -147,9 +152,20 @@ int main(int argc, char ** argv){
         do{
             ContainerClass* particles = octreeIterator.getCurrentListTargets();
             for(FSize idxPart = 0; idxPart < particles->getNbParticles() ; ++idxPart){
-                particles->getPositions()[0][idxPart] = (BoxWidth*FReal(drand48())) + (BoxCenter-(BoxWidth/2));
-                particles->getPositions()[1][idxPart] = (BoxWidth*FReal(drand48())) + (BoxCenter-(BoxWidth/2));
-                particles->getPositions()[2][idxPart] = (BoxWidth*FReal(drand48())) + (BoxCenter-(BoxWidth/2));
+                if(useMigration){
+                    // Small move, the particles stay in the box
+                    const FReal leafWidth = BoxWidth / FReal(1 << (NbLevels-1));
+                    for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                        const FReal newPosition = particles->getPositions()[idxDim][idxPart] + leafWidth * (FReal(drand48()) - FReal(0.5));
+                        particles->getPositions()[idxDim][idxPart] = FMath::Max(BoxCenter-(BoxWidth/2),
+                                                                     FMath::Min(newPosition, BoxCenter+(BoxWidth/2) - leafWidth/1024));
+                    }
+                }
+                else{
+                    particles->getPositions()[0][idxPart] = (BoxWidth*FReal(drand48())) + (BoxCenter-(BoxWidth/2));
+                    particles->getPositions()[1][idxPart] = (BoxWidth*FReal(drand48())) + (BoxCenter-(BoxWidth/2));
+                    particles->getPositions()[2][idxPart] = (BoxWidth*FReal(drand48())) + (BoxCenter-(BoxWidth/2));
+                }
             }
         } while(octreeIterator.moveRight());
     }
@@ -164,7 +180,14 @@ int main(int argc, char ** argv){
     counter.tic();
 
     FOctreeArrangerProc<FReal, OctreeClass, ContainerClass, TestParticle<FReal>, Converter<FReal, TestParticle<FReal>> > arrange(&tree);
-    arrange.rearrange(app.global());
+    if(useMigration){
+        arrange.migrate(app.global());
+        std::cout << "Migration sent " << arrange.getNbSentParticles() << " particles and received "
+                  << arrange.getNbReceivedParticles() << " particles" << std::endl;
+    }
+    else{
+        arrange.rearrange(app.global());
+    }
 
     counter.tac();
     std::cout << "Done  " << "(@Arrange = " << counter.elapsed() << "s)." << std::endl;
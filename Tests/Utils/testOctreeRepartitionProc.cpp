@@ -0,0 +1,211 @@
+// See LICENCE file at project root
+
+// ==== CMAKE =====
+// @FUSE_MPI
+// ================
+
+#include <iostream>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "Utils/FParameters.hpp"
+#include "Utils/FTic.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Containers/FVector.hpp"
+
+#include "Components/FSimpleLeaf.hpp"
+
+#include "Utils/FPoint.hpp"
+
+#include "Components/FTestCell.hpp"
+
+#include "Arranger/FRepartitionControllerProc.hpp"
+#include "Files/FMpiTreeBuilder.hpp"
+
+#include "Components/FBasicParticleContainer.hpp"
+
+#include "Utils/FLeafBalance.hpp"
+
+#include "Utils/FParameterNames.hpp"
+
+template <class FReal>
+struct TestParticle{
+    FPoint<FReal> position;
+    const FPoint<FReal>& getPosition(){
+        return position;
+    }
+};
+
+template <class FReal, class ParticleClass>
+class Converter {
+public:
+    template <class ContainerClass>
+    static ParticleClass GetParticleAndRemove(ContainerClass* container, const FSize idxExtract){
+        TestParticle<FReal> part;
+        part.position.setPosition(
+                    container->getPositions()[0][idxExtract],
+                container->getPositions()[1][idxExtract],
+                container->getPositions()[2][idxExtract]);
+        container->removeParticles(&idxExtract, 1);
+        return part;
+    }
+
+    template <class OctreeClass>
+    static void Insert(OctreeClass* tree, const ParticleClass& part){
+        tree->insert(part.position);
+    }
+};
+
+
+
+// Distribute clustered particles by number of leaves, then let the controller balance the cost
+int main(int argc, char ** argv){
+    const FParameterNames LocalOptionNbSteps {
+        {"-steps"},
+        "Number of time steps"
+    };
+    FHelpDescribeAndExit(argc, argv,
+                         "In distributed!\n"
+                         "Put clustered particles into a tree distributed by number of leaves, then move them\n"
+                         "at each step and let FRepartitionControllerProc balance the cost of the leaves (n^2).",
+                         FParameterDefinitions::NbParticles, FParameterDefinitions::OctreeHeight,
+                         FParameterDefinitions::OctreeSubHeight, LocalOptionNbSteps);
+
+    typedef double FReal;
+
+    typedef FTestCell                   CellClass;
+    typedef FBasicParticleContainer<FReal,0,FReal>      ContainerClass;
+
+    typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+    typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+    typedef FRepartitionControllerProc<FReal, OctreeClass, ContainerClass, TestParticle<FReal>,
+                                       Converter<FReal, TestParticle<FReal>> > ControllerClass;
+
+    FMpi app(argc, argv);
+
+    const int NbLevels          = FParameters::getValue(argc,argv,FParameterDefinitions::OctreeHeight.options, 6);
+    const int SizeSubLevels     = FParameters::getValue(argc,argv,FParameterDefinitions::OctreeSubHeight.options, 3);
+    const FSize NbPart          = FParameters::getValue(argc,argv,FParameterDefinitions::NbParticles.options, FSize(20000));
+    const int NbSteps           = FParameters::getValue(argc,argv,LocalOptionNbSteps.options, 10);
+
+    srand48 ( 1 + app.global().processId() );
+
+    const FReal BoxWidth = 1.0;
+    const FReal BoxCenter = 0.5;
+    const FReal leafWidth = BoxWidth / FReal(1 << (NbLevels-1));
+
+    OctreeClass tree(NbLevels, SizeSubLevels, BoxWidth, FPoint<FReal>(BoxCenter,BoxCenter,BoxCenter));
+
+    {
+        // Half of the particles in a corner
+        TestParticle<FReal>* particles = new TestParticle<FReal>[NbPart];
+        for(FSize idxPart = 0 ; idxPart < NbPart ; ++idxPart){
+            const FReal scale = (idxPart % 2 ? BoxWidth : BoxWidth/8);
+            particles[idxPart].position.setPosition(scale*FReal(drand48()), scale*FReal(drand48()), scale*FReal(drand48()));
+        }
+
+        FVector<TestParticle<FReal>> finalParticles;
+        FLeafBalance balancer;
+        FMpiTreeBuilder< FReal,TestParticle<FReal> >::DistributeArrayToContainer(app.global(),particles,
+                                                                                 NbPart,
+                                                                                 FPoint<FReal>(BoxCenter,BoxCenter,BoxCenter),
+                                                                                 BoxWidth,NbLevels,
+                                                                                 &finalParticles, &balancer);
+        for(int idx = 0 ; idx < finalParticles.getSize(); ++idx){
+            tree.insert(finalParticles[idx].position);
+        }
+
+        delete[] particles;
+    }
+
+    ControllerClass controller(app.global(), &tree);
+    controller.setThresholds(1.2, 1.1, 2);
+
+    bool hasRepartitioned = false;
+    for(int idxStep = 0 ; idxStep < NbSteps ; ++idxStep){
+        // The work of a step is given by the cost model n^2 of the leaves
+        double localCost = 0;
+        tree.forEachLeaf([&](LeafClass* leaf){
+            const FSize nbParticles = leaf->getSrc()->getNbParticles();
+            localCost += double(nbParticles) * double(nbParticles);
+        });
+        const bool willRepartition = controller.recordExecution(localCost);
+
+        if(app.global().processId() == 0){
+            std::cout << "Step " << idxStep << " imbalance " << controller.getImbalance()
+                      << " min/max " << controller.getMinMaxRatio()
+                      << (willRepartition ? " -> repartition" : "") << std::endl;
+            if(hasRepartitioned){
+                std::cout << "\t last migration " << controller.getLastMigrationTime() << "s, saved "
+                          << controller.getLastTimeSaved() << " (cost units) per step" << std::endl;
+            }
+        }
+
+        // Small moves, the particles stay in the box
+        tree.forEachLeaf([&](LeafClass* leaf){
+            ContainerClass* particles = leaf->getSrc();
+            for(FSize idxPart = 0; idxPart < particles->getNbParticles() ; ++idxPart){
+                for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                    const FReal newPosition = particles->getPositions()[idxDim][idxPart] + leafWidth * (FReal(drand48()) - FReal(0.5)) / 4;
+                    particles->getPositions()[idxDim][idxPart] = FMath::Max(BoxCenter-(BoxWidth/2),
+                                                                 FMath::Min(newPosition, BoxCenter+(BoxWidth/2) - leafWidth/1024));
+                }
+            }
+        });
+
+        controller.arrange();
+        hasRepartitioned = willRepartition;
+    }
+
+    { // Check that each particle is in the right leaf and that none has been lost
+        FSize counterPart = 0;
+        MortonIndex interval[2] = {-1, -1};
+        if(tree.isEmpty() == false){
+            OctreeClass::Iterator octreeIterator(&tree);
+            octreeIterator.gotoBottomLeft();
+            interval[0] = octreeIterator.getCurrentGlobalIndex();
+            do{
+                const MortonIndex leafIndex = octreeIterator.getCurrentGlobalIndex();
+                ContainerClass* particles = octreeIterator.getCurrentListTargets();
+                for(FSize idxPart = 0; idxPart < particles->getNbParticles() ; ++idxPart){
+                    const FPoint<FReal> particlePosition( particles->getPositions()[0][idxPart],
+                            particles->getPositions()[1][idxPart],
+                            particles->getPositions()[2][idxPart]);
+                    if( leafIndex != tree.getMortonFromPosition( particlePosition ) ){
+                        std::cout << "Index problem in leaf " << leafIndex << std::endl;
+                    }
+                }
+                counterPart += particles->getNbParticles();
+                if(particles->getNbParticles() == 0){
+                    std::cout << "Problem, leaf is empty at index " << leafIndex << std::endl;
+                }
+                interval[1] = leafIndex;
+            } while(octreeIterator.moveRight());
+        }
+
+        counterPart = app.global().reduceSum(counterPart);
+        if(app.global().processId() == 0 && counterPart != NbPart  * app.global().processCount() ){
+            std::cout <<"Wrong particles number, should be " << (NbPart  * app.global().processCount()) << " but is " << counterPart << std::endl;
+        }
+
+        MortonIndex*const allintervals = new MortonIndex[ 2 * app.global().processCount() ];
+        MPI_Allgather( interval, sizeof(MortonIndex) * 2, MPI_BYTE, allintervals, sizeof(MortonIndex) * 2, MPI_BYTE, app.global().getComm());
+        if(app.global().processId() == 0){
+            MortonIndex lastIndex = -1;
+            for(int idxProc = 0 ; idxProc < app.global().processCount() ; ++idxProc){
+                if( allintervals[idxProc*2] != -1 ){
+                    if( allintervals[idxProc*2] <= lastIndex ){
+                        std::cout << "Interval problem for process " << idxProc << std::endl;
+                    }
+                    lastIndex = allintervals[idxProc*2+1];
+                }
+            }
+            std::cout << "Number of repartitions " << controller.getNbRepartitions() << std::endl;
+        }
+        delete[] allintervals;
+    }
+
+    return 0;
+}
@@ -11,6 +11,11 @@
 #include "Components/FTestKernels.hpp"
 #include "Components/FBasicKernels.hpp"
 
+#include "Files/FRandomLoader.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
 
 /** This class test the core algorithm builder */
 #ifndef SCALFMM_USE_MPI
@@ -79,9 +84,97 @@ class TestBuilder : public FUTesterMpi<TestBuilder> {
 
     }
 
+#ifndef SCALFMM_USE_MPI
+    void TestAuto(){
+        typedef double FReal;
+        typedef FTestCell                   CellClass;
+        typedef FTestParticleContainer<FReal>      ContainerClass;
+
+        typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+        typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+        typedef FTestKernels< CellClass, ContainerClass >         KernelClass;
+        typedef FFmmAlgorithmAuto<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass> AutoClass;
+
+        const char cacheFilename[] = "utestAlgorithmBuilder.auto";
+        std::remove(cacheFilename);
+        setenv("SCALFMM_AUTO_CACHE", cacheFilename, 1);
+
+        FRandomLoader<FReal> loader(2000, 1, FPoint<FReal>(0.5,0.5,0.5), 1);
+        OctreeClass tree(5, 2, loader.getBoxWidth(), loader.getCenterOfBox());
+        for(FSize idxPart = 0 ; idxPart < loader.getNumberOfParticles() ; ++idxPart){
+            FPoint<FReal> particlePosition;
+            loader.fillParticle(&particlePosition);
+            tree.insert(particlePosition);
+        }
+        KernelClass kernel;
+
+        std::string chosenName;
+        {
+            FAbstractAlgorithm*const algo = FAlgorithmBuilder<FReal>::BuildAutoAlgorithm<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>(&tree, &kernel);
+            AutoClass*const autoAlgo = dynamic_cast<AutoClass*>(algo);
+            uassert(autoAlgo != nullptr);
+            uassert(autoAlgo->isCalibrated() == false);
+
+            // Two executions per candidate by default
+            for(int idxStep = 0 ; idxStep < 32 && autoAlgo->isCalibrated() == false ; ++idxStep){
+                algo->execute();
+            }
+            uassert(autoAlgo->isCalibrated());
+            chosenName = autoAlgo->getCurrentCandidateName();
+            delete algo;
+        }
+        {
+            // The decision comes from the cache
+            AutoClass autoAlgo(&tree, &kernel);
+            uassert(autoAlgo.isCalibrated());
+            uassert(autoAlgo.getCurrentCandidateName() == chosenName);
+        }
+
+        unsetenv("SCALFMM_AUTO_CACHE");
+        std::remove(cacheFilename);
+
+        {
+            // Without SCALFMM_AUTO_CACHE there is no cache
+            AutoClass autoAlgo(&tree, &kernel);
+            uassert(autoAlgo.isCalibrated() == false);
+        }
+
+#ifdef SCALFMM_AUTO_WITH_OMP4
+        {
+            // The Omp4 candidate gives the right results
+            FRandomLoader<FReal> omp4Loader(2000, 1, FPoint<FReal>(0.5,0.5,0.5), 1);
+            OctreeClass omp4Tree(5, 2, omp4Loader.getBoxWidth(), omp4Loader.getCenterOfBox());
+            for(FSize idxPart = 0 ; idxPart < omp4Loader.getNumberOfParticles() ; ++idxPart){
+                FPoint<FReal> particlePosition;
+                omp4Loader.fillParticle(&particlePosition);
+                omp4Tree.insert(particlePosition);
+            }
+
+            setenv("SCALFMM_AUTO_ALGORITHM", "omp4", 1);
+            AutoClass autoAlgo(&omp4Tree, &kernel);
+            unsetenv("SCALFMM_AUTO_ALGORITHM");
+            uassert(autoAlgo.isCalibrated());
+            uassert(autoAlgo.getCurrentCandidateName() == "omp4");
+
+            autoAlgo.execute();
+            omp4Tree.forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+                uassert(cell->getMultipoleData().get() == leaf->getSrc()->getNbParticles());
+                const long long int* dataDown = leaf->getTargets()->getDataDown();
+                for(FSize idxPart = 0 ; idxPart < leaf->getTargets()->getNbParticles() ; ++idxPart){
+                    uassert(dataDown[idxPart] == omp4Loader.getNumberOfParticles() - 1);
+                }
+            });
+        }
+#endif
+    }
+#endif
+
     // set test
     void SetTests(){
         AddTest(&TestBuilder::Test,"Test Algo Creation");
+#ifndef SCALFMM_USE_MPI
+        AddTest(&TestBuilder::TestAuto,"Test Auto Algo Calibration");
+#endif
     }
 
 #ifdef SCALFMM_USE_MPI
@@ -0,0 +1,134 @@
+// See LICENCE file at project root
+
+// ==== CMAKE =====
+// @FUSE_OMP5
+// ================
+
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Components/FSimpleLeaf.hpp"
+
+#include "Components/FTestParticleContainer.hpp"
+#include "Components/FTestCell.hpp"
+#include "Components/FTestKernels.hpp"
+
+#include "Core/FFmmAlgorithmThread.hpp"
+#include "Core/FFmmAlgorithmOmp5.hpp"
+
+#include "Files/FRandomLoader.hpp"
+
+#include <set>
+
+/**
+  In this test the FMM is executed with executeAsync, the results must be
+  the ones of execute(), and the leaves reported during the execution
+  must already have their final values.
+  */
+
+/** this class test the asynchronous execution */
+class TestAsyncExecution : public FUTester<TestAsyncExecution> {
+    typedef double FReal;
+    typedef FTestCell                   CellClass;
+    typedef FTestParticleContainer<FReal>      ContainerClass;
+
+    typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+    typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+    typedef FTestKernels< CellClass, ContainerClass >         KernelClass;
+
+    static const FSize NbParticles = 5000;
+
+    void fill(OctreeClass* tree){
+        FRandomLoader<FReal> loader(NbParticles, 1, FPoint<FReal>(0.5,0.5,0.5), 1);
+        for(FSize idxPart = 0 ; idxPart < loader.getNumberOfParticles() ; ++idxPart){
+            FPoint<FReal> particlePosition;
+            loader.fillParticle(&particlePosition);
+            tree->insert(particlePosition);
+        }
+    }
+
+    /** The cells and the particles of both trees have the same values */
+    void compareTrees(OctreeClass* asyncTree, OctreeClass* syncTree){
+        FSize nbChecked = 0;
+        asyncTree->forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+            const CellClass* syncCell = syncTree->getCell(cell->getMortonIndex(), syncTree->getHeight()-1);
+            uassert(syncCell != nullptr);
+            uassert(cell->getDataUp() == syncCell->getDataUp());
+            uassert(cell->getDataDown() == syncCell->getDataDown());
+
+            const ContainerClass* syncTargets = syncTree->getLeafSrc(cell->getMortonIndex());
+            uassert(syncTargets != nullptr && syncTargets->getNbParticles() == leaf->getTargets()->getNbParticles());
+            for(FSize idxPart = 0 ; idxPart < leaf->getTargets()->getNbParticles() ; ++idxPart){
+                uassert(leaf->getTargets()->getDataDown()[idxPart] == syncTargets->getDataDown()[idxPart]);
+                uassert(leaf->getTargets()->getDataDown()[idxPart] == NbParticles - 1);
+            }
+            nbChecked += leaf->getTargets()->getNbParticles();
+        });
+        uassert(nbChecked == NbParticles);
+    }
+
+    /** Run the algorithm with execute and executeAsync and compare */
+    template <class FmmClass>
+    void runAndCompare(const bool leavesAreReported){
+        OctreeClass syncTree(5, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        fill(&syncTree);
+        KernelClass syncKernels;
+        FmmClass syncAlgo(&syncTree, &syncKernels);
+        syncAlgo.execute();
+
+        OctreeClass asyncTree(5, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        fill(&asyncTree);
+        KernelClass asyncKernels;
+        FmmClass asyncAlgo(&asyncTree, &asyncKernels);
+
+        std::unique_ptr<FAsyncExecution> handle = asyncAlgo.executeAsync();
+        std::set<MortonIndex> reportedLeaves;
+        FSize nbProcessed = 0;
+        FSize nbFinished;
+        while((nbFinished = handle->waitForLeaves(nbProcessed)) != nbProcessed){
+            for( ; nbProcessed < nbFinished ; ++nbProcessed){
+                const MortonIndex leafIndex = handle->getFinishedLeaf(nbProcessed);
+                uassert(reportedLeaves.insert(leafIndex).second);
+                uassert(handle->isLeafFinished(leafIndex));
+                // The leaf will not be modified anymore
+                const ContainerClass* targets = asyncTree.getLeafSrc(leafIndex);
+                uassert(targets != nullptr);
+                for(FSize idxPart = 0 ; idxPart < targets->getNbParticles() ; ++idxPart){
+                    uassert(targets->getDataDown()[idxPart] == NbParticles - 1);
+                }
+            }
+        }
+        handle->wait();
+        uassert(handle->isFinished());
+
+        if(leavesAreReported){
+            FSize nbLeaves = 0;
+            asyncTree.forEachLeaf([&](LeafClass*){ nbLeaves += 1; });
+            uassert(FSize(reportedLeaves.size()) == nbLeaves);
+        }
+        else{
+            uassert(reportedLeaves.empty());
+        }
+
+        compareTrees(&asyncTree, &syncTree);
+    }
+
+    /** The thread algorithm only reports the end of the execution */
+    void TestThread(){
+        runAndCompare<FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>(false);
+    }
+
+    /** The OpenMP 5 algorithm reports each leaf */
+    void TestOmp5(){
+        runAndCompare<FFmmAlgorithmOmp5<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>(true);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestAsyncExecution::TestThread,"Asynchronous execution of the thread algorithm");
+        AddTest(&TestAsyncExecution::TestOmp5,"Asynchronous execution with the leaves reported");
+    }
+};
+
+// You must do this
+TestClass(TestAsyncExecution)
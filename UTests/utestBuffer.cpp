@@ -1,6 +1,7 @@
 // See LICENCE file at project root
 #
 #include <cstddef>
+#include <cmath>
 
 #include "FUTester.hpp"
 
@@ -92,10 +93,53 @@ class TestBuffer : public FUTester<TestBuffer> {
         }
 
 
+        void TestWriteReals(){
+            const int NbValues = 100;
+            // Values outside the float range only survive with the shared exponent
+            double values[NbValues];
+            for(int idxValue = 0 ; idxValue < NbValues ; ++idxValue){
+                values[idxValue] = (idxValue % 2 ? -1.0 : 1.0) * double(idxValue) * 1.0e300 / 3.0;
+            }
+
+            const FBufferPrecision precisions[] = {FBufferPrecision::Full, FBufferPrecision::Single, FBufferPrecision::SharedExponent};
+            for(const FBufferPrecision precision : precisions){
+                FBufferWriter writer;
+                writer.setPrecision(precision);
+                writer << int(1);
+                writer.writeReals(values, NbValues);
+                writer << int(2);
+
+                uassert(writer.getSize() == FSize(2*sizeof(int)) + FBufferRealsCoder::GetSize<double>(precision, NbValues));
+
+                FBufferReader reader(writer.getSize());
+                reader.setPrecision(precision);
+                memcpy(reader.data(), writer.data(), writer.getSize());
+
+                double readValues[NbValues];
+                uassert(reader.FBufferReader::getValue<int>() == 1);
+                reader.fillReals(readValues, NbValues);
+                uassert(reader.FBufferReader::getValue<int>() == 2);
+                uassert(reader.tell() == writer.getSize());
+
+                for(int idxValue = 0 ; idxValue < NbValues ; ++idxValue){
+                    if(precision == FBufferPrecision::Full){
+                        uassert(readValues[idxValue] == values[idxValue]);
+                    }
+                    else if(precision == FBufferPrecision::SharedExponent){
+                        uassert(std::abs(readValues[idxValue] - values[idxValue]) <= 1e-7 * std::abs(values[idxValue]));
+                    }
+                }
+            }
+
+            uassert(FBufferPrecisionForAccuracy(0) == FBufferPrecision::Full);
+            uassert(FBufferPrecisionForAccuracy(1e-5) == FBufferPrecision::SharedExponent);
+        }
+
         // set test
         void SetTests(){
             AddTest(&TestBuffer::TestWriteRead,"Test Write then Read");
             AddTest(&TestBuffer::TestWriteAt,"Test Write at then Read");
+            AddTest(&TestBuffer::TestWriteReals,"Test Write then Read reals with a precision");
         }
 };
 
@@ -0,0 +1,154 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Containers/FBlockAllocator.hpp"
+#include "Components/FSimpleLeaf.hpp"
+
+#include "Components/FTestParticleContainer.hpp"
+#include "Components/FTestCell.hpp"
+#include "Components/FTestKernels.hpp"
+
+#include "Core/FFmmAlgorithmThread.hpp"
+
+#include "Files/FRandomLoader.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+  In this test we compact the cells of trees with FOctree::compactCells,
+  the cells of each level must be side by side in Morton order, and the
+  tree must still work (FMM, insertions and removals).
+  */
+
+/** this class test the cells arenas of the octree */
+class TestCellArena : public FUTester<TestCellArena> {
+    typedef double FReal;
+    typedef FTestCell                   CellClass;
+    typedef FTestParticleContainer<FReal>      ContainerClass;
+
+    typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+    typedef FOctree<FReal, CellClass, ContainerClass , LeafClass, FArenaBlockAllocator<CellClass> >  OctreeClass;
+    typedef FTestKernels< CellClass, ContainerClass >         KernelClass;
+
+    void fill(OctreeClass* tree, const FSize nbParticles){
+        // Clustered, to have missing cells at all the levels
+        FRandomLoader<FReal> loader(nbParticles, 1, FPoint<FReal>(0.5,0.5,0.5), 1);
+        for(FSize idxPart = 0 ; idxPart < loader.getNumberOfParticles() ; ++idxPart){
+            FPoint<FReal> particlePosition;
+            loader.fillParticle(&particlePosition);
+            if(idxPart % 2){
+                particlePosition = particlePosition * FReal(0.2);
+            }
+            tree->insert(particlePosition);
+        }
+    }
+
+    /** The cells of each level in Morton order */
+    std::vector<std::vector<CellClass*>> getCells(OctreeClass* tree){
+        std::vector<std::vector<CellClass*>> cells(tree->getHeight());
+        tree->forEachCell([&](CellClass* cell){
+            cells[cell->getLevel()].push_back(cell);
+        });
+        return cells;
+    }
+
+    /** The cells of each level follow each other in Morton order, and are the same as before */
+    void TestCompact(){
+        for(int idxHeight = 3 ; idxHeight < 7 ; ++idxHeight){
+            for(int idxSub = 1 ; idxSub < idxHeight ; ++idxSub){
+                OctreeClass tree(idxHeight, idxSub, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+                fill(&tree, 2000);
+                const std::vector<std::vector<CellClass*>> cellsBefore = getCells(&tree);
+                std::vector<std::vector<MortonIndex>> indexesBefore(idxHeight);
+                for(int idxLevel = 1 ; idxLevel < idxHeight ; ++idxLevel){
+                    for(CellClass* cell : cellsBefore[idxLevel]){
+                        cell->getMultipoleData().set(cell->getMortonIndex() * 7);
+                        indexesBefore[idxLevel].push_back(cell->getMortonIndex());
+                    }
+                }
+
+                // Twice to move from an arena to a new one
+                for(int idxCompact = 0 ; idxCompact < 2 ; ++idxCompact){
+                    tree.compactCells();
+                    const std::vector<std::vector<CellClass*>> cells = getCells(&tree);
+                    for(int idxLevel = 1 ; idxLevel < idxHeight ; ++idxLevel){
+                        uassert(cells[idxLevel].size() == indexesBefore[idxLevel].size());
+                        uassert(reinterpret_cast<std::uintptr_t>(cells[idxLevel][0]) % FP2PDefaultAlignement == 0);
+                        for(size_t idxCell = 0 ; idxCell < cells[idxLevel].size() ; ++idxCell){
+                            uassert(cells[idxLevel][idxCell] == cells[idxLevel][0] + idxCell);
+                            uassert(cells[idxLevel][idxCell]->getMortonIndex() == indexesBefore[idxLevel][idxCell]);
+                            uassert(cells[idxLevel][idxCell]->getLevel() == idxLevel);
+                            uassert(cells[idxLevel][idxCell]->getMultipoleData().get() == indexesBefore[idxLevel][idxCell] * 7);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /** Insert and remove leaves after the compaction */
+    void TestModifyAfterCompact(){
+        OctreeClass tree(5, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        fill(&tree, 1000);
+        tree.compactCells();
+
+        // A new leaf far from the others (the clustered particles are not in this corner)
+        tree.insert(FPoint<FReal>(0.99,0.99,0.99));
+        const MortonIndex newLeaf = tree.getMortonFromPosition(FPoint<FReal>(0.99,0.99,0.99));
+        uassert(tree.getCell(newLeaf, 4) != nullptr);
+        uassert(tree.getCell(newLeaf, 4)->getMortonIndex() == newLeaf);
+
+        // Remove the first leaf (in the arena) and the new one (allocated)
+        OctreeClass::Iterator octreeIterator(&tree);
+        octreeIterator.gotoBottomLeft();
+        const MortonIndex firstLeaf = octreeIterator.getCurrentGlobalIndex();
+        tree.removeLeaf(firstLeaf);
+        tree.removeLeaf(newLeaf);
+        uassert(tree.getCell(firstLeaf, 4) == nullptr);
+        uassert(tree.getCell(newLeaf, 4) == nullptr);
+
+        tree.compactCells();
+        FSize nbLeaves = 0;
+        tree.forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+            uassert(cell->getMortonIndex() != firstLeaf && cell->getMortonIndex() != newLeaf);
+            uassert(leaf->getSrc()->getNbParticles() != 0);
+            nbLeaves += 1;
+        });
+        uassert(nbLeaves != 0);
+    }
+
+    /** Each particle must interact with all the others */
+    void TestFmm(){
+        const FSize nbParticles = 2000;
+        OctreeClass tree(5, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        fill(&tree, nbParticles);
+        tree.compactCells();
+
+        KernelClass kernels;
+        FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass> algo(&tree, &kernels);
+        algo.execute();
+
+        FSize nbChecked = 0;
+        tree.forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+            uassert(cell->getMultipoleData().get() == leaf->getSrc()->getNbParticles());
+            const long long int* dataDown = leaf->getTargets()->getDataDown();
+            for(FSize idxPart = 0 ; idxPart < leaf->getTargets()->getNbParticles() ; ++idxPart){
+                uassert(dataDown[idxPart] == nbParticles - 1);
+            }
+            nbChecked += leaf->getTargets()->getNbParticles();
+        });
+        uassert(nbChecked == nbParticles);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestCellArena::TestCompact,"Compact the cells of each level");
+        AddTest(&TestCellArena::TestModifyAfterCompact,"Insert and remove after the compaction");
+        AddTest(&TestCellArena::TestFmm,"FMM with the compacted cells");
+    }
+};
+
+// You must do this
+TestClass(TestCellArena)
@@ -0,0 +1,101 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FCellHashMap.hpp"
+#include "Components/FTestCell.hpp"
+
+#include <omp.h>
+
+/**
+* This file is a unit test for the FCellHashMap class
+*/
+
+/** this class test the map of the received cells */
+class TestCellHashMap : public FUTester<TestCellHashMap> {
+    typedef FTestCell CellClass;
+
+    /** Insert cells of several levels and find them back */
+    void TestInsertGet(){
+        FCellHashMap<CellClass> map;
+        uassert(map.getCell(0, 2) == nullptr);
+
+        map.reserve(3 * 64);
+        for(int idxLevel = 2 ; idxLevel < 5 ; ++idxLevel){
+            for(MortonIndex idxCell = 0 ; idxCell < 64 ; ++idxCell){
+                CellClass*const cell = map.allocateCell();
+                cell->setMortonIndex(idxCell);
+                cell->setLevel(idxLevel);
+                map.insertCell(idxCell, idxLevel, cell);
+            }
+        }
+        uassert(map.getNbCells() == 3 * 64);
+
+        for(int idxLevel = 2 ; idxLevel < 5 ; ++idxLevel){
+            for(MortonIndex idxCell = 0 ; idxCell < 64 ; ++idxCell){
+                const CellClass*const cell = map.getCell(idxCell, idxLevel);
+                uassert(cell != nullptr);
+                uassert(cell->getMortonIndex() == idxCell && cell->getLevel() == idxLevel);
+                // The cells are in the buffer
+                uassert(map.getCells() <= cell && cell < map.getCells() + map.getCapacity());
+            }
+            uassert(map.getCell(64, idxLevel) == nullptr);
+        }
+        uassert(map.getCell(0, 5) == nullptr);
+
+        // The deepest index of the deepest level
+        map.reserve(1);
+        const MortonIndex lastIndex = (MortonIndex(1) << (3 * (MaxTreeHeight - 1))) - 1;
+        CellClass*const cell = map.allocateCell();
+        map.insertCell(lastIndex, MaxTreeHeight - 1, cell);
+        uassert(map.getCell(lastIndex, MaxTreeHeight - 1) == cell);
+        uassert(map.getCell(lastIndex, MaxTreeHeight - 2) == nullptr);
+        uassert(map.getCell(0, 2) == nullptr);
+
+        map.clear();
+        uassert(map.getCell(lastIndex, MaxTreeHeight - 1) == nullptr);
+    }
+
+    /** The threads insert and read at the same time */
+    void TestParallel(){
+        const MortonIndex nbCells = 50000;
+        const int level = 7;
+        FCellHashMap<CellClass> map;
+        map.reserve(nbCells);
+
+        int nbErrors = 0;
+        #pragma omp parallel reduction(+:nbErrors)
+        {
+            #pragma omp for schedule(dynamic, 100) nowait
+            for(MortonIndex idxCell = 0 ; idxCell < nbCells ; ++idxCell){
+                // Spread the indexes to have collisions
+                const MortonIndex index = idxCell * 37;
+                CellClass*const cell = map.allocateCell();
+                cell->setMortonIndex(index);
+                cell->getMultipoleData().set(index);
+                map.insertCell(index, level, cell);
+                // A cell that is found must be complete
+                const CellClass*const other = map.getCell((idxCell / 2) * 37, level);
+                if(other && (other->getMortonIndex() != (idxCell / 2) * 37
+                             || other->getMultipoleData().get() != (idxCell / 2) * 37)){
+                    nbErrors += 1;
+                }
+            }
+        }
+        uassert(nbErrors == 0);
+        uassert(map.getNbCells() == nbCells);
+
+        for(MortonIndex idxCell = 0 ; idxCell < nbCells ; ++idxCell){
+            const CellClass*const cell = map.getCell(idxCell * 37, level);
+            uassert(cell && cell->getMortonIndex() == idxCell * 37 && cell->getMultipoleData().get() == idxCell * 37);
+        }
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestCellHashMap::TestInsertGet,"Insert and get cells");
+        AddTest(&TestCellHashMap::TestParallel,"Insert and get cells in parallel");
+    }
+};
+
+// You must do this
+TestClass(TestCellHashMap)
@@ -6,6 +6,7 @@
 #include "Utils/FOstreamTuple.hpp"
 
 #include "Components/FBasicParticleContainer.hpp"
+#include "Kernels/P2P/FP2PParticleContainerVortexIndexed.hpp"
 
 using FReal = double;
 
@@ -52,6 +53,9 @@ public:
         test_push_particle();
         test_positions();
         test_attributes();
+        test_append();
+        test_append_gathered();
+        test_append_vortex();
     }
 
 private:
@@ -180,6 +184,67 @@ private:
 
     }
 
+    void test_append() {
+        FContainer container;
+        container.push(part_vect[0]);
+
+        const FReal x[3] = {2,3,4}, y[3] = {6,7,8}, z[3] = {10,11,12};
+        const int a0[3] = {6,11,16}, a1[3] = {7,12,17}, a2[3] = {8,13,18}, a3[3] = {9,14,19}, a4[3] = {10,15,20};
+        const FReal* positions[3] = {x, y, z};
+        const int* attributes[5] = {a0, a1, a2, a3, a4};
+        container.append(3, positions, attributes);
+
+        assert(container.size() == 4);
+        for(std::size_t i = 0; i < 4; ++i) {
+            assert(container[i] == part_vect[i].as_tuple() );
+        }
+
+        // The missing attributes are set to 0
+        attributes[1] = nullptr;
+        container.append(3, positions, attributes);
+        container.append(1, positions, nullptr);
+        assert(container.size() == 8);
+        assert(container.getAttribute(0)[6] == 16);
+        assert(container.getAttribute(1)[6] == 0);
+        assert(container.getAttribute(0)[7] == 0);
+        assert(container.getPositions()[2][7] == 10);
+    }
+
+    void test_append_gathered() {
+        FContainer source;
+        for(auto p : part_vect) {
+            source.push(p);
+        }
+        const FReal* positions[3] = {source.getPositions()[0], source.getPositions()[1], source.getPositions()[2]};
+        const int* attributes[5];
+        for(int i = 0; i < 5; ++i) {
+            attributes[i] = source.getAttribute(i);
+        }
+
+        FContainer container;
+        container.appendGathered(4, [](const FSize i){ return 3 - i; }, positions, attributes);
+        assert(container.size() == 4);
+        for(std::size_t i = 0; i < 4; ++i) {
+            assert(container[i] == part_vect[3-i].as_tuple() );
+        }
+    }
+
+    void test_append_vortex() {
+        FP2PParticleContainerVortexIndexed<FReal> container;
+        const FReal x[2] = {1,2}, y[2] = {3,4}, z[2] = {5,6}, values[2] = {7,8};
+        const FSize indexes[2] = {10,11};
+        const FReal* positions[3] = {x, y, z};
+        const FReal* attributes[FP2PParticleContainerVortexIndexed<FReal>::NbAttributes] = {values};
+        container.append(2, positions, indexes, attributes);
+
+        assert(container.getNbParticles() == 2);
+        assert(container.getPositions()[1][1] == 4);
+        assert(container.getIndexes()[1] == 11);
+        assert(container.getPhysicalValues()[1] == 8);
+        assert(container.getPotentials()[1] == 0);
+        assert(container.getForcesZ_imag()[0] == 0);
+    }
+
 };
 
 
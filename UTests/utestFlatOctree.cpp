@@ -0,0 +1,192 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Containers/FFlatOctree.hpp"
+#include "Components/FSimpleLeaf.hpp"
+
+#include "Components/FTestParticleContainer.hpp"
+#include "Components/FTestCell.hpp"
+#include "Components/FTestKernels.hpp"
+
+#include "Core/FFmmAlgorithm.hpp"
+#include "Core/FFmmAlgorithmThread.hpp"
+
+#include "Files/FRandomLoader.hpp"
+
+/**
+  In this test we put the same particles in an FOctree and in an FFlatOctree,
+  the cells and the neighbors must be the same, and the FMM must give
+  the right number of interactions with the flat tree.
+  */
+
+/** this class test the flat octree container */
+class TestFlatOctree : public FUTester<TestFlatOctree> {
+    typedef double FReal;
+    typedef FTestCell                   CellClass;
+    typedef FTestParticleContainer<FReal>      ContainerClass;
+
+    typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+    typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+    typedef FFlatOctree<FReal, CellClass, ContainerClass , LeafClass >  FlatOctreeClass;
+    typedef FTestKernels< CellClass, ContainerClass >         KernelClass;
+
+    static const int NbLevels = 6;
+
+    template <class TreeClass>
+    void fill(TreeClass* tree, const FSize nbParticles){
+        // Clustered, to have missing cells at all the levels
+        FRandomLoader<FReal> loader(nbParticles, 1, FPoint<FReal>(0.5,0.5,0.5), 1);
+        for(FSize idxPart = 0 ; idxPart < loader.getNumberOfParticles() ; ++idxPart){
+            FPoint<FReal> particlePosition;
+            loader.fillParticle(&particlePosition);
+            if(idxPart % 2){
+                particlePosition = particlePosition * FReal(0.2);
+            }
+            tree->insert(particlePosition);
+        }
+    }
+
+    /** The cells and the neighbors lists are the same as with FOctree */
+    void TestSameAsOctree(){
+        OctreeClass tree(NbLevels, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        FlatOctreeClass flatTree(NbLevels, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        fill(&tree, 3000);
+        fill(&flatTree, 3000);
+
+        OctreeClass::Iterator octreeIterator(&tree);
+        octreeIterator.gotoBottomLeft();
+        FlatOctreeClass::Iterator flatIterator(&flatTree);
+        flatIterator.gotoBottomLeft();
+
+        const CellClass* neighbors[342];
+        int neighborPositions[342];
+        const CellClass* flatNeighbors[342];
+        int flatNeighborPositions[342];
+
+        for(int idxLevel = NbLevels - 1 ; idxLevel >= 1 ; --idxLevel){
+            OctreeClass::Iterator avoidGotoLeft(octreeIterator);
+            FlatOctreeClass::Iterator flatAvoidGotoLeft(flatIterator);
+            uassert(octreeIterator.level() == flatIterator.level());
+
+            bool hasNext;
+            do{
+                uassert(octreeIterator.getCurrentGlobalIndex() == flatIterator.getCurrentGlobalIndex());
+                uassert(flatIterator.getCurrentCell()->getMortonIndex() == flatIterator.getCurrentGlobalIndex());
+                uassert(flatIterator.getCurrentCell()->getLevel() == idxLevel);
+
+                if(idxLevel != NbLevels - 1){
+                    CellClass** children = octreeIterator.getCurrentChildren();
+                    CellClass** flatChildren = flatIterator.getCurrentChildren();
+                    for(int idxChild = 0 ; idxChild < 8 ; ++idxChild){
+                        uassert((children[idxChild] == nullptr) == (flatChildren[idxChild] == nullptr));
+                        if(children[idxChild]){
+                            uassert(children[idxChild]->getMortonIndex() == flatChildren[idxChild]->getMortonIndex());
+                        }
+                    }
+                }
+                else{
+                    uassert(octreeIterator.getCurrentListSrc()->getNbParticles() == flatIterator.getCurrentListSrc()->getNbParticles());
+
+                    ContainerClass* leaves[26];
+                    int leavesPositions[26];
+                    ContainerClass* flatLeaves[26];
+                    int flatLeavesPositions[26];
+                    const int counter = tree.getLeafsNeighbors(leaves, leavesPositions, octreeIterator.getCurrentGlobalCoordinate(), idxLevel);
+                    const int flatCounter = flatTree.getLeafsNeighbors(flatLeaves, flatLeavesPositions, flatIterator.getCurrentGlobalCoordinate(), idxLevel);
+                    uassert(counter == flatCounter);
+                    for(int idxNeighbor = 0 ; idxNeighbor < FMath::Min(counter, flatCounter) ; ++idxNeighbor){
+                        uassert(leavesPositions[idxNeighbor] == flatLeavesPositions[idxNeighbor]);
+                        uassert(leaves[idxNeighbor]->getNbParticles() == flatLeaves[idxNeighbor]->getNbParticles());
+                    }
+                }
+
+                if(idxLevel >= 2){
+                    for(int separation = 0 ; separation <= 2 ; ++separation){
+                        const int counter = tree.getInteractionNeighbors(neighbors, neighborPositions, octreeIterator.getCurrentGlobalCoordinate(), idxLevel, separation);
+                        const int flatCounter = flatTree.getInteractionNeighbors(flatNeighbors, flatNeighborPositions, flatIterator.getCurrentGlobalCoordinate(), idxLevel, separation);
+                        uassert(counter == flatCounter);
+                        for(int idxNeighbor = 0 ; idxNeighbor < FMath::Min(counter, flatCounter) ; ++idxNeighbor){
+                            uassert(neighborPositions[idxNeighbor] == flatNeighborPositions[idxNeighbor]);
+                            uassert(neighbors[idxNeighbor]->getMortonIndex() == flatNeighbors[idxNeighbor]->getMortonIndex());
+                        }
+                    }
+                }
+
+                hasNext = octreeIterator.moveRight();
+                uassert(hasNext == flatIterator.moveRight());
+            } while(hasNext);
+
+            avoidGotoLeft.moveUp();
+            octreeIterator = avoidGotoLeft;
+            flatAvoidGotoLeft.moveUp();
+            flatIterator = flatAvoidGotoLeft;
+        }
+    }
+
+    /** Each particle must interact with all the others */
+    template <class AlgorithmClass>
+    void RunFmm(){
+        const FSize nbParticles = 2000;
+        FlatOctreeClass tree(NbLevels, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        fill(&tree, nbParticles);
+
+        KernelClass kernels;
+        AlgorithmClass algo(&tree, &kernels);
+        algo.execute();
+
+        FSize nbChecked = 0;
+        tree.forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+            uassert(cell->getMultipoleData().get() == leaf->getSrc()->getNbParticles());
+            const long long int* dataDown = leaf->getTargets()->getDataDown();
+            for(FSize idxPart = 0 ; idxPart < leaf->getTargets()->getNbParticles() ; ++idxPart){
+                uassert(dataDown[idxPart] == nbParticles - 1);
+            }
+            nbChecked += leaf->getTargets()->getNbParticles();
+        });
+        uassert(nbChecked == nbParticles);
+    }
+
+    /** The threads that create an Iterator together see the same built tree */
+    void TestConcurrentBuild(){
+        FlatOctreeClass tree(NbLevels, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        fill(&tree, 2000);
+        for(int idxRound = 0 ; idxRound < 2 ; ++idxRound){
+            int nbLeavesError = 0;
+#pragma omp parallel reduction(+:nbLeavesError)
+            {
+                FlatOctreeClass::Iterator iterator(&tree);
+                iterator.gotoBottomLeft();
+                int nbLeaves = 0;
+                do{
+                    nbLeaves += 1;
+                } while(iterator.moveRight());
+                nbLeavesError += (nbLeaves != tree.getNbCellsAtLevel(NbLevels-1));
+            }
+            uassert(tree.isTreeBuilt());
+            uassert(nbLeavesError == 0);
+            // A new leaf needs a new build
+            tree.insert(FPoint<FReal>(0.99,0.99,FReal(0.99) - FReal(0.5) * FReal(idxRound)));
+            uassert(tree.isTreeBuilt() == false);
+        }
+    }
+
+    void TestFmm(){
+        RunFmm<FFmmAlgorithm<FlatOctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>();
+    }
+
+    void TestFmmThread(){
+        RunFmm<FFmmAlgorithmThread<FlatOctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>();
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestFlatOctree::TestSameAsOctree,"Same cells and neighbors as FOctree");
+        AddTest(&TestFlatOctree::TestConcurrentBuild,"Create the first iterators in parallel");
+        AddTest(&TestFlatOctree::TestFmm,"FMM with the flat tree");
+        AddTest(&TestFlatOctree::TestFmmThread,"Threaded FMM with the flat tree");
+    }
+};
+
+// You must do this
+TestClass(TestFlatOctree)
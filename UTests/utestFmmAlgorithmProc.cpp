@@ -35,6 +35,7 @@
 #include <iostream>
 #include <cstdio>
 #include <cstdlib>
+#include <vector>
 
 
 /** this class test the bool array container */
@@ -208,14 +209,9 @@ class TestFmmAlgoProc : public FUTesterMpi<TestFmmAlgoProc> {
     typedef FFmmAlgorithmThreadProc<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass >     FmmClassProc;
 
 
-    void TestAlgo(){
-        const int NbLevels = 7;
-        const int SizeSubLevels = 3;
-        std::string filename(SCALFMMDataPath+"unitCubeXYZQ20k.bfma");
-        FMpiFmaGenericLoader<FReal> loader(filename,app.global());
-
-        OctreeClass realTree(NbLevels, SizeSubLevels, loader.getBoxWidth(), loader.getCenterOfBox());
-
+    /** Insert the particles of the file in the distributed tree and in the sequential one */
+    void FillTrees(const std::string& filename, FMpiFmaGenericLoader<FReal>& loader,
+                   OctreeClass& realTree, OctreeClass& treeValide){
         if( app.global().processCount() != 1){
             struct TestParticle{
                 FPoint<FReal> position;
@@ -254,7 +250,6 @@ class TestFmmAlgoProc : public FUTesterMpi<TestFmmAlgoProc> {
             }
         }
 
-        OctreeClass treeValide(NbLevels, SizeSubLevels,loader.getBoxWidth(),loader.getCenterOfBox());
         {
             FFmaGenericLoader<FReal> loaderSeq(filename);
             FPoint<FReal> position;
@@ -264,6 +259,78 @@ class TestFmmAlgoProc : public FUTesterMpi<TestFmmAlgoProc> {
                 treeValide.insert(position);
             }
         }
+    }
+
+    /** Set the cells and the particles to zero to run the algorithm again */
+    static void ResetTree(OctreeClass& tree){
+        tree.forEachCell([](CellClass* cell){
+            cell->getDataUp().reset();
+            cell->getDataDown().reset();
+        });
+        tree.forEachLeaf([](LeafClass* leaf){
+            leaf->getSrc()->resetToInitialState();
+        });
+    }
+
+    /**
+     * Each process puts a particle in some of the empty leaves between its
+     * first and last leaves (so it stays the owner of the new leaves), all the
+     * new particles are also inserted in the sequential tree.
+     */
+    void AddLeaves(OctreeClass& realTree, OctreeClass& treeValide, const int maxNewLeaves){
+        const FReal leafWidth = realTree.getBoxWidth() / FReal(1 << (realTree.getHeight() - 1));
+        const FPoint<FReal> boxCorner(realTree.getBoxCenter(), -realTree.getBoxWidth()/2);
+
+        std::vector<FReal> myPositions;
+        {
+            std::vector<MortonIndex> leavesIndexes;
+            realTree.forEachCellLeaf([&](CellClass* cell, LeafClass*){
+                leavesIndexes.push_back(cell->getMortonIndex());
+            });
+            for(std::size_t idxLeaf = 1 ; idxLeaf < leavesIndexes.size()
+                    && int(myPositions.size()/3) < maxNewLeaves ; ++idxLeaf){
+                if(leavesIndexes[idxLeaf-1] + 1 != leavesIndexes[idxLeaf]){
+                    const FTreeCoordinate coord(leavesIndexes[idxLeaf-1] + 1);
+                    myPositions.push_back(boxCorner.getX() + (FReal(coord.getX()) + FReal(0.5)) * leafWidth);
+                    myPositions.push_back(boxCorner.getY() + (FReal(coord.getY()) + FReal(0.5)) * leafWidth);
+                    myPositions.push_back(boxCorner.getZ() + (FReal(coord.getZ()) + FReal(0.5)) * leafWidth);
+                }
+            }
+        }
+
+        const int nbProcs = app.global().processCount();
+        const int myNbValues = int(myPositions.size());
+        std::vector<int> nbValues(nbProcs);
+        FMpi::Assert( MPI_Allgather(const_cast<int*>(&myNbValues), 1, MPI_INT, nbValues.data(), 1, MPI_INT,
+                                    app.global().getComm()), __LINE__);
+        std::vector<int> displacements(nbProcs + 1, 0);
+        for(int idxProc = 0 ; idxProc < nbProcs ; ++idxProc){
+            displacements[idxProc+1] = displacements[idxProc] + nbValues[idxProc];
+        }
+        std::vector<FReal> allPositions(displacements[nbProcs]);
+        FMpi::Assert( MPI_Allgatherv(myPositions.data(), myNbValues, FMpi::GetType(FReal()),
+                                     allPositions.data(), nbValues.data(), displacements.data(),
+                                     FMpi::GetType(FReal()), app.global().getComm()), __LINE__);
+        // All the processes must have changed the tree to test the plan
+        uassert(allPositions.size() != 0);
+
+        for(std::size_t idxPart = 0 ; idxPart < myPositions.size() ; idxPart += 3){
+            realTree.insert(FPoint<FReal>(myPositions[idxPart], myPositions[idxPart+1], myPositions[idxPart+2]));
+        }
+        for(std::size_t idxPart = 0 ; idxPart < allPositions.size() ; idxPart += 3){
+            treeValide.insert(FPoint<FReal>(allPositions[idxPart], allPositions[idxPart+1], allPositions[idxPart+2]));
+        }
+    }
+
+    void TestAlgo(){
+        const int NbLevels = 7;
+        const int SizeSubLevels = 3;
+        std::string filename(SCALFMMDataPath+"unitCubeXYZQ20k.bfma");
+        FMpiFmaGenericLoader<FReal> loader(filename,app.global());
+
+        OctreeClass realTree(NbLevels, SizeSubLevels, loader.getBoxWidth(), loader.getCenterOfBox());
+        OctreeClass treeValide(NbLevels, SizeSubLevels,loader.getBoxWidth(),loader.getCenterOfBox());
+        FillTrees(filename, loader, realTree, treeValide);
 
         ValidateTree(realTree, treeValide);
 
@@ -278,10 +345,82 @@ class TestFmmAlgoProc : public FUTesterMpi<TestFmmAlgoProc> {
         ValidateFMMAlgoProc<OctreeClass,ContainerClass, FmmClassProc>(&realTree,&treeValide,&algo);
     }
 
+    /**
+     * Execute several times on the same tree (with the communication plan
+     * of the first execution), then after new leaves have been created
+     * (the plan has to be rebuilt).
+     * The environment variables are read when the algorithm is built.
+     */
+    void RunPlan(const char* const planEnv, const char* const datatypesEnv, const bool reducedWirePrecision){
+        const int NbLevels = 7;
+        const int SizeSubLevels = 3;
+        const int NbExecutions = 3;
+        std::string filename(SCALFMMDataPath+"unitCubeXYZQ20k.bfma");
+        FMpiFmaGenericLoader<FReal> loader(filename,app.global());
+
+        OctreeClass realTree(NbLevels, SizeSubLevels, loader.getBoxWidth(), loader.getCenterOfBox());
+        OctreeClass treeValide(NbLevels, SizeSubLevels,loader.getBoxWidth(),loader.getCenterOfBox());
+        FillTrees(filename, loader, realTree, treeValide);
+
+        setenv("SCALFMM_MPI_COMMUNICATION_PLAN", planEnv, 1);
+        setenv("SCALFMM_MPI_DERIVED_DATATYPES", datatypesEnv, 1);
+        KernelClass kernels;
+        FmmClassProc algo(app.global(),&realTree,&kernels);
+        unsetenv("SCALFMM_MPI_COMMUNICATION_PLAN");
+        unsetenv("SCALFMM_MPI_DERIVED_DATATYPES");
+
+        FmmClass algoValide(&treeValide,&kernels);
+        algoValide.execute();
+
+        for(int idxExecution = 0 ; idxExecution < NbExecutions ; ++idxExecution){
+            if(reducedWirePrecision && idxExecution == 1){
+                for(int idxLevel = 0 ; idxLevel < NbLevels ; ++idxLevel){
+                    algo.setWirePrecision(idxLevel, FBufferPrecision::Single);
+                }
+            }
+            ResetTree(realTree);
+            algo.execute();
+            ValidateFMMAlgoProc<OctreeClass,ContainerClass, FmmClassProc>(&realTree,&treeValide,&algo);
+        }
+
+        AddLeaves(realTree, treeValide, 16);
+        ValidateTree(realTree, treeValide);
+
+        ResetTree(treeValide);
+        algoValide.execute();
+
+        for(int idxExecution = 0 ; idxExecution < NbExecutions ; ++idxExecution){
+            ResetTree(realTree);
+            algo.execute();
+            ValidateFMMAlgoProc<OctreeClass,ContainerClass, FmmClassProc>(&realTree,&treeValide,&algo);
+        }
+    }
+
+    void TestPlanReuse(){
+        RunPlan("true", "false", false);
+    }
+
+    void TestPlanWithoutReuse(){
+        RunPlan("false", "false", false);
+    }
+
+    void TestPlanDerivedDatatypes(){
+        RunPlan("true", "true", false);
+    }
+
+    void TestPlanWirePrecision(){
+        RunPlan("true", "false", true);
+        RunPlan("true", "true", true);
+    }
+
 
     // set test
     void SetTests(){
         AddTest(&TestFmmAlgoProc::TestAlgo,"Test Algorithm");
+        AddTest(&TestFmmAlgoProc::TestPlanReuse,"Test Algorithm with the reuse of the communication plan");
+        AddTest(&TestFmmAlgoProc::TestPlanWithoutReuse,"Test Algorithm without the reuse of the communication plan");
+        AddTest(&TestFmmAlgoProc::TestPlanDerivedDatatypes,"Test Algorithm with the M2L in derived datatypes");
+        AddTest(&TestFmmAlgoProc::TestPlanWirePrecision,"Test Algorithm with a reduced wire precision");
     }
 public:
     TestFmmAlgoProc(int argc,char ** argv) : FUTesterMpi(argc,argv){
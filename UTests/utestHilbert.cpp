@@ -0,0 +1,91 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FHilbertCoding.hpp"
+#include "Containers/FTreeCoordinate.hpp"
+
+#include <vector>
+
+/**
+* This file is a unit test for the FHilbertCoding class
+*/
+
+/** this class test the Hilbert keys */
+class TestHilbert : public FUTester<TestHilbert> {
+    static const int MaxTestLevel = 6;
+
+    /** All the keys of a level are used once, and decode gives back the coordinate */
+    void EncodeDecode(){
+        for(int idxLevel = 0 ; idxLevel <= MaxTestLevel ; ++idxLevel){
+            const int limit = (1 << idxLevel);
+            std::vector<bool> used(size_t(limit) * limit * limit, false);
+            for(int x = 0 ; x < limit ; ++x){
+                for(int y = 0 ; y < limit ; ++y){
+                    for(int z = 0 ; z < limit ; ++z){
+                        const MortonIndex key = FHilbertCoding::Encode(x, y, z, idxLevel);
+                        uassert(0 <= key && key < MortonIndex(used.size()));
+                        uassert(!used[key]);
+                        used[key] = true;
+                        int decoded[3];
+                        FHilbertCoding::Decode(key, idxLevel, &decoded[0], &decoded[1], &decoded[2]);
+                        uassert(decoded[0] == x && decoded[1] == y && decoded[2] == z);
+
+                        const MortonIndex mindex = FTreeCoordinate(x, y, z).getMortonIndex();
+                        uassert(FHilbertCoding::MortonToHilbert(mindex, idxLevel) == key);
+                        uassert(FHilbertCoding::HilbertToMorton(key, idxLevel) == mindex);
+                    }
+                }
+            }
+        }
+    }
+
+    /** Two consecutive keys are two cells that share a face */
+    void Continuity(){
+        for(int idxLevel = 1 ; idxLevel <= MaxTestLevel ; ++idxLevel){
+            const MortonIndex nbCells = MortonIndex(1) << (3 * idxLevel);
+            int previous[3];
+            FHilbertCoding::Decode(0, idxLevel, &previous[0], &previous[1], &previous[2]);
+            for(MortonIndex key = 1 ; key < nbCells ; ++key){
+                int current[3];
+                FHilbertCoding::Decode(key, idxLevel, &current[0], &current[1], &current[2]);
+                const int distance = FMath::Abs(current[0] - previous[0]) + FMath::Abs(current[1] - previous[1])
+                                   + FMath::Abs(current[2] - previous[2]);
+                uassert(distance == 1);
+                previous[0] = current[0];
+                previous[1] = current[1];
+                previous[2] = current[2];
+            }
+        }
+    }
+
+    /** The key of a parent is the key of its children shifted by 3 */
+    void Hierarchy(){
+        for(int idxLevel = 2 ; idxLevel <= MaxTestLevel ; ++idxLevel){
+            const int limit = (1 << idxLevel);
+            for(int x = 0 ; x < limit ; ++x){
+                for(int y = 0 ; y < limit ; ++y){
+                    for(int z = 0 ; z < limit ; ++z){
+                        const MortonIndex key = FHilbertCoding::Encode(x, y, z, idxLevel);
+                        const MortonIndex parentKey = FHilbertCoding::Encode(x >> 1, y >> 1, z >> 1, idxLevel - 1);
+                        uassert((key >> 3) == parentKey);
+                        // The cell is in the interval of its ancestor at level 1
+                        MortonIndex first, last;
+                        FHilbertCoding::GetLeafInterval(FHilbertCoding::Encode(x >> (idxLevel-1), y >> (idxLevel-1), z >> (idxLevel-1), 1),
+                                                        1, idxLevel, &first, &last);
+                        uassert(first <= key && key <= last);
+                    }
+                }
+            }
+        }
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestHilbert::EncodeDecode,"Test encode and decode");
+        AddTest(&TestHilbert::Continuity,"Test the continuity of the curve");
+        AddTest(&TestHilbert::Hierarchy,"Test the keys of the parents");
+    }
+};
+
+// You must do this
+TestClass(TestHilbert)
@@ -2,6 +2,12 @@
 #include "FUTester.hpp"
 
 #include "Containers/FTreeCoordinate.hpp"
+#include "Containers/FMortonCoding.hpp"
+#include "Containers/FCoordinateComputer.hpp"
+
+#include <random>
+#include <vector>
+#include <algorithm>
 
 // compile by g++ utestMorton.cpp -o utestMorton.exe
 
@@ -59,10 +65,130 @@ class TestMorton : public FUTester<TestMorton> {
             }
 	}
 
+        /** The Morton index computed bit by bit */
+        static MortonIndex BitByBit(const int x, const int y, const int z){
+            MortonIndex index = 0;
+            for(int idxBit = 0 ; idxBit < 21 ; ++idxBit){
+                index |= MortonIndex((x >> idxBit) & 1) << (3*idxBit + 2);
+                index |= MortonIndex((y >> idxBit) & 1) << (3*idxBit + 1);
+                index |= MortonIndex((z >> idxBit) & 1) << (3*idxBit);
+            }
+            return index;
+        }
+
+        void Batch(){
+            std::mt19937 generator(0);
+            std::uniform_int_distribution<int> distribution(0, (1 << 21) - 1);
+            const int nbElements = 1000;
+            std::vector<int> x(nbElements), y(nbElements), z(nbElements);
+            for(int idx = 0 ; idx < nbElements ; ++idx){
+                x[idx] = distribution(generator);
+                y[idx] = distribution(generator);
+                z[idx] = distribution(generator);
+            }
+            // The extreme values
+            x[0] = y[0] = z[0] = 0;
+            x[1] = y[1] = z[1] = (1 << 21) - 1;
+
+            std::vector<MortonIndex> indexes(nbElements);
+            FMortonCoding::EncodeArray(x.data(), y.data(), z.data(), nbElements, indexes.data());
+            std::vector<int> decodedX(nbElements), decodedY(nbElements), decodedZ(nbElements);
+            FMortonCoding::DecodeArray(indexes.data(), nbElements, decodedX.data(), decodedY.data(), decodedZ.data());
+
+            for(int idx = 0 ; idx < nbElements ; ++idx){
+                uassert(indexes[idx] == BitByBit(x[idx], y[idx], z[idx]));
+                uassert(indexes[idx] == FMortonCoding::Encode(x[idx], y[idx], z[idx]));
+                uassert(indexes[idx] == FTreeCoordinate(x[idx], y[idx], z[idx]).getMortonIndex());
+                uassert(decodedX[idx] == x[idx] && decodedY[idx] == y[idx] && decodedZ[idx] == z[idx]);
+                int decoded[3];
+                FMortonCoding::Decode(indexes[idx], &decoded[0], &decoded[1], &decoded[2]);
+                uassert(decoded[0] == x[idx] && decoded[1] == y[idx] && decoded[2] == z[idx]);
+            }
+        }
+
+        void Positions(){
+            std::mt19937 generator(0);
+            std::uniform_real_distribution<double> distribution(0, 1);
+            const FPoint<double> centerOfBox(0.5, 0.5, 0.5);
+            const int treeHeight = 8;
+            const FSize nbPositions = 1000;
+            std::vector<FPoint<double>> positions(nbPositions);
+            for(FPoint<double>& position : positions){
+                position = FPoint<double>(distribution(generator), distribution(generator), distribution(generator));
+            }
+            positions[0] = FPoint<double>(1, 1, 1);
+
+            std::vector<MortonIndex> indexes(nbPositions, -1);
+            FCoordinateComputer::GetMortonIndexesFromPositions<double>(centerOfBox, 1.0, treeHeight, nbPositions,
+                    [&](const FSize idxPosition){ return positions[idxPosition]; },
+                    [&](const FSize idxPosition, const MortonIndex index){ indexes[idxPosition] = index; });
+            for(FSize idxPosition = 0 ; idxPosition < nbPositions ; ++idxPosition){
+                const FTreeCoordinate host = FCoordinateComputer::GetCoordinateFromPosition<double>(centerOfBox, 1.0, treeHeight,
+                                                                                                 positions[idxPosition]);
+                uassert(indexes[idxPosition] == host.getMortonIndex());
+            }
+        }
+
+        void Neighbors(){
+            const int level = 4;
+            const int limit = (1 << level);
+            for(int x = 0 ; x < limit ; ++x){
+                for(int y = 0 ; y < limit ; ++y){
+                    for(int z = 0 ; z < limit ; ++z){
+                        const FTreeCoordinate coord(x, y, z);
+                        // The direct neighbors
+                        MortonIndex indexes[26];
+                        int positions[26];
+                        const int nbNeighbors = coord.getNeighborsIndexes(level + 1, indexes, positions);
+                        int nbExpected = 0;
+                        for(int idxX = -1 ; idxX <= 1 ; ++idxX){
+                            for(int idxY = -1 ; idxY <= 1 ; ++idxY){
+                                for(int idxZ = -1 ; idxZ <= 1 ; ++idxZ){
+                                    if((idxX || idxY || idxZ) && 0 <= x+idxX && x+idxX < limit
+                                            && 0 <= y+idxY && y+idxY < limit && 0 <= z+idxZ && z+idxZ < limit){
+                                        uassert(nbExpected < nbNeighbors);
+                                        uassert(indexes[nbExpected] == BitByBit(x+idxX, y+idxY, z+idxZ));
+                                        uassert(positions[nbExpected] == ((idxX+1)*3 + (idxY+1)) * 3 + (idxZ+1));
+                                        nbExpected += 1;
+                                    }
+                                }
+                            }
+                        }
+                        uassert(nbExpected == nbNeighbors);
+
+                        // The interaction list
+                        MortonIndex interactions[216];
+                        int interactionsPositions[216];
+                        const int nbInteractions = coord.getInteractionNeighbors(level, interactions, interactionsPositions);
+                        for(int idxInteraction = 0 ; idxInteraction < nbInteractions ; ++idxInteraction){
+                            const FTreeCoordinate other(interactions[idxInteraction]);
+                            const int xdiff = other.getX() - x;
+                            const int ydiff = other.getY() - y;
+                            const int zdiff = other.getZ() - z;
+                            uassert(FMath::Max(FMath::Abs(xdiff), FMath::Max(FMath::Abs(ydiff), FMath::Abs(zdiff))) > 1);
+                            uassert((other.getX() >> 1) - (x >> 1) <= 1 && (x >> 1) - (other.getX() >> 1) <= 1);
+                            uassert((other.getY() >> 1) - (y >> 1) <= 1 && (y >> 1) - (other.getY() >> 1) <= 1);
+                            uassert((other.getZ() >> 1) - (z >> 1) <= 1 && (z >> 1) - (other.getZ() >> 1) <= 1);
+                            uassert(interactionsPositions[idxInteraction] == (((xdiff+3) * 7) + (ydiff+3)) * 7 + zdiff + 3);
+                        }
+                        // All the children of the parent's neighbors that are not direct neighbors
+                        int nbParentNeighbors = 1;
+                        nbParentNeighbors *= FMath::Min((x >> 1) + 1, limit/2 - 1) - FMath::Max((x >> 1) - 1, 0) + 1;
+                        nbParentNeighbors *= FMath::Min((y >> 1) + 1, limit/2 - 1) - FMath::Max((y >> 1) - 1, 0) + 1;
+                        nbParentNeighbors *= FMath::Min((z >> 1) + 1, limit/2 - 1) - FMath::Max((z >> 1) - 1, 0) + 1;
+                        uassert(nbInteractions == nbParentNeighbors * 8 - nbNeighbors - 1);
+                    }
+                }
+            }
+        }
+
 	// set test
 	void SetTests(){
             AddTest(&TestMorton::Morton,"Test Morton");
             AddTest(&TestMorton::Position,"Test Position");
+            AddTest(&TestMorton::Batch,"Test encode and decode arrays");
+            AddTest(&TestMorton::Positions,"Test the indexes of positions");
+            AddTest(&TestMorton::Neighbors,"Test the neighbors indexes");
 	}
 };
 
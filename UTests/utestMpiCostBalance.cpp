@@ -0,0 +1,155 @@
+// See LICENCE file at project root
+
+// ==== CMAKE =====
+// @FUSE_MPI
+// ================
+
+#include "ScalFmmConfig.h"
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <random>
+
+#include "FUTester.hpp"
+
+#include "Utils/FMpi.hpp"
+#include "Containers/FVector.hpp"
+#include "Containers/FTreeCoordinate.hpp"
+#include "Containers/FCoordinateComputer.hpp"
+
+#include "Utils/FLeafBalance.hpp"
+#include "Utils/FCostBalance.hpp"
+#include "Files/FMpiTreeBuilder.hpp"
+
+#include "Utils/FPoint.hpp"
+#include "Utils/FMath.hpp"
+
+/** Distribute a clustered set of particles with FLeafBalance and FCostBalance */
+class TestMpiCostBalance :  public FUTesterMpi< class TestMpiCostBalance> {
+    typedef double FReal;
+
+    struct TestParticle{
+        FPoint<FReal> position;
+        FSize indexInFile;
+
+        const FPoint<FReal>& getPosition()const{
+            return position;
+        }
+    };
+
+    static const int TreeHeight = 5;
+
+    FPoint<FReal> boxCenter;
+    FReal boxWidth;
+    FSize nbParticlesPerProc;
+    FSize nbLocalLeaves;
+
+    MortonIndex getLeafIndex(const FPoint<FReal>& position) const {
+        const FReal boxWidthAtLeafLevel = boxWidth/FReal(1 << (TreeHeight - 1));
+        const FPoint<FReal> boxCorner = boxCenter - boxWidth/2;
+        FTreeCoordinate host;
+        host.setX( FCoordinateComputer::GetTreeCoordinate<FReal>( position.getX() - boxCorner.getX(), boxWidth, boxWidthAtLeafLevel, TreeHeight ));
+        host.setY( FCoordinateComputer::GetTreeCoordinate<FReal>( position.getY() - boxCorner.getY(), boxWidth, boxWidthAtLeafLevel, TreeHeight ));
+        host.setZ( FCoordinateComputer::GetTreeCoordinate<FReal>( position.getZ() - boxCorner.getZ(), boxWidth, boxWidthAtLeafLevel, TreeHeight ));
+        return host.getMortonIndex();
+    }
+
+    /** Half of the particles are in a small corner to have very different leaves */
+    std::vector<TestParticle> generateParticles() const {
+        std::mt19937 generator(1234 + app.global().processId());
+        std::uniform_real_distribution<FReal> unit(0, 1);
+        std::vector<TestParticle> particles(nbParticlesPerProc);
+        for(FSize idxPart = 0 ; idxPart < nbParticlesPerProc ; ++idxPart){
+            const FReal scale = (idxPart % 2 ? boxWidth : boxWidth/8);
+            particles[idxPart].position.setPosition(unit(generator) * scale, unit(generator) * scale, unit(generator) * scale);
+            particles[idxPart].indexInFile = app.global().processId() * nbParticlesPerProc + idxPart;
+        }
+        return particles;
+    }
+
+    /** Distribute the particles and return the cost of the local leaves with the model n^2 */
+    double distribute(FAbstractBalanceAlgorithm* balancer, FSize* nbLocalParticles, double* maxLeafCost){
+        std::vector<TestParticle> particles = generateParticles();
+        FVector<TestParticle> finalParticles;
+        FMpiTreeBuilder<FReal, TestParticle>::DistributeArrayToContainer(app.global(), particles.data(), FSize(particles.size()),
+                                                                          boxCenter, boxWidth, TreeHeight, &finalParticles, balancer);
+
+        std::map<MortonIndex, FSize> particlesPerLeaf;
+        for(FSize idxPart = 0 ; idxPart < finalParticles.getSize() ; ++idxPart){
+            particlesPerLeaf[getLeafIndex(finalParticles[idxPart].position)] += 1;
+        }
+        double localCost = 0;
+        double localMaxLeafCost = 0;
+        for(const auto& leaf : particlesPerLeaf){
+            const double leafCost = double(leaf.second) * double(leaf.second);
+            localCost += leafCost;
+            localMaxLeafCost = FMath::Max(localMaxLeafCost, leafCost);
+        }
+        (*nbLocalParticles) = finalParticles.getSize();
+        nbLocalLeaves = FSize(particlesPerLeaf.size());
+        MPI_Allreduce(&localMaxLeafCost, maxLeafCost, 1, MPI_DOUBLE, MPI_MAX, app.global().getComm());
+        return localCost;
+    }
+
+    void TestCostBalance(){
+        boxCenter = FPoint<FReal>(0.5, 0.5, 0.5);
+        boxWidth = 1.0;
+        nbParticlesPerProc = 2000;
+        const int nbProcs = app.global().processCount();
+
+        FSize nbParticlesLeaf, nbParticlesCost;
+        double maxLeafCost;
+
+        FLeafBalance leafBalancer;
+        const double localCostLeaf = distribute(&leafBalancer, &nbParticlesLeaf, &maxLeafCost);
+
+        FCostBalance costBalancer(app.global(), FCostBalance::ModelCost(1.0));
+        const double localCostCost = distribute(&costBalancer, &nbParticlesCost, &maxLeafCost);
+
+        // No particle lost
+        FSize totalParticles = 0;
+        MPI_Allreduce(&nbParticlesCost, &totalParticles, 1, FMpi::GetType(totalParticles), MPI_SUM, app.global().getComm());
+        uassert(totalParticles == nbParticlesPerProc * nbProcs);
+
+        double maxCostLeaf, maxCostCost, totalCost;
+        MPI_Allreduce(&localCostLeaf, &maxCostLeaf, 1, MPI_DOUBLE, MPI_MAX, app.global().getComm());
+        MPI_Allreduce(&localCostCost, &maxCostCost, 1, MPI_DOUBLE, MPI_MAX, app.global().getComm());
+        MPI_Allreduce(&localCostCost, &totalCost, 1, MPI_DOUBLE, MPI_SUM, app.global().getComm());
+
+        // A process cannot exceed the average by more than one leaf
+        uassert(maxCostCost <= totalCost / nbProcs + maxLeafCost);
+        uassert(maxCostCost <= maxCostLeaf);
+        uassert(FMath::LookEqual(costBalancer.getImbalance(), maxCostCost / (totalCost / nbProcs)));
+    }
+
+    /** With the same cost for every leaf each process gets the same number of leaves */
+    void TestConstantCost(){
+        boxCenter = FPoint<FReal>(0.5, 0.5, 0.5);
+        boxWidth = 1.0;
+        nbParticlesPerProc = 1000;
+
+        FSize nbParticles;
+        double maxLeafCost;
+
+        FCostBalance costBalancer(app.global(), FCostBalance::ModelCost(0, 0, 1.0));
+        distribute(&costBalancer, &nbParticles, &maxLeafCost);
+
+        FSize totalNbLeaves = 0;
+        MPI_Allreduce(&nbLocalLeaves, &totalNbLeaves, 1, FMpi::GetType(totalNbLeaves), MPI_SUM, app.global().getComm());
+        const double averageNbLeaves = double(totalNbLeaves) / double(app.global().processCount());
+        uassert(FMath::Abs(double(nbLocalLeaves) - averageNbLeaves) <= 1.0);
+        uassert(costBalancer.getImbalance() <= (averageNbLeaves + 1.0) / averageNbLeaves);
+    }
+
+    void SetTests(){
+        AddTest(&TestMpiCostBalance::TestCostBalance,"Balance the cost n^2 of the leaves");
+        AddTest(&TestMpiCostBalance::TestConstantCost,"Constant cost divides the leaves");
+    }
+
+public:
+    TestMpiCostBalance(int argc,char ** argv) : FUTesterMpi(argc,argv){
+    }
+};
+
+TestClassMpi(TestMpiCostBalance);
@@ -0,0 +1,181 @@
+// See LICENCE file at project root
+#ifndef UTESTMPIRADIXSORT_HPP
+#define UTESTMPIRADIXSORT_HPP
+
+#include "Utils/FGlobal.hpp"
+#include "FUTester.hpp"
+
+#include "Utils/FMpi.hpp"
+#include "Utils/FRadixSortMpi.hpp"
+
+#include <memory>
+#include <random>
+#include <vector>
+#include <cstdint>
+
+// ==== CMAKE =====
+// @FUSE_MPI
+// ================
+
+/** this class test the mpi radix sort */
+class TestMpiRadixSort : public FUTesterMpi<TestMpiRadixSort> {
+    /** A key with a value to check the stability */
+    struct KeyValue {
+        long long key;
+        long long value;
+        operator long long() const {
+            return key;
+        }
+    };
+
+    typedef FRadixSortMpi<KeyValue, long long, FSize> SorterClass;
+
+    ////////////////////////////////////////////////////////////
+    /// Check function
+    ////////////////////////////////////////////////////////////
+
+    /** Sort the elements of each process and check the order, the balance and that nothing is lost */
+    void SortAndCheck(const std::vector<KeyValue>& elements){
+        const int myRank = app.global().processId();
+        const int nbProcess = app.global().processCount();
+
+        KeyValue* sorted = nullptr;
+        FSize nbSorted = 0;
+        SorterClass::SortMpi(elements.data(), FSize(elements.size()), &sorted, &nbSorted, app.global());
+        std::unique_ptr<KeyValue[]> sortedDeleter(sorted);
+
+        // Locally sorted
+        for(FSize idx = 1 ; idx < nbSorted ; ++idx){
+            uassert(sorted[idx-1].key <= sorted[idx].key);
+        }
+
+        // Exactly balanced
+        const long long localSize = (long long)(elements.size());
+        long long totalSize = 0;
+        MPI_Allreduce(&localSize, &totalSize, 1, MPI_LONG_LONG, MPI_SUM, app.global().getComm());
+        const long long expectedSize = (totalSize * (myRank + 1)) / nbProcess - (totalSize * myRank) / nbProcess;
+        uassert(nbSorted == expectedSize);
+
+        // Globally sorted
+        std::vector<long long> bounds(2 * nbProcess);
+        const long long myBounds[2] = { nbSorted ? sorted[0].key : -1, nbSorted ? sorted[nbSorted-1].key : -1 };
+        MPI_Allgather(myBounds, 2, MPI_LONG_LONG, bounds.data(), 2, MPI_LONG_LONG, app.global().getComm());
+        long long previousKey = -1;
+        for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+            if(bounds[2*idxProc] != -1){
+                uassert(previousKey <= bounds[2*idxProc]);
+                previousKey = bounds[2*idxProc+1];
+            }
+        }
+
+        // The same elements (sum of keys and values)
+        long long localSums[2] = {0, 0};
+        for(const KeyValue& element : elements){
+            localSums[0] += element.key;
+            localSums[1] += element.value;
+        }
+        long long sortedSums[2] = {0, 0};
+        for(FSize idx = 0 ; idx < nbSorted ; ++idx){
+            sortedSums[0] += sorted[idx].key;
+            sortedSums[1] += sorted[idx].value;
+        }
+        long long globalSums[2], globalSortedSums[2];
+        MPI_Allreduce(localSums, globalSums, 2, MPI_LONG_LONG, MPI_SUM, app.global().getComm());
+        MPI_Allreduce(sortedSums, globalSortedSums, 2, MPI_LONG_LONG, MPI_SUM, app.global().getComm());
+        uassert(globalSums[0] == globalSortedSums[0]);
+        uassert(globalSums[1] == globalSortedSums[1]);
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// The tests
+    ////////////////////////////////////////////////////////////
+
+    /** The local radix sort is stable */
+    void TestLocalSort(){
+        std::mt19937 generator(1);
+        std::uniform_int_distribution<long long> keys(0, 1000);
+        const FSize nbElements = 100000;
+        std::unique_ptr<KeyValue[]> elements(new KeyValue[nbElements]);
+        for(FSize idx = 0 ; idx < nbElements ; ++idx){
+            elements[idx].key = (keys(generator) << 40);
+            elements[idx].value = idx;
+        }
+        SorterClass::RadixSort(elements.get(), nbElements);
+        for(FSize idx = 1 ; idx < nbElements ; ++idx){
+            uassert(elements[idx-1].key < elements[idx].key
+                    || (elements[idx-1].key == elements[idx].key && elements[idx-1].value < elements[idx].value));
+        }
+    }
+
+    /** Uniform Morton indexes of height 21 */
+    void TestUniform(){
+        std::mt19937 generator(app.global().processId());
+        std::uniform_int_distribution<long long> keys(0, (1LL << 60) - 1);
+        std::vector<KeyValue> elements(10000 + 100 * app.global().processId());
+        for(KeyValue& element : elements){
+            element.key = keys(generator);
+            element.value = keys(generator) % 1000;
+        }
+        SortAndCheck(elements);
+    }
+
+    /** Most of the keys in a small range and many equal keys */
+    void TestClustered(){
+        std::mt19937 generator(app.global().processId());
+        std::uniform_int_distribution<long long> keys(0, (1LL << 60) - 1);
+        std::uniform_int_distribution<long long> clusterKeys(1000, 1010);
+        std::vector<KeyValue> elements(5000);
+        for(size_t idx = 0 ; idx < elements.size() ; ++idx){
+            elements[idx].key = (idx % 10 ? clusterKeys(generator) : keys(generator));
+            elements[idx].value = 1;
+        }
+        SortAndCheck(elements);
+    }
+
+    /** All the keys are the same */
+    void TestSameKey(){
+        std::vector<KeyValue> elements(777);
+        for(size_t idx = 0 ; idx < elements.size() ; ++idx){
+            elements[idx].key = 42;
+            elements[idx].value = (long long)(idx);
+        }
+        SortAndCheck(elements);
+    }
+
+    /** Only the last process has elements */
+    void TestOneProcess(){
+        std::vector<KeyValue> elements;
+        if(app.global().processId() == app.global().processCount() - 1){
+            for(long long idx = 0 ; idx < 1000 ; ++idx){
+                elements.push_back(KeyValue{1000 - idx, idx});
+            }
+        }
+        SortAndCheck(elements);
+    }
+
+    /** Less elements than processes */
+    void TestTinySort(){
+        std::vector<KeyValue> elements;
+        if(app.global().processId() == 0){
+            elements.push_back(KeyValue{7, 1});
+            elements.push_back(KeyValue{3, 2});
+        }
+        SortAndCheck(elements);
+    }
+
+    void SetTests(){
+        AddTest(&TestMpiRadixSort::TestLocalSort,"Local radix sort");
+        AddTest(&TestMpiRadixSort::TestUniform,"Uniform keys");
+        AddTest(&TestMpiRadixSort::TestClustered,"Clustered keys");
+        AddTest(&TestMpiRadixSort::TestSameKey,"Same key everywhere");
+        AddTest(&TestMpiRadixSort::TestOneProcess,"All the elements on one process");
+        AddTest(&TestMpiRadixSort::TestTinySort,"Less elements than processes");
+    }
+public:
+    TestMpiRadixSort(int argc,char ** argv) : FUTesterMpi(argc,argv){
+    }
+};
+
+TestClassMpi(TestMpiRadixSort)
+
+#endif // UTESTMPIRADIXSORT_HPP
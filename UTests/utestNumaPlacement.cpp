@@ -0,0 +1,115 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Containers/FBlockAllocator.hpp"
+#include "Containers/FNumaPlacement.hpp"
+#include "Components/FSimpleLeaf.hpp"
+
+#include "Components/FTestParticleContainer.hpp"
+#include "Components/FTestCell.hpp"
+#include "Components/FTestKernels.hpp"
+
+#include "Core/FFmmAlgorithmThread.hpp"
+
+#include "Files/FRandomLoader.hpp"
+
+/**
+  In this test we place a tree with FNumaPlacement, the reports must
+  cover the memory of the tree, and the FMM must work with all the
+  schedules (static is the one of the placement).
+  */
+
+/** this class test the NUMA placement of a tree */
+class TestNumaPlacement : public FUTester<TestNumaPlacement> {
+    typedef double FReal;
+    typedef FTestCell                   CellClass;
+    typedef FTestParticleContainer<FReal>      ContainerClass;
+
+    typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+    typedef FOctree<FReal, CellClass, ContainerClass , LeafClass, FArenaBlockAllocator<CellClass> >  OctreeClass;
+    typedef FTestKernels< CellClass, ContainerClass >         KernelClass;
+    typedef FNumaPlacement<OctreeClass, ContainerClass>       PlacementClass;
+
+    void fill(OctreeClass* tree, const FSize nbParticles){
+        FRandomLoader<FReal> loader(nbParticles, 1, FPoint<FReal>(0.5,0.5,0.5), 1);
+        for(FSize idxPart = 0 ; idxPart < loader.getNumberOfParticles() ; ++idxPart){
+            FPoint<FReal> particlePosition;
+            loader.fillParticle(&particlePosition);
+            if(idxPart % 2){
+                particlePosition = particlePosition * FReal(0.2);
+            }
+            tree->insert(particlePosition);
+        }
+    }
+
+    /** The reports count all the pages of the tree */
+    void TestReport(){
+        uassert(PlacementClass::BindThreads() != 0);
+        // Each thread runs on one proc
+        #pragma omp parallel
+        {
+            uassert(FBinding::GetThreadBinding() != -1);
+        }
+
+        OctreeClass tree(6, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        fill(&tree, 20000);
+
+        PlacementClass placement;
+        placement.place(&tree);
+        uassert(placement.getParticlesArena().getNbParticles() == 20000);
+
+        const PlacementClass::PageReport particlesReport = placement.getParticlesReport(&tree);
+        const PlacementClass::PageReport cellsReport = placement.getCellsReport(&tree);
+        // The particles are contiguous, there are at least as many pages as needed for the positions
+        const FSize particlesPages = particlesReport.localPages + particlesReport.remotePages + particlesReport.unknownPages;
+        uassert(particlesPages * FSize(sysconf(_SC_PAGESIZE)) >= FSize(20000 * 3 * sizeof(FReal)));
+        uassert(cellsReport.localPages + cellsReport.remotePages + cellsReport.unknownPages != 0);
+        uassert(0 <= particlesReport.getLocalRatio() && particlesReport.getLocalRatio() <= 1);
+
+        // With a single node all the known pages are local
+        if(FBinding::GetCurrentNumaNode() == 0 && access("/sys/devices/system/node/node1", F_OK) != 0){
+            uassert(particlesReport.remotePages == 0);
+            uassert(cellsReport.remotePages == 0);
+        }
+    }
+
+    /** Each particle must interact with all the others, with each chunk size and each placement order */
+    void TestFmm(){
+        const FSize nbParticles = 2000;
+        const int chunkSizes[3] = {-1, 0, 10};
+        const FSpaceFillingCurve curves[2] = {FSpaceFillingCurve::Morton, FSpaceFillingCurve::Hilbert};
+        for(const int chunkSize : chunkSizes){
+            for(const FSpaceFillingCurve curve : curves){
+                OctreeClass tree(5, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+                fill(&tree, nbParticles);
+                PlacementClass placement(curve);
+                placement.place(&tree);
+
+                KernelClass kernels;
+                FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass> algo(&tree, &kernels, chunkSize);
+                algo.execute();
+
+                FSize nbChecked = 0;
+                tree.forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+                    uassert(cell->getMultipoleData().get() == leaf->getSrc()->getNbParticles());
+                    const long long int* dataDown = leaf->getTargets()->getDataDown();
+                    for(FSize idxPart = 0 ; idxPart < leaf->getTargets()->getNbParticles() ; ++idxPart){
+                        uassert(dataDown[idxPart] == nbParticles - 1);
+                    }
+                    nbChecked += leaf->getTargets()->getNbParticles();
+                });
+                uassert(nbChecked == nbParticles);
+            }
+        }
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestNumaPlacement::TestReport,"Place a tree and report the pages");
+        AddTest(&TestNumaPlacement::TestFmm,"FMM with the static schedule and the Hilbert placement");
+    }
+};
+
+// You must do this
+TestClass(TestNumaPlacement)
@@ -0,0 +1,207 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Utils/FOutOfCoreMemory.hpp"
+
+#include "GroupTree/Core/FGroupTree.hpp"
+#include "GroupTree/Core/FGroupTaskAlgorithm.hpp"
+#include "GroupTree/TestKernel/FGroupTestParticleContainer.hpp"
+
+#include "Components/FTestParticleContainer.hpp"
+#include "Components/FTestCell.hpp"
+#include "Components/FSymbolicData.hpp"
+#include "Components/FTestKernels.hpp"
+
+#include "Files/FRandomLoader.hpp"
+
+#include <vector>
+
+/**
+  In this test the blocks are allocated in a file with a small resident
+  limit, the data must be the same after the blocks have been released
+  and the group tree FMM must give the exact result.
+  */
+
+/** this class test the out of core storage */
+class TestOutOfCore : public FUTester<TestOutOfCore> {
+    typedef double FReal;
+
+    /** The blocks keep their data after they have been evicted */
+    void TestStorage(){
+        const std::size_t blockSize = 3 * 4096 + 100;
+        const int nbBlocks = 16;
+        FOutOfCoreMemory storage("/tmp", 4 * blockSize);
+
+        std::vector<int*> blocks(nbBlocks);
+        for(int idxBlock = 0 ; idxBlock < nbBlocks ; ++idxBlock){
+            blocks[idxBlock] = reinterpret_cast<int*>(storage.allocate(blockSize));
+            uassert(blocks[idxBlock] != nullptr);
+            uassert(storage.owns(blocks[idxBlock]));
+            for(std::size_t idx = 0 ; idx < blockSize / sizeof(int) ; ++idx){
+                uassert(blocks[idxBlock][idx] == 0);
+                blocks[idxBlock][idx] = int(idx) * nbBlocks + idxBlock;
+            }
+        }
+        // Only the last blocks stay resident
+        FOutOfCoreMemory::Stats stats = storage.getStats();
+        uassert(stats.residentBytes <= storage.getResidentLimit());
+        uassert(stats.nbEvictions != 0);
+        uassert(stats.mappedBytes >= nbBlocks * blockSize);
+        // All the blocks are in the first arena
+        uassert(stats.nbMappings == 1);
+
+        for(int idxBlock = 0 ; idxBlock < nbBlocks ; ++idxBlock){
+            storage.prefetch(blocks[idxBlock] + 10);
+            for(std::size_t idx = 0 ; idx < blockSize / sizeof(int) ; ++idx){
+                uassert(blocks[idxBlock][idx] == int(idx) * nbBlocks + idxBlock);
+            }
+        }
+        stats = storage.getStats();
+        uassert(stats.residentBytes <= storage.getResidentLimit());
+        uassert(stats.nbPrefetches == std::size_t(nbBlocks));
+
+        // The file is reused after a free
+        const std::size_t fileBytes = stats.fileBytes;
+        uassert(storage.deallocate(blocks[3]));
+        uassert(!storage.deallocate(blocks[3]));
+        uassert(!storage.owns(blocks[3]));
+        int* newBlock = reinterpret_cast<int*>(storage.allocate(blockSize));
+        uassert(newBlock != nullptr);
+        for(std::size_t idx = 0 ; idx < blockSize / sizeof(int) ; ++idx){
+            uassert(newBlock[idx] == 0);
+        }
+        uassert(storage.getStats().fileBytes == fileBytes);
+
+        // Memory that is not from the storage is ignored
+        int notOwned = 0;
+        uassert(!storage.owns(&notOwned));
+        storage.prefetch(&notOwned);
+        uassert(!storage.deallocate(&notOwned));
+    }
+
+    /** The blocks are carved out of few arenas, a large block gets its own one */
+    void TestArenas(){
+        const std::size_t blockSize = 4096 + 100;
+        const int nbBlocks = 100;
+        // Five blocks (of two pages) per arena
+        FOutOfCoreMemory storage("/tmp", 8 * blockSize, 10 * 4096);
+
+        std::vector<int*> blocks(nbBlocks);
+        for(int idxBlock = 0 ; idxBlock < nbBlocks ; ++idxBlock){
+            blocks[idxBlock] = reinterpret_cast<int*>(storage.allocate(blockSize));
+            uassert(blocks[idxBlock] != nullptr);
+            for(std::size_t idx = 0 ; idx < blockSize / sizeof(int) ; ++idx){
+                uassert(blocks[idxBlock][idx] == 0);
+                blocks[idxBlock][idx] = int(idx) * nbBlocks + idxBlock;
+            }
+        }
+        uassert(storage.getStats().nbMappings == std::size_t(nbBlocks / 5));
+        uassert(storage.getStats().nbEvictions != 0);
+
+        const std::size_t largeSize = 25 * 4096;
+        int* largeBlock = reinterpret_cast<int*>(storage.allocate(largeSize));
+        uassert(largeBlock != nullptr);
+        uassert(storage.owns(largeBlock + largeSize / sizeof(int) - 1));
+        for(std::size_t idx = 0 ; idx < largeSize / sizeof(int) ; ++idx){
+            largeBlock[idx] = int(idx);
+        }
+        uassert(storage.getStats().nbMappings == std::size_t(nbBlocks / 5) + 1);
+
+        // A freed block is set to zero for the next one in its place
+        for(int idxBlock = 0 ; idxBlock < nbBlocks ; idxBlock += 2){
+            uassert(storage.deallocate(blocks[idxBlock]));
+        }
+        for(int idxBlock = 0 ; idxBlock < nbBlocks ; idxBlock += 2){
+            blocks[idxBlock] = reinterpret_cast<int*>(storage.allocate(blockSize));
+            uassert(blocks[idxBlock] != nullptr);
+            for(std::size_t idx = 0 ; idx < blockSize / sizeof(int) ; ++idx){
+                uassert(blocks[idxBlock][idx] == 0);
+                blocks[idxBlock][idx] = int(idx) * nbBlocks + idxBlock;
+            }
+        }
+        uassert(storage.getStats().nbMappings == std::size_t(nbBlocks / 5) + 1);
+
+        for(int idxBlock = 0 ; idxBlock < nbBlocks ; ++idxBlock){
+            storage.prefetch(blocks[idxBlock]);
+            for(std::size_t idx = 0 ; idx < blockSize / sizeof(int) ; ++idx){
+                uassert(blocks[idxBlock][idx] == int(idx) * nbBlocks + idxBlock);
+            }
+        }
+        for(std::size_t idx = 0 ; idx < largeSize / sizeof(int) ; ++idx){
+            uassert(largeBlock[idx] == int(idx));
+        }
+        uassert(storage.getStats().residentBytes <= storage.getResidentLimit());
+    }
+
+    /** Each particle must interact with all the others with an out of core group tree */
+    void TestGroupFmm(){
+        using GroupCellClass     = FTestCell;
+        using GroupCellUpClass   = typename FTestCell::multipole_t;
+        using GroupCellDownClass = typename FTestCell::local_expansion_t;
+        using GroupCellSymbClass = FSymbolicData;
+
+        typedef FGroupTestParticleContainer<FReal>                                GroupContainerClass;
+        typedef FGroupTree< FReal, GroupCellSymbClass, GroupCellUpClass, GroupCellDownClass,
+                GroupContainerClass, 0, 1, long long int>  GroupOctreeClass;
+        typedef FTestKernels< GroupCellClass, GroupContainerClass >  GroupKernelClass;
+        typedef FGroupTaskAlgorithm<GroupOctreeClass, typename GroupOctreeClass::CellGroupClass, GroupKernelClass,
+                typename GroupOctreeClass::ParticleGroupClass, GroupContainerClass > GroupAlgorithm;
+
+        // Far less than the size of the tree
+        FOutOfCoreMemory*const storage = FOutOfCoreMemory::EnableGlobal("/tmp", 256 * 1024);
+        uassert(storage == FOutOfCoreMemory::Global());
+
+        const FSize nbParticles = 20000;
+        FRandomLoader<FReal> loader(nbParticles, 1.0, FPoint<FReal>(0,0,0), 0);
+        FTestParticleContainer<FReal> allParticles;
+        for(FSize idxPart = 0 ; idxPart < loader.getNumberOfParticles() ; ++idxPart){
+            FPoint<FReal> particlePosition;
+            loader.fillParticle(&particlePosition);
+            allParticles.push(particlePosition);
+        }
+
+        {
+            GroupOctreeClass groupedTree(5, loader.getBoxWidth(), loader.getCenterOfBox(), 50, &allParticles, false, true, 0.2);
+            uassert(storage->getStats().mappedBytes > storage->getResidentLimit());
+
+            GroupKernelClass groupkernel;
+            GroupAlgorithm groupalgo(&groupedTree, &groupkernel);
+            groupalgo.execute();
+
+            const FOutOfCoreMemory::Stats stats = storage->getStats();
+            uassert(stats.nbPrefetches != 0);
+            uassert(stats.nbEvictions != 0);
+            uassert(stats.residentBytes <= storage->getResidentLimit());
+            // All the blocks are in the file
+            uassert(stats.nbFallbacks == 0);
+
+            FSize nbChecked = 0;
+            groupedTree.forEachCellLeaf<GroupContainerClass>(
+                [&](GroupCellSymbClass* /*gsymb*/,
+                    GroupCellUpClass* gmul,
+                    GroupCellDownClass* /*gloc*/,
+                    GroupContainerClass* leaf)
+                {
+                    uassert(gmul->get() == leaf->getNbParticles());
+                    const long long int* dataDown = leaf->getDataDown();
+                    for(FSize idxPart = 0 ; idxPart < leaf->getNbParticles() ; ++idxPart){
+                        uassert(dataDown[idxPart] == nbParticles - 1);
+                    }
+                    nbChecked += leaf->getNbParticles();
+                });
+            uassert(nbChecked == nbParticles);
+        }
+        // All the blocks have been given back
+        uassert(storage->getStats().mappedBytes == 0);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestOutOfCore::TestStorage,"Allocate, evict and reuse blocks");
+        AddTest(&TestOutOfCore::TestArenas,"Allocate the blocks in arenas");
+        AddTest(&TestOutOfCore::TestGroupFmm,"FMM with an out of core group tree");
+    }
+};
+
+// You must do this
+TestClass(TestOutOfCore)
@@ -0,0 +1,133 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Components/FSimpleLeaf.hpp"
+
+#include "Kernels/Rotation/FRotationCell.hpp"
+#include "Kernels/Rotation/FRotationKernel.hpp"
+#include "Kernels/P2P/FP2PParticleContainerIndexed.hpp"
+
+#include "Core/FFmmAlgorithmThread.hpp"
+
+#include "Files/FRandomLoader.hpp"
+
+#include <omp.h>
+#include <vector>
+
+/**
+  In this test two neighbor leaves contain most of the particles, their
+  P2P is split in tasks (with a low threshold) and the potentials and the
+  forces must be the ones of the P2P computed without splitting.
+  */
+
+/** this class test the split of the heavy leaves P2P */
+class TestP2PSplit : public FUTester<TestP2PSplit> {
+    typedef double FReal;
+    static const int P = 4;
+    typedef FRotationCell<FReal,P>               CellClass;
+    typedef FP2PParticleContainerIndexed<FReal>  ContainerClass;
+    typedef FRotationKernel<FReal, CellClass, ContainerClass, P > KernelClass;
+    typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+    typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+    typedef FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass > FmmClass;
+
+    static const int NbLevels = 4;
+
+    /** The potential and the forces of each particle (by index) */
+    struct Result {
+        FReal potential;
+        FReal forces[3];
+    };
+
+    /** Build a tree, run the given operations and return the results by index */
+    std::vector<Result> run(const std::vector<FPoint<FReal>>& positions, const FReal boxWidth,
+                            const FPoint<FReal>& center, const double splitRatio, const unsigned operations){
+        OctreeClass tree(NbLevels, 2, boxWidth, center);
+        for(FSize idxPart = 0 ; idxPart < FSize(positions.size()) ; ++idxPart){
+            tree.insert(positions[idxPart], idxPart, FReal(0.1) + FReal(idxPart % 7) * FReal(0.1));
+        }
+
+        KernelClass kernels(NbLevels, boxWidth, center);
+        FmmClass algo(&tree, &kernels);
+        algo.setP2PLeafSplitting(splitRatio, 64);
+        algo.execute(operations);
+
+        std::vector<Result> results(positions.size());
+        tree.forEachLeaf([&](LeafClass* leaf){
+            const ContainerClass* targets = leaf->getTargets();
+            const FVector<FSize>& indexes = targets->getIndexes();
+            for(FSize idxPart = 0 ; idxPart < targets->getNbParticles() ; ++idxPart){
+                Result& result = results[indexes[idxPart]];
+                result.potential = targets->getPotentials()[idxPart];
+                result.forces[0] = targets->getForcesX()[idxPart];
+                result.forces[1] = targets->getForcesY()[idxPart];
+                result.forces[2] = targets->getForcesZ()[idxPart];
+            }
+        });
+        return results;
+    }
+
+    /** Compare the results with and without splitting */
+    void compare(const unsigned operations){
+        const FReal boxWidth = 1.0;
+        const FPoint<FReal> center(0.5, 0.5, 0.5);
+        const FReal leafWidth = boxWidth / FReal(1 << (NbLevels-1));
+
+        std::vector<FPoint<FReal>> positions;
+        FRandomLoader<FReal> loader(4000, boxWidth, center, 1);
+        for(FSize idxPart = 0 ; idxPart < loader.getNumberOfParticles() ; ++idxPart){
+            FPoint<FReal> position;
+            loader.fillParticle(&position);
+            // Half of the particles in two neighbor leaves
+            if(idxPart % 4 == 0){
+                position = FPoint<FReal>(FReal(3) * leafWidth + position.getX() * leafWidth,
+                                         FReal(3) * leafWidth + position.getY() * leafWidth,
+                                         FReal(3) * leafWidth + position.getZ() * leafWidth);
+            }
+            else if(idxPart % 4 == 1){
+                position = FPoint<FReal>(FReal(4) * leafWidth + position.getX() * leafWidth,
+                                         FReal(3) * leafWidth + position.getY() * leafWidth,
+                                         FReal(3) * leafWidth + position.getZ() * leafWidth);
+            }
+            positions.push_back(position);
+        }
+
+        const std::vector<Result> reference = run(positions, boxWidth, center, 0, operations);
+        const std::vector<Result> split = run(positions, boxWidth, center, 0.01, operations);
+
+        FMath::FAccurater<FReal> potentialDiff, forcesDiff;
+        for(std::size_t idxPart = 0 ; idxPart < positions.size() ; ++idxPart){
+            potentialDiff.add(reference[idxPart].potential, split[idxPart].potential);
+            for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                forcesDiff.add(reference[idxPart].forces[idxDim], split[idxPart].forces[idxDim]);
+            }
+        }
+        uassert(potentialDiff.getRelativeInfNorm() < 1e-12);
+        uassert(forcesDiff.getRelativeInfNorm() < 1e-12);
+    }
+
+    /** The near field only */
+    void TestP2P(){
+        compare(FFmmP2P);
+    }
+
+    /** The complete FMM */
+    void TestFmm(){
+        compare(FFmmNearAndFarFields);
+    }
+
+    void PreTest(){
+        // The splitting needs several threads
+        omp_set_num_threads(4);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestP2PSplit::TestP2P,"Split the P2P of two neighbor heavy leaves");
+        AddTest(&TestP2PSplit::TestFmm,"FMM with the split P2P");
+    }
+};
+
+// You must do this
+TestClass(TestP2PSplit)
@@ -0,0 +1,177 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Containers/FParticleArena.hpp"
+#include "Components/FSimpleLeaf.hpp"
+
+#include "Components/FTestParticleContainer.hpp"
+#include "Components/FTestCell.hpp"
+#include "Components/FTestKernels.hpp"
+
+#include "Core/FFmmAlgorithmThread.hpp"
+
+#include "Files/FRandomLoader.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+  In this test we compact the particles of a tree in an arena, the leaves
+  must be side by side in Morton order with the same particles, and the
+  FMM must give the right number of interactions.
+  */
+
+/** this class test the particle arena */
+class TestParticleArena : public FUTester<TestParticleArena> {
+    typedef double FReal;
+    typedef FTestCell                   CellClass;
+    typedef FTestParticleContainer<FReal>      ContainerClass;
+
+    typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+    typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+    typedef FTestKernels< CellClass, ContainerClass >         KernelClass;
+    typedef FParticleArena<ContainerClass>                    ArenaClass;
+
+    static const int NbLevels = 5;
+
+    void fill(OctreeClass* tree, const FSize nbParticles){
+        // Clustered, to have leaves with very different sizes
+        FRandomLoader<FReal> loader(nbParticles, 1, FPoint<FReal>(0.5,0.5,0.5), 1);
+        for(FSize idxPart = 0 ; idxPart < loader.getNumberOfParticles() ; ++idxPart){
+            FPoint<FReal> particlePosition;
+            loader.fillParticle(&particlePosition);
+            if(idxPart % 2){
+                particlePosition = particlePosition * FReal(0.2);
+            }
+            tree->insert(particlePosition);
+        }
+    }
+
+    /** The positions of the particles in Morton order */
+    std::vector<FReal> getPositions(OctreeClass* tree){
+        std::vector<FReal> positions;
+        tree->forEachLeaf([&](LeafClass* leaf){
+            for(FSize idxPart = 0 ; idxPart < leaf->getSrc()->getNbParticles() ; ++idxPart){
+                for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                    positions.push_back(leaf->getSrc()->getPositions()[idxDim][idxPart]);
+                }
+            }
+        });
+        return positions;
+    }
+
+    /** The leaves are views in the arena, in Morton order and aligned */
+    void TestCompact(){
+        OctreeClass tree(NbLevels, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        fill(&tree, 3000);
+        const std::vector<FReal> positionsBefore = getPositions(&tree);
+
+        ArenaClass arena;
+        arena.compact(&tree);
+        uassert(arena.getNbParticles() == 3000);
+        uassert(arena.getCapacity() % ArenaClass::ViewGranularity == 0);
+
+        FSize idxView = 0;
+        tree.forEachLeaf([&](LeafClass* leaf){
+            ContainerClass* particles = leaf->getSrc();
+            uassert(particles->has_external_storage());
+            uassert(arena.getViewSize(idxView) == particles->getNbParticles());
+            // Each array of the container is in the array of the arena
+            uassert(particles->getPositions()[0] == std::get<0>(arena.getArrays()) + arena.getViewOffset(idxView));
+            uassert(particles->getPositions()[2] == std::get<2>(arena.getArrays()) + arena.getViewOffset(idxView));
+            uassert(particles->getDataDown() == std::get<3>(arena.getArrays()) + arena.getViewOffset(idxView));
+            uassert(reinterpret_cast<std::uintptr_t>(particles->getPositions()[1]) % FP2PDefaultAlignement == 0);
+            uassert(reinterpret_cast<std::uintptr_t>(particles->getDataDown()) % FP2PDefaultAlignement == 0);
+            // The padding is set to zero
+            for(FSize idxPart = particles->getNbParticles() ; idxPart < FSize(particles->capacity()) ; ++idxPart){
+                uassert(particles->getPositions()[0][idxPart] == 0);
+                uassert(particles->getDataDown()[idxPart] == 0);
+            }
+            idxView += 1;
+        });
+        uassert(idxView == arena.getNbViews());
+        // The views follow each other
+        for(FSize idx = 1 ; idx < arena.getNbViews() ; ++idx){
+            uassert(arena.getViewOffset(idx) - arena.getViewOffset(idx-1) >= arena.getViewSize(idx-1));
+            uassert(arena.getViewOffset(idx) - arena.getViewOffset(idx-1) < arena.getViewSize(idx-1) + ArenaClass::ViewGranularity);
+        }
+
+        uassert(getPositions(&tree) == positionsBefore);
+    }
+
+    /** A container that grows leaves the arena, the arena can be destroyed before the tree */
+    void TestGrowAndRelease(){
+        OctreeClass tree(NbLevels, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        fill(&tree, 1000);
+        {
+            ArenaClass arena;
+            arena.compact(&tree);
+            // Compact twice, the containers move in the new block
+            arena.compact(&tree);
+            uassert(arena.getNbParticles() == 1000);
+        }
+
+        const std::vector<FReal> positionsBefore = getPositions(&tree);
+        OctreeClass::Iterator octreeIterator(&tree);
+        octreeIterator.gotoBottomLeft();
+        ContainerClass* particles = octreeIterator.getCurrentListSrc();
+        const FSize nbParticles = particles->getNbParticles();
+        // The padding of the view is used first, then the container reallocates
+        const FPoint<FReal> position(particles->getPositions()[0][0],
+                                     particles->getPositions()[1][0],
+                                     particles->getPositions()[2][0]);
+        for(FSize idxInsert = 0 ; idxInsert <= ArenaClass::ViewGranularity && particles->has_external_storage() ; ++idxInsert){
+            tree.insert(position);
+        }
+        uassert(particles->has_external_storage() == false);
+        uassert(particles->getNbParticles() > nbParticles);
+
+        // The other leaves are still valid
+        FSize nbLeaves = 0;
+        FSize nbInArena = 0;
+        tree.forEachLeaf([&](LeafClass* leaf){
+            nbLeaves += 1;
+            nbInArena += (leaf->getSrc()->has_external_storage() ? 1 : 0);
+        });
+        uassert(nbInArena == nbLeaves - 1);
+        const std::vector<FReal> positionsAfter = getPositions(&tree);
+        uassert(std::equal(positionsBefore.begin()+3*nbParticles, positionsBefore.end(),
+                           positionsAfter.begin()+3*particles->getNbParticles()));
+    }
+
+    /** Each particle must interact with all the others */
+    void TestFmm(){
+        const FSize nbParticles = 2000;
+        OctreeClass tree(NbLevels, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        fill(&tree, nbParticles);
+
+        ArenaClass arena;
+        arena.compact(&tree);
+
+        KernelClass kernels;
+        FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass> algo(&tree, &kernels);
+        algo.execute();
+
+        FSize nbChecked = 0;
+        tree.forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+            uassert(cell->getMultipoleData().get() == leaf->getSrc()->getNbParticles());
+            const long long int* dataDown = leaf->getTargets()->getDataDown();
+            for(FSize idxPart = 0 ; idxPart < leaf->getTargets()->getNbParticles() ; ++idxPart){
+                uassert(dataDown[idxPart] == nbParticles - 1);
+            }
+            nbChecked += leaf->getTargets()->getNbParticles();
+        });
+        uassert(nbChecked == nbParticles);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestParticleArena::TestCompact,"Compact the leaves in the arena");
+        AddTest(&TestParticleArena::TestGrowAndRelease,"Grow a container and release the arena");
+        AddTest(&TestParticleArena::TestFmm,"FMM with the particles in the arena");
+    }
+};
+
+// You must do this
+TestClass(TestParticleArena)
@@ -0,0 +1,181 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Containers/FFlatOctree.hpp"
+#include "Components/FSimpleLeaf.hpp"
+#include "Components/FTypedLeaf.hpp"
+
+#include "Components/FTestParticleContainer.hpp"
+#include "Components/FTestCell.hpp"
+#include "Components/FBasicParticleContainer.hpp"
+
+#include "Files/FRandomLoader.hpp"
+#include "Files/FTreeBuilder.hpp"
+
+#include <vector>
+
+/**
+  In this test we build trees with FTreeBuilder and compare them with
+  the same trees filled with insert, the leaves, the cells and the
+  particles must be the same.
+  */
+
+/** this class test the bulk tree construction */
+class TestTreeBuilder : public FUTester<TestTreeBuilder> {
+    typedef double FReal;
+    typedef FTestCell                   CellClass;
+    typedef FBasicParticleContainer<FReal,1,FReal>      ContainerClass;
+
+    typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+    typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+
+    struct TestParticle{
+        FPoint<FReal> position;
+        FReal physicalValue;
+        const FPoint<FReal>& getPosition() const {
+            return position;
+        }
+    };
+
+    /** Clustered particles, to have groups of very different sizes */
+    std::vector<TestParticle> getParticles(const FSize nbParticles){
+        FRandomLoader<FReal> loader(nbParticles, 1, FPoint<FReal>(0.5,0.5,0.5), 1);
+        std::vector<TestParticle> particles(nbParticles);
+        for(FSize idxPart = 0 ; idxPart < nbParticles ; ++idxPart){
+            loader.fillParticle(&particles[idxPart].position);
+            if(idxPart % 3){
+                particles[idxPart].position = particles[idxPart].position * FReal(0.1);
+            }
+            particles[idxPart].physicalValue = FReal(idxPart);
+        }
+        return particles;
+    }
+
+    /** The trees have the same cells at all the levels and the same particles in the leaves */
+    template <class TreeClass, class OtherTreeClass>
+    void compareTrees(TreeClass* tree, OtherTreeClass* otherTree){
+        typename TreeClass::Iterator iterator(tree);
+        iterator.gotoBottomLeft();
+        typename OtherTreeClass::Iterator otherIterator(otherTree);
+        otherIterator.gotoBottomLeft();
+
+        // The leaves and the particles (in the insertion order of each leaf)
+        bool hasNext;
+        do{
+            uassert(iterator.getCurrentGlobalIndex() == otherIterator.getCurrentGlobalIndex());
+            const auto* particles = iterator.getCurrentListSrc();
+            const auto* otherParticles = otherIterator.getCurrentListSrc();
+            uassert(particles->getNbParticles() == otherParticles->getNbParticles());
+            for(FSize idxPart = 0 ; idxPart < FMath::Min(particles->getNbParticles(), otherParticles->getNbParticles()) ; ++idxPart){
+                uassert(particles->getPositions()[0][idxPart] == otherParticles->getPositions()[0][idxPart]);
+                uassert(particles->getAttribute(0)[idxPart] == otherParticles->getAttribute(0)[idxPart]);
+            }
+            hasNext = iterator.moveRight();
+            uassert(hasNext == otherIterator.moveRight());
+        } while(hasNext);
+
+        // The cells
+        for(int idxLevel = tree->getHeight() - 1 ; idxLevel >= 1 ; --idxLevel){
+            typename TreeClass::Iterator avoidGotoLeft(iterator);
+            typename OtherTreeClass::Iterator otherAvoidGotoLeft(otherIterator);
+            do{
+                uassert(iterator.getCurrentGlobalIndex() == otherIterator.getCurrentGlobalIndex());
+                uassert(iterator.getCurrentCell()->getMortonIndex() == iterator.getCurrentGlobalIndex());
+                uassert(iterator.getCurrentCell()->getLevel() == idxLevel);
+                uassert(iterator.getCurrentCell()->getCoordinate() == otherIterator.getCurrentCell()->getCoordinate());
+                hasNext = iterator.moveRight();
+                uassert(hasNext == otherIterator.moveRight());
+            } while(hasNext);
+            iterator = avoidGotoLeft;
+            iterator.gotoLeft();
+            otherIterator = otherAvoidGotoLeft;
+            otherIterator.gotoLeft();
+            if(idxLevel != 1){
+                iterator.moveUp();
+                otherIterator.moveUp();
+            }
+        }
+    }
+
+    /** Build from an array of particles, with different heights and sub-heights */
+    void TestFromParticles(){
+        std::vector<TestParticle> particles = getParticles(20000);
+        const int heights[4][2] = { {6, 1}, {6, 2}, {5, 4}, {8, 3} };
+        for(const auto& height : heights){
+            OctreeClass tree(height[0], height[1], 1.0, FPoint<FReal>(0.5,0.5,0.5));
+            FTreeBuilder<FReal, OctreeClass, LeafClass>::BuildTreeFromParticles(&tree, particles.data(), FSize(particles.size()),
+                    [](LeafClass* leaf, const TestParticle& particle){
+                leaf->push(particle.position, particle.physicalValue);
+            });
+
+            OctreeClass insertTree(height[0], height[1], 1.0, FPoint<FReal>(0.5,0.5,0.5));
+            for(const TestParticle& particle : particles){
+                insertTree.insert(particle.position, particle.physicalValue);
+            }
+            compareTrees(&tree, &insertTree);
+        }
+    }
+
+    /** Build from a container, and in a tree that already has particles */
+    void TestFromArray(){
+        std::vector<TestParticle> particles = getParticles(20000);
+        ContainerClass container;
+        for(const TestParticle& particle : particles){
+            container.push(particle.position, particle.physicalValue);
+        }
+
+        OctreeClass tree(7, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        OctreeClass insertTree(7, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        for(int idxBuild = 0 ; idxBuild < 2 ; ++idxBuild){
+            FTreeBuilder<FReal, OctreeClass, LeafClass>::BuildTreeFromArray(&tree, container);
+            for(const TestParticle& particle : particles){
+                insertTree.insert(particle.position, particle.physicalValue);
+            }
+        }
+        compareTrees(&tree, &insertTree);
+    }
+
+    /** Other tree and leaf types */
+    void TestOtherTypes(){
+        typedef FTypedLeaf<FReal, ContainerClass >                        TypedLeafClass;
+        typedef FOctree<FReal, CellClass, ContainerClass, TypedLeafClass > TypedOctreeClass;
+        typedef FFlatOctree<FReal, CellClass, ContainerClass, LeafClass >  FlatOctreeClass;
+
+        std::vector<TestParticle> particles = getParticles(5000);
+
+        TypedOctreeClass typedTree(6, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        FTreeBuilder<FReal, TypedOctreeClass, TypedLeafClass>::BuildTreeFromParticles(&typedTree, particles.data(), FSize(particles.size()),
+                [](TypedLeafClass* leaf, const TestParticle& particle){
+            leaf->push(particle.position, (particle.physicalValue < 2500 ? FParticleType::source : FParticleType::target),
+                       particle.physicalValue);
+        });
+        FSize nbSources = 0, nbTargets = 0;
+        typedTree.forEachLeaf([&](TypedLeafClass* leaf){
+            nbSources += leaf->getSrc()->getNbParticles();
+            nbTargets += leaf->getTargets()->getNbParticles();
+        });
+        uassert(nbSources == 2500 && nbTargets == 2500);
+
+        FlatOctreeClass flatTree(6, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        FTreeBuilder<FReal, FlatOctreeClass, LeafClass>::BuildTreeFromParticles(&flatTree, particles.data(), FSize(particles.size()),
+                [](LeafClass* leaf, const TestParticle& particle){
+            leaf->push(particle.position, particle.physicalValue);
+        });
+        OctreeClass insertTree(6, 2, 1.0, FPoint<FReal>(0.5,0.5,0.5));
+        for(const TestParticle& particle : particles){
+            insertTree.insert(particle.position, particle.physicalValue);
+        }
+        compareTrees(&flatTree, &insertTree);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestTreeBuilder::TestFromParticles,"Build from particles");
+        AddTest(&TestTreeBuilder::TestFromArray,"Build from a container");
+        AddTest(&TestTreeBuilder::TestOtherTypes,"Build with typed leaves and a flat tree");
+    }
+};
+
+// You must do this
+TestClass(TestTreeBuilder)
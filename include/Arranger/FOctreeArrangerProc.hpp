@@ -2,6 +2,12 @@
 #ifndef FOCTREEARRANGERPROC_HPP
 #define FOCTREEARRANGERPROC_HPP
 
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "../Utils/FGlobal.hpp"
 #include "../Containers/FVector.hpp"
 #include "../Utils/FAssert.hpp"
@@ -20,6 +26,14 @@
   * of the particles have been changed, then it may be better
   * to move the particles in the tree instead of building a new
   * tree.
+  *
+  * rearrange computes the intervals of the processes and exchanges the
+  * number of particles to send with all the processes at each call.
+  * migrate is made for the time stepping where few particles leave their
+  * interval : the intervals (the splitters) are kept between the calls and
+  * only the processes that send particles communicate, the cost of the
+  * exchange depends on the number of moving particles and not on the number
+  * of processes.
   */
 template <class FReal, class OctreeClass, class ContainerClass, class ParticleClass, class ConverterClass >
 class FOctreeArrangerProc  {
@@ -44,25 +58,33 @@ class FOctreeArrangerProc  {
         return size - 1;
     }
 
-    OctreeClass* const tree;
+    /** Find the process that owns mindex from the first index of each process */
+    static int getOwner(const MortonIndex mindex, const std::vector<MortonIndex>& firstIndexes){
+        const int owner = int(std::upper_bound(firstIndexes.begin(), firstIndexes.end(), mindex) - firstIndexes.begin()) - 1;
+        return (owner < 0 ? 0 : owner);
+    }
 
+    OctreeClass* const tree;
 
-public:
-    /** Basic constructor */
-    FOctreeArrangerProc(OctreeClass* const inTree) : tree(inTree) {
-        FAssertLF(tree, "Tree cannot be null");
-    }
+    std::vector<MortonIndex> splitters; //< The first Morton index of each process for migrate
+    FSize nbSentParticles;              //< Number of particles sent by the last migrate
+    FSize nbReceivedParticles;          //< Number of particles received by the last migrate
 
-    /** return false if the tree is empty after processing */
-    bool rearrange(const FMpi::FComm& comm, const int isPeriodic = DirNone){
-        // interval of each procs
-        Interval*const intervals = new Interval[comm.processCount()];
+    /**
+     * Exchange the intervals of all the processes, the holes between them are split in two.
+     * A process with an empty tree gets an empty interval (and no leaf), the
+     * intervals are [min, max[.
+     */
+    void exchangeIntervals(const FMpi::FComm& comm, Interval intervals[]) const {
         memset(intervals, 0, sizeof(Interval) * comm.processCount());
 
-        {   // We need to exchange interval of each process, this interval
-            // will be based on the current morton min max
-            Interval myLastInterval;
+        // We need to exchange interval of each process, this interval
+        // will be based on the current morton min max (-1 if the tree is empty)
+        Interval myLastInterval;
+        myLastInterval.min = -1;
+        myLastInterval.max = -1;
 
+        if(tree->isEmpty() == false){
             // take fist index
             typename OctreeClass::Iterator octreeIterator(tree);
             octreeIterator.gotoBottomLeft();
@@ -70,31 +92,126 @@ public:
             // take last index
             octreeIterator.gotoRight();
             myLastInterval.max = octreeIterator.getCurrentGlobalIndex();
+        }
 
-            // We get the min/max indexes from each procs
-            FMpi::MpiAssert( MPI_Allgather( &myLastInterval, sizeof(Interval), MPI_BYTE, intervals, sizeof(Interval), MPI_BYTE, comm.getComm()),  __LINE__ );
+        // We get the min/max indexes from each procs
+        FMpi::MpiAssert( MPI_Allgather( &myLastInterval, sizeof(Interval), MPI_BYTE, intervals, sizeof(Interval), MPI_BYTE, comm.getComm()),  __LINE__ );
+
+        // increase interval in the empty morton index, the empty processes
+        // get an empty interval where the next process starts
+        const MortonIndex endIndex = (MortonIndex(1) << (3*(tree->getHeight()-1)));
+        MortonIndex start = 0;
+        int idxProc = 0;
+        while(idxProc < comm.processCount()){
+            int idxNextProc = idxProc;
+            while(idxNextProc < comm.processCount() && intervals[idxNextProc].max < 0){
+                ++idxNextProc;
+            }
+            if(idxNextProc == comm.processCount()){
+                // No particles after start
+                for( ; idxProc < comm.processCount() ; ++idxProc){
+                    intervals[idxProc].min = start;
+                    intervals[idxProc].max = (idxProc == comm.processCount() - 1 ? endIndex : start);
+                }
+                break;
+            }
 
-            // increase interval in the empty morton index
-            intervals[0].min = 0;
-            for(int idxProc = 1 ; idxProc < comm.processCount() ; ++idxProc){
-                intervals[idxProc].min = ((intervals[idxProc].min - intervals[idxProc-1].max)/2) + intervals[idxProc-1].max;
-                intervals[idxProc-1].max = intervals[idxProc].min;
+            int idxFollowingProc = idxNextProc + 1;
+            while(idxFollowingProc < comm.processCount() && intervals[idxFollowingProc].max < 0){
+                ++idxFollowingProc;
             }
+            const MortonIndex end = (idxFollowingProc == comm.processCount() ? endIndex :
+                        intervals[idxNextProc].max + 1 + (intervals[idxFollowingProc].min - intervals[idxNextProc].max - 1)/2);
 
-            intervals[comm.processCount() - 1].max = ((1 << (3*(tree->getHeight()-1))) - 1);
+            for( ; idxProc < idxNextProc ; ++idxProc){
+                intervals[idxProc].min = start;
+                intervals[idxProc].max = start;
+            }
+            intervals[idxNextProc].min = start;
+            intervals[idxNextProc].max = end;
+            start = end;
+            idxProc = idxNextProc + 1;
         }
+    }
 
-        // Particles that move
-        FVector<ParticleClass>*const toMove = new FVector<ParticleClass>[comm.processCount()];
+    /** Put the particle back in the box if the simulation is periodic, print an error if it is out */
+    void applyPeriodicCondition(FPoint<FReal>* partPos, const int isPeriodic, const MortonIndex currentIndex) const {
+        const FReal boxWidth = tree->getBoxWidth();
+        const FPoint<FReal> min(tree->getBoxCenter(),-boxWidth/2);
+        const FPoint<FReal> max(tree->getBoxCenter(),boxWidth/2);
+        const char axisNames[3] = {'X', 'Y', 'Z'};
+        const PeriodicCondition plusDirs[3]  = {DirPlusX, DirPlusY, DirPlusZ};
+        const PeriodicCondition minusDirs[3] = {DirMinusX, DirMinusY, DirMinusZ};
+
+        for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+            if( TestPeriodicCondition(isPeriodic, plusDirs[idxDim]) ){
+                while(partPos->getDataValue()[idxDim] >= max.getDataValue()[idxDim]){
+                    partPos->getDataValue()[idxDim] -= boxWidth;
+                }
+            }
+            else if(partPos->getDataValue()[idxDim] >= max.getDataValue()[idxDim]){
+                printf("Error, particle out of Box in +%c, index %lld\n", axisNames[idxDim], currentIndex);
+                printf("Application is exiting...\n");
+            }
+            if( TestPeriodicCondition(isPeriodic, minusDirs[idxDim]) ){
+                while(partPos->getDataValue()[idxDim] < min.getDataValue()[idxDim]){
+                    partPos->getDataValue()[idxDim] += boxWidth;
+                }
+            }
+            else if(partPos->getDataValue()[idxDim] < min.getDataValue()[idxDim]){
+                printf("Error, particle out of Box in -%c, index %lld\n", axisNames[idxDim], currentIndex);
+                printf("Application is exiting...\n");
+            }
+        }
+    }
 
-        { // iterate on the leafs and found particle to remove or to send
-            // For periodic
-            const FReal boxWidth = tree->getBoxWidth();
-            const FPoint<FReal> min(tree->getBoxCenter(),-boxWidth/2);
-            const FPoint<FReal> max(tree->getBoxCenter(),boxWidth/2);
+public:
+    /** Basic constructor */
+    FOctreeArrangerProc(OctreeClass* const inTree) : tree(inTree), nbSentParticles(0), nbReceivedParticles(0) {
+        FAssertLF(tree, "Tree cannot be null");
+    }
+
+    /**
+     * Set the splitters used by migrate, for example the intervals given by
+     * the tree builder. The leaves in [inFirstIndexes[p], inFirstIndexes[p+1][
+     * belong to process p.
+     * @param inFirstIndexes the first Morton index of each process (sorted)
+     */
+    void setSplitters(std::vector<MortonIndex> inFirstIndexes){
+        FAssertLF(std::is_sorted(inFirstIndexes.begin(), inFirstIndexes.end()), "Splitters must be sorted");
+        splitters = std::move(inFirstIndexes);
+    }
+
+    /** The splitters used by migrate, empty if they have not been computed yet */
+    const std::vector<MortonIndex>& getSplitters() const {
+        return splitters;
+    }
+
+    /** Forget the splitters, migrate will compute them again from the tree (after a new distribution for example) */
+    void clearSplitters(){
+        splitters.clear();
+    }
+
+    /** Number of particles sent to the other processes by the last migrate */
+    FSize getNbSentParticles() const {
+        return nbSentParticles;
+    }
+
+    /** Number of particles received from the other processes by the last migrate */
+    FSize getNbReceivedParticles() const {
+        return nbReceivedParticles;
+    }
 
-            FVector<FSize> indexesToExtract;
+    /** return false if the tree is empty after processing */
+    bool rearrange(const FMpi::FComm& comm, const int isPeriodic = DirNone){
+        // interval of each procs
+        Interval*const intervals = new Interval[comm.processCount()];
+        exchangeIntervals(comm, intervals);
 
+        // Particles that move
+        FVector<ParticleClass>*const toMove = new FVector<ParticleClass>[comm.processCount()];
+
+        if(tree->isEmpty() == false){ // iterate on the leafs and found particle to remove or to send
             typename OctreeClass::Iterator octreeIterator(tree);
             octreeIterator.gotoBottomLeft();
             do{
@@ -105,63 +222,7 @@ public:
                     FPoint<FReal> partPos( particles->getPositions()[0][idxPart],
                             particles->getPositions()[1][idxPart],
                             particles->getPositions()[2][idxPart] );
-                    // XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
-                    if( TestPeriodicCondition(isPeriodic, DirPlusX) ){
-                        while(partPos.getX() >= max.getX()){
-                            partPos.incX(-boxWidth);
-                        }
-                    }
-                    else if(partPos.getX() >= max.getX()){
-                        printf("Error, particle out of Box in +X, index %lld\n", currentIndex);
-                        printf("Application is exiting...\n");
-                    }
-                    if( TestPeriodicCondition(isPeriodic, DirMinusX) ){
-                        while(partPos.getX() < min.getX()){
-                            partPos.incX(boxWidth);
-                        }
-                    }
-                    else if(partPos.getX() < min.getX()){
-                        printf("Error, particle out of Box in -X, index %lld\n", currentIndex);
-                        printf("Application is exiting...\n");
-                    }
-                    // YYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYY
-                    if( TestPeriodicCondition(isPeriodic, DirPlusY) ){
-                        while(partPos.getY() >= max.getY()){
-                            partPos.incY(-boxWidth);
-                        }
-                    }
-                    else if(partPos.getY() >= max.getY()){
-                        printf("Error, particle out of Box in +Y, index %lld\n", currentIndex);
-                        printf("Application is exiting...\n");
-                    }
-                    if( TestPeriodicCondition(isPeriodic, DirMinusY) ){
-                        while(partPos.getY() < min.getY()){
-                            partPos.incY(boxWidth);
-                        }
-                    }
-                    else if(partPos.getY() < min.getY()){
-                        printf("Error, particle out of Box in -Y, index %lld\n", currentIndex);
-                        printf("Application is exiting...\n");
-                    }
-                    // ZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ
-                    if( TestPeriodicCondition(isPeriodic, DirPlusX) ){
-                        while(partPos.getZ() >= max.getZ()){
-                            partPos.incZ(-boxWidth);
-                        }
-                    }
-                    else if(partPos.getZ() >= max.getZ()){
-                        printf("Error, particle out of Box in +Z, index %lld\n", currentIndex);
-                        printf("Application is exiting...\n");
-                    }
-                    if( TestPeriodicCondition(isPeriodic, DirMinusX) ){
-                        while(partPos.getZ() < min.getZ()){
-                            partPos.incZ(boxWidth);
-                        }
-                    }
-                    else if(partPos.getZ() < min.getZ()){
-                        printf("Error, particle out of Box in -Z, index %lld\n", currentIndex);
-                        printf("Application is exiting...\n");
-                    }
+                    applyPeriodicCondition(&partPos, isPeriodic, currentIndex);
                     // set pos
                     particles->getPositions()[0][idxPart] = partPos.getX();
                     particles->getPositions()[1][idxPart] = partPos.getY();
@@ -173,17 +234,12 @@ public:
                         // find the right interval
                         const int procConcerned = getInterval( particuleIndex, comm.processCount(), intervals);
                         toMove[procConcerned].push(ConverterClass::GetParticleAndRemove(particles,idxPart));
-                        indexesToExtract.push(idxPart);
                         //No need to increment idxPart, since the array has been staggered
                     }
                     else{
                         idxPart++;
                     }
                 }
-
-                particles->removeParticles(indexesToExtract.data(), indexesToExtract.getSize());
-                indexesToExtract.clear();
-
             } while(octreeIterator.moveRight());
         }
 
@@ -269,7 +325,7 @@ public:
         }
 
         int counterLeavesAlive = 0;
-        { // Remove empty leaves
+        if(tree->isEmpty() == false){ // Remove empty leaves
             typename OctreeClass::Iterator octreeIterator(tree);
             octreeIterator.gotoBottomLeft();
             bool workOnNext = true;
@@ -302,6 +358,149 @@ public:
         return counterLeavesAlive != 0;
     }
 
+    /**
+     * Move the particles that changed of leaf, sending to the other processes
+     * only the particles that left the interval of the current process.
+     * The intervals are computed from the tree at the first call (or given
+     * with setSplitters) and kept for the next calls, so a particle is always
+     * sent to the process that owns its leaf. When the splitters are changed
+     * (to balance the work) the leaves that left the interval of the process are
+     * sent to their new owner, only the leaves close to the old cuts move.
+     * The number of particles to receive is given by a sparse exchange between
+     * the processes that send.
+     * Only the leaves that lost particles are tested to remove the empty ones.
+     * @return false if the tree is empty after processing
+     */
+    bool migrate(const FMpi::FComm& comm, const int isPeriodic = DirNone){
+        const int myRank = comm.processId();
+        if(int(splitters.size()) != comm.processCount()){
+            std::unique_ptr<Interval[]> intervals(new Interval[comm.processCount()]);
+            exchangeIntervals(comm, intervals.get());
+            splitters.resize(comm.processCount());
+            for(int idxProc = 0 ; idxProc < comm.processCount() ; ++idxProc){
+                splitters[idxProc] = intervals[idxProc].min;
+            }
+        }
+
+        // Particles that stay on this process and that leave it (by destination)
+        FVector<ParticleClass> toMoveLocally;
+        std::map<int, FVector<ParticleClass>> toSend;
+        // The leaves that lost particles
+        std::vector<MortonIndex> leavesToCheck;
+
+        // A process that has no leaf (all its particles left at the previous call)
+        // has nothing to send but it still takes part in the exchange to receive
+        if(tree->isEmpty() == false){
+            typename OctreeClass::Iterator octreeIterator(tree);
+            octreeIterator.gotoBottomLeft();
+            do{
+                const MortonIndex currentIndex = octreeIterator.getCurrentGlobalIndex();
+                ContainerClass* particles = octreeIterator.getCurrentLeaf()->getSrc();
+                const FSize nbParticlesBefore = particles->getNbParticles();
+                const bool leafIsMine = (getOwner(currentIndex, splitters) == myRank);
+                //IdxPart is incremented at the end of the loop
+                for(FSize idxPart = 0 ; idxPart < particles->getNbParticles(); /*++idxPart*/){
+                    FPoint<FReal> partPos( particles->getPositions()[0][idxPart],
+                            particles->getPositions()[1][idxPart],
+                            particles->getPositions()[2][idxPart] );
+                    applyPeriodicCondition(&partPos, isPeriodic, currentIndex);
+                    particles->getPositions()[0][idxPart] = partPos.getX();
+                    particles->getPositions()[1][idxPart] = partPos.getY();
+                    particles->getPositions()[2][idxPart] = partPos.getZ();
+
+                    const MortonIndex particuleIndex = tree->getMortonFromPosition(partPos);
+                    if(particuleIndex != currentIndex || leafIsMine == false){
+                        const int procConcerned = getOwner(particuleIndex, splitters);
+                        // The particle is removed from the container, idxPart is now the next one
+                        if(procConcerned == myRank){
+                            toMoveLocally.push(ConverterClass::GetParticleAndRemove(particles,idxPart));
+                        }
+                        else{
+                            toSend[procConcerned].push(ConverterClass::GetParticleAndRemove(particles,idxPart));
+                        }
+                    }
+                    else{
+                        idxPart++;
+                    }
+                }
+                if(particles->getNbParticles() != nbParticlesBefore){
+                    leavesToCheck.push_back(currentIndex);
+                }
+            } while(octreeIterator.moveRight());
+        }
+
+        // Only the processes that receive particles are told how many
+        std::vector<std::pair<int,FSize>> nbToSend;
+        nbSentParticles = 0;
+        for(const auto& destination : toSend){
+            nbToSend.emplace_back(destination.first, destination.second.getSize());
+            nbSentParticles += destination.second.getSize();
+        }
+        const std::vector<std::pair<int,FSize>> nbToReceive = FMpi::SparseExchange(nbToSend, comm, FMpi::TagSparseExchangeMigrate);
+
+        nbReceivedParticles = 0;
+        for(const auto& source : nbToReceive){
+            nbReceivedParticles += source.second;
+        }
+        std::unique_ptr<ParticleClass[]> toReceive(new ParticleClass[nbReceivedParticles]);
+
+        std::vector<MPI_Request> recvRequests;
+        std::vector<int> recvRequestsSource;
+        std::vector<FSize> offsetOfSource;
+        {
+            FSize offset = 0;
+            for(const auto& source : nbToReceive){
+                const int nbRequests = FMpi::IRecvSplit(&toReceive[offset], size_t(source.second), source.first,
+                                                        FMpi::TagParticlesMigration, comm, &recvRequests);
+                recvRequestsSource.insert(recvRequestsSource.end(), nbRequests, int(offsetOfSource.size()));
+                offsetOfSource.push_back(offset);
+                offset += source.second;
+            }
+            offsetOfSource.push_back(offset);
+        }
+
+        std::vector<MPI_Request> sendRequests;
+        for(const auto& destination : toSend){
+            FMpi::ISendSplit(destination.second.data(), size_t(destination.second.getSize()), destination.first,
+                             FMpi::TagParticlesMigration, comm, &sendRequests);
+        }
+
+        // Insert the particles that stay here during the communications
+        for(FSize idxPart = 0 ; idxPart < toMoveLocally.getSize() ; ++idxPart){
+            ConverterClass::Insert( tree , toMoveLocally[idxPart]);
+        }
+
+        {   // Insert the particles of a source when all its messages are received
+            std::vector<int> remainingRequests(nbToReceive.size(), 0);
+            for(const int idxSource : recvRequestsSource){
+                remainingRequests[idxSource] += 1;
+            }
+            for(size_t idxRequest = 0 ; idxRequest < recvRequests.size() ; ++idxRequest){
+                int done = 0;
+                FMpi::MpiAssert( MPI_Waitany( int(recvRequests.size()), recvRequests.data(), &done, MPI_STATUS_IGNORE ),  __LINE__ );
+                const int idxSource = recvRequestsSource[done];
+                remainingRequests[idxSource] -= 1;
+                if(remainingRequests[idxSource] == 0){
+                    for(FSize idxPart = offsetOfSource[idxSource] ; idxPart < offsetOfSource[idxSource+1] ; ++idxPart){
+                        ConverterClass::Insert( tree , toReceive[idxPart]);
+                    }
+                }
+            }
+        }
+
+        // Remove the leaves that became empty
+        for(const MortonIndex leafIndex : leavesToCheck){
+            ContainerClass* particles = tree->getLeafSrc(leafIndex);
+            if(particles && particles->getNbParticles() == 0){
+                tree->removeLeaf(leafIndex);
+            }
+        }
+
+        FMpi::MpiAssert( MPI_Waitall( int(sendRequests.size()), sendRequests.data(), MPI_STATUSES_IGNORE),  __LINE__ );
+
+        return !tree->isEmpty();
+    }
+
 };
 
 #endif // FOCTREEARRANGERPROC_HPP
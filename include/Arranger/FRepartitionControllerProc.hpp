@@ -0,0 +1,264 @@
+// See LICENCE file at project root
+#ifndef FREPARTITIONCONTROLLERPROC_HPP
+#define FREPARTITIONCONTROLLERPROC_HPP
+
+#include <vector>
+
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FAssert.hpp"
+#include "../Utils/FMpi.hpp"
+#include "../Utils/FEnv.hpp"
+#include "../Utils/FLog.hpp"
+#include "../Utils/FTic.hpp"
+#include "../Utils/FMath.hpp"
+#include "../Utils/FCostBalance.hpp"
+#include "../Utils/FGlobalPeriodic.hpp"
+
+#include "FOctreeArrangerProc.hpp"
+
+/**
+ * @brief Repartition the leaves between the processes when the execution
+ * times become imbalanced, for the time stepping.
+ *
+ * After each execution of the FMM the time of the process is given to
+ * recordExecution. The imbalance is the greatest time divided by the
+ * average time. When it goes above the trigger threshold, the next call to
+ * arrange moves the Morton splitters so that each process gets the same
+ * measured cost, and the leaves are moved incrementally by
+ * FOctreeArrangerProc::migrate (only the leaves close to the old cuts are
+ * sent, to the neighbor processes in most cases) instead of a new
+ * distribution of all the particles.
+ *
+ * The cost of a leaf for the new cut is the time of its process shared
+ * between its leaves with a model (FCostBalance::ModelCost by default).
+ *
+ * To avoid repartitioning at each step, the controller has an hysteresis :
+ * after a repartition it does not trigger again until the imbalance has gone
+ * below the rearm threshold, and never before minStepsBetween executions.
+ *
+ * The execution after a repartition is compared to the one before : the
+ * controller reports the time of the migration, the time saved per step
+ * and the number of steps needed to pay the migration back.
+ *
+ * The thresholds can be set with SCALFMM_REPARTITION_TRIGGER (default 1.2),
+ * SCALFMM_REPARTITION_REARM (default 1.1) and SCALFMM_REPARTITION_MIN_STEPS
+ * (default 5).
+ */
+template <class FReal, class OctreeClass, class ContainerClass, class ParticleClass, class ConverterClass >
+class FRepartitionControllerProc {
+    typedef FOctreeArrangerProc<FReal, OctreeClass, ContainerClass, ParticleClass, ConverterClass> ArrangerClass;
+
+    const FMpi::FComm comm;
+    OctreeClass* const tree;
+    ArrangerClass arranger;
+
+    double triggerImbalance;
+    double rearmImbalance;
+    int minStepsBetween;
+    FCostBalance::CostFunction costModel;
+
+    bool isArmed;
+    bool repartitionRequested;
+    int stepsSinceRepartition;
+    int nbRepartitions;
+
+    double localTime;        //< Time of the last execution on this process
+    double lastImbalance;    //< max/average of the last execution
+    double lastMinMaxRatio;  //< min/max of the last execution
+    double lastMaxTime;
+
+    bool hasToReport;        //< The next execution is the first after a repartition
+    double maxTimeBeforeRepartition;
+    double lastMigrationTime;
+    double lastTimeSaved;
+
+    /** Compute the splitters that share the measured cost, it is a collective */
+    std::vector<MortonIndex> computeBalancedSplitters(){
+        const int nbProcs = comm.processCount();
+
+        std::vector<MortonIndex> leavesIndexes;
+        std::vector<FSize> leavesOffsetInParticles(1, 0);
+        double localModelCost = 0;
+        if(tree->isEmpty() == false){
+            typename OctreeClass::Iterator octreeIterator(tree);
+            octreeIterator.gotoBottomLeft();
+            do{
+                const MortonIndex leafIndex = octreeIterator.getCurrentGlobalIndex();
+                const FSize nbParticles = octreeIterator.getCurrentLeaf()->getSrc()->getNbParticles();
+                leavesIndexes.push_back(leafIndex);
+                leavesOffsetInParticles.push_back(leavesOffsetInParticles.back() + nbParticles);
+                localModelCost += costModel(leafIndex, nbParticles);
+            } while(octreeIterator.moveRight());
+        }
+
+        // The time of the process is shared between its leaves
+        const double scale = (localModelCost != 0 ? localTime / localModelCost : 0);
+        const FCostBalance::CostFunction model = costModel;
+        FCostBalance balancer(comm, [scale, model](const MortonIndex leafIndex, const FSize nbParticles){
+            return scale * model(leafIndex, nbParticles);
+        });
+
+        const FSize nbLeaves = FSize(leavesIndexes.size());
+        FSize firstLeaf = 0;
+        FMpi::MpiAssert( MPI_Exscan(const_cast<FSize*>(&nbLeaves), &firstLeaf, 1, FMpi::GetType(nbLeaves), MPI_SUM, comm.getComm()), __LINE__);
+        if(comm.processId() == 0){
+            firstLeaf = 0;
+        }
+        balancer.setLocalLeaves(leavesIndexes.data(), leavesOffsetInParticles.data(), nbLeaves, firstLeaf);
+
+        FSize totalNbLeaves = 0;
+        FMpi::MpiAssert( MPI_Allreduce(const_cast<FSize*>(&nbLeaves), &totalNbLeaves, 1, FMpi::GetType(nbLeaves), MPI_SUM, comm.getComm()), __LINE__);
+
+        // The process that has the first leaf of a process gives its Morton index
+        const MortonIndex afterLastIndex = (MortonIndex(1) << (3 * (tree->getHeight() - 1)));
+        std::vector<MortonIndex> localSplitters(nbProcs, -1);
+        for(int idxProc = 0 ; idxProc < nbProcs ; ++idxProc){
+            const FSize firstLeafOfProc = balancer.getLeft(totalNbLeaves, nbProcs, idxProc);
+            if(firstLeafOfProc == totalNbLeaves){
+                localSplitters[idxProc] = afterLastIndex;
+            }
+            else if(firstLeaf <= firstLeafOfProc && firstLeafOfProc < firstLeaf + nbLeaves){
+                localSplitters[idxProc] = leavesIndexes[firstLeafOfProc - firstLeaf];
+            }
+        }
+        std::vector<MortonIndex> splitters(nbProcs);
+        FMpi::MpiAssert( MPI_Allreduce(localSplitters.data(), splitters.data(), nbProcs, FMpi::GetType(splitters[0]), MPI_MAX, comm.getComm()), __LINE__);
+        splitters[0] = 0;
+
+        FLOG( if(comm.processId() == 0) FLog::Controller << "FRepartitionControllerProc expects an imbalance of "
+              << balancer.getImbalance() << " instead of " << lastImbalance << "\n"; );
+        return splitters;
+    }
+
+public:
+    /**
+     * @param inComm the communicator of the simulation
+     * @param inTree the local tree (built from FMpiTreeBuilder for example)
+     */
+    FRepartitionControllerProc(const FMpi::FComm& inComm, OctreeClass* const inTree)
+        : comm(inComm), tree(inTree), arranger(inTree),
+          triggerImbalance(FEnv::GetValue("SCALFMM_REPARTITION_TRIGGER", 1.2)),
+          rearmImbalance(FEnv::GetValue("SCALFMM_REPARTITION_REARM", 1.1)),
+          minStepsBetween(FEnv::GetValue("SCALFMM_REPARTITION_MIN_STEPS", 5)),
+          costModel(FCostBalance::ModelCost()),
+          isArmed(true), repartitionRequested(false), stepsSinceRepartition(0), nbRepartitions(0),
+          localTime(0), lastImbalance(1), lastMinMaxRatio(1), lastMaxTime(0),
+          hasToReport(false), maxTimeBeforeRepartition(0), lastMigrationTime(0), lastTimeSaved(0) {
+        FAssertLF(tree, "Tree cannot be null");
+    }
+
+    /**
+     * Set the hysteresis, a repartition is triggered when the imbalance goes above
+     * inTrigger, then the controller waits for the imbalance to go below inRearm
+     * and for inMinStepsBetween executions.
+     */
+    void setThresholds(const double inTrigger, const double inRearm, const int inMinStepsBetween){
+        FAssertLF(1 <= inRearm && inRearm <= inTrigger, "The thresholds must verify 1 <= rearm <= trigger");
+        triggerImbalance = inTrigger;
+        rearmImbalance = inRearm;
+        minStepsBetween = inMinStepsBetween;
+    }
+
+    /** Set how the time of a process is shared between its leaves */
+    void setCostModel(FCostBalance::CostFunction inCostModel){
+        costModel = std::move(inCostModel);
+    }
+
+    /** The arranger used to move the particles */
+    ArrangerClass& getArranger(){
+        return arranger;
+    }
+
+    /**
+     * Give the time of the last execution of this process, it is a collective.
+     * @return true if the next call to arrange will repartition the leaves
+     */
+    bool recordExecution(const double inLocalTime){
+        localTime = inLocalTime;
+
+        double maxAndMinusMin[2] = {inLocalTime, -inLocalTime};
+        double reducedMaxAndMinusMin[2];
+        FMpi::MpiAssert( MPI_Allreduce(maxAndMinusMin, reducedMaxAndMinusMin, 2, MPI_DOUBLE, MPI_MAX, comm.getComm()), __LINE__);
+        double sumTime = 0;
+        FMpi::MpiAssert( MPI_Allreduce(&localTime, &sumTime, 1, MPI_DOUBLE, MPI_SUM, comm.getComm()), __LINE__);
+
+        lastMaxTime = reducedMaxAndMinusMin[0];
+        const double averageTime = sumTime / double(comm.processCount());
+        lastImbalance = (averageTime != 0 ? lastMaxTime / averageTime : 1);
+        lastMinMaxRatio = (lastMaxTime != 0 ? -reducedMaxAndMinusMin[1] / lastMaxTime : 1);
+
+        if(hasToReport){
+            lastTimeSaved = maxTimeBeforeRepartition - lastMaxTime;
+            hasToReport = false;
+            FLOG( if(comm.processId() == 0) FLog::Controller << "FRepartitionControllerProc migration took " << lastMigrationTime
+                  << "s, the step went from " << maxTimeBeforeRepartition << "s to " << lastMaxTime << "s ("
+                  << getStepsToAmortize() << " steps to amortize)\n"; );
+        }
+
+        stepsSinceRepartition += 1;
+        if(isArmed == false && lastImbalance <= rearmImbalance){
+            isArmed = true;
+        }
+        repartitionRequested = (isArmed && lastImbalance > triggerImbalance && stepsSinceRepartition >= minStepsBetween);
+        return repartitionRequested;
+    }
+
+    /**
+     * Move the particles that changed of leaf (FOctreeArrangerProc::migrate),
+     * and repartition the leaves if the last execution was too imbalanced.
+     * @return false if the tree is empty after processing
+     */
+    bool arrange(const int isPeriodic = DirNone){
+        if(repartitionRequested == false){
+            return arranger.migrate(comm, isPeriodic);
+        }
+
+        FTic migrationTimer;
+        arranger.setSplitters(computeBalancedSplitters());
+        const bool treeIsNotEmpty = arranger.migrate(comm, isPeriodic);
+        migrationTimer.tac();
+
+        const double localMigrationTime = migrationTimer.elapsed();
+        FMpi::MpiAssert( MPI_Allreduce(const_cast<double*>(&localMigrationTime), &lastMigrationTime, 1, MPI_DOUBLE, MPI_MAX, comm.getComm()), __LINE__);
+
+        maxTimeBeforeRepartition = lastMaxTime;
+        hasToReport = true;
+        repartitionRequested = false;
+        isArmed = false;
+        stepsSinceRepartition = 0;
+        nbRepartitions += 1;
+        return treeIsNotEmpty;
+    }
+
+    /** The greatest time divided by the average time of the last execution */
+    double getImbalance() const {
+        return lastImbalance;
+    }
+
+    /** The smallest time divided by the greatest time of the last execution */
+    double getMinMaxRatio() const {
+        return lastMinMaxRatio;
+    }
+
+    /** Number of repartitions done */
+    int getNbRepartitions() const {
+        return nbRepartitions;
+    }
+
+    /** The time of the last repartition (greatest among the processes) */
+    double getLastMigrationTime() const {
+        return lastMigrationTime;
+    }
+
+    /** The time saved per step by the last repartition, measured on the execution that follows it */
+    double getLastTimeSaved() const {
+        return lastTimeSaved;
+    }
+
+    /** The number of steps needed to pay the last migration back, negative if no time was saved */
+    double getStepsToAmortize() const {
+        return (lastTimeSaved > 0 ? lastMigrationTime / lastTimeSaved : -1);
+    }
+};
+
+#endif // FREPARTITIONCONTROLLERPROC_HPP
@@ -97,6 +97,17 @@ public:
         return false;
     }
 
+    /** This method tells the algorithms if the copy constructor of the kernel
+     *  can be called by several threads at the same time. If the copies only
+     *  share read-only (or atomic reference counted) data, inherit it and
+     *  return true, so that the per-thread kernels are created in parallel.
+     *
+     * @return false
+     */
+    constexpr static bool HasThreadSafeCopy(){
+        return false;
+    }
+
     /** This method can be optionally inherited
      * It is called at the end of each computation level during the M2L pass
      * @param level the ending level
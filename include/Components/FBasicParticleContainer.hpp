@@ -3,6 +3,7 @@
 #ifndef FBASIC_PARTICLE_CONTAINER_HPP_
 #define FBASIC_PARTICLE_CONTAINER_HPP_
 
+#include <algorithm>
 #include <vector>
 
 #include "Utils/FPoint.hpp"
@@ -218,6 +219,11 @@ public:
      */
     template<typename... Args>
     void pushArray(const FPoint<FReal,Dim>* positionArray, FSize arraySize, Args*... args) {
+        // Geometric growth, repeated calls stay linear
+        const std::size_t newSize = this->size() + std::size_t(arraySize);
+        if(newSize > this->capacity()) {
+            this->reserve(std::max(newSize, 2 * this->capacity()));
+        }
         for(FSize idx = 0; idx < arraySize; ++idx) {
             this->push(positionArray[idx], args[idx]...);
         }
@@ -225,6 +231,47 @@ public:
 
     using FBase::push;
 
+    /** \brief Appends several particles in the container (structure of arrays)
+     *
+     * An empty container gets exactly the new particle count, otherwise the
+     * storage grows geometrically when needed (the new capacity is the new
+     * particle count plus the old capacity) so that repeated appends stay
+     * linear. Each position and attribute array is copied in one pass
+     * instead of one push per particle.
+     *
+     * ~~~~{.cpp}
+     * const FReal* positions[3] = {x, y, z};
+     * const FReal* attributes[Container::AttributeCount] = {physicalValues}; // the others are set to 0
+     * container.append(nbParticles, positions, attributes);
+     * ~~~~
+     *
+     * \param nbParticles Number of particles to add
+     * \param positions Dim arrays of nbParticles position components
+     * \param others Arrays of the secondary attributes
+     * \param attributes AttributeCount arrays of nbParticles attributes, a
+     * nullptr array (or attributes itself) sets the attribute to 0
+     */
+    void append(const FSize nbParticles, const FReal* const* positions, const OtherTypes*... others,
+                const Attribute* const* attributes) {
+        FBase::append(std::size_t(nbParticles), positions[posIndices]..., others...,
+                      (attributes ? attributes[attrIndices] : nullptr)...);
+    }
+
+    /** \brief Appends several particles gathered from arrays
+     *
+     * Same as append(), but the i-th particle added is at position
+     * `indexOf(i)` in the arrays (for example to copy the particles of a
+     * leaf from an unsorted array). The storage grows as with append().
+     *
+     * \tparam IndexFunction Callable type, `FSize(FSize)`
+     */
+    template<class IndexFunction>
+    void appendGathered(const FSize nbParticles, const IndexFunction& indexOf, const FReal* const* positions,
+                        const OtherTypes*... others, const Attribute* const* attributes) {
+        FBase::append_gathered(std::size_t(nbParticles), [&indexOf](const std::size_t idx){ return indexOf(FSize(idx)); },
+                               positions[posIndices]..., others..., (attributes ? attributes[attrIndices] : nullptr)...);
+    }
+
 
     /** \brief Push a particle in the container
      *
@@ -43,6 +43,13 @@ namespace FTestCell_impl {
         FSize getSavedSize() const {
             return sizeof(this->data);
         }
+        /// The data written by serialize, getSavedSize() bytes
+        const void* getContiguousData() const {
+            return &this->data;
+        }
+        void* getContiguousData() {
+            return &this->data;
+        }
         template <class BufferWriterClass>
         void serialize(BufferWriterClass& buffer) const {
             buffer << this->data;
@@ -32,6 +32,11 @@ public:
     virtual ~FTestKernels(){
     }
 
+    /** The test kernel has no state */
+    constexpr static bool HasThreadSafeCopy(){
+        return true;
+    }
+
     /** Before upward */
     template<class Symb>
     void P2M(typename CellClass::multipole_t* const leaf_multipole,
@@ -32,6 +32,10 @@ public:
     void fillArray(ClassType* const , const FSize ){
         static_assert(sizeof(ClassType) == 0, "Your Buffer should implement fillArray.");
     }
+    template <class RealType>
+    void fillReals(RealType* const , const FSize ){
+        static_assert(sizeof(RealType) == 0, "Your Buffer should implement fillReals.");
+    }
     template <class ClassType>
     FAbstractBufferReader& operator>>(ClassType& ){
         static_assert(sizeof(ClassType) == 0, "Your Buffer should implement operator>>.");
@@ -66,6 +70,10 @@ public:
     void write(const ClassType* const /*objects*/, const FSize /*inSize*/){
         static_assert(sizeof(ClassType) == 0, "Your Buffer should implement write.");
     }
+    template <class RealType>
+    void writeReals(const RealType* const /*values*/, const FSize /*inSize*/){
+        static_assert(sizeof(RealType) == 0, "Your Buffer should implement writeReals.");
+    }
     template <class ClassType>
     FAbstractBufferWriter& operator<<(const ClassType& ){
         static_assert(sizeof(ClassType) == 0, "Your Buffer should implement operator<<.");
@@ -5,6 +5,8 @@
 
 #include <list>
 #include <cstring>
+#include <memory>
+#include <vector>
 
 #include "Utils/FAssert.hpp"
 
@@ -42,6 +44,50 @@ public:
 };
 
 
+/**
+ * Redirection to normal operators, but the objects can be moved in arenas
+ * (FOctree::compactCells puts all the cells of a level in one memory block).
+ * The objects of an arena are only destroyed by deleteObject, the memory
+ * block is freed when the last allocator that uses it is destroyed or
+ * cleared, so the teardown of a compacted tree frees one block per level.
+ */
+template <class ObjectClass>
+class FArenaBlockAllocator : public FAbstractBlockAllocator<ObjectClass> {
+  struct Arena {
+    const ObjectClass* begin;
+    const ObjectClass* end;
+    std::shared_ptr<void> memory;
+  };
+
+  std::vector<Arena> arenas;
+
+public:
+  ObjectClass* newObject(){
+    return new ObjectClass;
+  }
+
+  void deleteObject(const ObjectClass* inObject){
+    for(const Arena& arena : arenas){
+      if(arena.begin <= inObject && inObject < arena.end){
+        inObject->~ObjectClass();
+        return;
+      }
+    }
+    delete inObject;
+  }
+
+  /** The objects of [inBegin, inEnd[ are in the memory block inMemory (kept alive by the allocator) */
+  void addArena(const ObjectClass* inBegin, const ObjectClass* inEnd, std::shared_ptr<void> inMemory){
+    arenas.push_back(Arena{inBegin, inEnd, std::move(inMemory)});
+  }
+
+  /** Release the arenas, there must not be any object in them */
+  void clearArenas(){
+    arenas.clear();
+  }
+};
+
+
 /**
  * Allocation per blocks
  */
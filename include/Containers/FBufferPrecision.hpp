@@ -0,0 +1,113 @@
+// See LICENCE file at project root
+#ifndef FBUFFERPRECISION_HPP
+#define FBUFFERPRECISION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "Utils/FGlobal.hpp"
+
+/**
+ * \brief How the floating point arrays are stored in a buffer
+ *
+ * The precision is used by FBufferWriter::writeReals and
+ * FBufferReader::fillReals only, the other methods always do byte copies.
+ *
+ *   - Full : byte copy, the format is the same as write/fillArray.
+ *   - Single : each value is converted to float.
+ *   - SharedExponent : the values are scaled by the power of two of the
+ *     greatest absolute value of the array (written once as an int32_t) and
+ *     converted to float. The scaling is exact, so it only protects from the
+ *     overflows and the denormals of the float range.
+ *
+ * The writer and the reader must use the same precision.
+ */
+enum class FBufferPrecision {
+    Full,
+    Single,
+    SharedExponent
+};
+
+/**
+ * \brief Give the cheapest precision that respects a relative accuracy
+ *
+ * \param accuracy The relative error accepted on the values, 0 for exact
+ */
+inline FBufferPrecision FBufferPrecisionForAccuracy(const double accuracy){
+    // The rounding to float gives an error below 2^-24
+    if(accuracy >= 16 * double(std::numeric_limits<float>::epsilon())){
+        return FBufferPrecision::SharedExponent;
+    }
+    return FBufferPrecision::Full;
+}
+
+/**
+ * \brief Conversion of the real arrays for the buffers
+ */
+struct FBufferRealsCoder {
+    /** The number of bytes needed to store count values of type RealType */
+    template <class RealType>
+    static FSize GetSize(const FBufferPrecision precision, const FSize count){
+        switch(precision){
+        case FBufferPrecision::Single:
+            return FSize(sizeof(float)) * count;
+        case FBufferPrecision::SharedExponent:
+            return FSize(sizeof(std::int32_t)) + FSize(sizeof(float)) * count;
+        default:
+            return FSize(sizeof(RealType)) * count;
+        }
+    }
+
+    /** Encode the values in dest which must have GetSize bytes */
+    template <class RealType>
+    static void Encode(const FBufferPrecision precision, const RealType* const values, const FSize count, char* dest){
+        if(precision == FBufferPrecision::Full){
+            memcpy(dest, values, sizeof(RealType) * count);
+            return;
+        }
+
+        std::int32_t exponent = 0;
+        if(precision == FBufferPrecision::SharedExponent){
+            RealType maxAbsValue = 0;
+            for(FSize idx = 0 ; idx < count ; ++idx){
+                maxAbsValue = std::max(maxAbsValue, RealType(std::abs(values[idx])));
+            }
+            int maxExponent = 0;
+            std::frexp(maxAbsValue, &maxExponent);
+            exponent = std::int32_t(maxExponent);
+            memcpy(dest, &exponent, sizeof(exponent));
+            dest += sizeof(exponent);
+        }
+
+        for(FSize idx = 0 ; idx < count ; ++idx){
+            const float value = float(std::ldexp(values[idx], -exponent));
+            memcpy(dest + sizeof(float) * idx, &value, sizeof(float));
+        }
+    }
+
+    /** Decode GetSize bytes from src into values */
+    template <class RealType>
+    static void Decode(const FBufferPrecision precision, RealType* const values, const FSize count, const char* src){
+        if(precision == FBufferPrecision::Full){
+            memcpy(values, src, sizeof(RealType) * count);
+            return;
+        }
+
+        std::int32_t exponent = 0;
+        if(precision == FBufferPrecision::SharedExponent){
+            memcpy(&exponent, src, sizeof(exponent));
+            src += sizeof(exponent);
+        }
+
+        for(FSize idx = 0 ; idx < count ; ++idx){
+            float value;
+            memcpy(&value, src + sizeof(float) * idx, sizeof(float));
+            values[idx] = RealType(std::ldexp(RealType(value), exponent));
+        }
+    }
+};
+
+#endif // FBUFFERPRECISION_HPP
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include "FAbstractBuffer.hpp"
 #include "FBufferWriter.hpp"
+#include "FBufferPrecision.hpp"
 #include "Utils/FAssert.hpp"
 
 /**
@@ -25,6 +26,7 @@ class FBufferReader : public FAbstractBufferReader {
     FSize arrayCapacity;            ///< Allocated space
     std::unique_ptr<char[]> array;  ///< Allocated array
     FSize currentIndex;             ///< First unread byte
+    FBufferPrecision precision;     ///< Storage of the arrays read with fillReals
 
 public :
 
@@ -36,7 +38,8 @@ public :
     explicit FBufferReader(const FSize capacity = 512)
         : arrayCapacity(capacity),
           array(new char[capacity]),
-          currentIndex(0)
+          currentIndex(0),
+          precision(FBufferPrecision::Full)
     {
         FAssertLF(array, "Cannot allocate array");
     }
@@ -46,7 +49,7 @@ public :
      * \param capacity Buffer capacity in bytes
      */
     explicit FBufferReader( FBufferWriter& buf)
-        : arrayCapacity(buf.getCapacity() )
+        : arrayCapacity(buf.getCapacity() ), precision(buf.getPrecision())
     {
       this->cleanAndResize(arrayCapacity) ;
       std::unique_ptr<char[]> arraytmp(new char[arrayCapacity]);
@@ -218,6 +221,38 @@ public :
         currentIndex += sizeof(T)*count;
     }
 
+    /**
+     * \brief Set how the arrays read with fillReals are stored
+     */
+    void setPrecision(const FBufferPrecision inPrecision){
+        precision = inPrecision;
+    }
+
+    /**
+     * \brief Get how the arrays read with fillReals are stored
+     */
+    FBufferPrecision getPrecision() const {
+        return precision;
+    }
+
+    /**
+     * \brief Read floating point values written by FBufferWriter::writeReals
+     *
+     * The precision must be the one of the writer.
+     *
+     * \tparam RealType Type of the values (float or double)
+     *
+     * \param inArray Array of values to fill
+     * \param count Value count in the array
+     */
+    template <class RealType>
+    void fillReals(RealType* const inArray, const FSize count){
+        const FSize sizeInBytes = FBufferRealsCoder::GetSize<RealType>(precision, count);
+        FAssertLF(currentIndex + sizeInBytes <= arrayCapacity );
+        FBufferRealsCoder::Decode(precision, inArray, count, &array[currentIndex]);
+        currentIndex += sizeInBytes;
+    }
+
     /**
      * \brief Stream-like deserialisation
      *
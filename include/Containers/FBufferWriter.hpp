@@ -4,6 +4,7 @@
 
 #include <memory>
 #include "FAbstractBuffer.hpp"
+#include "FBufferPrecision.hpp"
 #include "../Utils/FAssert.hpp"
 
 /**
@@ -23,6 +24,7 @@ class FBufferWriter : public FAbstractBufferWriter {
     FSize arrayCapacity;              ///< Allocated space
     std::unique_ptr<char[]> array;    ///< Allocated array
     FSize currentIndex;               ///< Currently filled space
+    FBufferPrecision precision;       ///< Storage of the arrays written with writeReals
 
     /**
      * \brief Ensure minimum remaining space in the buffer
@@ -52,7 +54,8 @@ public:
     explicit FBufferWriter(const FSize capacity = 1024)
         : arrayCapacity(capacity),
           array(new char[capacity]),
-          currentIndex(0)
+          currentIndex(0),
+          precision(FBufferPrecision::Full)
     {
         FAssertLF(array, "Cannot allocate array");
     }
@@ -157,6 +160,38 @@ public:
         currentIndex += sizeof(ClassType)*inSize;
     }
 
+    /**
+     * \brief Set how the arrays written with writeReals are stored
+     */
+    void setPrecision(const FBufferPrecision inPrecision){
+        precision = inPrecision;
+    }
+
+    /**
+     * \brief Get how the arrays written with writeReals are stored
+     */
+    FBufferPrecision getPrecision() const {
+        return precision;
+    }
+
+    /**
+     * \brief Write floating point values with the buffer precision
+     *
+     * With FBufferPrecision::Full this is the same as write(values, count).
+     *
+     * \tparam RealType Type of the values (float or double)
+     *
+     * \param values Array of values to write
+     * \param count Value count in the array
+     */
+    template <class RealType>
+    void writeReals(const RealType* const values, const FSize count){
+        const FSize sizeInBytes = FBufferRealsCoder::GetSize<RealType>(precision, count);
+        expandIfNeeded(sizeInBytes);
+        FBufferRealsCoder::Encode(precision, values, count, &array[currentIndex]);
+        currentIndex += sizeInBytes;
+    }
+
     /**
      * \brief Stream-like serialisation
      *
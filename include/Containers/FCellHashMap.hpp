@@ -0,0 +1,163 @@
+// See LICENCE file at project root
+#ifndef FCELLHASHMAP_HPP
+#define FCELLHASHMAP_HPP
+
+#include <atomic>
+#include <memory>
+
+#include "Utils/FGlobal.hpp"
+#include "Utils/FAssert.hpp"
+#include "Utils/FNoCopyable.hpp"
+
+/**
+ * @class FCellHashMap
+ *
+ * This class stores the cells received from the other processes and finds
+ * them from their Morton index and level. It replaces FLightOctree: the
+ * cells are in one contiguous buffer (allocated once with reserve), and
+ * the index is a flat open addressing hash table (linear probing) from the
+ * key (level, Morton index) to the cell.
+ *
+ * The cells can be inserted by several threads at the same time, and
+ * getCell is lock free, it can be called while other threads insert:
+ * @code
+ * map.reserve(nbCellsToReceive);
+ * // in parallel
+ * CellClass* cell = map.allocateCell();
+ * cell->deserializeUp(buffer);
+ * map.insertCell(index, level, cell); // now visible by getCell
+ * @endcode
+ *
+ * A cell is visible once insertCell has returned (release/acquire), so a
+ * thread that finds it also sees its data.
+ */
+template <class CellClass>
+class FCellHashMap : public FNoCopyable {
+    /** A slot of the hash table, the key is EmptyKey if the slot is free */
+    struct Entry {
+        std::atomic<MortonIndex> key;
+        std::atomic<CellClass*> cell;
+    };
+
+    static const MortonIndex EmptyKey = -1;
+    /** The level is put above the Morton index (3 bits per level, the deepest level is MaxTreeHeight-1) */
+    static const int LevelShift = 3 * (MaxTreeHeight - 1);
+
+    std::unique_ptr<CellClass[]> cells;   //< The contiguous buffer of cells
+    FSize capacity;                       //< The number of cells in the buffer
+    std::atomic<FSize> nbCells;           //< The number of cells allocated in the buffer
+    std::unique_ptr<Entry[]> table;       //< The hash table
+    FSize tableMask;                      //< The size of the table minus one (power of 2)
+
+    static MortonIndex BuildKey(const MortonIndex inIndex, const int inLevel){
+        return (MortonIndex(inLevel) << LevelShift) | inIndex;
+    }
+
+    /** Mix the bits of the key (the neighbors have close Morton indexes) */
+    static FSize Hash(const MortonIndex inKey){
+        unsigned long long value = static_cast<unsigned long long>(inKey);
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdULL;
+        value ^= value >> 33;
+        value *= 0xc4ceb9fe1a85ec53ULL;
+        value ^= value >> 33;
+        return FSize(value >> 1);
+    }
+
+public:
+    FCellHashMap() : capacity(0), nbCells(0), tableMask(0) {
+    }
+
+    /**
+     * Allocate the buffer for inCapacity cells and an empty table,
+     * the previous cells are removed (it is not thread safe).
+     */
+    void reserve(const FSize inCapacity){
+        cells.reset(inCapacity ? new CellClass[inCapacity] : nullptr);
+        capacity = inCapacity;
+        nbCells  = 0;
+        // The table is at most half full
+        FSize tableSize = 16;
+        while(tableSize < 2 * inCapacity){
+            tableSize <<= 1;
+        }
+        table.reset(new Entry[tableSize]);
+        tableMask = tableSize - 1;
+        for(FSize idxEntry = 0 ; idxEntry < tableSize ; ++idxEntry){
+            table[idxEntry].key.store(EmptyKey, std::memory_order_relaxed);
+            table[idxEntry].cell.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    /** Remove the cells and release the memory (it is not thread safe) */
+    void clear(){
+        cells.reset();
+        capacity  = 0;
+        nbCells   = 0;
+        table.reset();
+        tableMask = 0;
+    }
+
+    /** Take the next cell of the buffer (thread safe), it is not visible until insertCell */
+    CellClass* allocateCell(){
+        const FSize position = nbCells.fetch_add(1, std::memory_order_relaxed);
+        FAssertLF(position < capacity, "The cells map is full, reserve must be called with the number of cells");
+        return &cells[position];
+    }
+
+    /** Make a cell of the buffer visible at (inIndex, inLevel) (thread safe) */
+    void insertCell(const MortonIndex inIndex, const int inLevel, CellClass*const inCell){
+        FAssertLF(0 <= inIndex && inIndex < (MortonIndex(1) << LevelShift));
+        const MortonIndex key = BuildKey(inIndex, inLevel);
+        FSize position = Hash(key) & tableMask;
+        while(true){
+            MortonIndex currentKey = table[position].key.load(std::memory_order_acquire);
+            if(currentKey == EmptyKey){
+                if(table[position].key.compare_exchange_strong(currentKey, key, std::memory_order_acq_rel)){
+                    currentKey = key;
+                }
+            }
+            if(currentKey == key){
+                table[position].cell.store(inCell, std::memory_order_release);
+                return;
+            }
+            position = (position + 1) & tableMask;
+        }
+    }
+
+    /** The cell at (inIndex, inLevel), or nullptr if it has not been inserted (lock free) */
+    CellClass* getCell(const MortonIndex inIndex, const int inLevel) const {
+        if(!table){
+            return nullptr;
+        }
+        const MortonIndex key = BuildKey(inIndex, inLevel);
+        FSize position = Hash(key) & tableMask;
+        while(true){
+            const MortonIndex currentKey = table[position].key.load(std::memory_order_acquire);
+            if(currentKey == key){
+                return table[position].cell.load(std::memory_order_acquire);
+            }
+            if(currentKey == EmptyKey){
+                return nullptr;
+            }
+            position = (position + 1) & tableMask;
+        }
+    }
+
+    /** The number of cells taken in the buffer */
+    FSize getNbCells() const {
+        return nbCells.load(std::memory_order_relaxed);
+    }
+
+    /** The capacity of the buffer */
+    FSize getCapacity() const {
+        return capacity;
+    }
+
+    /** The buffer of cells */
+    CellClass* getCells(){
+        return cells.get();
+    }
+};
+
+#endif // FCELLHASHMAP_HPP
@@ -3,6 +3,7 @@
 
 #include "../Utils/FGlobal.hpp"
 #include "FTreeCoordinate.hpp"
+#include "FMortonCoding.hpp"
 #include "../Utils/FPoint.hpp"
 #include "../Utils/FMath.hpp"
 #include "../Utils/FAssert.hpp"
@@ -54,6 +55,41 @@ struct FCoordinateComputer {
     }
 
 
+    /**
+     * Compute the Morton indexes at the leaf level of a set of positions.
+     * The positions are converted in coordinates by blocks, and each block
+     * is encoded at once with FMortonCoding::EncodeArray.
+     * @param getPosition is called as getPosition(idxPosition) and returns the position
+     * @param setMortonIndex is called as setMortonIndex(idxPosition, index)
+     */
+    template <class FReal, class PositionGetterClass, class IndexSetterClass>
+    static inline void GetMortonIndexesFromPositions(const FPoint<FReal>& centerOfBox, const FReal boxWidth, const int treeHeight,
+                                                     const FSize nbPositions, PositionGetterClass&& getPosition,
+                                                     IndexSetterClass&& setMortonIndex) {
+        const FPoint<FReal> boxCorner(centerOfBox,-(boxWidth/2));
+        const FReal boxWidthAtLeafLevel(boxWidth/FReal(1<<(treeHeight-1)));
+
+        const FSize BlockSize = 256;
+        int coordinatesX[BlockSize];
+        int coordinatesY[BlockSize];
+        int coordinatesZ[BlockSize];
+        MortonIndex indexes[BlockSize];
+
+        for(FSize idxBlock = 0 ; idxBlock < nbPositions ; idxBlock += BlockSize){
+            const FSize nbInBlock = FMath::Min(BlockSize, nbPositions - idxBlock);
+            for(FSize idxPosition = 0 ; idxPosition < nbInBlock ; ++idxPosition){
+                const FPoint<FReal> pos = getPosition(idxBlock + idxPosition);
+                coordinatesX[idxPosition] = GetTreeCoordinate<FReal>( pos.getX() - boxCorner.getX(), boxWidth, boxWidthAtLeafLevel, treeHeight);
+                coordinatesY[idxPosition] = GetTreeCoordinate<FReal>( pos.getY() - boxCorner.getY(), boxWidth, boxWidthAtLeafLevel, treeHeight);
+                coordinatesZ[idxPosition] = GetTreeCoordinate<FReal>( pos.getZ() - boxCorner.getZ(), boxWidth, boxWidthAtLeafLevel, treeHeight);
+            }
+            FMortonCoding::EncodeArray(coordinatesX, coordinatesY, coordinatesZ, nbInBlock, indexes);
+            for(FSize idxPosition = 0 ; idxPosition < nbInBlock ; ++idxPosition){
+                setMortonIndex(idxBlock + idxPosition, indexes[idxPosition]);
+            }
+        }
+    }
+
     template <class FReal>
     static inline FPoint<FReal> GetPositionFromCoordinate(const FPoint<FReal>& centerOfBox, const FReal boxWidth, const int treeHeight,
                                               const FTreeCoordinate& pos) {
@@ -0,0 +1,794 @@
+// See LICENCE file at project root
+#ifndef FFLATOCTREE_HPP
+#define FFLATOCTREE_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <omp.h>
+
+#include "FTreeCoordinate.hpp"
+#include "FCoordinateComputer.hpp"
+
+#include "Utils/FLog.hpp"
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FPoint.hpp"
+#include "../Utils/FMath.hpp"
+#include "../Utils/FNoCopyable.hpp"
+#include "../Utils/FAssert.hpp"
+#include "../Utils/FTic.hpp"
+
+/**
+ * @class FFlatOctree
+ *
+ * This class is an octree container with the same interface as FOctree
+ * (insert, Iterator, getInteractionNeighbors, getLeafsNeighbors, forEach...)
+ * so it can be given to the FMM algorithms (FFmmAlgorithm, FFmmAlgorithmThread,
+ * FFmmAlgorithmTask...) instead of an FOctree.
+ *
+ * Instead of a hierarchy of sub-octrees, each level is stored as a sorted
+ * array of Morton indexes with the cells in one contiguous array, the
+ * parent and the children of a cell are given by their positions in the
+ * arrays of the levels above and below.
+ * When the tree is built (build(), called by the first Iterator after the
+ * insertions) the M2L interaction lists of all the levels and the P2P
+ * neighbors of the leaves are computed once, in parallel, and stored in
+ * CSR arrays (offsets per cell and one array for the level). The lists
+ * come from the colleagues (adjacent cells) of each cell, computed from
+ * the top with the colleagues of the parent, so there is no search.
+ * The neighbor requests of the algorithms only copy the list of the cell.
+ *
+ * Remarks :
+ * - The lists are precomputed for a separation criteria of 1, the other
+ *   values are computed at the request from the colleagues.
+ * - The leaves are allocated by blocks in the insertion order, they are
+ *   accessed in Morton order by an array of pointers.
+ * - Inserting a particle in a new leaf makes the tree not built, the next
+ *   build creates new cells (the content of the cells is lost).
+ * - The periodic requests and the removal of leaves are not supported.
+ * - The build is done once even if several threads create an Iterator at
+ *   the same time (std::call_once), the insertions are not thread safe.
+ */
+template<class FReal, class CellClass, class ContainerClass, class LeafClass_>
+class FFlatOctree : public FNoCopyable {
+public:
+    using FRealType = FReal;
+    using CellClassType      = CellClass;
+    using ContainerClassType = ContainerClass;   //< The type of the container used to store particles in the Octree
+    using LeafClassType      = LeafClass_;   //< The type of the Leaf used in the Octree
+    using LeafClass          = LeafClass_;     //< The type of the Leaf used in the Octree
+    using LeafClass_T        = LeafClass_;     //< The type of the Leaf used in the Octree
+
+protected:
+    /** A level of the tree, the cells are sorted by Morton index */
+    struct Level {
+        std::vector<MortonIndex> indexes;        //< Morton index of each cell
+        std::unique_ptr<CellClass[]> cells;      //< The cells
+        std::vector<int> parents;                //< Position of the parent in the level above
+        std::unique_ptr<CellClass*[]> children;  //< 8 pointers per cell (null if the child does not exist)
+        std::vector<int> firstChild;             //< Position of the first child in the level below (size+1 values)
+
+        std::vector<FSize> colleagueOffsets;       //< CSR offsets of the colleagues (adjacent cells and the cell itself)
+        std::unique_ptr<int[]> colleagues;         //< Position of the colleagues in the level
+        std::unique_ptr<int[]> colleaguePositions; //< Relative position of the colleagues (index in a 3x3x3 cube)
+
+        std::vector<FSize> m2lOffsets;             //< CSR offsets of the interaction lists (size+1 values)
+        std::unique_ptr<int[]> m2lCells;           //< The interaction lists (position of the cells in the level)
+        std::unique_ptr<int[]> m2lPositions;       //< The relative positions of the interactions
+
+        int size() const {
+            return int(indexes.size());
+        }
+    };
+
+    const int height;                   //< Total tree height
+    const int subHeight;                //< Kept for compatibility with FOctree
+    const int leafIndex;                //< index of leaf level
+
+    const FPoint<FReal> boxCenter;      //< the space system center
+    const FPoint<FReal> boxCorner;      //< the space system corner (used to compute morton index)
+    const FReal boxWidth;               //< the space system width
+
+    std::deque<LeafClass> leavesStorage;                  //< The leaves in insertion order
+    std::unordered_map<MortonIndex, LeafClass*> leavesMap; //< To find the leaf of a particle
+
+    bool isBuilt;
+    std::unique_ptr<std::once_flag> buildFlag; //< Renewed when the tree is no longer built
+    std::vector<Level> levels;           //< From 0 (unused) to height-1
+    std::vector<LeafClass*> leaves;      //< The leaves in Morton order
+
+    std::vector<FSize> p2pOffsets;                  //< CSR offsets of the leaves neighbors
+    std::unique_ptr<ContainerClass*[]> p2pLeaves;   //< The neighbors of the leaves
+    std::unique_ptr<int[]> p2pPositions;            //< The relative positions of the neighbors
+
+    /** Get the leaf coordinate from a position */
+    FTreeCoordinate getCoordinateFromPosition(const FPoint<FReal>& inPosition) const {
+        return FCoordinateComputer::GetCoordinateFromPositionAndCorner<FReal>(this->boxCorner, this->boxWidth, height, inPosition);
+    }
+
+    /** The position of a cell in its level or -1 */
+    int findCell(const int inLevel, const MortonIndex inIndex) const {
+        const std::vector<MortonIndex>& indexes = levels[inLevel].indexes;
+        const auto iter = std::lower_bound(indexes.begin(), indexes.end(), inIndex);
+        if(iter == indexes.end() || (*iter) != inIndex){
+            return -1;
+        }
+        return int(iter - indexes.begin());
+    }
+
+    /**
+     * The distance between a cell and a child of a colleague of its parent
+     * @param parentPosition the position of the colleague around the parent (index in a 3x3x3 cube)
+     * @param cousinPosition the position of the child in the colleague (Morton order)
+     * @param childPosition the position of the cell in its parent (Morton order)
+     */
+    static void GetCousinDistance(const int parentPosition, const int cousinPosition, const int childPosition,
+                                  int* xdiff, int* ydiff, int* zdiff){
+        (*xdiff) = 2 * (parentPosition / 9 - 1) + ((cousinPosition >> 2) & 1) - ((childPosition >> 2) & 1);
+        (*ydiff) = 2 * ((parentPosition / 3) % 3 - 1) + ((cousinPosition >> 1) & 1) - ((childPosition >> 1) & 1);
+        (*zdiff) = 2 * (parentPosition % 3 - 1) + (cousinPosition & 1) - (childPosition & 1);
+    }
+
+    /** Compute the M2L list of a cell of the tree from the colleagues of its parent (same order as FOctree) */
+    int computeInteractionNeighbors(const CellClass* inNeighbors[342], int inNeighborPositions[342],
+                                    const int idxCell, const int inLevel, const int neighSeparation) const {
+        const Level& level = levels[inLevel];
+        const Level& parentLevel = levels[inLevel-1];
+        const int idxParent = level.parents[idxCell];
+        const int childPosition = int(level.indexes[idxCell] & 7);
+
+        int idxNeighbors = 0;
+        for(FSize idxColleague = parentLevel.colleagueOffsets[idxParent] ; idxColleague < parentLevel.colleagueOffsets[idxParent+1] ; ++idxColleague){
+            const int parentPosition = parentLevel.colleaguePositions[idxColleague];
+            // The children of the parent are all adjacent
+            if(neighSeparation >= 1 && parentPosition == 13){
+                continue;
+            }
+            CellClass*const* const cells = &parentLevel.children[8 * parentLevel.colleagues[idxColleague]];
+            for(int idxCousin = 0 ; idxCousin < 8 ; ++idxCousin){
+                if(cells[idxCousin]){
+                    int xdiff, ydiff, zdiff;
+                    GetCousinDistance(parentPosition, idxCousin, childPosition, &xdiff, &ydiff, &zdiff);
+
+                    if(FMath::Abs(xdiff) > neighSeparation || FMath::Abs(ydiff) > neighSeparation || FMath::Abs(zdiff) > neighSeparation){
+                        inNeighbors[idxNeighbors] = cells[idxCousin];
+                        inNeighborPositions[idxNeighbors] = (((xdiff+3) * 7) + (ydiff+3)) * 7 + zdiff + 3;
+                        ++idxNeighbors;
+                    }
+                }
+            }
+        }
+        return idxNeighbors;
+    }
+
+    /** Search the M2L list of a cell that is not in the tree (same order as FOctree) */
+    int searchInteractionNeighbors(const CellClass* inNeighbors[342], int inNeighborPositions[342],
+                                    const FTreeCoordinate& workingCell, const int inLevel, const int neighSeparation) const {
+        const FTreeCoordinate parentCell(workingCell.getX()>>1,workingCell.getY()>>1,workingCell.getZ()>>1);
+        const int boxLimite = FMath::pow2(inLevel-1);
+        const Level& parentLevel = levels[inLevel-1];
+
+        int idxNeighbors = 0;
+        for(int idxX = -1 ; idxX <= 1 ; ++idxX){
+            if(!FMath::Between(parentCell.getX() + idxX,0,boxLimite)) continue;
+            for(int idxY = -1 ; idxY <= 1 ; ++idxY){
+                if(!FMath::Between(parentCell.getY() + idxY,0,boxLimite)) continue;
+                for(int idxZ = -1 ; idxZ <= 1 ; ++idxZ){
+                    if(!FMath::Between(parentCell.getZ() + idxZ,0,boxLimite)) continue;
+
+                    if( neighSeparation<1 || idxX || idxY || idxZ ){
+                        const FTreeCoordinate otherParent(parentCell.getX() + idxX,parentCell.getY() + idxY,parentCell.getZ() + idxZ);
+                        // At level 1 the parent is the root, all the cells of level 1 are its children
+                        const int idxParent = (inLevel == 1 ? 0 : findCell(inLevel-1, otherParent.getMortonIndex()));
+                        if(idxParent == -1){
+                            continue;
+                        }
+                        CellClass*const* const cells = &parentLevel.children[8 * idxParent];
+                        for(int idxCousin = 0 ; idxCousin < 8 ; ++idxCousin){
+                            if(cells[idxCousin]){
+                                const int xdiff  = ((otherParent.getX()<<1) | ( (idxCousin>>2) & 1)) - workingCell.getX();
+                                const int ydiff  = ((otherParent.getY()<<1) | ( (idxCousin>>1) & 1)) - workingCell.getY();
+                                const int zdiff  = ((otherParent.getZ()<<1) | (idxCousin&1)) - workingCell.getZ();
+
+                                if(FMath::Abs(xdiff) > neighSeparation || FMath::Abs(ydiff) > neighSeparation || FMath::Abs(zdiff) > neighSeparation){
+                                    inNeighbors[idxNeighbors] = cells[idxCousin];
+                                    inNeighborPositions[idxNeighbors] = (((xdiff+3) * 7) + (ydiff+3)) * 7 + zdiff + 3;
+                                    ++idxNeighbors;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        return idxNeighbors;
+    }
+
+    /** Search the P2P neighbors of a leaf that is not in the tree (same order as FOctree) */
+    int searchLeafsNeighbors(ContainerClass* inNeighbors[26], int inNeighborPositions[26], const FTreeCoordinate& center) const {
+        const int boxLimite = FMath::pow2(leafIndex);
+        int idxNeighbors = 0;
+        for(int idxX = -1 ; idxX <= 1 ; ++idxX){
+            if(!FMath::Between(center.getX() + idxX,0,boxLimite)) continue;
+            for(int idxY = -1 ; idxY <= 1 ; ++idxY){
+                if(!FMath::Between(center.getY() + idxY,0,boxLimite)) continue;
+                for(int idxZ = -1 ; idxZ <= 1 ; ++idxZ){
+                    if(!FMath::Between(center.getZ() + idxZ,0,boxLimite)) continue;
+                    if( idxX || idxY || idxZ ){
+                        const FTreeCoordinate other(center.getX() + idxX,center.getY() + idxY,center.getZ() + idxZ);
+                        const int idxLeaf = findCell(leafIndex, other.getMortonIndex());
+                        if(idxLeaf != -1){
+                            inNeighbors[idxNeighbors] = leaves[idxLeaf]->getSrc();
+                            inNeighborPositions[idxNeighbors] = (((idxX + 1) * 3) + (idxY +1)) * 3 + idxZ + 1;
+                            ++idxNeighbors;
+                        }
+                    }
+                }
+            }
+        }
+        return idxNeighbors;
+    }
+
+    /**
+     * Fill CSR lists in parallel, countList(idxCell) gives the size of the list of a cell
+     * and fillList(idxCell, values, positions) fills it. The arrays are not initialized,
+     * they are first touched by the threads that fill them.
+     */
+    template <class ValueType, class CountFunction, class FillFunction>
+    static void BuildCsr(const int nbCells, std::vector<FSize>* offsets, std::unique_ptr<ValueType[]>* values,
+                         std::unique_ptr<int[]>* positions, CountFunction&& countList, FillFunction&& fillList){
+        offsets->resize(nbCells + 1);
+        (*offsets)[0] = 0;
+        #pragma omp parallel for schedule(static)
+        for(int idxCell = 0 ; idxCell < nbCells ; ++idxCell){
+            (*offsets)[idxCell + 1] = countList(idxCell);
+        }
+        for(int idxCell = 0 ; idxCell < nbCells ; ++idxCell){
+            (*offsets)[idxCell + 1] += (*offsets)[idxCell];
+        }
+        values->reset(new ValueType[(*offsets)[nbCells]]);
+        positions->reset(new int[(*offsets)[nbCells]]);
+        #pragma omp parallel for schedule(static)
+        for(int idxCell = 0 ; idxCell < nbCells ; ++idxCell){
+            fillList(idxCell, values->get() + (*offsets)[idxCell], positions->get() + (*offsets)[idxCell]);
+        }
+    }
+
+public:
+    /**
+     * Constructor
+     * @param inHeight the octree height
+     * @param inSubHeight not used, to have the same constructor as FOctree
+     * @param inBoxWidth box width for this simulation
+     * @param inBoxCenter box center for this simulation
+     */
+    FFlatOctree(const int inHeight, const int inSubHeight,
+                const FReal inBoxWidth, const FPoint<FReal>& inBoxCenter)
+        : height(inHeight) , subHeight(inSubHeight), leafIndex(inHeight-1),
+          boxCenter(inBoxCenter), boxCorner(inBoxCenter,-(inBoxWidth/2)), boxWidth(inBoxWidth),
+          isBuilt(false), buildFlag(new std::once_flag), levels(inHeight) {
+        FAssertLF(height >= 2, "FFlatOctree height must be at least 2");
+    }
+
+    /** To get the tree height */
+    int getHeight() const {
+        return this->height;
+    }
+
+    /** To get the tree subheight (not used by this tree) */
+    int getSubHeight() const{
+        return this->subHeight;
+    }
+
+    /** To get the box width */
+    FReal getBoxWidth() const{
+        return this->boxWidth;
+    }
+
+    /** To get the center of the box */
+    const FPoint<FReal>& getBoxCenter() const{
+        return this->boxCenter;
+    }
+
+    /** Insert a particle in its leaf, the leaf is created if needed */
+    template<typename... Args>
+    void insert(const FPoint<FReal>& inParticlePosition, Args... args){
+        const MortonIndex particleIndex = getCoordinateFromPosition( inParticlePosition ).getMortonIndex();
+        createLeaf(particleIndex)->push(inParticlePosition, args...);
+    }
+
+    /** Create a leaf from its morton index (or return the existing one)
+     * @param indexToCreate the Morton index of the leaf to create
+     * @return a pointer on the leaf
+     */
+    LeafClass* createLeaf(const MortonIndex indexToCreate){
+        LeafClass*& leaf = leavesMap[indexToCreate];
+        if(leaf == nullptr){
+            leavesStorage.emplace_back();
+            leaf = &leavesStorage.back();
+            if(isBuilt){
+                isBuilt = false;
+                buildFlag.reset(new std::once_flag);
+            }
+        }
+        return leaf;
+    }
+
+    /** Get a morton index from a real position */
+    MortonIndex getMortonFromPosition(const FPoint<FReal>& position) const {
+        return getCoordinateFromPosition(position).getMortonIndex();
+    }
+
+    /** Indicate if tree is empty or not. */
+    bool isEmpty() const {
+        return leavesMap.empty();
+    }
+
+    /** To know if the cells and the lists are up to date with the leaves */
+    bool isTreeBuilt() const {
+        return isBuilt;
+    }
+
+    /** Build the tree if it is not built, the concurrent calls wait for the first one */
+    void ensureBuilt(){
+        std::call_once(*buildFlag, [this](){
+            if(isBuilt == false){
+                build();
+            }
+        });
+    }
+
+    /**
+     * Create the levels from the leaves and compute the interaction lists,
+     * it is called by the Iterator (with ensureBuilt) if the tree is not built.
+     */
+    void build(){
+        FLOG(FTic counterTime);
+
+        // The leaves in Morton order
+        std::vector<std::pair<MortonIndex,LeafClass*>> sortedLeaves(leavesMap.begin(), leavesMap.end());
+        std::sort(sortedLeaves.begin(), sortedLeaves.end(), [](const std::pair<MortonIndex,LeafClass*>& l1, const std::pair<MortonIndex,LeafClass*>& l2){
+            return l1.first < l2.first;
+        });
+        leaves.resize(sortedLeaves.size());
+        levels[leafIndex].indexes.resize(sortedLeaves.size());
+        for(size_t idxLeaf = 0 ; idxLeaf < sortedLeaves.size() ; ++idxLeaf){
+            levels[leafIndex].indexes[idxLeaf] = sortedLeaves[idxLeaf].first;
+            leaves[idxLeaf] = sortedLeaves[idxLeaf].second;
+        }
+
+        // The indexes of the upper levels and the parents
+        for(int idxLevel = leafIndex ; idxLevel >= 1 ; --idxLevel){
+            Level& level = levels[idxLevel];
+            level.parents.resize(level.size());
+            if(idxLevel != 1){
+                std::vector<MortonIndex>& parentIndexes = levels[idxLevel-1].indexes;
+                parentIndexes.clear();
+                for(int idxCell = 0 ; idxCell < level.size() ; ++idxCell){
+                    const MortonIndex parentIndex = (level.indexes[idxCell] >> 3);
+                    if(parentIndexes.empty() || parentIndexes.back() != parentIndex){
+                        parentIndexes.push_back(parentIndex);
+                    }
+                    level.parents[idxCell] = int(parentIndexes.size()) - 1;
+                }
+            }
+            else{
+                std::fill(level.parents.begin(), level.parents.end(), 0);
+            }
+        }
+
+        // The cells and the links
+        for(int idxLevel = 1 ; idxLevel <= leafIndex ; ++idxLevel){
+            Level& level = levels[idxLevel];
+            const int nbCells = level.size();
+            level.cells.reset(new CellClass[nbCells]);
+            #pragma omp parallel for schedule(static)
+            for(int idxCell = 0 ; idxCell < nbCells ; ++idxCell){
+                CellClass& cell = level.cells[idxCell];
+                cell.setMortonIndex(level.indexes[idxCell]);
+                cell.setCoordinate(FTreeCoordinate(level.indexes[idxCell]));
+                cell.setLevel(idxLevel);
+            }
+        }
+        // The root (level 0) only has children
+        levels[0].indexes.assign(1, 0);
+        for(int idxLevel = 0 ; idxLevel < leafIndex ; ++idxLevel){
+            Level& level = levels[idxLevel];
+            const Level& lowerLevel = levels[idxLevel+1];
+            const int nbCells = level.size();
+            level.children.reset(new CellClass*[8 * nbCells]);
+            std::fill(level.children.get(), level.children.get() + 8 * nbCells, nullptr);
+            level.firstChild.assign(nbCells + 1, lowerLevel.size());
+            for(int idxChild = lowerLevel.size() - 1 ; idxChild >= 0 ; --idxChild){
+                const int idxParent = lowerLevel.parents[idxChild];
+                level.firstChild[idxParent] = idxChild;
+                level.children[8 * idxParent + (lowerLevel.indexes[idxChild] & 7)] = &lowerLevel.cells[idxChild];
+            }
+        }
+
+        // The colleagues from the top, the colleagues of a cell are children of the colleagues of its parent
+        levels[0].colleagueOffsets = {0, 1};
+        levels[0].colleagues.reset(new int[1]{0});
+        levels[0].colleaguePositions.reset(new int[1]{13});
+        for(int idxLevel = 1 ; idxLevel <= leafIndex ; ++idxLevel){
+            const Level& level = levels[idxLevel];
+            const Level& parentLevel = levels[idxLevel-1];
+            auto computeColleagues = [&](const int idxCell, int* outColleagues, int* outPositions){
+                const int idxParent = level.parents[idxCell];
+                const int childPosition = int(level.indexes[idxCell] & 7);
+                int colleaguesByPosition[27];
+                std::fill(colleaguesByPosition, colleaguesByPosition + 27, -1);
+                for(FSize idxColleague = parentLevel.colleagueOffsets[idxParent] ; idxColleague < parentLevel.colleagueOffsets[idxParent+1] ; ++idxColleague){
+                    const int parentPosition = parentLevel.colleaguePositions[idxColleague];
+                    CellClass*const* const cells = &parentLevel.children[8 * parentLevel.colleagues[idxColleague]];
+                    for(int idxCousin = 0 ; idxCousin < 8 ; ++idxCousin){
+                        if(cells[idxCousin]){
+                            int xdiff, ydiff, zdiff;
+                            GetCousinDistance(parentPosition, idxCousin, childPosition, &xdiff, &ydiff, &zdiff);
+                            if(FMath::Abs(xdiff) <= 1 && FMath::Abs(ydiff) <= 1 && FMath::Abs(zdiff) <= 1){
+                                colleaguesByPosition[(((xdiff + 1) * 3) + (ydiff +1)) * 3 + zdiff + 1] = int(cells[idxCousin] - level.cells.get());
+                            }
+                        }
+                    }
+                }
+                int counter = 0;
+                for(int idxPosition = 0 ; idxPosition < 27 ; ++idxPosition){
+                    if(colleaguesByPosition[idxPosition] != -1){
+                        outColleagues[counter] = colleaguesByPosition[idxPosition];
+                        outPositions[counter] = idxPosition;
+                        ++counter;
+                    }
+                }
+                return counter;
+            };
+            BuildCsr(level.size(), &levels[idxLevel].colleagueOffsets, &levels[idxLevel].colleagues, &levels[idxLevel].colleaguePositions,
+                     [&](const int idxCell){
+                int bufferColleagues[27];
+                int bufferPositions[27];
+                return computeColleagues(idxCell, bufferColleagues, bufferPositions);
+            }, computeColleagues);
+        }
+
+        // The interaction lists
+        for(int idxLevel = 2 ; idxLevel <= leafIndex ; ++idxLevel){
+            Level& level = levels[idxLevel];
+            const Level& parentLevel = levels[idxLevel-1];
+            BuildCsr(level.size(), &level.m2lOffsets, &level.m2lCells, &level.m2lPositions,
+                     [&](const int idxCell){
+                // The children of the colleagues of the parent that are not colleagues of the cell
+                const int idxParent = level.parents[idxCell];
+                int counter = 0;
+                for(FSize idxColleague = parentLevel.colleagueOffsets[idxParent] ; idxColleague < parentLevel.colleagueOffsets[idxParent+1] ; ++idxColleague){
+                    const int idxOtherParent = parentLevel.colleagues[idxColleague];
+                    counter += parentLevel.firstChild[idxOtherParent+1] - parentLevel.firstChild[idxOtherParent];
+                }
+                return counter - int(level.colleagueOffsets[idxCell+1] - level.colleagueOffsets[idxCell]);
+            }, [&](const int idxCell, int* outCells, int* outPositions){
+                const CellClass* neighbors[342];
+                const int counter = computeInteractionNeighbors(neighbors, outPositions, idxCell, idxLevel, 1);
+                for(int idxNeighbor = 0 ; idxNeighbor < counter ; ++idxNeighbor){
+                    outCells[idxNeighbor] = int(neighbors[idxNeighbor] - level.cells.get());
+                }
+            });
+        }
+        // The P2P neighbors are the colleagues of the leaves
+        const Level& leafLevel = levels[leafIndex];
+        BuildCsr(leafLevel.size(), &p2pOffsets, &p2pLeaves, &p2pPositions,
+                 [&](const int idxLeaf){
+            return int(leafLevel.colleagueOffsets[idxLeaf+1] - leafLevel.colleagueOffsets[idxLeaf]) - 1;
+        }, [&](const int idxLeaf, ContainerClass** outLeaves, int* outPositions){
+            int counter = 0;
+            for(FSize idxColleague = leafLevel.colleagueOffsets[idxLeaf] ; idxColleague < leafLevel.colleagueOffsets[idxLeaf+1] ; ++idxColleague){
+                if(leafLevel.colleaguePositions[idxColleague] != 13){
+                    outLeaves[counter] = leaves[leafLevel.colleagues[idxColleague]]->getSrc();
+                    outPositions[counter] = leafLevel.colleaguePositions[idxColleague];
+                    ++counter;
+                }
+            }
+        });
+
+        isBuilt = true;
+        FLOG( FSize nbM2LInteractions = 0 );
+        FLOG( for(int idxLevel = 2 ; idxLevel <= leafIndex ; ++idxLevel) nbM2LInteractions += levels[idxLevel].m2lOffsets.back() );
+        FLOG( FLog::Controller << "FFlatOctree built " << leaves.size() << " leaves, " << p2pOffsets.back() << " P2P and "
+              << nbM2LInteractions << " M2L interactions (" << counterTime.tacAndElapsed() << "s)\n" );
+    }
+
+    /** The number of cells of a level, the tree must be built */
+    int getNbCellsAtLevel(const int inLevel) const {
+        FAssertLF(isBuilt, "FFlatOctree must be built");
+        return levels[inLevel].size();
+    }
+
+    /** Count the number of cells per level */
+    void getNbCellsPerLevel(int inNbCells[]){
+        ensureBuilt();
+        for(int idxLevel = 1 ; idxLevel < height ; ++idxLevel){
+            inNbCells[idxLevel] = levels[idxLevel].size();
+        }
+        inNbCells[0] = 0;
+    }
+
+    /**
+     * Iterator on the flat levels, same interface as FOctree::Iterator.
+     * The iterator is a level and a position in the level.
+     */
+    class Iterator {
+        FFlatOctree* tree;
+        int currentLevel;
+        int currentIndex;
+
+    public:
+        /**
+         * After building a iterator, this one is positioned at the level 1
+         * of the octree at the left limit index
+         */
+        explicit Iterator(FFlatOctree* const inTarget)
+            : tree(inTarget), currentLevel(1), currentIndex(0) {
+            FAssertLF(inTarget, "Target for FFlatOctree::Iterator cannot be null", __LINE__, __FILE__);
+            FAssertLF(inTarget->isEmpty() == false, "Octree seems to be empty", __LINE__, __FILE__);
+            tree->ensureBuilt();
+        }
+
+        Iterator() : tree(nullptr), currentLevel(0), currentIndex(0) {
+        }
+
+        bool operator==(const Iterator& other) const {
+            return tree == other.tree && currentLevel == other.currentLevel && currentIndex == other.currentIndex;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !((*this) == other);
+        }
+
+        /** Move to the top of the tree (level 1) on the ancestor of the current cell */
+        void gotoTop(){
+            while(moveUp()){
+            }
+        }
+
+        /** Move to the left-most leaf */
+        void gotoBottomLeft(){
+            currentLevel = tree->leafIndex;
+            currentIndex = 0;
+        }
+
+        /** Move to the left-most cell of the current level */
+        void gotoLeft(){
+            currentIndex = 0;
+        }
+
+        /** Move to the right-most cell of the current level */
+        void gotoRight(){
+            currentIndex = tree->levels[currentLevel].size() - 1;
+        }
+
+        /** Move to the next cell of the level, return false if there is no more cell */
+        bool moveRight(){
+            if(currentIndex + 1 < tree->levels[currentLevel].size()){
+                ++currentIndex;
+                return true;
+            }
+            return false;
+        }
+
+        /** Move to the parent of the current cell */
+        bool moveUp() {
+            if(currentLevel > 1){
+                currentIndex = tree->levels[currentLevel].parents[currentIndex];
+                --currentLevel;
+                return true;
+            }
+            return false;
+        }
+
+        /** Move to the first child of the current cell */
+        bool moveDown(){
+            if(currentLevel < tree->leafIndex){
+                currentIndex = tree->levels[currentLevel].firstChild[currentIndex];
+                ++currentLevel;
+                return true;
+            }
+            return false;
+        }
+
+        bool canProgressToUp() const {
+            return currentLevel > 1;
+        }
+
+        bool canProgressToDown() const {
+            return currentLevel < tree->leafIndex;
+        }
+
+        bool isAtLeafLevel() const {
+            return currentLevel == tree->leafIndex;
+        }
+
+        /** The level in the entire octree */
+        int level() const {
+            return currentLevel;
+        }
+
+        /** The position of the current cell in its level (the same as for FFlatOctree::getCellAt) */
+        int getCurrentPosition() const {
+            return currentIndex;
+        }
+
+        LeafClass* getCurrentLeaf() const {
+            return tree->leaves[currentIndex];
+        }
+
+        ContainerClass* getCurrentListSrc() const {
+            return tree->leaves[currentIndex]->getSrc();
+        }
+
+        ContainerClass* getCurrentListTargets() const {
+            return tree->leaves[currentIndex]->getTargets();
+        }
+
+        CellClass* getCurrentCell() const {
+            return &tree->levels[currentLevel].cells[currentIndex];
+        }
+
+        /** The 8 children of the current cell, a missing child is null */
+        CellClass** getCurrentChild() const {
+            return &tree->levels[currentLevel].children[8 * currentIndex];
+        }
+
+        CellClass** getCurrentChildren() const {
+            return getCurrentChild();
+        }
+
+        /** The current cell siblings array (including the current cell) */
+        CellClass** getCurrentBox() const {
+            return &tree->levels[currentLevel-1].children[8 * tree->levels[currentLevel].parents[currentIndex]];
+        }
+
+        MortonIndex getCurrentGlobalIndex() const{
+            return tree->levels[currentLevel].indexes[currentIndex];
+        }
+
+        const FTreeCoordinate& getCurrentGlobalCoordinate() const{
+            return tree->levels[currentLevel].cells[currentIndex].getCoordinate();
+        }
+    };
+
+    friend class Iterator;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // This part is related to the FMM algorithm (needed by M2M,M2L,etc.)
+    ///////////////////////////////////////////////////////////////////////////
+
+    /** Return a cell (if it exists) from a morton index and a level */
+    CellClass* getCell(const MortonIndex inIndex, const int inLevel) const{
+        const int idxCell = findCell(inLevel, inIndex);
+        return (idxCell == -1 ? nullptr : &levels[inLevel].cells[idxCell]);
+    }
+
+    /** Return the cell at a position of a level (see Iterator::getCurrentPosition) */
+    CellClass* getCellAt(const int inPosition, const int inLevel) const{
+        return &levels[inLevel].cells[inPosition];
+    }
+
+    /** Return a leaf container (if it exists) from a morton index */
+    ContainerClass* getLeafSrc(const MortonIndex inIndex){
+        const auto iter = leavesMap.find(inIndex);
+        return (iter == leavesMap.end() ? nullptr : iter->second->getSrc());
+    }
+
+    /** The M2L list of a cell, the cells and their positions (index in a 7x7x7 cube) are copied */
+    int getInteractionNeighbors(const CellClass* inNeighbors[342], int inNeighborPositions[342],
+                                const FTreeCoordinate& workingCell, const int inLevel, const int neighSeparation = 1) const{
+        const int idxCell = findCell(inLevel, workingCell.getMortonIndex());
+        if(idxCell == -1){
+            return searchInteractionNeighbors(inNeighbors, inNeighborPositions, workingCell, inLevel, neighSeparation);
+        }
+        if(neighSeparation != 1){
+            return computeInteractionNeighbors(inNeighbors, inNeighborPositions, idxCell, inLevel, neighSeparation);
+        }
+        const Level& level = levels[inLevel];
+        const FSize first = level.m2lOffsets[idxCell];
+        const int counter = int(level.m2lOffsets[idxCell+1] - first);
+        for(int idxNeighbor = 0 ; idxNeighbor < counter ; ++idxNeighbor){
+            inNeighbors[idxNeighbor] = &level.cells[level.m2lCells[first + idxNeighbor]];
+        }
+        std::copy(level.m2lPositions.get() + first, level.m2lPositions.get() + first + counter, inNeighborPositions);
+        return counter;
+    }
+
+    /** The M2L list of a cell, each cell is put at its position in a 7x7x7 cube */
+    int getInteractionNeighbors(const CellClass* inNeighbors[343],
+                                const FTreeCoordinate& workingCell, const int inLevel, const int neighSeparation = 1) const{
+        memset(inNeighbors, 0, sizeof(CellClass*) * 343);
+        const CellClass* neighbors[342];
+        int neighborPositions[342];
+        const int counter = getInteractionNeighbors(neighbors, neighborPositions, workingCell, inLevel, neighSeparation);
+        for(int idxNeighbor = 0 ; idxNeighbor < counter ; ++idxNeighbor){
+            inNeighbors[neighborPositions[idxNeighbor]] = neighbors[idxNeighbor];
+        }
+        return counter;
+    }
+
+    /** The P2P neighbors of a leaf and their positions (index in a 3x3x3 cube) */
+    int getLeafsNeighbors(ContainerClass* inNeighbors[26], int inNeighborPositions[26], const FTreeCoordinate& center, const int inLevel){
+        FAssertLF(inLevel == leafIndex, "FFlatOctree only gives the neighbors at the leaf level");
+        const int idxLeaf = findCell(leafIndex, center.getMortonIndex());
+        if(idxLeaf != -1){
+            const FSize first = p2pOffsets[idxLeaf];
+            const int counter = int(p2pOffsets[idxLeaf+1] - first);
+            std::copy(p2pLeaves.get() + first, p2pLeaves.get() + first + counter, inNeighbors);
+            std::copy(p2pPositions.get() + first, p2pPositions.get() + first + counter, inNeighborPositions);
+            return counter;
+        }
+        return searchLeafsNeighbors(inNeighbors, inNeighborPositions, center);
+    }
+
+    /** The P2P neighbors of a leaf, each is put at its position in a 3x3x3 cube */
+    int getLeafsNeighbors(ContainerClass* inNeighbors[27], const FTreeCoordinate& center, const int inLevel){
+        memset(inNeighbors, 0, 27 * sizeof(ContainerClass*));
+        ContainerClass* neighbors[26];
+        int neighborPositions[26];
+        const int counter = getLeafsNeighbors(neighbors, neighborPositions, center, inLevel);
+        for(int idxNeighbor = 0 ; idxNeighbor < counter ; ++idxNeighbor){
+            inNeighbors[neighborPositions[idxNeighbor]] = neighbors[idxNeighbor];
+        }
+        return counter;
+    }
+
+    /////////////////////////////////////////////////////////
+    // Lambda function to apply to all member
+    /////////////////////////////////////////////////////////
+
+    /** Apply the function to each leaf, `Ret(LeafClass*)` */
+    template<class F>
+    void forEachLeaf(F&& function){
+        if(isEmpty()){
+            return;
+        }
+        ensureBuilt();
+        for(LeafClass* leaf : leaves){
+            function(leaf);
+        }
+    }
+
+    /** Apply the function to each cell from the leaves to the top, `Ret(CellClass*)` */
+    template<class F>
+    void forEachCell(F&& function){
+        forEachCellWithLevel([&](CellClass* cell, const int /*level*/){
+            function(cell);
+        });
+    }
+
+    /** Apply the function to each cell from the leaves to the top, `Ret(CellClass*, int level)` */
+    template<class F>
+    void forEachCellWithLevel(F&& function){
+        if(isEmpty()){
+            return;
+        }
+        ensureBuilt();
+        for(int idxLevel = height-1 ; idxLevel >= 1 ; --idxLevel ){
+            for(int idxCell = 0 ; idxCell < levels[idxLevel].size() ; ++idxCell){
+                function(&levels[idxLevel].cells[idxCell], idxLevel);
+            }
+        }
+    }
+
+    /** Apply the function to each leaf and its cell, `Ret(CellClass*, LeafClass*)` */
+    template<class F>
+    void forEachCellLeaf(F function){
+        if(isEmpty()){
+            return;
+        }
+        ensureBuilt();
+        for(size_t idxLeaf = 0 ; idxLeaf < leaves.size() ; ++idxLeaf){
+            function(&levels[leafIndex].cells[idxLeaf], leaves[idxLeaf]);
+        }
+    }
+};
+
+#endif // FFLATOCTREE_HPP
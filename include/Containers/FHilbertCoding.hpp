@@ -0,0 +1,134 @@
+// See LICENCE file at project root
+#ifndef FHILBERTCODING_HPP
+#define FHILBERTCODING_HPP
+
+#include "Utils/FGlobal.hpp"
+#include "FMortonCoding.hpp"
+
+/** The order used to sort the leaves and the cells of a level */
+enum class FSpaceFillingCurve {
+    Morton,
+    Hilbert
+};
+
+/**
+ * @brief The FHilbertCoding struct computes the Hilbert keys of the cells.
+ *
+ * The keys are computed with the transpose algorithm of J. Skilling
+ * ("Programming the Hilbert curve", 2004): the coordinates are transformed
+ * from the highest bit to the lowest, and the result is interleaved as a
+ * Morton index. A bit of the key only depends on the bits of the
+ * coordinates at the same position or higher, so the key of a cell at
+ * level L-1 is the key of any of its children at level L shifted by 3.
+ * Then, as with the Morton indexes, a cell of key k at level l covers the
+ * keys [k << 3(L-l), (k+1) << 3(L-l)[ at level L (see GetLeafInterval).
+ *
+ * Two consecutive keys of a level are always two cells that share a face,
+ * so a range of keys is more compact than the same range of Morton indexes.
+ * The level is the number of bits of the coordinates (the level in the tree).
+ */
+struct FHilbertCoding {
+    /** The Hilbert key of the cell at coordinate (x,y,z) at level inLevel */
+    static MortonIndex Encode(const int inX, const int inY, const int inZ, const int inLevel){
+        if(inLevel <= 0){
+            return 0;
+        }
+        unsigned coordinates[3] = {unsigned(inX), unsigned(inY), unsigned(inZ)};
+        const unsigned highestBit = 1U << (inLevel - 1);
+
+        // Inverse undo excess work
+        for(unsigned bit = highestBit ; bit > 1 ; bit >>= 1){
+            const unsigned lowerBits = bit - 1;
+            for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                if(coordinates[idxDim] & bit){
+                    coordinates[0] ^= lowerBits;
+                }
+                else{
+                    const unsigned exchange = (coordinates[0] ^ coordinates[idxDim]) & lowerBits;
+                    coordinates[0] ^= exchange;
+                    coordinates[idxDim] ^= exchange;
+                }
+            }
+        }
+
+        // Gray encode
+        coordinates[1] ^= coordinates[0];
+        coordinates[2] ^= coordinates[1];
+        unsigned flip = 0;
+        for(unsigned bit = highestBit ; bit > 1 ; bit >>= 1){
+            if(coordinates[2] & bit){
+                flip ^= bit - 1;
+            }
+        }
+        coordinates[0] ^= flip;
+        coordinates[1] ^= flip;
+        coordinates[2] ^= flip;
+
+        return FMortonCoding::Encode(int(coordinates[0]), int(coordinates[1]), int(coordinates[2]));
+    }
+
+    /** The coordinate of the cell of Hilbert key inKey at level inLevel */
+    static void Decode(const MortonIndex inKey, const int inLevel, int* outX, int* outY, int* outZ){
+        int transposed[3] = {0, 0, 0};
+        if(inLevel > 0){
+            FMortonCoding::Decode(inKey, &transposed[0], &transposed[1], &transposed[2]);
+        }
+        unsigned coordinates[3] = {unsigned(transposed[0]), unsigned(transposed[1]), unsigned(transposed[2])};
+        const unsigned endBit = (inLevel > 0 ? 2U << (inLevel - 1) : 2U);
+
+        // Gray decode
+        const unsigned flip = coordinates[2] >> 1;
+        coordinates[2] ^= coordinates[1];
+        coordinates[1] ^= coordinates[0];
+        coordinates[0] ^= flip;
+
+        // Undo excess work
+        for(unsigned bit = 2 ; bit < endBit ; bit <<= 1){
+            const unsigned lowerBits = bit - 1;
+            for(int idxDim = 2 ; idxDim >= 0 ; --idxDim){
+                if(coordinates[idxDim] & bit){
+                    coordinates[0] ^= lowerBits;
+                }
+                else{
+                    const unsigned exchange = (coordinates[0] ^ coordinates[idxDim]) & lowerBits;
+                    coordinates[0] ^= exchange;
+                    coordinates[idxDim] ^= exchange;
+                }
+            }
+        }
+
+        (*outX) = int(coordinates[0]);
+        (*outY) = int(coordinates[1]);
+        (*outZ) = int(coordinates[2]);
+    }
+
+    /** The Hilbert key of the cell of Morton index inIndex at level inLevel */
+    static MortonIndex MortonToHilbert(const MortonIndex inIndex, const int inLevel){
+        int x, y, z;
+        FMortonCoding::Decode(inIndex, &x, &y, &z);
+        return Encode(x, y, z, inLevel);
+    }
+
+    /** The Morton index of the cell of Hilbert key inKey at level inLevel */
+    static MortonIndex HilbertToMorton(const MortonIndex inKey, const int inLevel){
+        int x, y, z;
+        Decode(inKey, inLevel, &x, &y, &z);
+        return FMortonCoding::Encode(x, y, z);
+    }
+
+    /** The keys at level inLeafLevel of the cells under the cell of key inKey at level inLevel,
+     * the interval is [outFirst, outLast] (the same relation holds for the Morton indexes) */
+    static void GetLeafInterval(const MortonIndex inKey, const int inLevel, const int inLeafLevel,
+                                MortonIndex* outFirst, MortonIndex* outLast){
+        const int shift = 3 * (inLeafLevel - inLevel);
+        (*outFirst) = (inKey << shift);
+        (*outLast)  = ((inKey + 1) << shift) - 1;
+    }
+
+    /** The key of a cell at level inLevel in the order inCurve (the Morton index is the key of the Morton order) */
+    static MortonIndex GetKey(const FSpaceFillingCurve inCurve, const MortonIndex inIndex, const int inLevel){
+        return (inCurve == FSpaceFillingCurve::Hilbert ? MortonToHilbert(inIndex, inLevel) : inIndex);
+    }
+};
+
+#endif // FHILBERTCODING_HPP
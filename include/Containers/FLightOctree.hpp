@@ -8,6 +8,7 @@
 * it is used to store small data in an octree way.
 * @warning It can only store one level of data!
 * As it is linked, the acess is always made fro the top.
+* The MPI algorithms use FCellHashMap instead (contiguous cells and flat index).
 */
 template <class CellClass>
 class FLightOctree {
@@ -0,0 +1,136 @@
+// See LICENCE file at project root
+#ifndef FMORTONCODING_HPP
+#define FMORTONCODING_HPP
+
+#include "Utils/FGlobal.hpp"
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief The FMortonCoding struct computes the Morton indexes from the
+ * coordinates (and back) without looping on the bits.
+ *
+ * The bits of a coordinate are spread (one every three bits) with magic
+ * numbers, or with pdep/pext when the compiler targets BMI2. The order is
+ * xyz.xyz... (x is the highest bit of each triplet), as in FTreeCoordinate.
+ * The coordinates must be in [0, 2^21[ (a tree of 22 levels at most).
+ *
+ * The array versions have no dependencies between the elements, they are
+ * vectorized by the compiler.
+ *
+ * The neighbors of a cell are computed from its Morton index with the
+ * dilated integers arithmetic: the bits of one dimension are extracted
+ * from the index, incremented (or decremented) with the holes filled by
+ * ones (or zeros), and the neighbor index is the OR of three components,
+ * so there is no need to encode again the coordinates of each neighbor.
+ */
+struct FMortonCoding {
+    /** The bits of z in a Morton index */
+    static const MortonIndex MaskZ = 0x1249249249249249LL;
+    /** The bits of y in a Morton index */
+    static const MortonIndex MaskY = MaskZ << 1;
+    /** The bits of x in a Morton index */
+    static const MortonIndex MaskX = MaskZ << 2;
+
+    /** Put two zeros between each bit of the 21 first bits of inValue */
+    static inline MortonIndex Spread(const int inValue){
+        MortonIndex value = MortonIndex(inValue) & 0x1fffffLL;
+        value = (value | value << 32) & 0x1f00000000ffffLL;
+        value = (value | value << 16) & 0x1f0000ff0000ffLL;
+        value = (value | value << 8)  & 0x100f00f00f00f00fLL;
+        value = (value | value << 4)  & 0x10c30c30c30c30c3LL;
+        value = (value | value << 2)  & 0x1249249249249249LL;
+        return value;
+    }
+
+    /** Get back the value from one bit every three bits (the reverse of Spread) */
+    static inline int Compact(const MortonIndex inValue){
+        MortonIndex value = inValue & 0x1249249249249249LL;
+        value = (value ^ (value >> 2))  & 0x10c30c30c30c30c3LL;
+        value = (value ^ (value >> 4))  & 0x100f00f00f00f00fLL;
+        value = (value ^ (value >> 8))  & 0x1f0000ff0000ffLL;
+        value = (value ^ (value >> 16)) & 0x1f00000000ffffLL;
+        value = (value ^ (value >> 32)) & 0x1fffffLL;
+        return int(value);
+    }
+
+    /** The Morton index of a coordinate */
+    static inline MortonIndex Encode(const int inX, const int inY, const int inZ){
+#ifdef __BMI2__
+        return MortonIndex(_pdep_u64(static_cast<unsigned long long>(inX), MaskX)
+                           | _pdep_u64(static_cast<unsigned long long>(inY), MaskY)
+                           | _pdep_u64(static_cast<unsigned long long>(inZ), MaskZ));
+#else
+        return (Spread(inX) << 2) | (Spread(inY) << 1) | Spread(inZ);
+#endif
+    }
+
+    /** The coordinate of a Morton index */
+    static inline void Decode(const MortonIndex inIndex, int* outX, int* outY, int* outZ){
+#ifdef __BMI2__
+        (*outX) = int(_pext_u64(static_cast<unsigned long long>(inIndex), MaskX));
+        (*outY) = int(_pext_u64(static_cast<unsigned long long>(inIndex), MaskY));
+        (*outZ) = int(_pext_u64(static_cast<unsigned long long>(inIndex), MaskZ));
+#else
+        (*outX) = Compact(inIndex >> 2);
+        (*outY) = Compact(inIndex >> 1);
+        (*outZ) = Compact(inIndex);
+#endif
+    }
+
+    /** The Morton indexes of an array of coordinates */
+    static void EncodeArray(const int inX[], const int inY[], const int inZ[], const FSize inNbElements,
+                            MortonIndex outIndexes[]){
+        for(FSize idx = 0 ; idx < inNbElements ; ++idx){
+            outIndexes[idx] = (Spread(inX[idx]) << 2) | (Spread(inY[idx]) << 1) | Spread(inZ[idx]);
+        }
+    }
+
+    /** The coordinates of an array of Morton indexes */
+    static void DecodeArray(const MortonIndex inIndexes[], const FSize inNbElements,
+                            int outX[], int outY[], int outZ[]){
+        for(FSize idx = 0 ; idx < inNbElements ; ++idx){
+            outX[idx] = Compact(inIndexes[idx] >> 2);
+            outY[idx] = Compact(inIndexes[idx] >> 1);
+            outZ[idx] = Compact(inIndexes[idx]);
+        }
+    }
+
+    /** The bits of one dimension of the index of the neighbor at -1, 0 and +1
+     * in this dimension (the coordinate must be in the tree, the caller
+     * removes the ones outside) */
+    static inline void GetNeighborComponents(const MortonIndex inIndex, const MortonIndex inMask,
+                                             MortonIndex outComponents[3]){
+        const MortonIndex component = inIndex & inMask;
+        outComponents[0] = (component - 1) & inMask;
+        outComponents[1] = component;
+        outComponents[2] = ((component | ~inMask) + 1) & inMask;
+    }
+
+    /**
+     * The Morton indexes of the 27 cells around a cell (and itself),
+     * the neighbor at (idxX, idxY, idxZ) in [-1,1]^3 is at position
+     * ((idxX+1)*3 + (idxY+1))*3 + (idxZ+1).
+     * The indexes of the cells out of the tree are meaningless.
+     */
+    static inline void GetNeighborsBlock(const MortonIndex inIndex, MortonIndex outIndexes[27]){
+        MortonIndex componentsX[3];
+        MortonIndex componentsY[3];
+        MortonIndex componentsZ[3];
+        GetNeighborComponents(inIndex, MaskX, componentsX);
+        GetNeighborComponents(inIndex, MaskY, componentsY);
+        GetNeighborComponents(inIndex, MaskZ, componentsZ);
+        for(int idxX = 0 ; idxX < 3 ; ++idxX){
+            for(int idxY = 0 ; idxY < 3 ; ++idxY){
+                const MortonIndex componentXY = componentsX[idxX] | componentsY[idxY];
+                for(int idxZ = 0 ; idxZ < 3 ; ++idxZ){
+                    outIndexes[(idxX*3 + idxY)*3 + idxZ] = componentXY | componentsZ[idxZ];
+                }
+            }
+        }
+    }
+};
+
+#endif // FMORTONCODING_HPP
@@ -34,6 +34,7 @@ public:
 
 
 #include "FTreeCoordinate.hpp"
+#include "FMortonCoding.hpp"
 
 /**
  * This class compute the neigh position from the tree coordinates
@@ -144,30 +145,15 @@ public:
         currentMaxZ = ((mindex&limiteZ) == limiteZ? 0 : 1);
 
         {
-            MortonIndex mindex_minus = mindex;
-            MortonIndex flag_minus =   (((mindex&flagX)^flagX) == flagX ? 0 : 4)
-                                     | (((mindex&flagY)^flagY) == flagY ? 0 : 2)
-                                     | (((mindex&flagZ)^flagZ) == flagZ ? 0 : 1);
-
-            while(flag_minus){
-                const MortonIndex prevflag_minus = flag_minus;
-                flag_minus = (flag_minus& ~mindex_minus)<<3;
-                mindex_minus = (mindex_minus^prevflag_minus);
-            }
-            mindexes[0] = mindex_minus;
-        }
-        {
-            MortonIndex mindex_plus = mindex;
-            MortonIndex flag_plus =   ((mindex&limiteX) == limiteX? 0 : 4)
-                                    | ((mindex&limiteY) == limiteY? 0 : 2)
-                                    | ((mindex&limiteZ) == limiteZ? 0 : 1);
-
-            while(flag_plus){
-                const MortonIndex prevflag_plus = flag_plus;
-                flag_plus = (flag_plus& mindex_plus)<<3;
-                mindex_plus = (mindex_plus^prevflag_plus);
-            }
-            mindexes[2] = mindex_plus;
+            // The components at -1 and +1 in each dimension (if not at the border)
+            MortonIndex componentsX[3];
+            MortonIndex componentsY[3];
+            MortonIndex componentsZ[3];
+            FMortonCoding::GetNeighborComponents(mindex, flagX, componentsX);
+            FMortonCoding::GetNeighborComponents(mindex, flagY, componentsY);
+            FMortonCoding::GetNeighborComponents(mindex, flagZ, componentsZ);
+            mindexes[0] = componentsX[1+currentMinX] | componentsY[1+currentMinY] | componentsZ[1+currentMinZ];
+            mindexes[2] = componentsX[1+currentMaxX] | componentsY[1+currentMaxY] | componentsZ[1+currentMaxZ];
         }
         mindexes[1] = mindex;
     }
@@ -0,0 +1,218 @@
+// See LICENCE file at project root
+#ifndef FNUMAPLACEMENT_HPP
+#define FNUMAPLACEMENT_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <tuple>
+#include <vector>
+
+#include <unistd.h>
+#include <omp.h>
+
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FNoCopyable.hpp"
+#include "../Utils/FBinding.hpp"
+#include "FParticleArena.hpp"
+#include "inria/integer_sequence.hpp"
+
+/**
+ * @class FNumaPlacement
+ *
+ * This class places the memory of a tree on the NUMA nodes of the threads
+ * that work on it. The particles and the cells are moved in new memory
+ * blocks (FParticleArena and FOctree::compactCells) that are first touched
+ * in parallel with a static schedule: the Morton range of the leaves (and
+ * of the cells of each level) that a thread touches is the one it receives
+ * in the loops of FFmmAlgorithmThread with a chunk size of -1, so the pages
+ * of a range are allocated on the node of the thread that works on it.
+ *
+ * @code
+ * FNumaPlacement<OctreeClass, ContainerClass>::BindThreads();
+ * FNumaPlacement<OctreeClass, ContainerClass> placement;
+ * placement.place(&tree);
+ * std::cout << placement.getParticlesReport(&tree) << placement.getCellsReport(&tree);
+ * FFmmAlgorithmThread<...> algorithm(&tree, &kernels, -1);
+ * @endcode
+ *
+ * The memory can follow the Hilbert order instead of the Morton order
+ * (FSpaceFillingCurve) to put the neighbor leaves closer. The loops of
+ * FFmmAlgorithmThread stay in Morton order, so with the Hilbert order a
+ * thread does not work on the exact range it has first touched.
+ *
+ * Remarks :
+ * - The threads must be bound (BindThreads, or OMP_PROC_BIND), else they can
+ *   move to another node after the placement.
+ * - The pages are placed by the kernel (first touch policy), the reports
+ *   only read the node of the pages, there is no need of libnuma.
+ * - placeCells needs a tree that uses FArenaBlockAllocator for its cells.
+ * - The leaves and the containers objects themselves stay where they have
+ *   been allocated, only their particles are moved.
+ */
+template <class OctreeClass, class ContainerClass>
+class FNumaPlacement : public FNoCopyable {
+public:
+    /** Number of pages of some data on the node of the thread that works on it */
+    struct PageReport {
+        FSize localPages;
+        FSize remotePages;
+        FSize unknownPages; //< not touched or the system cannot give the node
+
+        PageReport() : localPages(0), remotePages(0), unknownPages(0) {
+        }
+
+        /** The ratio of the local pages over the pages with a known node */
+        double getLocalRatio() const {
+            return (localPages + remotePages ? double(localPages) / double(localPages + remotePages) : 0);
+        }
+
+        friend std::ostream& operator<<(std::ostream& output, const PageReport& report){
+            return output << "local pages " << report.localPages << ", remote pages " << report.remotePages
+                          << ", unknown " << report.unknownPages << " (local ratio " << report.getLocalRatio() << ")\n";
+        }
+    };
+
+private:
+    FParticleArena<ContainerClass> particlesArena;
+    /** The order of the leaves and of the cells of a level */
+    const FSpaceFillingCurve spaceFillingCurve;
+
+    /** The pages of a memory range, page aligned */
+    static void AddPages(const void* inBegin, const std::size_t inSize, const std::uintptr_t inPageSize,
+                         std::vector<void*>* pages){
+        if(inSize == 0){
+            return;
+        }
+        const std::uintptr_t firstPage = reinterpret_cast<std::uintptr_t>(inBegin) / inPageSize;
+        const std::uintptr_t lastPage  = (reinterpret_cast<std::uintptr_t>(inBegin) + inSize - 1) / inPageSize;
+        for(std::uintptr_t idxPage = firstPage ; idxPage <= lastPage ; ++idxPage){
+            // The views of the arena are contiguous, the same page is often given twice
+            if(pages->empty() || pages->back() != reinterpret_cast<void*>(idxPage * inPageSize)){
+                pages->push_back(reinterpret_cast<void*>(idxPage * inPageSize));
+            }
+        }
+    }
+
+    /** The pages of all the arrays of a container */
+    template <std::size_t... Indexes>
+    static void AddContainerPages(const ContainerClass* container, const std::uintptr_t inPageSize,
+                                  std::vector<void*>* pages, inria::index_sequence<Indexes...>){
+        const auto arrays = container->data();
+        auto l = {(AddPages(std::get<Indexes>(arrays), sizeof(*std::get<Indexes>(arrays)) * container->capacity(),
+                            inPageSize, pages), 0)...};
+        (void)l;
+    }
+
+    /** Each thread takes its part of the items (static schedule), and compares
+     * the node of their pages with its own node */
+    template <class ItemClass, class AddItemPages>
+    static PageReport Report(const std::vector<ItemClass>& items, AddItemPages&& addItemPages){
+        const std::uintptr_t pageSize = std::uintptr_t(sysconf(_SC_PAGESIZE));
+        FSize localPages = 0, remotePages = 0, unknownPages = 0;
+
+        #pragma omp parallel reduction(+:localPages,remotePages,unknownPages)
+        {
+            std::vector<void*> pages;
+            #pragma omp for schedule(static) nowait
+            for(FSize idxItem = 0 ; idxItem < FSize(items.size()) ; ++idxItem){
+                addItemPages(items[idxItem], pageSize, &pages);
+            }
+
+            const int myNode = FBinding::GetCurrentNumaNode();
+            std::vector<int> nodes(pages.size());
+            FBinding::GetPagesNumaNodes(long(pages.size()), pages.data(), nodes.data());
+            for(const int node : nodes){
+                if(node < 0 || myNode < 0){
+                    unknownPages += 1;
+                }
+                else if(node == myNode){
+                    localPages += 1;
+                }
+                else{
+                    remotePages += 1;
+                }
+            }
+        }
+
+        PageReport report;
+        report.localPages   = localPages;
+        report.remotePages  = remotePages;
+        report.unknownPages = unknownPages;
+        return report;
+    }
+
+public:
+    /** The threads first touch ranges of leaves (and cells) in the inCurve order,
+     * the algorithm uses the Morton ranges */
+    explicit FNumaPlacement(const FSpaceFillingCurve inCurve = FSpaceFillingCurve::Morton)
+        : spaceFillingCurve(inCurve) {
+    }
+
+    /** Bind the OpenMP threads, one per proc (see FBinding::BindOmpThreads) */
+    static int BindThreads(){
+        return FBinding::BindOmpThreads();
+    }
+
+    /** Move the particles in memory first touched by the threads that own the leaves */
+    void placeParticles(OctreeClass*const tree){
+        particlesArena.compact(tree, spaceFillingCurve);
+    }
+
+    /** Move the cells in memory first touched by the threads that own them at each level */
+    void placeCells(OctreeClass*const tree){
+        tree->compactCells(spaceFillingCurve);
+    }
+
+    /** Move the particles and the cells */
+    void place(OctreeClass*const tree){
+        placeParticles(tree);
+        placeCells(tree);
+    }
+
+    /** The particles memory */
+    const FParticleArena<ContainerClass>& getParticlesArena() const {
+        return particlesArena;
+    }
+
+    /** The location of the particles pages, for the threads that work on the leaves */
+    PageReport getParticlesReport(OctreeClass*const tree) const {
+        // The containers in the order of the views of the arena
+        const std::vector<ContainerClass*> containers = FParticleArena<ContainerClass>::GetContainers(tree, spaceFillingCurve);
+        return Report(containers, [](const ContainerClass* container, const std::uintptr_t inPageSize,
+                                     std::vector<void*>* pages){
+            AddContainerPages(container, inPageSize, pages,
+                              inria::make_index_sequence<std::tuple_size<typename ContainerClass::pointer_tuple>::value>());
+        });
+    }
+
+    /** The location of the cells pages, for the threads that work on each level */
+    PageReport getCellsReport(OctreeClass*const tree) const {
+        using CellClass = typename OctreeClass::CellClassType;
+        std::vector<std::vector<const CellClass*>> cellsAtLevel(tree->getHeight());
+        tree->forEachCell([&](CellClass* cell){
+            cellsAtLevel[cell->getLevel()].push_back(cell);
+        });
+
+        PageReport report;
+        for(std::vector<const CellClass*>& cells : cellsAtLevel){
+            if(spaceFillingCurve != FSpaceFillingCurve::Morton){
+                const FSpaceFillingCurve curve = spaceFillingCurve;
+                std::sort(cells.begin(), cells.end(), [curve](const CellClass* first, const CellClass* second){
+                    return FHilbertCoding::GetKey(curve, first->getMortonIndex(), first->getLevel())
+                            < FHilbertCoding::GetKey(curve, second->getMortonIndex(), second->getLevel());
+                });
+            }
+            const PageReport levelReport = Report(cells, [](const CellClass* cell, const std::uintptr_t inPageSize,
+                                                            std::vector<void*>* pages){
+                AddPages(cell, sizeof(CellClass), inPageSize, pages);
+            });
+            report.localPages   += levelReport.localPages;
+            report.remotePages  += levelReport.remotePages;
+            report.unknownPages += levelReport.unknownPages;
+        }
+        return report;
+    }
+};
+
+#endif // FNUMAPLACEMENT_HPP
@@ -2,10 +2,14 @@
 #ifndef FOCTREE_HPP
 #define FOCTREE_HPP
 
+#include <algorithm>
 #include <functional>
+#include <memory>
+#include <vector>
 
 #include "FSubOctree.hpp"
 #include "FTreeCoordinate.hpp"
+#include "FHilbertCoding.hpp"
 #include "FBlockAllocator.hpp"
 
 #include "Utils/FLog.hpp"
@@ -15,6 +19,7 @@
 #include "../Utils/FMath.hpp"
 #include "../Utils/FNoCopyable.hpp"
 #include "../Utils/FAssert.hpp"
+#include "../Utils/FAlignedMemory.hpp"
 #include "FCoordinateComputer.hpp"
 
 /**
@@ -36,7 +41,9 @@
  *
  * If the octree as an height H, then it goes from 0 to H-1
  * at level 0 the space is not split
- * CellAllocator can be FListBlockAllocator<CellClass, 10> or FBasicBlockAllocator<CellClass>
+ * CellAllocator can be FListBlockAllocator<CellClass, 10> or FBasicBlockAllocator<CellClass>,
+ * or FArenaBlockAllocator<CellClass> to be able to put the cells of each level
+ * in one memory block with compactCells().
  */
 template<class FReal, class CellClass, class ContainerClass, class LeafClass_, class CellAllocatorClass = FBasicBlockAllocator<CellClass> /*FListBlockAllocator<CellClass, 15>*/ >
 class FOctree : public FNoCopyable {
@@ -221,6 +228,103 @@ public:
         return root->getRightLeafIndex() < 0;
     }
 
+    /**
+     * Move the cells of each level in one contiguous memory block (aligned
+     * on FP2PDefaultAlignement), in Morton order (or in Hilbert order), so
+     * the passes on a level read the expansions linearly. It should be called
+     * after the insertions.
+     * The cells are moved in parallel with a static schedule (first touch
+     * by the threads that work on them in the static loops).
+     * The cells created after are allocated as usual, and the memory of a
+     * level is freed with the suboctrees (one free per level).
+     * The CellAllocatorClass must be FArenaBlockAllocator<CellClass>.
+     * @param inCurve the order of the cells of a level in the memory
+     */
+    void compactCells(const FSpaceFillingCurve inCurve = FSpaceFillingCurve::Morton){
+        static_assert(alignof(CellClass) <= std::size_t(FP2PDefaultAlignement), "The cells cannot be aligned in the arenas");
+        using SubOctreeBase = FAbstractSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass>;
+
+        struct CellSlot {
+            SubOctreeBase* subOctree;
+            CellClass** cell;
+        };
+        // The cells of each level in Morton order
+        std::vector<std::vector<CellSlot>> cellsAtLevel(this->height);
+        std::vector<SubOctreeBase*> subOctrees;
+
+        std::function<void(SubOctreeBase*)> collectCells = [&](SubOctreeBase* subOctree){
+            subOctrees.push_back(subOctree);
+            const int subOctreeHeight = subOctree->getSubOctreeHeight();
+            for(int idxLocalLevel = 0 ; idxLocalLevel < subOctreeHeight ; ++idxLocalLevel){
+                const int shift = 3 * (subOctreeHeight - idxLocalLevel - 1);
+                CellClass** cells = subOctree->cellsAt(idxLocalLevel);
+                for(int idxCell = (subOctree->getLeftLeafIndex() >> shift) ; idxCell <= (subOctree->getRightLeafIndex() >> shift) ; ++idxCell){
+                    if(cells[idxCell]){
+                        cellsAtLevel[subOctree->getSubOctreePosition() + idxLocalLevel].push_back(CellSlot{subOctree, &cells[idxCell]});
+                    }
+                }
+            }
+            if(!subOctree->isLeafPart()){
+                FSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass>* middleTree =
+                        static_cast<FSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass>*>(subOctree);
+                for(int idxChild = subOctree->getLeftLeafIndex() ; idxChild <= subOctree->getRightLeafIndex() ; ++idxChild){
+                    if(middleTree->leafs(idxChild)){
+                        collectCells(middleTree->leafs(idxChild));
+                    }
+                }
+            }
+        };
+        if(isEmpty()){
+            return;
+        }
+        collectCells(root);
+
+        if(inCurve != FSpaceFillingCurve::Morton){
+            for(int idxLevel = 1 ; idxLevel < this->height ; ++idxLevel){
+                std::vector<std::pair<MortonIndex, CellSlot>> keysAndCells(cellsAtLevel[idxLevel].size());
+                for(size_t idxCell = 0 ; idxCell < keysAndCells.size() ; ++idxCell){
+                    const CellSlot& slot = cellsAtLevel[idxLevel][idxCell];
+                    keysAndCells[idxCell] = {FHilbertCoding::GetKey(inCurve, (*slot.cell)->getMortonIndex(), idxLevel), slot};
+                }
+                std::sort(keysAndCells.begin(), keysAndCells.end(),
+                          [](const std::pair<MortonIndex, CellSlot>& first, const std::pair<MortonIndex, CellSlot>& second){
+                    return first.first < second.first;
+                });
+                for(size_t idxCell = 0 ; idxCell < keysAndCells.size() ; ++idxCell){
+                    cellsAtLevel[idxLevel][idxCell] = keysAndCells[idxCell].second;
+                }
+            }
+        }
+
+        std::vector<std::shared_ptr<void>> arenas(this->height);
+        std::vector<CellClass*> arenaCells(this->height, nullptr);
+        for(int idxLevel = 1 ; idxLevel < this->height ; ++idxLevel){
+            const std::vector<CellSlot>& cells = cellsAtLevel[idxLevel];
+            const FSize nbCells = FSize(cells.size());
+            CellClass*const arena = static_cast<CellClass*>(FAlignedMemory::AllocateBytes<FP2PDefaultAlignement>(sizeof(CellClass) * nbCells));
+            FAssertLF(arena, "Cannot allocate the cells arena");
+            arenas[idxLevel] = std::shared_ptr<void>(arena, [](void* ptr){ FAlignedMemory::DeallocBytes(ptr); });
+            arenaCells[idxLevel] = arena;
+
+            #pragma omp parallel for schedule(static)
+            for(FSize idxCell = 0 ; idxCell < nbCells ; ++idxCell){
+                CellClass*const oldCell = *cells[idxCell].cell;
+                new (&arena[idxCell]) CellClass(std::move(*oldCell));
+                cells[idxCell].subOctree->getCellAllocator().deleteObject(oldCell);
+                *cells[idxCell].cell = &arena[idxCell];
+            }
+        }
+
+        // The previous arenas (if any) are empty, each suboctree keeps the arenas of its levels
+        for(SubOctreeBase* subOctree : subOctrees){
+            subOctree->getCellAllocator().clearArenas();
+            for(int idxLocalLevel = 0 ; idxLocalLevel < subOctree->getSubOctreeHeight() ; ++idxLocalLevel){
+                const int idxLevel = subOctree->getSubOctreePosition() + idxLocalLevel;
+                subOctree->getCellAllocator().addArena(arenaCells[idxLevel], arenaCells[idxLevel] + cellsAtLevel[idxLevel].size(), arenas[idxLevel]);
+            }
+        }
+    }
+
     /**
      * The class works on suboctree. Most of the resources needed
      * are avaiblable by using FAbstractSubOctree. But when accessing
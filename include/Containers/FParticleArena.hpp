@@ -0,0 +1,249 @@
+// See LICENCE file at project root
+#ifndef FPARTICLEARENA_HPP
+#define FPARTICLEARENA_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FNoCopyable.hpp"
+#include "../Utils/FAlignedMemory.hpp"
+#include "../Utils/FAssert.hpp"
+#include "FHilbertCoding.hpp"
+#include "inria/integer_sequence.hpp"
+
+/**
+ * @class FParticleArena
+ *
+ * This class puts the particles of all the leaves of a tree in one memory
+ * block, in Morton order (or Hilbert order). The block has the same layout as the memory of a
+ * particle container (one array per position/attribute, SoA) but it holds
+ * all the particles, and each container becomes a view (offset, count)
+ * in these arrays. The particles of the neighbor leaves are then next
+ * to each other in memory, which helps the caches and the prefetchers
+ * during the P2P.
+ *
+ * The containers are filled as usual (the tree insertions), compact() is
+ * called after, when the tree will not change for a while:
+ * @code
+ * FParticleArena<ContainerClass> arena;
+ * arena.compact(&tree);
+ * algorithm.execute();
+ * @endcode
+ *
+ * Remarks :
+ * - The views are aligned on Alignment bytes, the count of each view is
+ *   rounded up (with zeros at the end) so that all the arrays of all the
+ *   views are aligned. The leading dimension of the containers is then the
+ *   capacity of the arena.
+ * - The views are filled in parallel with a static schedule, so the memory
+ *   of a leaf is first touched by the thread that will work on it in the
+ *   static loops over the leaves.
+ * - A container that grows after the compaction (push) leaves the arena:
+ *   it moves its particles in a new memory block of its own, as usual.
+ * - The memory is shared by the arena and the containers, it is freed
+ *   when the last of them releases it, so the arena object can be
+ *   destroyed before or after the tree.
+ * - The ContainerClass must be a variadic container (FBasicParticleContainer,
+ *   FP2PParticleContainer, ...).
+ */
+template <class ContainerClass, std::size_t Alignment = FP2PDefaultAlignement>
+class FParticleArena : public FNoCopyable {
+    using pointer_tuple = typename ContainerClass::pointer_tuple;
+
+    /** Compute the layout of the arrays from the types of the container */
+    template <class TupleClass, class IndexList>
+    struct Layout;
+
+    template <class... Types, std::size_t... Indexes>
+    struct Layout<std::tuple<Types*...>, inria::index_sequence<Indexes...>> {
+        static constexpr std::size_t Gcd(const std::size_t a, const std::size_t b){
+            return (b == 0 ? a : Gcd(b, a % b));
+        }
+
+        /** The number of elements of a view must be a multiple of this value
+         * to have all the arrays aligned */
+        static constexpr std::size_t Granularity(){
+            const std::size_t sizes[] = {sizeof(Types)...};
+            std::size_t granularity = 1;
+            for(const std::size_t size : sizes){
+                const std::size_t needed = Alignment / Gcd(Alignment, size);
+                granularity = granularity / Gcd(granularity, needed) * needed;
+            }
+            return granularity;
+        }
+
+        /** The size of one element in all the arrays */
+        static constexpr std::size_t ElementSize(){
+            const std::size_t sizes[] = {sizeof(Types)...};
+            std::size_t total = 0;
+            for(const std::size_t size : sizes){
+                total += size;
+            }
+            return total;
+        }
+
+        /** The position of an array in the memory block (by element) */
+        static constexpr std::size_t ArrayOffset(const std::size_t idxArray){
+            const std::size_t sizes[] = {sizeof(Types)...};
+            std::size_t offset = 0;
+            for(std::size_t idx = 0 ; idx < idxArray ; ++idx){
+                offset += sizes[idx];
+            }
+            return offset;
+        }
+
+        /** The arrays in a memory block of capacity elements (as in the containers) */
+        static pointer_tuple Split(unsigned char* memory, const FSize capacity){
+            return pointer_tuple(reinterpret_cast<Types*>(memory + capacity * ArrayOffset(Indexes))...);
+        }
+
+        /** A view starting at element offset */
+        static pointer_tuple Shift(const pointer_tuple& arrays, const FSize offset){
+            return pointer_tuple((std::get<Indexes>(arrays) + offset)...);
+        }
+
+        /** Set to zero the elements [from, to[ of all the arrays */
+        static void SetToZero(const pointer_tuple& arrays, const FSize from, const FSize to){
+            auto l = {(memset(static_cast<void*>(std::get<Indexes>(arrays) + from), 0, sizeof(Types) * (to - from)), 0)...};
+            (void)l;
+        }
+    };
+
+    using LayoutClass = Layout<pointer_tuple, inria::make_index_sequence<std::tuple_size<pointer_tuple>::value>>;
+
+    /** The memory block, shared with the containers */
+    std::shared_ptr<void> storage;
+    /** The arrays in the block */
+    pointer_tuple arrays;
+    /** Number of elements of each array (with the padding) */
+    FSize capacity;
+    /** Number of particles */
+    FSize nbParticles;
+    /** Position and size of each view, in Morton order */
+    std::vector<FSize> viewOffsets;
+    std::vector<FSize> viewSizes;
+
+public:
+    /** The containers of the leaves of a tree in the order of the curve
+     * (the source then the targets if they are different) */
+    template <class OctreeClass>
+    static std::vector<ContainerClass*> GetContainers(OctreeClass*const tree, const FSpaceFillingCurve inCurve){
+        const int leafLevel = tree->getHeight() - 1;
+        std::vector<std::pair<MortonIndex, typename OctreeClass::LeafClass_T*>> leaves;
+        tree->forEachCellLeaf([&](typename OctreeClass::CellClassType* cell, typename OctreeClass::LeafClass_T* leaf){
+            leaves.emplace_back(FHilbertCoding::GetKey(inCurve, cell->getMortonIndex(), leafLevel), leaf);
+        });
+        if(inCurve != FSpaceFillingCurve::Morton){
+            std::sort(leaves.begin(), leaves.end(),
+                      [](const std::pair<MortonIndex, typename OctreeClass::LeafClass_T*>& first,
+                         const std::pair<MortonIndex, typename OctreeClass::LeafClass_T*>& second){
+                return first.first < second.first;
+            });
+        }
+
+        std::vector<ContainerClass*> containers;
+        for(const auto& keyAndLeaf : leaves){
+            containers.push_back(keyAndLeaf.second->getSrc());
+            if(keyAndLeaf.second->getTargets() != keyAndLeaf.second->getSrc()){
+                containers.push_back(keyAndLeaf.second->getTargets());
+            }
+        }
+        return containers;
+    }
+
+    /** The number of elements of each view is a multiple of this value */
+    static constexpr FSize ViewGranularity = FSize(LayoutClass::Granularity());
+
+    FParticleArena() : arrays(), capacity(0), nbParticles(0) {
+    }
+
+    /**
+     * Move the particles of all the leaves of the tree in a new arena.
+     * The source and the targets of a leaf are two views if they are
+     * two different containers (TSM).
+     * If the arena was already used, the containers that were in the
+     * previous memory block are moved in the new one.
+     * @param tree an octree (FOctree, FFlatOctree...) with the particles
+     * @param inCurve the order of the leaves in the arena
+     */
+    template <class OctreeClass>
+    void compact(OctreeClass*const tree, const FSpaceFillingCurve inCurve = FSpaceFillingCurve::Morton){
+        std::vector<ContainerClass*> containers = GetContainers(tree, inCurve);
+
+        const FSize nbViews = FSize(containers.size());
+        viewOffsets.resize(nbViews);
+        viewSizes.resize(nbViews);
+        capacity    = 0;
+        nbParticles = 0;
+        for(FSize idxView = 0 ; idxView < nbViews ; ++idxView){
+            viewOffsets[idxView] = capacity;
+            viewSizes[idxView]   = FSize(containers[idxView]->size());
+            nbParticles += viewSizes[idxView];
+            capacity    += ((viewSizes[idxView] + ViewGranularity - 1) / ViewGranularity) * ViewGranularity;
+        }
+
+        // The pages are not touched here, but by the threads that fill the views
+        unsigned char*const memory = static_cast<unsigned char*>(
+                    FAlignedMemory::AllocateBytes<Alignment>(std::size_t(capacity) * LayoutClass::ElementSize()));
+        FAssertLF(capacity == 0 || memory, "Cannot allocate the particle arena");
+        std::shared_ptr<void> newStorage(memory, [](void* ptr){ FAlignedMemory::DeallocBytes(ptr); });
+        pointer_tuple newArrays = LayoutClass::Split(memory, capacity);
+
+        #pragma omp parallel for schedule(static)
+        for(FSize idxView = 0 ; idxView < nbViews ; ++idxView){
+            const FSize viewCapacity = (idxView + 1 < nbViews ? viewOffsets[idxView+1] : capacity) - viewOffsets[idxView];
+            const pointer_tuple view = LayoutClass::Shift(newArrays, viewOffsets[idxView]);
+            containers[idxView]->adopt_storage(view, viewCapacity, newStorage);
+            LayoutClass::SetToZero(view, viewSizes[idxView], viewCapacity);
+        }
+
+        storage = std::move(newStorage);
+        arrays  = newArrays;
+    }
+
+    /** Release the memory block (it is freed when no container uses it) */
+    void release(){
+        storage.reset();
+        arrays      = pointer_tuple();
+        capacity    = 0;
+        nbParticles = 0;
+        viewOffsets.clear();
+        viewSizes.clear();
+    }
+
+    /** The arrays of the arena (positions and attributes of all the particles) */
+    const pointer_tuple& getArrays() const {
+        return arrays;
+    }
+
+    /** The number of elements of each array, it is also the leading dimension of the containers */
+    FSize getCapacity() const {
+        return capacity;
+    }
+
+    /** The number of particles in the arena (without the padding) */
+    FSize getNbParticles() const {
+        return nbParticles;
+    }
+
+    /** The number of views (containers) */
+    FSize getNbViews() const {
+        return FSize(viewOffsets.size());
+    }
+
+    /** The position of a view in the arrays */
+    FSize getViewOffset(const FSize idxView) const {
+        return viewOffsets[idxView];
+    }
+
+    /** The number of particles of a view at the compaction */
+    FSize getViewSize(const FSize idxView) const {
+        return viewSizes[idxView];
+    }
+};
+
+#endif // FPARTICLEARENA_HPP
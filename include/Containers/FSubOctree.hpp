@@ -270,6 +270,12 @@ public:
         return cells[level];
     }
 
+    /** To get the allocator of the cells of this suboctree
+      * @return cellAllocator */
+    CellAllocatorClass& getCellAllocator(){
+        return cellAllocator;
+    }
+
     /** To know if it is the root suboctree
       * @return true if has parent otherwise return false */
     bool hasParent() const {
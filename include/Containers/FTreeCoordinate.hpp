@@ -10,6 +10,8 @@
 
 #include "Components/FAbstractSerializable.hpp"
 
+#include "FMortonCoding.hpp"
+
 /**
  * @author Berenger Bramas (berenger.bramas@inria.fr)
  * @class FTreeCoordinate
@@ -90,35 +92,12 @@ public:
 
     /**
      * To get the morton index of the current position
-     * @complexity inLevel
-     * @param inLevel the level of the component
+     * @complexity constant (see FMortonCoding)
      * @return morton index
      */
     MortonIndex getMortonIndex() const{
-        MortonIndex index = 0x0LL;
-        MortonIndex mask = 0x1LL;
         // the order is xyz.xyz...
-        MortonIndex mx = point_t::data()[0] << 2;
-        MortonIndex my = point_t::data()[1] << 1;
-        MortonIndex mz = point_t::data()[2];
-
-        while( (mask <= mz)
-               || ((mask << 1) <= my)
-               || ((mask << 2) <= mx))
-        {
-            index |= (mz & mask);
-            mask <<= 1;
-            index |= (my & mask);
-            mask <<= 1;
-            index |= (mx & mask);
-            mask <<= 1;
-
-            mz <<= 2;
-            my <<= 2;
-            mx <<= 2;
-        }
-
-        return index;
+        return FMortonCoding::Encode(point_t::data()[0], point_t::data()[1], point_t::data()[2]);
     }
 
     [[gnu::deprecated]]
@@ -130,21 +109,7 @@ public:
      * @param inIndex the morton index to compute position
      */
     void setPositionFromMorton(MortonIndex inIndex) {
-        MortonIndex mask = 0x1LL;
-
-        point_t::data()[0] = 0;
-        point_t::data()[1] = 0;
-        point_t::data()[2] = 0;
-
-        while(inIndex >= mask) {
-            point_t::data()[2] |= int(inIndex & mask);
-            inIndex >>= 1;
-            point_t::data()[1] |= int(inIndex & mask);
-            inIndex >>= 1;
-            point_t::data()[0] |= int(inIndex & mask);
-
-            mask <<= 1;
-        }
+        FMortonCoding::Decode(inIndex, &point_t::data()[0], &point_t::data()[1], &point_t::data()[2]);
     }
 
 
@@ -193,6 +158,10 @@ public:
      * @param indexInArray store (must have the same length as indexes)
      */
     int getNeighborsIndexes(const int OctreeHeight, MortonIndex indexes[26], int* indexInArray = nullptr) const {
+        // The indexes of the cells around are computed from the index of the current cell
+        MortonIndex neighborsBlock[27];
+        FMortonCoding::GetNeighborsBlock(getMortonIndex(), neighborsBlock);
+
         int idxNeig = 0;
         int limite = 1 << (OctreeHeight - 1);
         // We test all cells around
@@ -207,10 +176,10 @@ public:
 
                     // if we are not on the current cell
                     if( idxX || idxY || idxZ ){
-                        const FTreeCoordinate other(this->getX() + idxX, this->getY() + idxY, this->getZ() + idxZ);
-                        indexes[ idxNeig ] = other.getMortonIndex();
+                        const int positionInBlock = ((idxX+1)*3 + (idxY+1)) * 3 + (idxZ+1);
+                        indexes[ idxNeig ] = neighborsBlock[positionInBlock];
                         if(indexInArray)
-                            indexInArray[ idxNeig ] = ((idxX+1)*3 + (idxY+1)) * 3 + (idxZ+1);
+                            indexInArray[ idxNeig ] = positionInBlock;
                         ++idxNeig;
                     }
                 }
@@ -227,6 +196,8 @@ public:
         // Then take each child of the parent's neighbors if not in directNeighbors
         // Father coordinate
         const FTreeCoordinate parentCell(this->getX()>>1,this->getY()>>1,this->getZ()>>1);
+        MortonIndex parentNeighborsBlock[27];
+        FMortonCoding::GetNeighborsBlock(parentCell.getMortonIndex(), parentNeighborsBlock);
 
         // Limite at parent level number of box (split by 2 by level)
         const int limite = FMath::pow2(inLevel-1);
@@ -245,7 +216,7 @@ public:
                     // if we are not on the current cell
                     if(neighSeparation<1 || idxX || idxY || idxZ ){
                         const FTreeCoordinate otherParent(parentCell.getX() + idxX,parentCell.getY() + idxY,parentCell.getZ() + idxZ);
-                        const MortonIndex mortonOther = otherParent.getMortonIndex();
+                        const MortonIndex mortonOther = parentNeighborsBlock[((idxX+1)*3 + (idxY+1)) * 3 + (idxZ+1)];
 
                         // For each child
                         for(int idxCousin = 0 ; idxCousin < 8 ; ++idxCousin){
@@ -10,6 +10,7 @@
 #include "FFmmAlgorithm.hpp"
 #include "FFmmAlgorithmThread.hpp"
 #include "FFmmAlgorithmPeriodic.hpp"
+#include "FFmmAlgorithmAuto.hpp"
 
 #ifdef SCALFMM_USE_MPI
 #include "../Utils/FMpi.hpp"
@@ -92,6 +93,23 @@ public:
         }
     #endif
     }
+
+    /**
+     * Build an algorithm which calibrates the shared memory algorithms on the
+     * first executions and keeps the fastest (see FFmmAlgorithmAuto).
+     * With mpi or periodicity it is the same as BuildAlgorithm.
+     */
+    template<class OctreeClass, class CellClass, class ContainerClass, class KernelClass, class LeafClass>
+    static FAbstractAlgorithm* BuildAutoAlgorithm(OctreeClass*const tree, KernelClass*const kernel,
+                                       const MPI_Comm mpiComm = (MPI_Comm)0, const bool isPeriodic = false,
+                                       const int periodicUpperlevel = 0){
+    #ifndef SCALFMM_USE_MPI
+        if(isPeriodic == false){
+            return new FFmmAlgorithmAuto<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>(tree, kernel);
+        }
+    #endif
+        return BuildAlgorithm<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>(tree, kernel, mpiComm, isPeriodic, periodicUpperlevel);
+    }
 };
 
 
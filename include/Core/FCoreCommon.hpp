@@ -3,6 +3,12 @@
 #define FCORECOMMON_HPP
 
 #include <vector>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 #include "Utils/FGlobal.hpp"
 #include "Utils/FAssert.hpp"
 
@@ -99,6 +105,106 @@ struct FAlgorithmInterface {
 
 
 
+/**
+ * \brief Handle of an asynchronous execution
+ *
+ * Returned by FAbstractAlgorithm::executeAsync. The algorithm runs in its own
+ * thread and reports the leaves that will not be modified anymore (their L2P
+ * and P2P are done) so that the caller can process them while the rest of the
+ * computation goes on:
+ *
+ *     auto handle = algo.executeAsync();
+ *     FSize nbProcessed = 0;
+ *     FSize nbFinished;
+ *     while((nbFinished = handle->waitForLeaves(nbProcessed)) != nbProcessed){
+ *         for( ; nbProcessed < nbFinished ; ++nbProcessed){
+ *             process(handle->getFinishedLeaf(nbProcessed));
+ *         }
+ *     }
+ *     handle->wait();
+ *
+ * Algorithms that do not report the leaves one by one only notify the end of
+ * the execution, after which isLeafFinished returns true for any leaf.
+ * The handle must be waited (or destroyed) before the algorithm is destroyed.
+ */
+class FAsyncExecution {
+    std::thread worker;
+    mutable std::mutex finishedMutex;
+    std::condition_variable finishedCondition;
+    std::vector<MortonIndex> finishedLeaves; ///< In the order they have been finished
+    bool executionFinished;
+
+public:
+    FAsyncExecution() : executionFinished(false) {
+    }
+
+    FAsyncExecution(const FAsyncExecution&) = delete;
+    FAsyncExecution& operator=(const FAsyncExecution&) = delete;
+
+    /** Wait the end of the execution */
+    ~FAsyncExecution(){
+        wait();
+    }
+
+    /** Run the given function in the worker thread, and notify its end */
+    void start(std::function<void()> work){
+        FAssertLF(worker.joinable() == false, "The execution has already been started");
+        worker = std::thread([this, work](){
+            work();
+            std::lock_guard<std::mutex> guard(finishedMutex);
+            executionFinished = true;
+            finishedCondition.notify_all();
+        });
+    }
+
+    /** Called by the algorithm (from any thread) when a leaf is finished */
+    void leafFinished(const MortonIndex inLeafIndex){
+        std::lock_guard<std::mutex> guard(finishedMutex);
+        finishedLeaves.push_back(inLeafIndex);
+        finishedCondition.notify_all();
+    }
+
+    /** Block until more than nbAlreadyKnown leaves are finished or the
+     *  execution is over, and return the number of finished leaves.
+     *  It returns nbAlreadyKnown only when no more leaves will be reported.
+     */
+    FSize waitForLeaves(const FSize nbAlreadyKnown){
+        std::unique_lock<std::mutex> guard(finishedMutex);
+        finishedCondition.wait(guard, [&](){
+            return executionFinished || FSize(finishedLeaves.size()) > nbAlreadyKnown;
+        });
+        return FSize(finishedLeaves.size());
+    }
+
+    /** Get the index of the idxLeaf-th finished leaf */
+    MortonIndex getFinishedLeaf(const FSize idxLeaf) const {
+        std::lock_guard<std::mutex> guard(finishedMutex);
+        return finishedLeaves[idxLeaf];
+    }
+
+    /** Test if a leaf is finished (linear in the number of finished leaves) */
+    bool isLeafFinished(const MortonIndex inLeafIndex) const {
+        std::lock_guard<std::mutex> guard(finishedMutex);
+        return executionFinished
+                || std::find(finishedLeaves.begin(), finishedLeaves.end(), inLeafIndex) != finishedLeaves.end();
+    }
+
+    /** Test if the whole execution is over */
+    bool isFinished() const {
+        std::lock_guard<std::mutex> guard(finishedMutex);
+        return executionFinished;
+    }
+
+    /** Block until the end of the execution */
+    void wait(){
+        if(worker.joinable()){
+            worker.join();
+        }
+    }
+};
+
+
+
 /**
  * \brief Base class of algorithms
  *
@@ -112,6 +218,8 @@ protected:
     int lowerWorkingLevel; ///< Where to end the work (exclusive)
     int nbLevelsInTree;    ///< Height of the tree
 
+    FAsyncExecution* asyncExecution; ///< The current asynchronous execution if any
+
     void setNbLevelsInTree(const int inNbLevelsInTree){
         nbLevelsInTree    = inNbLevelsInTree;
         lowerWorkingLevel = nbLevelsInTree;
@@ -123,9 +231,23 @@ protected:
     }
     virtual void executeCore(const unsigned operationsToProceed) = 0;
 
+    /** To be called by the algorithms when a leaf will not be modified anymore
+     *  during the current execution, it does nothing if the execution is not
+     *  asynchronous */
+    void notifyLeafFinished(const MortonIndex inLeafIndex){
+        if(asyncExecution){
+            asyncExecution->leafFinished(inLeafIndex);
+        }
+    }
+
+    /** To know if the leaves have to be notified */
+    bool isExecutionAsync() const {
+        return asyncExecution != nullptr;
+    }
+
 public:
     FAbstractAlgorithm()
-        : upperWorkingLevel(2), lowerWorkingLevel(0), nbLevelsInTree(-1){
+        : upperWorkingLevel(2), lowerWorkingLevel(0), nbLevelsInTree(-1), asyncExecution(nullptr){
     }
 
     virtual ~FAbstractAlgorithm(){
@@ -157,6 +279,25 @@ public:
         executeCore(operationsToProceed);
     }
 
+    /** \brief Execute some steps in a separate thread.
+     *
+     * The returned handle gives the leaves as soon as they are finished and
+     * allows to wait the end of the execution (see FAsyncExecution).
+     */
+    std::unique_ptr<FAsyncExecution> executeAsync(const unsigned operationsToProceed = FFmmNearAndFarFields){
+        FAssertLF(asyncExecution == nullptr, "An asynchronous execution is already running");
+        upperWorkingLevel = 2;
+        lowerWorkingLevel = nbLevelsInTree;
+        validateLevels();
+        std::unique_ptr<FAsyncExecution> handle(new FAsyncExecution);
+        asyncExecution = handle.get();
+        handle->start([this, operationsToProceed](){
+            executeCore(operationsToProceed);
+            asyncExecution = nullptr;
+        });
+        return handle;
+    }
+
     /// Build and dill vector of the  MortonIndex Distribution at Leaf level
     ///  p = mpi process id then
     ///  [mortonLeafDistribution[2*p], mortonLeafDistribution[2*p+1]  is the morton index shared by process p
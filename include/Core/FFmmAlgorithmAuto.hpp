@@ -0,0 +1,274 @@
+// See LICENCE file at project root
+#ifndef FFMMALGORITHMAUTO_HPP
+#define FFMMALGORITHMAUTO_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <fstream>
+#include <sstream>
+#include <limits>
+
+#include <omp.h>
+
+#include "Utils/FGlobal.hpp"
+#include "Utils/FAssert.hpp"
+#include "Utils/FLog.hpp"
+#include "Utils/FTic.hpp"
+#include "Utils/FMath.hpp"
+#include "Utils/FEnv.hpp"
+
+#include "FCoreCommon.hpp"
+#include "FFmmAlgorithmThread.hpp"
+#include "FFmmAlgorithmTask.hpp"
+#include "FFmmAlgorithmSectionTask.hpp"
+#include "FFmmAlgorithmThreadBalance.hpp"
+// Same condition as SCALFMM_USE_OMP4 in FGlobal.hpp: native OpenMP 4 tasks
+// unless disabled in the configuration (SCALFMM_DISABLE_NATIVE_OMP4)
+#if _OPENMP >= 201307 && !defined(SCALFMM_DISABLE_NATIVE_OMP4) && !defined(__INTEL_COMPILER)
+#define SCALFMM_AUTO_WITH_OMP4
+#include "FFmmAlgorithmOmp4.hpp"
+#endif
+
+/**
+ * @brief Algorithm which selects the fastest shared memory algorithm for the machine
+ * and the particle distribution.
+ *
+ * The calibration is done on the real executions : the complete execute()
+ * (all the operations on all the levels) are done with each candidate
+ * (FFmmAlgorithmThread with several chunk sizes, Task, SectionTask,
+ * ThreadBalance and Omp4 if supported) in turn, SCALFMM_AUTO_RUNS times
+ * (2 by default) each, and the minimum duration of a candidate is kept, so
+ * the first one does not pay for the warm-up (page faults, precomputations).
+ * When all the candidates have been timed the fastest one is kept for the
+ * next executions. The results of the calibration steps are therefore as
+ * valid as the others.
+ *
+ * The decision can be saved in a cache file given by SCALFMM_AUTO_CACHE
+ * (no file is used by default) with a key made of the tree height, the number of
+ * threads and the magnitude of the number of particles, of the number of
+ * particles per leaf and of the imbalance between leaves. An algorithm built for a
+ * key already in the cache does not calibrate.
+ * The calibration can be disabled with SCALFMM_AUTO_ALGORITHM=<candidate name>.
+ */
+template<class OctreeClass, class CellClass, class ContainerClass, class KernelClass, class LeafClass>
+class FFmmAlgorithmAuto : public FAbstractAlgorithm {
+
+    struct Candidate {
+        std::string name;
+        std::function<FAbstractAlgorithm*()> build;
+        double duration;    //< The minimum duration of the runs
+        int nbRuns;
+    };
+
+    OctreeClass* const tree;
+    const KernelClass* const kernel;
+    const int leafLevelSeparationCriteria;
+
+    std::vector<Candidate> candidates;
+    int currentCandidate;    //< The candidate being calibrated or the chosen one
+    bool isDecided;
+    std::unique_ptr<FAbstractAlgorithm> algorithm;
+
+    std::string problemKey;
+    const std::string cacheFilename;    //< Empty if there is no cache
+    const int nbCalibrationRuns;        //< The number of runs of each candidate
+
+    /** Build the list of the possible algorithms */
+    void buildCandidates(){
+        typedef FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass> ThreadClass;
+        const int chunkSizes[] = {1, 10, 0};
+        for(const int chunkSize : chunkSizes){
+            candidates.push_back({std::string("thread-chunk-") + std::to_string(chunkSize), [this, chunkSize](){
+                ThreadClass* algo = new ThreadClass(tree, kernel, 10, leafLevelSeparationCriteria);
+                algo->setChunkSize(chunkSize);
+                return static_cast<FAbstractAlgorithm*>(algo);
+            }, std::numeric_limits<double>::max(), 0});
+        }
+        candidates.push_back({"task", [this](){
+            return static_cast<FAbstractAlgorithm*>(
+                new FFmmAlgorithmTask<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>(tree, kernel, leafLevelSeparationCriteria));
+        }, std::numeric_limits<double>::max(), 0});
+        candidates.push_back({"section-task", [this](){
+            return static_cast<FAbstractAlgorithm*>(
+                new FFmmAlgorithmSectionTask<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>(tree, kernel, leafLevelSeparationCriteria));
+        }, std::numeric_limits<double>::max(), 0});
+        candidates.push_back({"thread-balance", [this](){
+            return static_cast<FAbstractAlgorithm*>(
+                new FFmmAlgorithmThreadBalance<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>(tree, kernel, leafLevelSeparationCriteria));
+        }, std::numeric_limits<double>::max(), 0});
+#ifdef SCALFMM_AUTO_WITH_OMP4
+        candidates.push_back({"omp4", [this](){
+            return static_cast<FAbstractAlgorithm*>(
+                new FFmmAlgorithmOmp4<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>(tree, kernel, leafLevelSeparationCriteria));
+        }, std::numeric_limits<double>::max(), 0});
+#endif
+    }
+
+    /** The key of the problem in the cache, the sizes are given by their magnitude */
+    void buildProblemKey(){
+        FSize nbParticles = 0;
+        FSize nbLeaves = 0;
+        FSize maxParticlesInLeaf = 0;
+        tree->forEachLeaf([&](LeafClass* leaf){
+            const FSize nbParticlesInLeaf = leaf->getTargets()->getNbParticles();
+            nbParticles += nbParticlesInLeaf;
+            nbLeaves += 1;
+            maxParticlesInLeaf = FMath::Max(maxParticlesInLeaf, nbParticlesInLeaf);
+        });
+
+        const FSize averageInLeaf = (nbLeaves ? nbParticles/nbLeaves : 0);
+        auto log2 = [](FSize value){
+            int result = 0;
+            while(value > 1){
+                value >>= 1;
+                result += 1;
+            }
+            return result;
+        };
+
+        std::stringstream key;
+        key << "h" << tree->getHeight()
+            << "-t" << omp_get_max_threads()
+            << "-n" << log2(nbParticles)
+            << "-l" << log2(averageInLeaf)
+            << "-i" << log2(averageInLeaf ? maxParticlesInLeaf/averageInLeaf : 0);
+        problemKey = key.str();
+    }
+
+    int findCandidate(const std::string& inName) const {
+        for(int idxCandidate = 0 ; idxCandidate < int(candidates.size()) ; ++idxCandidate){
+            if(candidates[idxCandidate].name == inName){
+                return idxCandidate;
+            }
+        }
+        return -1;
+    }
+
+    /** Look for the key in the cache file, return the candidate or -1 */
+    int readCache() const {
+        if(cacheFilename.empty()){
+            return -1;
+        }
+        std::ifstream cacheFile(cacheFilename);
+        std::string key, name;
+        int found = -1;
+        // The last decision for a key is the one used
+        while(cacheFile >> key >> name){
+            if(key == problemKey){
+                found = findCandidate(name);
+            }
+        }
+        return found;
+    }
+
+    void writeCache() const {
+        if(cacheFilename.empty()){
+            return;
+        }
+        std::ofstream cacheFile(cacheFilename, std::ios::app);
+        if(cacheFile){
+            cacheFile << problemKey << " " << candidates[currentCandidate].name << "\n";
+        }
+    }
+
+    void decide(const int inCandidate){
+        currentCandidate = inCandidate;
+        isDecided = true;
+        algorithm.reset(candidates[currentCandidate].build());
+        FLOG(FLog::Controller << "FFmmAlgorithmAuto uses " << candidates[currentCandidate].name << " for " << problemKey << "\n");
+    }
+
+public:
+    /**
+     * @param inTree the octree to work on
+     * @param inKernel the kernel copied by the algorithms
+     * @param inLeafLevelSeperationCriteria the separation criteria at leaf level
+     */
+    FFmmAlgorithmAuto(OctreeClass* const inTree, const KernelClass* const inKernel, const int inLeafLevelSeperationCriteria = 1)
+        : tree(inTree), kernel(inKernel), leafLevelSeparationCriteria(inLeafLevelSeperationCriteria),
+          currentCandidate(0), isDecided(false),
+          cacheFilename(FEnv::GetStr("SCALFMM_AUTO_CACHE", "")),
+          nbCalibrationRuns(FMath::Max(1, FEnv::GetValue("SCALFMM_AUTO_RUNS", 2))) {
+        FAssertLF(tree, "tree cannot be null");
+        FAssertLF(kernel, "kernel cannot be null");
+
+        FAbstractAlgorithm::setNbLevelsInTree(tree->getHeight());
+
+        buildCandidates();
+        buildProblemKey();
+
+        const char* const forcedName = FEnv::GetStr("SCALFMM_AUTO_ALGORITHM");
+        const int forcedCandidate = (forcedName ? findCandidate(forcedName) : -1);
+        const int cachedCandidate = readCache();
+        if(forcedCandidate != -1){
+            decide(forcedCandidate);
+        }
+        else if(cachedCandidate != -1){
+            decide(cachedCandidate);
+        }
+        else{
+            algorithm.reset(candidates[currentCandidate].build());
+        }
+    }
+
+    std::string name() const override {
+        return std::string("Auto algorithm (") + (isDecided ? "" : "calibrating ")
+                + candidates[currentCandidate].name + ")";
+    }
+
+    std::string description() const override {
+        return problemKey + ", " + algorithm->description();
+    }
+
+    /** To know if the calibration is over */
+    bool isCalibrated() const {
+        return isDecided;
+    }
+
+    /** The name of the candidate in use */
+    const std::string& getCurrentCandidateName() const {
+        return candidates[currentCandidate].name;
+    }
+
+protected:
+    void executeCore(const unsigned operationsToProceed) override {
+        // Only complete executions are comparable
+        const bool isCalibrationStep = (isDecided == false && operationsToProceed == FFmmNearAndFarFields
+                && FAbstractAlgorithm::upperWorkingLevel == 2
+                && FAbstractAlgorithm::lowerWorkingLevel == FAbstractAlgorithm::nbLevelsInTree);
+
+        FTic timer;
+        algorithm->execute(operationsToProceed, FAbstractAlgorithm::upperWorkingLevel, FAbstractAlgorithm::lowerWorkingLevel);
+        timer.tac();
+
+        if(isCalibrationStep){
+            Candidate& candidate = candidates[currentCandidate];
+            candidate.duration = FMath::Min(candidate.duration, timer.elapsed());
+            candidate.nbRuns += 1;
+            FLOG(FLog::Controller << "FFmmAlgorithmAuto " << candidate.name << " took " << timer.elapsed() << "s\n");
+
+            // The same candidate is run again until it has done all its runs
+            if(candidate.nbRuns < nbCalibrationRuns){
+                return;
+            }
+            if(currentCandidate + 1 < int(candidates.size())){
+                currentCandidate += 1;
+                algorithm.reset(candidates[currentCandidate].build());
+            }
+            else{
+                int bestCandidate = 0;
+                for(int idxCandidate = 1 ; idxCandidate < int(candidates.size()) ; ++idxCandidate){
+                    if(candidates[idxCandidate].duration < candidates[bestCandidate].duration){
+                        bestCandidate = idxCandidate;
+                    }
+                }
+                decide(bestCandidate);
+                writeCache();
+            }
+        }
+    }
+};
+
+#endif // FFMMALGORITHMAUTO_HPP
@@ -22,6 +22,7 @@
 #include "Components/FBasicCell.hpp"
 
 #include "FCoreCommon.hpp"
+#include "FKernelCopies.hpp"
 #include "FP2PExclusion.hpp"
 
 #include <omp.h>
@@ -74,13 +75,7 @@ public:
             MaxThreads = omp_get_num_threads();
 
         this->kernels = new KernelClass*[MaxThreads];
-        #pragma omp parallel num_threads(MaxThreads)
-        {
-            #pragma omp critical (InitFFmmAlgorithmNewTask)
-            {
-                this->kernels[omp_get_thread_num()] = new KernelClass(*inKernels);
-            }
-        }
+        FCopyKernelPerThread(this->kernels, inKernels, MaxThreads);
 
         FAbstractAlgorithm::setNbLevelsInTree(tree->getHeight());
 
@@ -18,6 +18,7 @@
 #include "Utils/FEnv.hpp"
 
 #include "FCoreCommon.hpp"
+#include "FKernelCopies.hpp"
 #include "FP2PExclusion.hpp"
 
 #undef commute_if_supported
@@ -136,13 +137,7 @@ public:
             MaxThreads = omp_get_num_threads();
 
         this->kernels = new KernelClass*[MaxThreads];
-        #pragma omp parallel num_threads(MaxThreads)
-        {
-            #pragma omp critical (InitFFmmAlgorithmOmp4)
-            {
-                this->kernels[omp_get_thread_num()] = new KernelClass(*inKernels);
-            }
-        }
+        FCopyKernelPerThread(this->kernels, inKernels, MaxThreads);
 
         FAbstractAlgorithm::setNbLevelsInTree(tree->getHeight());
 
@@ -0,0 +1,575 @@
+#ifndef FFMMALGORITHMOMP5_HPP
+#define FFMMALGORITHMOMP5_HPP
+
+#include <array>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <omp.h>
+
+#include "Utils/FGlobal.hpp"
+#include "Utils/FAssert.hpp"
+#include "Utils/FLog.hpp"
+
+#include "Utils/FTic.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Utils/FAlgorithmTimers.hpp"
+#include "Utils/FEnv.hpp"
+
+#include "FCoreCommon.hpp"
+#include "FKernelCopies.hpp"
+#include "FP2PExclusion.hpp"
+
+
+enum class Omp5_Priorities{
+    P2M       = 9,
+    M2M       = 8,
+    M2L_High  = 7,
+    L2L       = 6,
+    P2P_Big   = 5,
+    M2L       = 4,
+    L2P       = 3,
+    P2P_Small = 2
+};
+
+
+/**
+ * @class FFmmAlgorithmOmp5
+ * @brief
+ * Please read the license
+ *
+ * This class is an OpenMP 5 task based FMM algorithm working on the FOctree.
+ *
+ * Compared to FFmmAlgorithmOmp4 the tasks do not work on a single cell but on
+ * a block of cells : at level l the cells are grouped by their Morton prefix at
+ * level max(l - blockLevels, 0), so a block is a subtree of up to 8^blockLevels
+ * cells and a parent block has 1 or 8 child blocks.
+ * The dependencies are expressed on one token per block (multipole, local and
+ * particles) using OpenMP 5 depend iterators, instead of the 342 entries
+ * depend lists of the Omp4 version, and the accumulations (M2L and L2L into
+ * the locals, P2P and L2P into the particles) use mutexinoutset so that they
+ * can be executed in any order but never at the same time on a block.
+ *
+ * The block depth can be given to the constructor or set with the
+ * environment variable SCALFMM_OMP5_BLOCK_LEVELS (default 2).
+ *
+ * Of course this class does not deallocate pointer given in arguements.
+ */
+template<class OctreeClass, class CellClass, class ContainerClass, class KernelClass, class LeafClass, class P2PExclusionClass = FP2PMiddleExclusion>
+class FFmmAlgorithmOmp5 : public FAbstractAlgorithm, public FAlgorithmTimers {
+
+    using multipole_t = typename CellClass::multipole_t;
+    using local_expansion_t = typename CellClass::local_expansion_t;
+    using symbolic_data_t = CellClass;
+
+    /** The cells of one level sorted by Morton index and cut in blocks */
+    struct LevelBlocks {
+        std::vector<CellClass*> cells;
+        std::vector<CellClass**> children;       //< Only above the leaf level
+        std::vector<ContainerClass*> targets;    //< Only at the leaf level
+        std::vector<ContainerClass*> sources;    //< Only at the leaf level
+        std::vector<MortonIndex> blockPrefix;
+        std::vector<FSize> blockStart;           //< nbBlocks + 1 intervals
+        // The dependency tokens, one char per block
+        std::unique_ptr<unsigned char[]> multipoleDeps;
+        std::unique_ptr<unsigned char[]> localDeps;
+        std::unique_ptr<unsigned char[]> particlesDeps;
+
+        int getNbBlocks() const {
+            return int(blockPrefix.size());
+        }
+    };
+
+    OctreeClass* const tree;       //< The octree to work on
+    KernelClass** kernels;    //< The kernels
+
+    int MaxThreads;
+
+    const int OctreeHeight;
+
+    const int leafLevelSeparationCriteria;
+
+    int blockLevels;
+
+    std::unique_ptr<LevelBlocks[]> levels;
+
+    // Blocks with more particles are given an higher P2P priority
+    FSize p2pPrioCriteria;
+
+public:
+    /** The constructor need the octree and the kernels used for computation
+     * @param inTree the octree to work on
+     * @param inKernels the kernels to call
+     * @param inLeafLevelSeperationCriteria the separation criteria at leaf level
+     * @param inBlockLevels the depth of the subtrees that form a block, -1 to use
+     * SCALFMM_OMP5_BLOCK_LEVELS
+     * An assert is launched if one of the arguments is null
+     */
+    FFmmAlgorithmOmp5(OctreeClass* const inTree, const KernelClass* const inKernels,
+                      const int inLeafLevelSeperationCriteria = 1, const int inBlockLevels = -1)
+    : tree(inTree) , kernels(nullptr),
+      OctreeHeight(tree->getHeight()), leafLevelSeparationCriteria(inLeafLevelSeperationCriteria),
+      blockLevels(inBlockLevels), levels(new LevelBlocks[tree->getHeight()]),
+      p2pPrioCriteria(0)
+    {
+
+        FAssertLF(tree, "tree cannot be null");
+        FAssertLF(inKernels, "kernels cannot be null");
+        FAssertLF(leafLevelSeparationCriteria < 3, "Separation criteria should be < 3");
+
+        if(blockLevels < 0){
+            blockLevels = FEnv::GetValue("SCALFMM_OMP5_BLOCK_LEVELS", 2);
+        }
+        FAssertLF(blockLevels >= 1, "The block levels must be at least 1 (a parent block must be at an upper level)");
+
+        MaxThreads = 1;
+        #pragma omp parallel
+        #pragma omp master
+            MaxThreads = omp_get_num_threads();
+
+        this->kernels = new KernelClass*[MaxThreads];
+        FCopyKernelPerThread(this->kernels, inKernels, MaxThreads);
+
+        FAbstractAlgorithm::setNbLevelsInTree(tree->getHeight());
+
+        FLOG(FLog::Controller << "FFmmAlgorithmOmp5 (Max Thread " << MaxThreads << ", block levels " << blockLevels << ")\n");
+
+        FAssertLF(KernelClass::NeedFinishedM2LEvent() == false, "FFmmAlgorithmOmp5 cannot notify for M2L at level ending.");
+    }
+
+    /** Default destructor */
+    virtual ~FFmmAlgorithmOmp5(){
+        for(int idxThread = 0 ; idxThread < MaxThreads ; ++idxThread){
+            delete this->kernels[idxThread];
+        }
+        delete [] this->kernels;
+    }
+
+    std::string name() const override {
+        return "OpenMP 5 block task algorithm";
+    }
+
+    std::string description() const override {
+        return std::string("threads: ") + std::to_string(MaxThreads)
+            + ", block levels: " + std::to_string(blockLevels);
+    }
+
+protected:
+
+    /** The level at which the Morton prefix of a block is taken */
+    int getBlockLevel(const int idxLevel) const {
+        return FMath::Max(idxLevel - blockLevels, 0);
+    }
+
+    /** Fill the cells and the blocks of all the levels of the tree */
+    void buildBlocks(){
+        typename OctreeClass::Iterator octreeIterator(tree);
+        octreeIterator.gotoBottomLeft();
+        FSize nbParticles = 0;
+
+        for(int idxLevel = OctreeHeight - 1 ; idxLevel >= 1 ; --idxLevel){
+            LevelBlocks* const level = &levels[idxLevel];
+            level->cells.clear();
+            level->children.clear();
+            level->targets.clear();
+            level->sources.clear();
+            level->blockPrefix.clear();
+            level->blockStart.clear();
+
+            const int shift = 3*(idxLevel - getBlockLevel(idxLevel));
+            do{
+                const MortonIndex prefix = (octreeIterator.getCurrentGlobalIndex() >> shift);
+                if(level->blockPrefix.empty() || level->blockPrefix.back() != prefix){
+                    level->blockPrefix.push_back(prefix);
+                    level->blockStart.push_back(FSize(level->cells.size()));
+                }
+                level->cells.push_back(octreeIterator.getCurrentCell());
+                if(idxLevel == OctreeHeight - 1){
+                    level->targets.push_back(octreeIterator.getCurrentListTargets());
+                    level->sources.push_back(octreeIterator.getCurrentListSrc());
+                    nbParticles += level->targets.back()->getNbParticles();
+                }
+                else{
+                    level->children.push_back(octreeIterator.getCurrentChild());
+                }
+            } while(octreeIterator.moveRight());
+            level->blockStart.push_back(FSize(level->cells.size()));
+
+            const int nbBlocks = level->getNbBlocks();
+            level->multipoleDeps.reset(new unsigned char[nbBlocks]);
+            level->localDeps.reset(new unsigned char[nbBlocks]);
+            level->particlesDeps.reset(idxLevel == OctreeHeight - 1 ? new unsigned char[nbBlocks] : nullptr);
+
+            octreeIterator.moveUp();
+            octreeIterator.gotoLeft();
+        }
+
+        const FSize nbLeafBlocks = levels[OctreeHeight - 1].getNbBlocks();
+        p2pPrioCriteria = (nbLeafBlocks ? nbParticles/nbLeafBlocks : 0);
+    }
+
+    /** Return the index of the block of prefix inPrefix at level idxLevel, or -1 */
+    int findBlock(const int idxLevel, const MortonIndex inPrefix) const {
+        const std::vector<MortonIndex>& prefixes = levels[idxLevel].blockPrefix;
+        const auto iter = std::lower_bound(prefixes.begin(), prefixes.end(), inPrefix);
+        if(iter != prefixes.end() && (*iter) == inPrefix){
+            return int(iter - prefixes.begin());
+        }
+        return -1;
+    }
+
+    /**
+     * Get the blocks of level idxLevel that are neighbors of the block idxBlock
+     * (including itself), the cells used by M2L and P2P are inside these blocks
+     * because their ancestors at the block level are neighbors.
+     * @return the number of blocks put in neighborBlocks (at most 27)
+     */
+    int getNeighborBlocks(const int idxLevel, const int idxBlock, int neighborBlocks[27]) const {
+        const int blockLevel = getBlockLevel(idxLevel);
+        const int boxLimit = 1 << blockLevel;
+        FTreeCoordinate center;
+        center.setPositionFromMorton(levels[idxLevel].blockPrefix[idxBlock]);
+
+        int counter = 0;
+        for(int idxX = -1 ; idxX <= 1 ; ++idxX){
+            const int x = center.getX() + idxX;
+            if(x < 0 || boxLimit <= x) continue;
+            for(int idxY = -1 ; idxY <= 1 ; ++idxY){
+                const int y = center.getY() + idxY;
+                if(y < 0 || boxLimit <= y) continue;
+                for(int idxZ = -1 ; idxZ <= 1 ; ++idxZ){
+                    const int z = center.getZ() + idxZ;
+                    if(z < 0 || boxLimit <= z) continue;
+                    const int neighBlock = findBlock(idxLevel, FTreeCoordinate(x, y, z).getMortonIndex());
+                    if(neighBlock != -1){
+                        neighborBlocks[counter++] = neighBlock;
+                    }
+                }
+            }
+        }
+        return counter;
+    }
+
+    /**
+     * Get the interval of blocks at level idxLevel+1 that contain the children of
+     * the block idxBlock, they are contiguous since the prefixes are sorted.
+     */
+    std::pair<int,int> getChildBlocks(const int idxLevel, const int idxBlock) const {
+        const MortonIndex parentPrefix = levels[idxLevel].blockPrefix[idxBlock];
+        const std::vector<MortonIndex>& childPrefixes = levels[idxLevel+1].blockPrefix;
+        const MortonIndex firstPrefix = (getBlockLevel(idxLevel+1) == getBlockLevel(idxLevel) ? parentPrefix : parentPrefix << 3);
+        const MortonIndex lastPrefix  = (getBlockLevel(idxLevel+1) == getBlockLevel(idxLevel) ? parentPrefix : (parentPrefix << 3) | 7);
+        const int first = int(std::lower_bound(childPrefixes.begin(), childPrefixes.end(), firstPrefix) - childPrefixes.begin());
+        const int last  = int(std::upper_bound(childPrefixes.begin(), childPrefixes.end(), lastPrefix) - childPrefixes.begin());
+        return std::pair<int,int>(first, last);
+    }
+
+    /**
+     * To execute the fmm algorithm
+     * Call this function to run the complete algorithm
+     */
+    void executeCore(const unsigned operationsToProceed) override {
+        buildBlocks();
+
+        #pragma omp parallel num_threads(MaxThreads)
+        {
+            #pragma omp master
+            {
+                Timers[P2MTimer].tic();
+                if(operationsToProceed & FFmmP2M)
+                    bottomPass();
+                Timers[P2MTimer].tac();
+
+                Timers[M2MTimer].tic();
+                if(operationsToProceed & FFmmM2M)
+                    upwardPass();
+                Timers[M2MTimer].tac();
+
+                // M2L and L2L are inserted level by level so that the L2L of
+                // a level can start as soon as the M2L of its blocks are done
+                Timers[M2LTimer].tic();
+                Timers[L2LTimer].tic();
+                for(int idxLevel = FAbstractAlgorithm::upperWorkingLevel ; idxLevel < FAbstractAlgorithm::lowerWorkingLevel ; ++idxLevel){
+                    if(operationsToProceed & FFmmM2L)
+                        transferPass(idxLevel);
+                    if((operationsToProceed & FFmmL2L) && idxLevel < FAbstractAlgorithm::lowerWorkingLevel - 1)
+                        downardPass(idxLevel);
+                }
+                Timers[L2LTimer].tac();
+                Timers[M2LTimer].tac();
+
+                Timers[L2PTimer].tic();
+                if( operationsToProceed & FFmmL2P)
+                    mergePass();
+                Timers[L2PTimer].tac();
+
+                // The P2P are the lowest priority tasks, they fill the gaps
+                Timers[NearTimer].tic();
+                if( operationsToProceed & FFmmP2P )
+                    directPass();
+                Timers[NearTimer].tac();
+
+                if(FAbstractAlgorithm::isExecutionAsync())
+                    notifyPass();
+
+                #pragma omp taskwait
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // P2M
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** P2M */
+    void bottomPass(){
+        FLOG( FLog::Controller.write("\tStart Bottom Pass\n").write(FLog::Flush) );
+        FLOG(FTic counterTime);
+
+        LevelBlocks* const leafLevel = &levels[OctreeHeight - 1];
+
+        for(int idxBlock = 0 ; idxBlock < leafLevel->getNbBlocks() ; ++idxBlock){
+            const unsigned char* taskMultipole = &leafLevel->multipoleDeps[idxBlock];
+            // The P2M only reads the positions and the physical values, so it
+            // does not need to be ordered with the P2P and L2P
+            #pragma omp task firstprivate(idxBlock, taskMultipole) depend(out:taskMultipole[0]) priority(int(Omp5_Priorities::P2M))
+            {
+                KernelClass* const kernel = kernels[omp_get_thread_num()];
+                for(FSize idxCell = leafLevel->blockStart[idxBlock] ; idxCell < leafLevel->blockStart[idxBlock+1] ; ++idxCell){
+                    CellClass* const cell = leafLevel->cells[idxCell];
+                    kernel->P2M(&(cell->getMultipoleData()), cell, leafLevel->sources[idxCell]);
+                }
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Bottom Pass (P2M) = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Upward
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** M2M */
+    void upwardPass(){
+        FLOG( FLog::Controller.write("\tStart Upward Pass\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        for(int idxLevel = FMath::Min(OctreeHeight - 2, FAbstractAlgorithm::lowerWorkingLevel - 1) ; idxLevel >= FAbstractAlgorithm::upperWorkingLevel ; --idxLevel ){
+            LevelBlocks* const level = &levels[idxLevel];
+            const LevelBlocks* const childLevel = &levels[idxLevel+1];
+
+            for(int idxBlock = 0 ; idxBlock < level->getNbBlocks() ; ++idxBlock){
+                const std::pair<int,int> childBlocks = getChildBlocks(idxLevel, idxBlock);
+                const unsigned char* taskMultipole = &level->multipoleDeps[idxBlock];
+                const unsigned char* taskChildMultipole = &childLevel->multipoleDeps[childBlocks.first];
+                const int nbChildBlocks = childBlocks.second - childBlocks.first;
+
+                #pragma omp task firstprivate(idxBlock, taskMultipole) depend(iterator(idxChild=0:nbChildBlocks), in:taskChildMultipole[idxChild]) depend(out:taskMultipole[0]) priority(int(Omp5_Priorities::M2M))
+                {
+                    KernelClass* const kernel = kernels[omp_get_thread_num()];
+                    for(FSize idxCell = level->blockStart[idxBlock] ; idxCell < level->blockStart[idxBlock+1] ; ++idxCell){
+                        CellClass* const cell = level->cells[idxCell];
+                        CellClass** const children = level->children[idxCell];
+
+                        std::array<const multipole_t*, 8> child_multipoles;
+                        std::array<const symbolic_data_t*, 8> child_symbolics;
+                        for(int idxChild = 0 ; idxChild < 8 ; ++idxChild){
+                            child_multipoles[idxChild] = (children[idxChild] ? &(children[idxChild]->getMultipoleData()) : nullptr);
+                            child_symbolics[idxChild] = children[idxChild];
+                        }
+
+                        kernel->M2M(&(cell->getMultipoleData()), cell,
+                                    child_multipoles.data(), child_symbolics.data());
+                    }
+                }
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Upward Pass (M2M) = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Transfer
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** M2L of one level */
+    void transferPass(const int idxLevel){
+        FLOG( FLog::Controller.write("\tStart Downward Pass (M2L)\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        LevelBlocks* const level = &levels[idxLevel];
+        const int separationCriteria = (idxLevel != FAbstractAlgorithm::lowerWorkingLevel-1 ? 1 : leafLevelSeparationCriteria);
+        // The upper levels are on the critical path
+        const int taskPriority = (idxLevel == FAbstractAlgorithm::lowerWorkingLevel-1 ? int(Omp5_Priorities::M2L) : int(Omp5_Priorities::M2L_High));
+
+        for(int idxBlock = 0 ; idxBlock < level->getNbBlocks() ; ++idxBlock){
+            int neighborBlocks[27];
+            const int nbNeighborBlocks = getNeighborBlocks(idxLevel, idxBlock, neighborBlocks);
+            const unsigned char* taskNeighMultipole[27];
+            for(int idxNeigh = 0 ; idxNeigh < nbNeighborBlocks ; ++idxNeigh){
+                taskNeighMultipole[idxNeigh] = &level->multipoleDeps[neighborBlocks[idxNeigh]];
+            }
+            const unsigned char* taskLocal = &level->localDeps[idxBlock];
+
+            #pragma omp task firstprivate(idxBlock, idxLevel, separationCriteria, taskLocal) depend(iterator(idxNeigh=0:nbNeighborBlocks), in:taskNeighMultipole[idxNeigh][0]) depend(mutexinoutset:taskLocal[0]) priority(taskPriority)
+            {
+                KernelClass* const kernel = kernels[omp_get_thread_num()];
+                const CellClass* neighbors[342];
+                int neighborPositions[342];
+                std::array<const multipole_t*, 342> neighbor_multipoles;
+                std::array<const symbolic_data_t*, 342> neighbor_symbolics;
+
+                for(FSize idxCell = level->blockStart[idxBlock] ; idxCell < level->blockStart[idxBlock+1] ; ++idxCell){
+                    CellClass* const cell = level->cells[idxCell];
+                    const int counter = tree->getInteractionNeighbors(neighbors, neighborPositions, cell->getCoordinate(), idxLevel, separationCriteria);
+                    if(counter){
+                        for(int idxNeigh = 0 ; idxNeigh < counter ; ++idxNeigh){
+                            neighbor_multipoles[idxNeigh] = &(neighbors[idxNeigh]->getMultipoleData());
+                            neighbor_symbolics[idxNeigh] = neighbors[idxNeigh];
+                        }
+                        kernel->M2L(&(cell->getLocalExpansionData()), cell,
+                                    neighbor_multipoles.data(), neighbor_symbolics.data(),
+                                    neighborPositions, counter);
+                    }
+                }
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Downward Pass (M2L) level " << idxLevel << " = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Downward
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** L2L from idxLevel to idxLevel+1 */
+    void downardPass(const int idxLevel){
+        FLOG( FLog::Controller.write("\tStart Downward Pass (L2L)\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        LevelBlocks* const level = &levels[idxLevel];
+        const LevelBlocks* const childLevel = &levels[idxLevel+1];
+
+        for(int idxBlock = 0 ; idxBlock < level->getNbBlocks() ; ++idxBlock){
+            const std::pair<int,int> childBlocks = getChildBlocks(idxLevel, idxBlock);
+            const unsigned char* taskLocal = &level->localDeps[idxBlock];
+            const unsigned char* taskChildLocal = &childLevel->localDeps[childBlocks.first];
+            const int nbChildBlocks = childBlocks.second - childBlocks.first;
+
+            #pragma omp task firstprivate(idxBlock, taskLocal) depend(in:taskLocal[0]) depend(iterator(idxChild=0:nbChildBlocks), mutexinoutset:taskChildLocal[idxChild]) priority(int(Omp5_Priorities::L2L))
+            {
+                KernelClass* const kernel = kernels[omp_get_thread_num()];
+                for(FSize idxCell = level->blockStart[idxBlock] ; idxCell < level->blockStart[idxBlock+1] ; ++idxCell){
+                    CellClass* const cell = level->cells[idxCell];
+                    CellClass** const children = level->children[idxCell];
+
+                    std::array<local_expansion_t*, 8> child_local_exps;
+                    std::array<const symbolic_data_t*, 8> child_symbolics;
+                    for(int idxChild = 0 ; idxChild < 8 ; ++idxChild){
+                        child_local_exps[idxChild] = (children[idxChild] ? &(children[idxChild]->getLocalExpansionData()) : nullptr);
+                        child_symbolics[idxChild] = children[idxChild];
+                    }
+
+                    kernel->L2L(&(cell->getLocalExpansionData()), cell,
+                                child_local_exps.data(), child_symbolics.data());
+                }
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Downward Pass (L2L) level " << idxLevel << " = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Direct
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** P2P */
+    void directPass(){
+        FLOG( FLog::Controller.write("\tStart Direct Pass\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+        const int heightMinusOne = OctreeHeight - 1;
+
+        LevelBlocks* const leafLevel = &levels[heightMinusOne];
+
+        for(int idxBlock = 0 ; idxBlock < leafLevel->getNbBlocks() ; ++idxBlock){
+            // The neighbors of the leaves, which are also updated by the
+            // mutual P2P, are in the neighbor blocks
+            int neighborBlocks[27];
+            const int nbNeighborBlocks = getNeighborBlocks(heightMinusOne, idxBlock, neighborBlocks);
+            const unsigned char* taskNeighParticles[27];
+            for(int idxNeigh = 0 ; idxNeigh < nbNeighborBlocks ; ++idxNeigh){
+                taskNeighParticles[idxNeigh] = &leafLevel->particlesDeps[neighborBlocks[idxNeigh]];
+            }
+
+            FSize nbParticlesInBlock = 0;
+            for(FSize idxCell = leafLevel->blockStart[idxBlock] ; idxCell < leafLevel->blockStart[idxBlock+1] ; ++idxCell){
+                nbParticlesInBlock += leafLevel->targets[idxCell]->getNbParticles();
+            }
+            const int taskPriority = (nbParticlesInBlock > FSize(double(p2pPrioCriteria)*1.1) ?
+                                      int(Omp5_Priorities::P2P_Big) : int(Omp5_Priorities::P2P_Small));
+
+            #pragma omp task firstprivate(idxBlock, heightMinusOne) depend(iterator(idxNeigh=0:nbNeighborBlocks), mutexinoutset:taskNeighParticles[idxNeigh][0]) priority(taskPriority)
+            {
+                KernelClass* const kernel = kernels[omp_get_thread_num()];
+                ContainerClass* neighbors[26];
+                int neighborPositions[26];
+
+                for(FSize idxCell = leafLevel->blockStart[idxBlock] ; idxCell < leafLevel->blockStart[idxBlock+1] ; ++idxCell){
+                    const FTreeCoordinate coord = leafLevel->cells[idxCell]->getCoordinate();
+                    const int counter = tree->getLeafsNeighbors(neighbors, neighborPositions, coord, heightMinusOne);
+                    kernel->P2P(coord, leafLevel->targets[idxCell], leafLevel->sources[idxCell],
+                                neighbors, neighborPositions, counter);
+                }
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Direct Pass (P2P) = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+    /** Notify the leaves of a block when all the L2P and P2P that modify them are done */
+    void notifyPass(){
+        LevelBlocks* const leafLevel = &levels[OctreeHeight - 1];
+
+        for(int idxBlock = 0 ; idxBlock < leafLevel->getNbBlocks() ; ++idxBlock){
+            const unsigned char* taskParticles = &leafLevel->particlesDeps[idxBlock];
+
+            #pragma omp task firstprivate(idxBlock, taskParticles) depend(inout:taskParticles[0]) priority(int(Omp5_Priorities::P2M))
+            {
+                for(FSize idxCell = leafLevel->blockStart[idxBlock] ; idxCell < leafLevel->blockStart[idxBlock+1] ; ++idxCell){
+                    FAbstractAlgorithm::notifyLeafFinished(leafLevel->cells[idxCell]->getMortonIndex());
+                }
+            }
+        }
+    }
+
+    /** L2P */
+    void mergePass(){
+        FLOG( FLog::Controller.write("\tStart Direct Pass\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        LevelBlocks* const leafLevel = &levels[OctreeHeight - 1];
+
+        for(int idxBlock = 0 ; idxBlock < leafLevel->getNbBlocks() ; ++idxBlock){
+            const unsigned char* taskLocal = &leafLevel->localDeps[idxBlock];
+            const unsigned char* taskParticles = &leafLevel->particlesDeps[idxBlock];
+
+            #pragma omp task firstprivate(idxBlock, taskLocal, taskParticles) depend(in:taskLocal[0]) depend(mutexinoutset:taskParticles[0]) priority(int(Omp5_Priorities::L2P))
+            {
+                KernelClass* const kernel = kernels[omp_get_thread_num()];
+                for(FSize idxCell = leafLevel->blockStart[idxBlock] ; idxCell < leafLevel->blockStart[idxBlock+1] ; ++idxCell){
+                    CellClass* const cell = leafLevel->cells[idxCell];
+                    kernel->L2P(&(cell->getLocalExpansionData()), cell, leafLevel->targets[idxCell]);
+                }
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Merge Pass (L2P) = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+};
+
+
+#endif // FFMMALGORITHMOMP5_HPP
@@ -21,6 +21,7 @@
 #include "Components/FBasicCell.hpp"
 
 #include "FCoreCommon.hpp"
+#include "FKernelCopies.hpp"
 #include "FP2PExclusion.hpp"
 
 #include <omp.h>
@@ -82,13 +83,7 @@ public:
             MaxThreads = omp_get_num_threads();
 
         this->kernels = new KernelClass*[MaxThreads];
-        #pragma omp parallel num_threads(MaxThreads)
-        {
-            #pragma omp critical (InitFFmmAlgorithmSectionTask)
-            {
-                this->kernels[omp_get_thread_num()] = new KernelClass(*inKernels);
-            }
-        }
+        FCopyKernelPerThread(this->kernels, inKernels, MaxThreads);
 
         FAbstractAlgorithm::setNbLevelsInTree(tree->getHeight());
 
@@ -4,6 +4,9 @@
 
 #include <array>
 #include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include "../Utils/FAssert.hpp"
 #include "../Utils/FLog.hpp"
@@ -16,6 +19,7 @@
 #include "../Containers/FOctree.hpp"
 
 #include "FCoreCommon.hpp"
+#include "FKernelCopies.hpp"
 #include "FP2PExclusion.hpp"
 
 #include <omp.h>
@@ -59,6 +63,9 @@ class FFmmAlgorithmThread : public FAbstractAlgorithm, public FAlgorithmTimers{
 
     const int leafLevelSeparationCriteria;
 
+    double p2pSplitCostRatio;   ///< A leaf P2P is split when its cost exceeds this ratio of the mean work per thread (0 disables)
+    FSize p2pSplitBlockSize;    ///< Number of target particles per task when a leaf P2P is split
+
 public:
     /** Class constructor
      *
@@ -74,10 +81,12 @@ public:
                         const int inUserChunkSize = 10, const int inLeafLevelSeperationCriteria = 1)
         : tree(inTree), kernels(nullptr), iterArray(nullptr), leafsNumber(0),
           OctreeHeight(tree->getHeight()),
-          userChunkSize(inUserChunkSize), leafLevelSeparationCriteria(inLeafLevelSeperationCriteria) {
+          userChunkSize(inUserChunkSize), leafLevelSeparationCriteria(inLeafLevelSeperationCriteria),
+          p2pSplitCostRatio(FEnv::GetValue("SCALFMM_P2P_SPLIT_RATIO", 0.0)),
+          p2pSplitBlockSize(FEnv::GetValue("SCALFMM_P2P_SPLIT_BLOCK", FSize(512))) {
         FAssertLF(tree, "tree cannot be null");
         FAssertLF(leafLevelSeparationCriteria < 3, "Separation criteria should be < 3");
-        FAssertLF(0 < userChunkSize, "Chunk size should be > 0");
+        FAssertLF(-1 <= userChunkSize, "Chunk size should be >= -1");
 
         MaxThreads = 1;
         #pragma omp parallel
@@ -85,13 +94,7 @@ public:
             MaxThreads = omp_get_num_threads();
 
         this->kernels = new KernelClass*[MaxThreads];
-        #pragma omp parallel num_threads(MaxThreads) 
-        {
-            #pragma omp critical (InitFFmmAlgorithmThread)
-            {
-                this->kernels[omp_get_thread_num()] = new KernelClass(*inKernels);
-            }
-        }
+        FCopyKernelPerThread(this->kernels, inKernels, MaxThreads);
 
         FAbstractAlgorithm::setNbLevelsInTree(tree->getHeight());
 
@@ -142,6 +145,39 @@ public:
             userChunkSize = size;
     }
 
+    /** Set the schedule of the next loops of the calling thread
+     *
+     * With a chunk size of -1 the loops use the default static schedule
+     * (one contiguous range of iterations per thread), which is the one used
+     * by FParticleArena::compact and FOctree::compactCells, so a thread works
+     * on the memory it has first touched (see FNumaPlacement).
+     * It must be called by all the threads of the parallel region.
+     */
+    void setLoopSchedule(const int chunkSize) const {
+        if(userChunkSize <= -1){
+            omp_set_schedule(omp_sched_static, 0);
+        } else {
+            omp_set_schedule(omp_sched_dynamic, chunkSize);
+        }
+    }
+
+    /** Enable the intra-leaf parallelization of the P2P for the dense leaves
+     *
+     * A leaf whose P2P cost (targets x sources) is greater than inCostRatio times
+     * the mean cost per thread is removed from the leaf loop and its work is
+     * split in tasks of inBlockSize targets that all the threads execute.
+     * The kernel must implement P2PRemote.
+     *
+     * \param inCostRatio the threshold ratio, 0 disables the splitting
+     * \param inBlockSize the number of targets per task
+     */
+    void setP2PLeafSplitting(const double inCostRatio, const FSize inBlockSize = 512) {
+        FAssertLF(0 <= inCostRatio, "Cost ratio should be >= 0");
+        FAssertLF(0 < inBlockSize, "Block size should be > 0");
+        p2pSplitCostRatio = inCostRatio;
+        p2pSplitBlockSize = inBlockSize;
+    }
+
 protected:
     /**
       * Runs the complete algorithm.
@@ -214,7 +250,8 @@ protected:
         #pragma omp parallel num_threads(MaxThreads)
         {
             KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
-            #pragma omp for nowait schedule(dynamic, chunkSize)
+            this->setLoopSchedule(chunkSize);
+            #pragma omp for nowait schedule(runtime)
             for(int idxLeafs = 0 ; idxLeafs < leafs ; ++idxLeafs){
                 // We need the current cell that represent the leaf
                 // and the list of particles
@@ -271,7 +308,8 @@ protected:
             #pragma omp parallel num_threads(MaxThreads)
             {
                 KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
-                #pragma omp for nowait  schedule(dynamic, chunkSize)
+                this->setLoopSchedule(chunkSize);
+                #pragma omp for nowait  schedule(runtime)
                 for(int idxCell = 0 ; idxCell < numberOfCells ; ++idxCell){
                     // We need the current cell and its children
 
@@ -365,7 +403,8 @@ protected:
                 const CellClass* neighbors[342];
                 int neighborPositions[342];
 
-                #pragma omp for  schedule(dynamic, chunkSize) nowait
+                this->setLoopSchedule(chunkSize);
+                #pragma omp for  schedule(runtime) nowait
                 for(int idxCell = 0 ; idxCell < numberOfCells ; ++idxCell){
                     const int counter = tree->getInteractionNeighbors(neighbors, neighborPositions, iterArray[idxCell].getCurrentGlobalCoordinate(), idxLevel, separationCriteria);
                     if(counter) {
@@ -447,7 +486,8 @@ protected:
             #pragma omp parallel num_threads(MaxThreads)
             {
                 KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
-                #pragma omp for nowait schedule(dynamic, chunkSize)
+                this->setLoopSchedule(chunkSize);
+                #pragma omp for nowait schedule(runtime)
                 for(int idxCell = 0 ; idxCell < numberOfCells ; ++idxCell){
 
                     local_expansion_t* const parent_local_exp
@@ -487,6 +527,14 @@ protected:
     // Direct
     /////////////////////////////////////////////////////////////////////////////
 
+    /** The description of a leaf used by the direct pass */
+    struct LeafData{
+        MortonIndex index;
+        CellClass* cell;
+        ContainerClass* targets;
+        ContainerClass* sources;
+    };
+
     /** Runs the P2P & L2P kernels.
       *
      * \param p2pEnabled Run the P2P kernel.
@@ -497,25 +545,19 @@ protected:
         FLOG(FTic counterTime);
         FLOG(FTic computationCounter);
         FLOG(FTic computationCounterP2P);
+        FLOG(FTic computationCounterSplit);
 
-        omp_lock_t lockShape[SizeShape];
-        for(int idxShape = 0 ; idxShape < SizeShape ; ++idxShape){
-            omp_init_lock(&lockShape[idxShape]);
-        }
-
-        struct LeafData{
-            MortonIndex index;
-            CellClass* cell;
-            ContainerClass* targets;
-            ContainerClass* sources;
-        };
         LeafData* const leafsDataArray = new LeafData[this->leafsNumber];
 
-        int startPosAtShape[SizeShape];
-        startPosAtShape[0] = 0;
-        for(int idxShape = 1 ; idxShape < SizeShape ; ++idxShape){
-            startPosAtShape[idxShape] = startPosAtShape[idxShape-1] + this->shapeLeaf[idxShape-1];
-        }
+        // The leaves of each shape are stored in Morton order: each thread counts
+        // the leaves of its range per shape, and the ranges are put one after the other
+        std::vector<int> startPosAtShape(SizeShape * MaxThreads, 0);
+
+        // The leaves that are too costly to be computed by a single thread
+        const bool splitEnabled = (p2pEnabled && p2pSplitCostRatio > 0 && MaxThreads > 1);
+        double totalP2PCost = 0;
+        std::vector<int> heavyLeaves;
+        std::vector<const ContainerClass*> heavySources;
 
         #pragma omp parallel num_threads(MaxThreads)
         {
@@ -532,27 +574,71 @@ protected:
                 octreeIterator.moveRight();
             }
 
+            typename OctreeClass::Iterator startIterator(octreeIterator);
+            int* const myStartPosAtShape = &startPosAtShape[SizeShape * omp_get_thread_num()];
+            for(int idxMyLeafs = start ; idxMyLeafs < end ; ++idxMyLeafs){
+                myStartPosAtShape[P2PExclusionClass::GetShapeIdx(octreeIterator.getCurrentGlobalCoordinate())] += 1;
+                octreeIterator.moveRight();
+            }
+            octreeIterator = startIterator;
+
+            #pragma omp barrier
+
+            #pragma omp single
+            {
+                int currentPosition = 0;
+                for(int idxShape = 0 ; idxShape < SizeShape ; ++idxShape){
+                    for(int idxThread = 0 ; idxThread < omp_get_num_threads() ; ++idxThread){
+                        const int nbLeavesOfThread = startPosAtShape[SizeShape * idxThread + idxShape];
+                        startPosAtShape[SizeShape * idxThread + idxShape] = currentPosition;
+                        currentPosition += nbLeavesOfThread;
+                    }
+                }
+            }
+
+            double myP2PCost = 0;
             // for each leafs
             for(int idxMyLeafs = start ; idxMyLeafs < end ; ++idxMyLeafs){
-                //iterArray[leafs] = octreeIterator;
-                //++leafs;
                 const FTreeCoordinate& coord = octreeIterator.getCurrentGlobalCoordinate();
                 const int shapePosition = P2PExclusionClass::GetShapeIdx(coord);
 
-                omp_set_lock(&lockShape[shapePosition]);
-                const int positionToWork = startPosAtShape[shapePosition]++;
-                omp_unset_lock(&lockShape[shapePosition]);
+                const int positionToWork = myStartPosAtShape[shapePosition]++;
 
                 leafsDataArray[positionToWork].index   = octreeIterator.getCurrentGlobalIndex();
                 leafsDataArray[positionToWork].cell    = octreeIterator.getCurrentCell();
                 leafsDataArray[positionToWork].targets = octreeIterator.getCurrentListTargets();
                 leafsDataArray[positionToWork].sources = octreeIterator.getCurrentListSrc();
 
+                myP2PCost += double(leafsDataArray[positionToWork].targets->getNbParticles())
+                        * double(leafsDataArray[positionToWork].sources->getNbParticles());
+
                 octreeIterator.moveRight();
             }
 
+            if(splitEnabled){
+                #pragma omp atomic
+                totalP2PCost += myP2PCost;
+            }
+
             #pragma omp barrier
 
+            if(splitEnabled){
+                #pragma omp single
+                {
+                    const double costLimit = p2pSplitCostRatio * totalP2PCost / double(omp_get_num_threads());
+                    for(int idxLeafs = 0 ; idxLeafs < this->leafsNumber ; ++idxLeafs){
+                        const FSize nbTargets = leafsDataArray[idxLeafs].targets->getNbParticles();
+                        const double cost = double(nbTargets) * double(leafsDataArray[idxLeafs].sources->getNbParticles());
+                        if(costLimit < cost && p2pSplitBlockSize < nbTargets){
+                            heavyLeaves.push_back(idxLeafs);
+                            heavySources.push_back(leafsDataArray[idxLeafs].sources);
+                        }
+                    }
+                    std::sort(heavySources.begin(), heavySources.end());
+                    FLOG( FLog::Controller << "\t\t Leaves with a split P2P : " << heavyLeaves.size() << "\n" );
+                }
+            }
+
             FLOG(if(!omp_get_thread_num()) computationCounter.tic());
 
             KernelClass& myThreadkernels = (*kernels[omp_get_thread_num()]);
@@ -564,7 +650,8 @@ protected:
             for(int idxShape = 0 ; idxShape < SizeShape ; ++idxShape){
                 const int endAtThisShape = this->shapeLeaf[idxShape] + previous;
                 const int chunkSize = this->getChunkSize(endAtThisShape-previous);
-                #pragma omp for schedule(dynamic, chunkSize)
+                this->setLoopSchedule(chunkSize);
+                #pragma omp for schedule(runtime)
                 for(int idxLeafs = previous ; idxLeafs < endAtThisShape ; ++idxLeafs){
                     LeafData& currentIter = leafsDataArray[idxLeafs];
                     if(l2pEnabled){
@@ -573,10 +660,22 @@ protected:
                             currentIter.cell,
                             currentIter.targets);
                     }
-                    if(p2pEnabled){
+                    if(p2pEnabled && (heavySources.empty() || !isHeavySource(heavySources, currentIter.sources))){
                         // need the current particles and neighbors particles
                         FLOG(if(!omp_get_thread_num()) computationCounterP2P.tic());
-                        const int counter = tree->getLeafsNeighbors(neighbors, neighborPositions, currentIter.cell->getCoordinate(), OctreeHeight-1);
+                        int counter = tree->getLeafsNeighbors(neighbors, neighborPositions, currentIter.cell->getCoordinate(), OctreeHeight-1);
+                        if(!heavySources.empty()){
+                            // The interactions with the heavy leaves are done when they are split
+                            int counterLight = 0;
+                            for(int idxNeigh = 0 ; idxNeigh < counter ; ++idxNeigh){
+                                if(!isHeavySource(heavySources, neighbors[idxNeigh])){
+                                    neighbors[counterLight] = neighbors[idxNeigh];
+                                    neighborPositions[counterLight] = neighborPositions[idxNeigh];
+                                    ++counterLight;
+                                }
+                            }
+                            counter = counterLight;
+                        }
                         myThreadkernels.P2P(currentIter.cell->getCoordinate(), currentIter.targets,
                                             currentIter.sources, neighbors, neighborPositions, counter);
                         FLOG(if(!omp_get_thread_num()) computationCounterP2P.tac());
@@ -585,20 +684,154 @@ protected:
 
                 previous = endAtThisShape;
             }
+
+            if(!heavyLeaves.empty()){
+                #pragma omp single
+                {
+                    FLOG(computationCounterSplit.tic());
+                    std::vector<std::pair<const ContainerClass*, int>> leafBySource(this->leafsNumber);
+                    for(int idxLeafs = 0 ; idxLeafs < this->leafsNumber ; ++idxLeafs){
+                        leafBySource[idxLeafs] = std::pair<const ContainerClass*, int>(leafsDataArray[idxLeafs].sources, idxLeafs);
+                    }
+                    std::sort(leafBySource.begin(), leafBySource.end());
+
+                    // Heavy leaves are processed one after the other since they may share neighbors
+                    for(const int idxHeavy : heavyLeaves){
+                        splitLeafP2P(leafsDataArray, idxHeavy, heavySources, leafBySource);
+                    }
+                    FLOG(computationCounterSplit.tac());
+                }
+            }
         }
 
         FLOG(computationCounter.tac());
 
         delete [] leafsDataArray;
-        for(int idxShape = 0 ; idxShape < SizeShape ; ++idxShape){
-            omp_destroy_lock(&lockShape[idxShape]);
-        }
 
 
         FLOG( FLog::Controller << "\tFinished (@Direct Pass (L2P + P2P) = "  << counterTime.tacAndElapsed() << " s)\n" );
         FLOG( FLog::Controller << "\t\t Computation L2P + P2P : " << computationCounter.cumulated()    << " s\n" );
         FLOG( FLog::Controller << "\t\t Computation P2P :       " << computationCounterP2P.cumulated() << " s\n" );
+        FLOG( FLog::Controller << "\t\t Computation split P2P : " << computationCounterSplit.cumulated() << " s\n" );
+
+    }
+
+    /** Test if a source container belongs to a leaf whose P2P is split */
+    static bool isHeavySource(const std::vector<const ContainerClass*>& heavySources, const ContainerClass* const sources){
+        return std::binary_search(heavySources.begin(), heavySources.end(), sources);
+    }
+
+    /** Copy a range of particles in a new container */
+    static void CopyParticles(const ContainerClass* const from, const FSize start, const FSize end, ContainerClass* const to){
+        to->reserve(end-start);
+        for(FSize idxPart = start ; idxPart < end ; ++idxPart){
+            to->push_back((*from)[idxPart]);
+        }
+    }
+
+    /** Compute all the P2P interactions of a dense leaf using tasks
+     *
+     * Must be called by a single thread, the other threads execute the tasks.
+     * The targets are copied in blocks which receive (without mutual
+     * interactions) the particles of the leaf and of all its neighbors.
+     * Then the non split neighbors receive the particles of the leaf and the
+     * blocks are copied back.
+     */
+    void splitLeafP2P(LeafData leafsDataArray[], const int idxHeavy,
+                      const std::vector<const ContainerClass*>& heavySources,
+                      const std::vector<std::pair<const ContainerClass*, int>>& leafBySource){
+        const LeafData& heavyLeaf = leafsDataArray[idxHeavy];
+        const FTreeCoordinate& coord = heavyLeaf.cell->getCoordinate();
+        const bool sourcesAreTargets = (heavyLeaf.targets == heavyLeaf.sources);
+
+        ContainerClass* neighbors[26];
+        int neighborPositions[26];
+        const int counter = tree->getLeafsNeighbors(neighbors, neighborPositions, coord, OctreeHeight-1);
+
+        const FSize nbTargets = heavyLeaf.targets->getNbParticles();
+        const int nbBlocks = int((nbTargets + p2pSplitBlockSize - 1) / p2pSplitBlockSize);
+        std::unique_ptr<ContainerClass[]> targetBlocks(new ContainerClass[nbBlocks]);
+        std::unique_ptr<ContainerClass[]> sourceBlocks(new ContainerClass[sourcesAreTargets ? nbBlocks : 0]);
+
+        for(int idxBlock = 0 ; idxBlock < nbBlocks ; ++idxBlock){
+            #pragma omp task default(shared) firstprivate(idxBlock)
+            {
+                const FSize start = FSize(idxBlock) * p2pSplitBlockSize;
+                const FSize end = FMath::Min(nbTargets, start + p2pSplitBlockSize);
+                CopyParticles(heavyLeaf.targets, start, end, &targetBlocks[idxBlock]);
+                if(sourcesAreTargets){
+                    CopyParticles(heavyLeaf.sources, start, end, &sourceBlocks[idxBlock]);
+                }
+            }
+        }
+        #pragma omp taskwait
+
+        // Each block receives the inner and the neighbors interactions
+        for(int idxBlock = 0 ; idxBlock < nbBlocks ; ++idxBlock){
+            #pragma omp task default(shared) firstprivate(idxBlock)
+            {
+                KernelClass* const myThreadkernels = kernels[omp_get_thread_num()];
+                ContainerClass* const block = &targetBlocks[idxBlock];
+                std::vector<const ContainerClass*> blockSources;
+                std::vector<int> blockPositions;
+                blockSources.reserve(nbBlocks + counter);
+                blockPositions.reserve(nbBlocks + counter);
+
+                ContainerClass* noNeighbors[1] = {nullptr};
+                const int noPositions[1] = {0};
+                if(sourcesAreTargets){
+                    myThreadkernels->P2P(coord, block, block, noNeighbors, noPositions, 0);
+                    for(int idxOther = 0 ; idxOther < nbBlocks ; ++idxOther){
+                        if(idxOther != idxBlock){
+                            blockSources.push_back(&sourceBlocks[idxOther]);
+                            blockPositions.push_back(13);
+                        }
+                    }
+                }
+                else{
+                    myThreadkernels->P2P(coord, block, heavyLeaf.sources, noNeighbors, noPositions, 0);
+                }
+                for(int idxNeigh = 0 ; idxNeigh < counter ; ++idxNeigh){
+                    blockSources.push_back(neighbors[idxNeigh]);
+                    blockPositions.push_back(neighborPositions[idxNeigh]);
+                }
+                if(blockSources.size()){
+                    myThreadkernels->P2PRemote(coord, block, heavyLeaf.sources, blockSources.data(),
+                                               blockPositions.data(), int(blockSources.size()));
+                }
+            }
+        }
+        #pragma omp taskwait
+
+        // The other heavy leaves take this leaf into account when they are split
+        for(int idxNeigh = 0 ; idxNeigh < counter ; ++idxNeigh){
+            if(!isHeavySource(heavySources, neighbors[idxNeigh])){
+                const int idxNeighLeaf = std::lower_bound(leafBySource.begin(), leafBySource.end(),
+                                                          std::pair<const ContainerClass*, int>(neighbors[idxNeigh], -1))->second;
+                const int oppositePosition = 26 - neighborPositions[idxNeigh];
+                #pragma omp task default(shared) firstprivate(idxNeighLeaf, oppositePosition)
+                {
+                    KernelClass* const myThreadkernels = kernels[omp_get_thread_num()];
+                    const LeafData& neighborLeaf = leafsDataArray[idxNeighLeaf];
+                    const ContainerClass* const heavySrc[1] = {heavyLeaf.sources};
+                    myThreadkernels->P2PRemote(neighborLeaf.cell->getCoordinate(), neighborLeaf.targets,
+                                               neighborLeaf.sources, heavySrc, &oppositePosition, 1);
+                }
+            }
+        }
+        #pragma omp taskwait
 
+        for(int idxBlock = 0 ; idxBlock < nbBlocks ; ++idxBlock){
+            #pragma omp task default(shared) firstprivate(idxBlock)
+            {
+                const FSize start = FSize(idxBlock) * p2pSplitBlockSize;
+                const ContainerClass& block = targetBlocks[idxBlock];
+                for(FSize idxPart = 0 ; idxPart < block.getNbParticles() ; ++idxPart){
+                    (*heavyLeaf.targets)[start + idxPart] = block[idxPart];
+                }
+            }
+        }
+        #pragma omp taskwait
     }
 
 };
@@ -6,8 +6,13 @@
 
 
 #include <algorithm>
+#include <array>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <limits>
+#include <type_traits>
+#include <utility>
 //#include <sys/time.h>
 
 //
@@ -27,12 +32,13 @@
 #include "Containers/FVector.hpp"
 #include "Containers/FBoolArray.hpp"
 #include "Containers/FOctree.hpp"
-#include "Containers/FLightOctree.hpp"
+#include "Containers/FCellHashMap.hpp"
 
 #include "Containers/FBufferWriter.hpp"
 #include "Containers/FBufferReader.hpp"
 
 #include "FCoreCommon.hpp"
+#include "FKernelCopies.hpp"
 #include "FP2PExclusion.hpp"
 
 #include "Utils/FAlgorithmTimers.hpp"
@@ -125,7 +131,227 @@ private:
         return (getWorkingInterval((idxLevel+1) , idxProc).rightIndex >>3) == (getWorkingInterval((idxLevel+1) , idProcess).leftIndex>>3);
     }
 
+    /**
+     * The communication plan of the M2L and of the P2P : what has to be sent to who,
+     * what will be received, the buffers and the persistent MPI requests.
+     * It is built by the first execution and reused by the next ones as long as no
+     * process changes its leaves (or their number of particles), so the intervals,
+     * the preparation of the messages and the exchange of their sizes are done once.
+     */
+    struct CommunicationPlan {
+        /// True if the intervals and the compute communicator can be reused
+        bool isValid = false;
+        /// Hash of the local leaves (index, addresses, saved size of the sources)
+        std::size_t leavesHash = 0;
+
+        /// M2L part, built for given working levels
+        bool hasTransfer = false;
+        int transferUpperLevel = 0;
+        int transferLowerLevel = 0;
+        std::unique_ptr<FVector<typename OctreeClass::Iterator>[]> transferToSend; ///< [level * nbProcess + proc]
+        std::vector<long long int> transferSizeToSend;
+        std::vector<long long int> transferSizeToReceive;
+        std::vector<std::vector<typename OctreeClass::Iterator>> transferCells;       ///< [level] cells in the working interval
+        std::vector<std::vector<typename OctreeClass::Iterator>> transferRemoteCells; ///< [level] cells that need others
+        std::vector<std::unique_ptr<FBufferWriter>> transferSendBuffers;
+        std::vector<std::unique_ptr<FBufferReader>> transferRecvBuffers;
+        std::vector<MPI_Request> transferSendRequests;
+        std::vector<MPI_Request> transferRecvRequests;
+        std::vector<int> transferRecvRequestLevel;       ///< The level of each reception
+        std::vector<int> transferNbRecvRequestsAtLevel;  ///< [level]
+        /// With derived datatypes the multipoles are sent from the cells and received in
+        /// transferReceivedCells[level], there are no buffers
+        bool transferUseDatatypes = false;
+        std::unique_ptr<FCellHashMap<CellClass>[]> transferReceivedCells;
+        std::vector<MPI_Datatype> transferDatatypes;
+
+        /// P2P part
+        bool hasDirect = false;
+        std::unique_ptr<FVector<typename OctreeClass::Iterator>[]> directToSend;   ///< [proc]
+        std::vector<FSize> directSizeToSend;
+        std::vector<FSize> directSizeToReceive;
+        std::vector<typename OctreeClass::Iterator> directRemoteLeaves;  ///< The leaves that need others
+        std::vector<std::vector<int>> directProcsOfRemoteLeaf;  ///< The processes each of them waits for
+        std::vector<std::vector<int>> directRemoteLeavesOfProc; ///< [proc] the remote leaves that wait for proc
+        std::vector<std::unique_ptr<FBufferWriter>> directSendBuffers;
+        std::vector<std::unique_ptr<FBufferReader>> directRecvBuffers;
+        std::vector<MPI_Request> directSendRequests;
+        std::vector<MPI_Request> directRecvRequests;
+        std::vector<int> directRecvRequestProc;            ///< The source of each reception
+        std::vector<int> directNbRecvRequestsOfProc;       ///< [proc]
+
+        static void FreeRequests(std::vector<MPI_Request>* requests){
+            int mpiIsFinalized = 0;
+            MPI_Finalized(&mpiIsFinalized);
+            if(!mpiIsFinalized){
+                for(MPI_Request& request : (*requests)){
+                    if(request != MPI_REQUEST_NULL){
+                        MPI_Request_free(&request);
+                    }
+                }
+            }
+            requests->clear();
+        }
+
+        static void FreeDatatypes(std::vector<MPI_Datatype>* datatypes){
+            int mpiIsFinalized = 0;
+            MPI_Finalized(&mpiIsFinalized);
+            if(!mpiIsFinalized){
+                for(MPI_Datatype& datatype : (*datatypes)){
+                    MPI_Type_free(&datatype);
+                }
+            }
+            datatypes->clear();
+        }
+
+        void resetTransfer(){
+            FreeRequests(&transferSendRequests);
+            FreeRequests(&transferRecvRequests);
+            hasTransfer = false;
+            transferToSend.reset();
+            transferSizeToSend.clear();
+            transferSizeToReceive.clear();
+            transferCells.clear();
+            transferRemoteCells.clear();
+            transferSendBuffers.clear();
+            transferRecvBuffers.clear();
+            transferRecvRequestLevel.clear();
+            transferNbRecvRequestsAtLevel.clear();
+            transferUseDatatypes = false;
+            transferReceivedCells.reset();
+            FreeDatatypes(&transferDatatypes);
+        }
+
+        void resetDirect(){
+            FreeRequests(&directSendRequests);
+            FreeRequests(&directRecvRequests);
+            hasDirect = false;
+            directToSend.reset();
+            directSizeToSend.clear();
+            directSizeToReceive.clear();
+            directRemoteLeaves.clear();
+            directProcsOfRemoteLeaf.clear();
+            directRemoteLeavesOfProc.clear();
+            directSendBuffers.clear();
+            directRecvBuffers.clear();
+            directRecvRequestProc.clear();
+            directNbRecvRequestsOfProc.clear();
+        }
+
+        void reset(){
+            resetTransfer();
+            resetDirect();
+            isValid = false;
+        }
+
+        ~CommunicationPlan(){
+            reset();
+        }
+    };
+
+    CommunicationPlan plan;
+    /// To disable the reuse of the plan (SCALFMM_MPI_COMMUNICATION_PLAN=false)
+    const bool reuseCommunicationPlan;
+
+    /// To send the multipoles of the M2L with MPI derived datatypes (SCALFMM_MPI_DERIVED_DATATYPES=true)
+    const bool useDerivedDatatypes;
+
+    /** The multipoles that give their serialized bytes with getContiguousData() can be sent in place */
+    template <class MultipoleClass>
+    static auto GetContiguousData(MultipoleClass& multipole, int) -> decltype(multipole.getContiguousData()) {
+        return multipole.getContiguousData();
+    }
+    template <class MultipoleClass>
+    static std::nullptr_t GetContiguousData(MultipoleClass&, long) {
+        return nullptr;
+    }
+    static constexpr bool HasContiguousMultipole(){
+        return !std::is_same<decltype(GetContiguousData(std::declval<multipole_t&>(), 0)), std::nullptr_t>::value;
+    }
+
+    /// The storage of the expansions exchanged at each level (see FBufferPrecision)
+    std::unique_ptr<FBufferPrecision[]> wirePrecisions;
+
+    /**
+     * The size of the multipole of a cell once serialized at a level.
+     * With a reduced precision the cell is serialized in scratchBuffer to know it.
+     */
+    FSize getWireSizeUp(const CellClass* const cell, const int level, FBufferWriter* const scratchBuffer) const {
+        if(wirePrecisions[level] == FBufferPrecision::Full){
+            return cell->getMultipoleData().getSavedSize();
+        }
+        scratchBuffer->reset();
+        scratchBuffer->setPrecision(wirePrecisions[level]);
+        cell->serializeUp(*scratchBuffer);
+        return scratchBuffer->getSize();
+    }
+
+    /**
+     * Compare the local leaves with the ones used to build the plan, all the
+     * processes have to agree so it costs a single reduction.
+     * @return true if at least one process has changed its leaves
+     */
+    bool partitionHasChanged(){
+        std::size_t hash = 14695981039346656037ULL;
+        auto combine = [&hash](const std::size_t value){
+            hash = (hash ^ value) * 1099511628211ULL;
+        };
+        tree->forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+            combine(std::size_t(cell->getMortonIndex()));
+            combine(std::size_t(cell));
+            combine(std::size_t(leaf->getSrc()));
+            combine(std::size_t(leaf->getSrc()->getSavedSize()));
+        });
+
+        const int iHaveChanged = (plan.isValid == false || plan.leavesHash != hash);
+        plan.leavesHash = hash;
+
+        int someoneHasChanged = 0;
+        FMpi::Assert( MPI_Allreduce(&iHaveChanged, &someoneHasChanged, 1, MPI_INT, MPI_MAX, comm.getComm()), __LINE__);
+        return someoneHasChanged != 0;
+    }
+
 public:
+    /**
+     * Force the communication plan to be rebuilt at the next execution.
+     * A change of the leaves is detected, but this has to be called if the
+     * size of the multipoles changes.
+     */
+    void invalidateCommunicationPlan(){
+        plan.isValid = false;
+    }
+
+    /**
+     * Set the storage of the expansions exchanged at a level (M2M and L2L
+     * with the cells of this level, M2L at this level).
+     * It must be the same on all the processes.
+     * Only the cells that serialize with writeReals/fillReals are concerned (FChebCell).
+     */
+    void setWirePrecision(const int level, const FBufferPrecision precision){
+        FAssertLF(0 <= level && level < OctreeHeight);
+        if(wirePrecisions[level] != precision){
+            wirePrecisions[level] = precision;
+            invalidateCommunicationPlan();
+        }
+    }
+
+    /**
+     * Select the storage of the exchanged expansions from the relative error accepted on them.
+     * The levels deeper than deepestLevel keep the full precision, by default all the
+     * levels are concerned.
+     * This is also set at construction from SCALFMM_MPI_WIRE_ACCURACY (0 by default, full precision).
+     */
+    void setWireAccuracy(const double accuracy, const int deepestLevel = -1){
+        const int lastLevel = (deepestLevel < 0 ? OctreeHeight - 1 : FMath::Min(deepestLevel, OctreeHeight - 1));
+        for(int idxLevel = 0 ; idxLevel < OctreeHeight ; ++idxLevel){
+            setWirePrecision(idxLevel, idxLevel <= lastLevel ? FBufferPrecisionForAccuracy(accuracy) : FBufferPrecision::Full);
+        }
+    }
+
+    FBufferPrecision getWirePrecision(const int level) const {
+        return wirePrecisions[level];
+    }
+
     ///
     /// \brief getWorkingInterval
     /// \param level level in th tree
@@ -173,13 +399,7 @@ public:
     /// @todo move it in private section
     void setKernel(const KernelClass*const inKernels){
         this->kernels = new KernelClass*[MaxThreads];
-        #pragma omp parallel num_threads(MaxThreads)
-        {
-          #pragma omp critical (InitFFmmAlgorithmThreadProc)
-          {
-            this->kernels[omp_get_thread_num()] = new KernelClass(*inKernels);
-          }
-        }
+        FCopyKernelPerThread(this->kernels, inKernels, MaxThreads);
     }
     ///
     /// \brief getPtrOnMortonIndexAtLeaf
@@ -221,7 +441,10 @@ public:
         userChunkSize(inUserChunkSize),
         leafLevelSeparationCriteria(inLeafLevelSeperationCriteria),
         intervals(new Interval[inComm.processCount()]),
-        workingIntervalsPerLevel(new Interval[inComm.processCount() * tree->getHeight()]) {
+        workingIntervalsPerLevel(new Interval[inComm.processCount() * tree->getHeight()]),
+        reuseCommunicationPlan(FEnv::GetBool("SCALFMM_MPI_COMMUNICATION_PLAN", true)),
+        useDerivedDatatypes(FEnv::GetBool("SCALFMM_MPI_DERIVED_DATATYPES", false)),
+        wirePrecisions(new FBufferPrecision[tree->getHeight()]) {
         FAssertLF(tree, "tree cannot be null");
         FAssertLF(leafLevelSeparationCriteria < 3, "Separation criteria should be < 3");
 
@@ -234,9 +457,15 @@ public:
 
         FAbstractAlgorithm::setNbLevelsInTree(tree->getHeight());
 
+        std::fill(wirePrecisions.get(), wirePrecisions.get() + OctreeHeight, FBufferPrecision::Full);
+        setWireAccuracy(FEnv::GetValue("SCALFMM_MPI_WIRE_ACCURACY", 0.0));
+
         FLOG(FLog::Controller << "FFmmAlgorithmThreadProc\n");
         FLOG(FLog::Controller << "Max threads = "  << MaxThreads << ", Procs = " << nbProcessOrig << ", I am " << idProcessOrig << ".\n");
         FLOG(FLog::Controller << "Chunck Size = " << userChunkSize << "\n");
+        FLOG(FLog::Controller << "Reuse communication plan = " << reuseCommunicationPlan << "\n");
+        FLOG(FLog::Controller << "Wire precision at root = " << int(wirePrecisions[0]) << "\n");
+        FLOG(FLog::Controller << "M2L with derived datatypes = " << (useDerivedDatatypes && HasContiguousMultipole()) << "\n");
     }
 
     /// Default destructor
@@ -259,13 +488,20 @@ protected:
         // We are not involve if the tree is empty
         const int iHaveParticles = (!tree->isEmpty());
 
-        std::unique_ptr<int[]> hasParticles(new int[comm.processCount()]);
-        FMpi::Assert( MPI_Allgather(const_cast<int*>(&iHaveParticles), 1,MPI_INT,
-                                    hasParticles.get(), 1, MPI_INT,
-                                    comm.getComm()), __LINE__);
+        // If no process has changed its leaves, the compute communicator,
+        // the intervals and the communication plan are still valid
+        const bool hasToBuildPartition = partitionHasChanged();
+        if(hasToBuildPartition){
+            plan.reset();
 
-        fcomCompute = FMpi::FComm(comm);
-        fcomCompute.groupReduce(hasParticles.get());
+            std::unique_ptr<int[]> hasParticles(new int[comm.processCount()]);
+            FMpi::Assert( MPI_Allgather(const_cast<int*>(&iHaveParticles), 1,MPI_INT,
+                                        hasParticles.get(), 1, MPI_INT,
+                                        comm.getComm()), __LINE__);
+
+            fcomCompute = FMpi::FComm(comm);
+            fcomCompute.groupReduce(hasParticles.get());
+        }
 
         if(iHaveParticles){
 
@@ -279,8 +515,8 @@ protected:
             eztrace_resume();
 #endif
             this->numberOfLeafs = 0;
+            Interval myFullInterval;
             {
-                Interval myFullInterval;
                 {//Building the interval with the first and last leaves (and count the number of leaves)
                     typename OctreeClass::Iterator octreeIterator(tree);
                     octreeIterator.gotoBottomLeft();
@@ -295,7 +531,8 @@ protected:
                 iterArrayComm = new typename OctreeClass::Iterator[numberOfLeafs];
                 FAssertLF(iterArray,     "iterArray     bad alloc");
                 FAssertLF(iterArrayComm, "iterArrayComm bad alloc");
-
+            }
+            if(hasToBuildPartition){
                 // We get the leftIndex/rightIndex indexes from each procs
                 FMpi::MpiAssert( MPI_Allgather( &myFullInterval, sizeof(Interval), MPI_BYTE, intervals, sizeof(Interval), MPI_BYTE, fcomCompute.getComm()),  __LINE__ );
 
@@ -408,6 +645,13 @@ protected:
         else{
             FLOG( FLog::Controller << "\tProcess = " << comm.processId() << " has zero particles.\n" );
         }
+
+        if(reuseCommunicationPlan){
+            plan.isValid = true;
+        }
+        else{
+            plan.reset();
+        }
     }
 
     /////////////////////////////////////////////////////////////////////////////
@@ -513,6 +757,12 @@ protected:
                 break;
             }
 
+            // The cells exchanged are the children
+            sendBuffer.setPrecision(wirePrecisions[idxLevel+1]);
+            for(int idxBuffer = 0 ; idxBuffer < 7 ; ++idxBuffer){
+                recvBuffer[idxBuffer].setPrecision(wirePrecisions[idxLevel+1]);
+            }
+
             // Copy and count ALL the cells (even the ones outside the working interval)
             int totalNbCellsAtLevel = 0;
             do{
@@ -744,457 +994,618 @@ protected:
     /////////////////////////////////////////////////////////////////////////////
 
 
-    void transferPass(){
-        FLOG( FLog::Controller.write("\tStart Downward Pass (M2L)\n").write(FLog::Flush); );
-        FLOG(FTic counterTime);
-        FLOG(FTic computationCounter);
-        FLOG(FTic sendCounter);
-        FLOG(FTic receiveCounter);
-        FLOG(FTic prepareCounter);
-        FLOG(FTic gatherCounter);
-
-        //////////////////////////////////////////////////////////////////
-        // First know what to send to who
-        //////////////////////////////////////////////////////////////////
+    /**
+     * Build the M2L part of the plan : find the cells needed by others
+     * and the cells needed from others, exchange the sizes of the messages,
+     * allocate the buffers and create the persistent requests.
+     */
+    void buildTransferPlan(){
+        plan.resetTransfer();
+        plan.hasTransfer = true;
+        plan.transferUpperLevel = FAbstractAlgorithm::upperWorkingLevel;
+        plan.transferLowerLevel = FAbstractAlgorithm::lowerWorkingLevel;
 
         // pointer to send
-        std::unique_ptr<FVector<typename OctreeClass::Iterator>[]> toSend(new FVector<typename OctreeClass::Iterator>[nbProcess * OctreeHeight]);
+        plan.transferToSend.reset(new FVector<typename OctreeClass::Iterator>[nbProcess * OctreeHeight]);
+        FVector<typename OctreeClass::Iterator>*const toSend = plan.transferToSend.get();
         // index
-        long long int*const indexToSend = new long long int[nbProcess * OctreeHeight];
-        memset(indexToSend, 0, sizeof(long long int) * nbProcess * OctreeHeight);
-        // To know which one has need someone
-        FBoolArray** const leafsNeedOther = new FBoolArray*[OctreeHeight];
-        memset(leafsNeedOther, 0, sizeof(FBoolArray*) * OctreeHeight);
-
-        // All process say to each others
-        // what the will send to who
-        long long int*const globalReceiveMap = new long long  int[nbProcess * nbProcess * OctreeHeight];
-        memset(globalReceiveMap, 0, sizeof(long long  int) * nbProcess * nbProcess * OctreeHeight);
+        plan.transferSizeToSend.resize(nbProcess * OctreeHeight, 0);
+        long long int*const indexToSend = plan.transferSizeToSend.data();
+        // The cells of each level and the ones that need others
+        plan.transferCells.resize(OctreeHeight);
+        plan.transferRemoteCells.resize(OctreeHeight);
+        // What this process will receive from each other at each level
+        plan.transferSizeToReceive.resize(nbProcess * OctreeHeight, 0);
+        long long int*const indexToReceive = plan.transferSizeToReceive.data();
 
-        FBufferWriter**const sendBuffer = new FBufferWriter*[nbProcess * OctreeHeight];
-        memset(sendBuffer, 0, sizeof(FBufferWriter*) * nbProcess * OctreeHeight);
+        {
+            // To know if a leaf has been already sent to a proc
+            std::unique_ptr<bool[]> alreadySent(new bool[nbProcess]);
+            // To measure the cells serialized with a reduced precision
+            FBufferWriter sizeBuffer;
 
-        FBufferReader**const recvBuffer = new FBufferReader*[nbProcess * OctreeHeight];
-        memset(recvBuffer, 0, sizeof(FBufferReader*) * nbProcess * OctreeHeight);
+            typename OctreeClass::Iterator octreeIterator(tree);
+            octreeIterator.moveDown();
 
-#pragma omp parallel num_threads(MaxThreads)
-        {
-#pragma omp master
-            {
-                {
-                    FLOG(prepareCounter.tic());
+            for(int idxLevel = 2 ; idxLevel < FAbstractAlgorithm::upperWorkingLevel ; ++idxLevel){
+                octreeIterator.moveDown();
+            }
 
-                    std::unique_ptr<typename OctreeClass::Iterator[]> iterArrayLocal(new typename OctreeClass::Iterator[numberOfLeafs]);
+            typename OctreeClass::Iterator avoidGotoLeftIterator(octreeIterator);
+            // for each levels
+            for(int idxLevel = FAbstractAlgorithm::upperWorkingLevel ; idxLevel < FAbstractAlgorithm::lowerWorkingLevel ; ++idxLevel ){
 
-                    // To know if a leaf has been already sent to a proc
-                    bool*const alreadySent = new bool[nbProcess];
-                    memset(alreadySent, 0, sizeof(bool) * nbProcess);
+                const int separationCriteria = (idxLevel != FAbstractAlgorithm::lowerWorkingLevel-1 ? 1 : leafLevelSeparationCriteria);
 
-                    typename OctreeClass::Iterator octreeIterator(tree);
-                    octreeIterator.moveDown();
+                if(!procHasWorkAtLevel(idxLevel, idProcess)){
+                    avoidGotoLeftIterator.moveDown();
+                    octreeIterator = avoidGotoLeftIterator;
+                    continue;
+                }
 
-                    for(int idxLevel = 2 ; idxLevel < FAbstractAlgorithm::upperWorkingLevel ; ++idxLevel){
-                        octreeIterator.moveDown();
-                    }
+                while(octreeIterator.getCurrentGlobalIndex() <  getWorkingInterval(idxLevel , idProcess).leftIndex){
+                    octreeIterator.moveRight();
+                }
 
-                    typename OctreeClass::Iterator avoidGotoLeftIterator(octreeIterator);
-                    // for each levels
-                    for(int idxLevel = FAbstractAlgorithm::upperWorkingLevel ; idxLevel < FAbstractAlgorithm::lowerWorkingLevel ; ++idxLevel ){
+                // for each cells
+                std::vector<typename OctreeClass::Iterator>& cellsAtLevel = plan.transferCells[idxLevel];
+                do{
+                    cellsAtLevel.push_back(octreeIterator);
+                } while(octreeIterator.moveRight());
+                avoidGotoLeftIterator.moveDown();
+                octreeIterator = avoidGotoLeftIterator;
 
-                        const int separationCriteria = (idxLevel != FAbstractAlgorithm::lowerWorkingLevel-1 ? 1 : leafLevelSeparationCriteria);
+                // Which cell potentialy needs other data and in the same time
+                // are potentialy needed by other
+                MortonIndex neighborsIndexes[/*189+26+1*/216];
+                for(size_t idxCell = 0 ; idxCell < cellsAtLevel.size() ; ++idxCell){
+                    // Find the M2L neigbors of a cell
+                    const int counter = cellsAtLevel[idxCell].getCurrentGlobalCoordinate().getInteractionNeighbors(idxLevel, neighborsIndexes, separationCriteria);
 
-                        if(!procHasWorkAtLevel(idxLevel, idProcess)){
-                            avoidGotoLeftIterator.moveDown();
-                            octreeIterator = avoidGotoLeftIterator;
-                            continue;
-                        }
+                    memset(alreadySent.get(), false, sizeof(bool) * nbProcess);
+                    bool needOther = false;
+                    // Test each negibors to know which one do not belong to us
+                    for(int idxNeigh = 0 ; idxNeigh < counter ; ++idxNeigh){
+                        if(neighborsIndexes[idxNeigh] < getWorkingInterval(idxLevel , idProcess).leftIndex
+                                || (getWorkingInterval(idxLevel , idProcess).rightIndex) < neighborsIndexes[idxNeigh]){
+                            int procToReceive = idProcess;
+                            while( 0 != procToReceive && neighborsIndexes[idxNeigh] < getWorkingInterval(idxLevel , procToReceive).leftIndex ){
+                                --procToReceive;
+                            }
+                            while( procToReceive != nbProcess -1 && (getWorkingInterval(idxLevel , procToReceive).rightIndex) < neighborsIndexes[idxNeigh]){
+                                ++procToReceive;
+                            }
+                            // Maybe already sent to that proc?
+                            if( !alreadySent[procToReceive]
+                                    && getWorkingInterval(idxLevel , procToReceive).leftIndex <= neighborsIndexes[idxNeigh]
+                                    && neighborsIndexes[idxNeigh] <= getWorkingInterval(idxLevel , procToReceive).rightIndex){
 
-                        int numberOfCells = 0;
+                                alreadySent[procToReceive] = true;
 
-                        while(octreeIterator.getCurrentGlobalIndex() <  getWorkingInterval(idxLevel , idProcess).leftIndex){
-                            octreeIterator.moveRight();
-                        }
+                                needOther = true;
 
-                        // for each cells
-                        do{
-                            iterArrayLocal[numberOfCells] = octreeIterator;
-                            ++numberOfCells;
-                        } while(octreeIterator.moveRight());
-                        avoidGotoLeftIterator.moveDown();
-                        octreeIterator = avoidGotoLeftIterator;
-
-                        leafsNeedOther[idxLevel] = new FBoolArray(numberOfCells);
-
-                        // Which cell potentialy needs other data and in the same time
-                        // are potentialy needed by other
-                        MortonIndex neighborsIndexes[/*189+26+1*/216];
-                        for(int idxCell = 0 ; idxCell < numberOfCells ; ++idxCell){
-                            // Find the M2L neigbors of a cell
-                            const int counter = iterArrayLocal[idxCell].getCurrentGlobalCoordinate().getInteractionNeighbors(idxLevel, neighborsIndexes, separationCriteria);
-
-                            memset(alreadySent, false, sizeof(bool) * nbProcess);
-                            bool needOther = false;
-                            // Test each negibors to know which one do not belong to us
-                            for(int idxNeigh = 0 ; idxNeigh < counter ; ++idxNeigh){
-                                if(neighborsIndexes[idxNeigh] < getWorkingInterval(idxLevel , idProcess).leftIndex
-                                        || (getWorkingInterval(idxLevel , idProcess).rightIndex) < neighborsIndexes[idxNeigh]){
-                                    int procToReceive = idProcess;
-                                    while( 0 != procToReceive && neighborsIndexes[idxNeigh] < getWorkingInterval(idxLevel , procToReceive).leftIndex ){
-                                        --procToReceive;
-                                    }
-                                    while( procToReceive != nbProcess -1 && (getWorkingInterval(idxLevel , procToReceive).rightIndex) < neighborsIndexes[idxNeigh]){
-                                        ++procToReceive;
-                                    }
-                                    // Maybe already sent to that proc?
-                                    if( !alreadySent[procToReceive]
-                                            && getWorkingInterval(idxLevel , procToReceive).leftIndex <= neighborsIndexes[idxNeigh]
-                                            && neighborsIndexes[idxNeigh] <= getWorkingInterval(idxLevel , procToReceive).rightIndex){
-
-                                        alreadySent[procToReceive] = true;
-
-                                        needOther = true;
-
-                                        toSend[idxLevel * nbProcess + procToReceive].push(iterArrayLocal[idxCell]);
-                                        if(indexToSend[idxLevel * nbProcess + procToReceive] == 0){
-                                            indexToSend[idxLevel * nbProcess + procToReceive] = sizeof(int);
-                                        }
-                                        indexToSend[idxLevel * nbProcess + procToReceive] += iterArrayLocal[idxCell].getCurrentCell()->getMultipoleData().getSavedSize();
-                                        indexToSend[idxLevel * nbProcess + procToReceive] += sizeof(MortonIndex);
-                                        indexToSend[idxLevel * nbProcess + procToReceive] += sizeof(FSize);
-                                    }
+                                toSend[idxLevel * nbProcess + procToReceive].push(cellsAtLevel[idxCell]);
+                                if(indexToSend[idxLevel * nbProcess + procToReceive] == 0){
+                                    indexToSend[idxLevel * nbProcess + procToReceive] = sizeof(int);
                                 }
-                            }
-                            if(needOther){
-                                leafsNeedOther[idxLevel]->set(idxCell,true);
+                                indexToSend[idxLevel * nbProcess + procToReceive] += getWireSizeUp(cellsAtLevel[idxCell].getCurrentCell(), idxLevel, &sizeBuffer);
+                                indexToSend[idxLevel * nbProcess + procToReceive] += sizeof(MortonIndex);
+                                indexToSend[idxLevel * nbProcess + procToReceive] += sizeof(FSize);
                             }
                         }
                     }
-                    FLOG(prepareCounter.tac());
-
-                    delete[] alreadySent;
+                    if(needOther){
+                        plan.transferRemoteCells[idxLevel].push_back(cellsAtLevel[idxCell]);
+                    }
                 }
+            }
+        }
 
-                //////////////////////////////////////////////////////////////////
-                // Gather this information
-                //////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////
+        // Exchange this information with the concerned processes only
+        //////////////////////////////////////////////////////////////////
 
-                FLOG(gatherCounter.tic());
-                FMpi::MpiAssert( MPI_Allgather( indexToSend, nbProcess * OctreeHeight, MPI_LONG_LONG_INT, globalReceiveMap, nbProcess * OctreeHeight, MPI_LONG_LONG_INT, fcomCompute.getComm()),  __LINE__ );
-                FLOG(gatherCounter.tac());
+        {
+            // (level, size) for each non empty message
+            std::vector<std::pair<int,std::array<long long int,2>>> sizesToSend;
+            for(int idxLevel = 2 ; idxLevel < OctreeHeight ; ++idxLevel ){
+                for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                    if(indexToSend[idxLevel * nbProcess + idxProc]){
+                        sizesToSend.push_back({idxProc, {{idxLevel, indexToSend[idxLevel * nbProcess + idxProc]}}});
+                    }
+                }
+            }
+            const std::vector<std::pair<int,std::array<long long int,2>>> sizesToReceive
+                    = FMpi::SparseExchange(sizesToSend, fcomCompute, FMpi::TagSparseExchangeM2L);
+            for(const auto& sizeToReceive : sizesToReceive){
+                indexToReceive[sizeToReceive.second[0] * nbProcess + sizeToReceive.first] = sizeToReceive.second[1];
+            }
+        }
 
-                //////////////////////////////////////////////////////////////////
-                // Send and receive for real
-                //////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////
+        // Allocate the buffers and create the requests
+        //////////////////////////////////////////////////////////////////
 
-                FLOG(sendCounter.tic());
-                // Then they can send and receive (because they know what they will receive)
-                // To send in asynchrone way
-                std::vector<MPI_Request> requests;
-                requests.reserve(2 * nbProcess * OctreeHeight);
+        plan.transferSendBuffers.resize(nbProcess * OctreeHeight);
+        plan.transferRecvBuffers.resize(nbProcess * OctreeHeight);
+        plan.transferNbRecvRequestsAtLevel.resize(OctreeHeight, 0);
 
-                for(int idxLevel = 2 ; idxLevel < OctreeHeight ; ++idxLevel ){
-                    for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
-                        const long long int toSendAtProcAtLevel = indexToSend[idxLevel * nbProcess + idxProc];
-                        if(toSendAtProcAtLevel != 0){
-                            sendBuffer[idxLevel * nbProcess + idxProc] = new FBufferWriter(toSendAtProcAtLevel);
-
-                            sendBuffer[idxLevel * nbProcess + idxProc]->write(int(toSend[idxLevel * nbProcess + idxProc].getSize()));
-
-                            for(int idxLeaf = 0 ; idxLeaf < toSend[idxLevel * nbProcess + idxProc].getSize(); ++idxLeaf){
-                                const FSize currentTell = sendBuffer[idxLevel * nbProcess + idxProc]->getSize();
-                                sendBuffer[idxLevel * nbProcess + idxProc]->write(currentTell);
-                                const MortonIndex cellIndex = toSend[idxLevel * nbProcess + idxProc][idxLeaf].getCurrentGlobalIndex();
-                                sendBuffer[idxLevel * nbProcess + idxProc]->write(cellIndex);
-                                toSend[idxLevel * nbProcess + idxProc][idxLeaf].getCurrentCell()->serializeUp(*sendBuffer[idxLevel * nbProcess + idxProc]);
-                            }
-
-                            FAssertLF(sendBuffer[idxLevel * nbProcess + idxProc]->getSize() == toSendAtProcAtLevel);
+        if(canUseTransferDatatypes()){
+            buildTransferDatatypes();
+            return;
+        }
 
-                            FMpi::ISendSplit(sendBuffer[idxLevel * nbProcess + idxProc]->data(),
-                                    sendBuffer[idxLevel * nbProcess + idxProc]->getSize(), idxProc,
-                                    FMpi::TagLast + idxLevel*100, fcomCompute, &requests);
-                        }
+        for(int idxLevel = 2 ; idxLevel < OctreeHeight ; ++idxLevel ){
+            for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                const long long int toSendAtProcAtLevel = indexToSend[idxLevel * nbProcess + idxProc];
+                if(toSendAtProcAtLevel != 0){
+                    plan.transferSendBuffers[idxLevel * nbProcess + idxProc].reset(new FBufferWriter(toSendAtProcAtLevel));
+                    plan.transferSendBuffers[idxLevel * nbProcess + idxProc]->setPrecision(wirePrecisions[idxLevel]);
+                    FMpi::SendInitSplit(plan.transferSendBuffers[idxLevel * nbProcess + idxProc]->data(),
+                            toSendAtProcAtLevel, idxProc,
+                            FMpi::TagLast + idxLevel*100, fcomCompute, &plan.transferSendRequests);
+                }
 
-                        const long long int toReceiveFromProcAtLevel = globalReceiveMap[(idxProc * nbProcess * OctreeHeight) + idxLevel * nbProcess + idProcess];
-                        if(toReceiveFromProcAtLevel){
-                            recvBuffer[idxLevel * nbProcess + idxProc] = new FBufferReader(toReceiveFromProcAtLevel);
+                const long long int toReceiveFromProcAtLevel = indexToReceive[idxLevel * nbProcess + idxProc];
+                if(toReceiveFromProcAtLevel){
+                    plan.transferRecvBuffers[idxLevel * nbProcess + idxProc].reset(new FBufferReader(toReceiveFromProcAtLevel));
+                    plan.transferRecvBuffers[idxLevel * nbProcess + idxProc]->setPrecision(wirePrecisions[idxLevel]);
+                    const int nbRequests = FMpi::RecvInitSplit(plan.transferRecvBuffers[idxLevel * nbProcess + idxProc]->data(),
+                            plan.transferRecvBuffers[idxLevel * nbProcess + idxProc]->getCapacity(), idxProc,
+                            FMpi::TagLast + idxLevel*100, fcomCompute, &plan.transferRecvRequests);
+                    plan.transferRecvRequestLevel.insert(plan.transferRecvRequestLevel.end(), nbRequests, idxLevel);
+                    plan.transferNbRecvRequestsAtLevel[idxLevel] += nbRequests;
+                }
+            }
+        }
+    }
 
-                            FMpi::IRecvSplit(recvBuffer[idxLevel * nbProcess + idxProc]->data(),
-                                    recvBuffer[idxLevel * nbProcess + idxProc]->getCapacity(), idxProc,
-                                    FMpi::TagLast + idxLevel*100, fcomCompute, &requests);
-                        }
-                    }
+    /**
+     * The derived datatypes need the multipoles to be contiguous, in full precision and the
+     * messages to be smaller than 2GB (a single datatype is used by message).
+     * All the processes have to take the same decision.
+     */
+    bool canUseTransferDatatypes() const {
+        if(!useDerivedDatatypes || !HasContiguousMultipole()){
+            return false;
+        }
+        int canUse = 1;
+        for(int idxLevel = 2 ; idxLevel < OctreeHeight ; ++idxLevel ){
+            if(wirePrecisions[idxLevel] != FBufferPrecision::Full){
+                canUse = 0;
+            }
+            for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                if(plan.transferSizeToSend[idxLevel * nbProcess + idxProc] >= std::numeric_limits<int>::max()
+                        || plan.transferSizeToReceive[idxLevel * nbProcess + idxProc] >= std::numeric_limits<int>::max()){
+                    canUse = 0;
                 }
+            }
+        }
+        int allCanUse = 0;
+        FMpi::Assert( MPI_Allreduce(&canUse, &allCanUse, 1, MPI_INT, MPI_MIN, fcomCompute.getComm()), __LINE__);
+        return allCanUse != 0;
+    }
 
-                //////////////////////////////////////////////////////////////////
-                // Wait received data and compute
-                //////////////////////////////////////////////////////////////////
+    /**
+     * Replace the M2L buffers by derived datatypes (MPI_Type_create_hindexed) over the
+     * multipoles of the cells to send and of the cells that receive.
+     * The Morton indexes of the cells are exchanged once here, the receiving cells are
+     * allocated for the lifetime of the plan (one contiguous buffer per level).
+     */
+    void buildTransferDatatypes(){
+        plan.transferUseDatatypes = true;
+        plan.transferReceivedCells.reset(new FCellHashMap<CellClass>[OctreeHeight]);
 
-                // Wait to receive every things (and send every things)
-                FMpi::MpiAssert(MPI_Waitall(int(requests.size()), requests.data(), MPI_STATUS_IGNORE), __LINE__);
+        std::vector<MPI_Request> indexesRequests;
+        std::vector<std::vector<MortonIndex>> indexesToSend(nbProcess * OctreeHeight);
 
-                FLOG(sendCounter.tac());
-            }//End of Master region
+        for(int idxLevel = 2 ; idxLevel < OctreeHeight ; ++idxLevel ){
+            for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                const FVector<typename OctreeClass::Iterator>& toSend = plan.transferToSend[idxLevel * nbProcess + idxProc];
+                if(plan.transferSizeToSend[idxLevel * nbProcess + idxProc] == 0){
+                    continue;
+                }
+                std::vector<MortonIndex>& indexes = indexesToSend[idxLevel * nbProcess + idxProc];
+                std::vector<int> blockLengths;
+                std::vector<MPI_Aint> displacements;
+                for(int idxCell = 0 ; idxCell < toSend.getSize() ; ++idxCell){
+                    CellClass*const cell = toSend[idxCell].getCurrentCell();
+                    indexes.push_back(toSend[idxCell].getCurrentGlobalIndex());
+                    MPI_Aint address;
+                    FMpi::Assert( MPI_Get_address(GetContiguousData(cell->getMultipoleData(), 0), &address), __LINE__);
+                    displacements.push_back(address);
+                    blockLengths.push_back(int(cell->getMultipoleData().getSavedSize()));
+                }
 
-            //////////////////////////////////////////////////////////////////
-            // Do M2L
-            //////////////////////////////////////////////////////////////////
+                FAssertLF(indexes.size() < std::numeric_limits<int>::max());
+                MPI_Request request;
+                FMpi::Assert( MPI_Isend(indexes.data(), int(indexes.size() * sizeof(MortonIndex)), MPI_BYTE, idxProc,
+                                        FMpi::TagFmmM2LIndexes + idxLevel, fcomCompute.getComm(), &request), __LINE__);
+                indexesRequests.push_back(request);
+
+                MPI_Datatype datatype;
+                FMpi::Assert( MPI_Type_create_hindexed(int(blockLengths.size()), blockLengths.data(), displacements.data(),
+                                                       MPI_BYTE, &datatype), __LINE__);
+                FMpi::Assert( MPI_Type_commit(&datatype), __LINE__);
+                plan.transferDatatypes.push_back(datatype);
+
+                MPI_Request sendRequest;
+                FMpi::Assert( MPI_Send_init(MPI_BOTTOM, 1, datatype, idxProc, FMpi::TagLast + idxLevel*100,
+                                            fcomCompute.getComm(), &sendRequest), __LINE__);
+                plan.transferSendRequests.push_back(sendRequest);
+            }
+        }
 
-#pragma omp single nowait
-            {
-                typename OctreeClass::Iterator octreeIterator(tree);
-                octreeIterator.moveDown();
+        for(int idxLevel = 2 ; idxLevel < OctreeHeight ; ++idxLevel ){
+            // All the indexes of the level are needed to allocate the cells at once
+            std::vector<std::vector<MortonIndex>> indexesToReceive(nbProcess);
+            FSize nbCellsAtLevel = 0;
+            for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                if(plan.transferSizeToReceive[idxLevel * nbProcess + idxProc] == 0){
+                    continue;
+                }
+                MPI_Status status;
+                FMpi::Assert( MPI_Probe(idxProc, FMpi::TagFmmM2LIndexes + idxLevel, fcomCompute.getComm(), &status), __LINE__);
+                int nbBytes = 0;
+                FMpi::Assert( MPI_Get_count(&status, MPI_BYTE, &nbBytes), __LINE__);
+                indexesToReceive[idxProc].resize(nbBytes / sizeof(MortonIndex));
+                FMpi::Assert( MPI_Recv(indexesToReceive[idxProc].data(), nbBytes, MPI_BYTE, idxProc, FMpi::TagFmmM2LIndexes + idxLevel,
+                                       fcomCompute.getComm(), MPI_STATUS_IGNORE), __LINE__);
+                nbCellsAtLevel += FSize(indexesToReceive[idxProc].size());
+            }
+            plan.transferReceivedCells[idxLevel].reserve(nbCellsAtLevel);
 
-                for(int idxLevel = 2 ; idxLevel < FAbstractAlgorithm::upperWorkingLevel ; ++idxLevel){
-                    octreeIterator.moveDown();
+            for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                if(plan.transferSizeToReceive[idxLevel * nbProcess + idxProc] == 0){
+                    continue;
+                }
+                std::vector<int> blockLengths;
+                std::vector<MPI_Aint> displacements;
+                for(const MortonIndex cellIndex : indexesToReceive[idxProc]){
+                    CellClass* const newCell = plan.transferReceivedCells[idxLevel].allocateCell();
+                    newCell->setMortonIndex(cellIndex);
+                    plan.transferReceivedCells[idxLevel].insertCell(cellIndex, idxLevel, newCell);
+
+                    MPI_Aint address;
+                    FMpi::Assert( MPI_Get_address(GetContiguousData(newCell->getMultipoleData(), 0), &address), __LINE__);
+                    displacements.push_back(address);
+                    blockLengths.push_back(int(newCell->getMultipoleData().getSavedSize()));
                 }
 
-                typename OctreeClass::Iterator avoidGotoLeftIterator(octreeIterator);
-                // Now we can compute all the data
-                // for each levels
-                for(int idxLevel = FAbstractAlgorithm::upperWorkingLevel ; idxLevel < FAbstractAlgorithm::lowerWorkingLevel ; ++idxLevel ){
-                    const int separationCriteria = (idxLevel != FAbstractAlgorithm::lowerWorkingLevel-1 ? 1 : leafLevelSeparationCriteria);
+                MPI_Datatype datatype;
+                FMpi::Assert( MPI_Type_create_hindexed(int(blockLengths.size()), blockLengths.data(), displacements.data(),
+                                                       MPI_BYTE, &datatype), __LINE__);
+                FMpi::Assert( MPI_Type_commit(&datatype), __LINE__);
+                plan.transferDatatypes.push_back(datatype);
+
+                MPI_Request recvRequest;
+                FMpi::Assert( MPI_Recv_init(MPI_BOTTOM, 1, datatype, idxProc, FMpi::TagLast + idxLevel*100,
+                                            fcomCompute.getComm(), &recvRequest), __LINE__);
+                plan.transferRecvRequests.push_back(recvRequest);
+                plan.transferRecvRequestLevel.push_back(idxLevel);
+                plan.transferNbRecvRequestsAtLevel[idxLevel] += 1;
+            }
+        }
 
-                    if(!procHasWorkAtLevel(idxLevel, idProcess)){
-                        avoidGotoLeftIterator.moveDown();
-                        octreeIterator = avoidGotoLeftIterator;
-                        continue;
-                    }
+        FMpi::Assert( MPI_Waitall(int(indexesRequests.size()), indexesRequests.data(), MPI_STATUSES_IGNORE), __LINE__);
+    }
 
-                    int numberOfCells = 0;
-                    while(octreeIterator.getCurrentGlobalIndex() <  getWorkingInterval(idxLevel , idProcess).leftIndex){
-                        octreeIterator.moveRight();
-                    }
-                    // for each cells
-                    do{
-                        iterArray[numberOfCells] = octreeIterator;
-                        ++numberOfCells;
-                    } while(octreeIterator.moveRight());
-                    avoidGotoLeftIterator.moveDown();
-                    octreeIterator = avoidGotoLeftIterator;
+    /**
+     * The M2L kernels that buffer their work (NeedFinishedM2LEvent) are flushed at the end of
+     * each task, because a thread may proceed several levels in any order.
+     */
+    static void FinishedM2LTask(KernelClass*const kernel, const int idxLevel){
+        if(KernelClass::NeedFinishedM2LEvent()){
+            kernel->finishedLevelM2L(idxLevel);
+        }
+    }
 
-                    FLOG(computationCounter.tic());
-                    {
-                        const int chunckSize = userChunkSize;
-                        for(int idxCell = 0 ; idxCell < numberOfCells ; idxCell += chunckSize){
-#pragma omp task default(none) shared(numberOfCells,idxLevel) firstprivate(idxCell) //+ shared(chunckSize)
-                            {
-                                KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
-                                const CellClass* neighbors[342] {};
-                                int neighborPositions[342] {};
+    /** M2L of a cell with its neighbors received from the other processes */
+    void computeRemoteM2L(KernelClass*const myThreadkernels, const typename OctreeClass::Iterator& targetIterator,
+                          const int idxLevel, const int separationCriteria, const FCellHashMap<CellClass>*const receivedCells) const {
+        MortonIndex neighborsIndex[/*189+26+1*/216];
+        int neighborsPosition[/*189+26+1*/216];
+        const CellClass* neighbors[342] {};
+        int neighborPositions[342] {};
 
-                                const int nbCellToCompute = FMath::Min(chunckSize, numberOfCells-idxCell);
-                                for(int idxCellToCompute = idxCell ; idxCellToCompute < idxCell+nbCellToCompute ; ++idxCellToCompute) {
-                                    const int counter = tree->getInteractionNeighbors(
-                                        neighbors,
-                                        neighborPositions,
-                                        iterArray[idxCellToCompute].getCurrentGlobalCoordinate(),
-                                        idxLevel,
-                                        separationCriteria
-                                        );
-                                    if(counter) {
-                                        local_expansion_t* target_local_expansion
-                                            = &(iterArray[idxCellToCompute].getCurrentCell()->getLocalExpansionData());
-                                        const symbolic_data_t* target_symbolic
-                                            = iterArray[idxCellToCompute].getCurrentCell();
-
-                                        std::array<const multipole_t*, 342> source_multipoles {};
-                                        std::transform(std::begin(neighbors), std::end(neighbors),
-                                                       std::begin(source_multipoles),
-                                                       [](const CellClass* c) {
-                                                           return ((c != nullptr)
-                                                                   ? &(c->getMultipoleData())
-                                                                   : nullptr);
-                                                       });
-
-                                        std::array<const symbolic_data_t*, 342> source_symbolics {};
-                                        std::copy(std::begin(neighbors), std::end(neighbors),
-                                                  std::begin(source_symbolics));
-
-                                        myThreadkernels->M2L(
-                                            target_local_expansion,
-                                            target_symbolic,
-                                            source_multipoles.data(),
-                                            source_symbolics.data(),
-                                            neighborPositions,
-                                            counter
-                                            );
-                                    }
-                                }
-                            }
-                        }
-                    }//End of task spawning
+        const int counterNeighbors = targetIterator.getCurrentGlobalCoordinate().getInteractionNeighbors(idxLevel, neighborsIndex, neighborsPosition, separationCriteria);
 
-#pragma omp taskwait
+        int counter = 0;
+        // does we receive this index from someone?
+        for(int idxNeig = 0 ;idxNeig < counterNeighbors ; ++idxNeig){
+            if(neighborsIndex[idxNeig] < (getWorkingInterval(idxLevel , idProcess).leftIndex)
+                    || (getWorkingInterval(idxLevel , idProcess).rightIndex) < neighborsIndex[idxNeig]){
 
-                    for(int idxThread = 0 ; idxThread < omp_get_num_threads() ; ++idxThread){
-#pragma omp task  default(none) firstprivate(idxThread,idxLevel)
-                        {
-                            kernels[idxThread]->finishedLevelM2L(idxLevel);
-                        }
-                    }
-#pragma omp taskwait
+                CellClass*const otherCell = receivedCells->getCell(neighborsIndex[idxNeig], idxLevel);
 
-                    FLOG(computationCounter.tac());
+                if(otherCell){
+                    neighbors[counter] = otherCell;
+                    neighborPositions[counter] = neighborsPosition[idxNeig];
+                    ++counter;
                 }
             }
         }
+        // need to compute
+        if(counter){
+            local_expansion_t* target_local_expansion
+                = &(targetIterator.getCurrentCell()->getLocalExpansionData());
+            const symbolic_data_t* target_symbolic
+                = targetIterator.getCurrentCell();
+
+            std::array<const multipole_t*, 342> source_multipoles {};
+            std::transform(std::begin(neighbors), std::end(neighbors),
+                           std::begin(source_multipoles),
+                           [](const CellClass* c) {
+                               return ((c != nullptr)
+                                       ? &(c->getMultipoleData())
+                                       : nullptr);
+                           });
+
+            std::array<const symbolic_data_t*, 342> source_symbolics {};
+            std::copy(std::begin(neighbors), std::end(neighbors),
+                      std::begin(source_symbolics));
+
+            myThreadkernels->M2L(
+                target_local_expansion,
+                target_symbolic,
+                source_multipoles.data(),
+                source_symbolics.data(),
+                neighborPositions,
+                counter
+                );
+        }
+    }
+
+    /**
+     * The M2L of all the levels are done in tasks. The local M2L tasks of all the levels
+     * are created first, then the thread that created them polls the receptions and
+     * creates the remote M2L of a level as soon as all its messages are received and
+     * its local M2L is over (both work on the same local expansions).
+     * So the remote work of a level overlaps the local work of the others and the
+     * receptions of the other levels.
+     */
+    void transferPass(){
+        FLOG( FLog::Controller.write("\tStart Downward Pass (M2L)\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+        FLOG(FTic sendCounter);
+        FLOG(FTic receiveCounter);
+        FLOG(FTic prepareCounter);
 
+        // The cells received at each level
+        std::unique_ptr<FCellHashMap<CellClass>[]> receivedCells(new FCellHashMap<CellClass>[OctreeHeight]);
+        // To proceed the remote M2L of a level after its local M2L (dependencies only)
+        std::unique_ptr<char[]> levelTokens(new char[OctreeHeight]);
 
+#pragma omp parallel num_threads(MaxThreads)
+#pragma omp single nowait
         {
-            FLOG(receiveCounter.tic());
-            typename OctreeClass::Iterator octreeIterator(tree);
-            octreeIterator.moveDown();
-
-            for(int idxLevel = 2 ; idxLevel < FAbstractAlgorithm::upperWorkingLevel ; ++idxLevel){
-                octreeIterator.moveDown();
+            if(plan.hasTransfer == false || plan.transferUpperLevel != FAbstractAlgorithm::upperWorkingLevel
+                    || plan.transferLowerLevel != FAbstractAlgorithm::lowerWorkingLevel){
+                FLOG(prepareCounter.tic());
+                buildTransferPlan();
+                FLOG(prepareCounter.tac());
             }
 
-            typename OctreeClass::Iterator avoidGotoLeftIterator(octreeIterator);
-            // compute the second time
-            // for each levels
-            for(int idxLevel = FAbstractAlgorithm::upperWorkingLevel ; idxLevel < FAbstractAlgorithm::lowerWorkingLevel ; ++idxLevel ){
-                const int separationCriteria = (idxLevel != FAbstractAlgorithm::lowerWorkingLevel-1 ? 1 : leafLevelSeparationCriteria);
+            //////////////////////////////////////////////////////////////////
+            // Send and receive for real
+            //////////////////////////////////////////////////////////////////
 
-                if(!procHasWorkAtLevel(idxLevel, idProcess)){
-                    avoidGotoLeftIterator.moveDown();
-                    octreeIterator = avoidGotoLeftIterator;
-                    continue;
-                }
+            FLOG(sendCounter.tic());
+            if(plan.transferRecvRequests.size()){
+                FMpi::MpiAssert(MPI_Startall(int(plan.transferRecvRequests.size()), plan.transferRecvRequests.data()), __LINE__);
+            }
 
-                // put the received data into a temporary tree
-                FLightOctree<CellClass> tempTree;
+            for(int idxLevel = 2 ; idxLevel < OctreeHeight ; ++idxLevel ){
                 for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
-                    if(recvBuffer[idxLevel * nbProcess + idxProc]){
-                        const int toReceiveFromProcAtLevel = recvBuffer[idxLevel * nbProcess + idxProc]->template getValue<int>();
+                    FBufferWriter*const sendBuffer = plan.transferSendBuffers[idxLevel * nbProcess + idxProc].get();
+                    if(sendBuffer){
+                        const FVector<typename OctreeClass::Iterator>& toSend = plan.transferToSend[idxLevel * nbProcess + idxProc];
+                        const char*const sendBufferData = sendBuffer->data();
+                        sendBuffer->reset();
+                        sendBuffer->write(int(toSend.getSize()));
+
+                        for(int idxLeaf = 0 ; idxLeaf < toSend.getSize(); ++idxLeaf){
+                            const FSize currentTell = sendBuffer->getSize();
+                            sendBuffer->write(currentTell);
+                            const MortonIndex cellIndex = toSend[idxLeaf].getCurrentGlobalIndex();
+                            sendBuffer->write(cellIndex);
+                            toSend[idxLeaf].getCurrentCell()->serializeUp(*sendBuffer);
+                        }
+
+                        FAssertLF(sendBuffer->getSize() == plan.transferSizeToSend[idxLevel * nbProcess + idxProc]);
+                        FAssertLF(sendBuffer->data() == sendBufferData, "The persistent requests use the buffer address");
+                    }
+                }
+            }
 
-                        for(int idxCell = 0 ; idxCell < toReceiveFromProcAtLevel ; ++idxCell){
-                            const FSize currentTell = recvBuffer[idxLevel * nbProcess + idxProc]->tell();
-                            const FSize verifCurrentTell = recvBuffer[idxLevel * nbProcess + idxProc]->template getValue<FSize>();
-                            FAssertLF(currentTell == verifCurrentTell, currentTell, " ", verifCurrentTell);
+            if(plan.transferSendRequests.size()){
+                FMpi::MpiAssert(MPI_Startall(int(plan.transferSendRequests.size()), plan.transferSendRequests.data()), __LINE__);
+            }
+            FLOG(sendCounter.tac());
 
-                            const MortonIndex cellIndex = recvBuffer[idxLevel * nbProcess + idxProc]->template getValue<MortonIndex>();
+            //////////////////////////////////////////////////////////////////
+            // Do local M2L
+            //////////////////////////////////////////////////////////////////
 
-                            CellClass* const newCell = new CellClass;
-                            newCell->setMortonIndex(cellIndex);
-                            newCell->deserializeUp(*recvBuffer[idxLevel * nbProcess + idxProc]);
+            const int chunckSize = userChunkSize;
+            for(int idxLevel = FAbstractAlgorithm::upperWorkingLevel ; idxLevel < FAbstractAlgorithm::lowerWorkingLevel ; ++idxLevel ){
+                const int separationCriteria = (idxLevel != FAbstractAlgorithm::lowerWorkingLevel-1 ? 1 : leafLevelSeparationCriteria);
+                const std::vector<typename OctreeClass::Iterator>* const cellsAtLevel = &plan.transferCells[idxLevel];
+                const int numberOfCells = int(cellsAtLevel->size());
+                char* const levelToken = &levelTokens[idxLevel];
 
-                            tempTree.insertCell(cellIndex, idxLevel, newCell);
+                for(int idxCell = 0 ; idxCell < numberOfCells ; idxCell += chunckSize){
+#pragma omp task firstprivate(idxCell, idxLevel, numberOfCells, chunckSize, separationCriteria, cellsAtLevel) depend(in: levelToken[0])
+                    {
+                        KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+                        const CellClass* neighbors[342] {};
+                        int neighborPositions[342] {};
+
+                        const int nbCellToCompute = FMath::Min(chunckSize, numberOfCells-idxCell);
+                        for(int idxCellToCompute = idxCell ; idxCellToCompute < idxCell+nbCellToCompute ; ++idxCellToCompute) {
+                            const typename OctreeClass::Iterator& targetIterator = (*cellsAtLevel)[idxCellToCompute];
+                            const int counter = tree->getInteractionNeighbors(
+                                neighbors,
+                                neighborPositions,
+                                targetIterator.getCurrentGlobalCoordinate(),
+                                idxLevel,
+                                separationCriteria
+                                );
+                            if(counter) {
+                                local_expansion_t* target_local_expansion
+                                    = &(targetIterator.getCurrentCell()->getLocalExpansionData());
+                                const symbolic_data_t* target_symbolic
+                                    = targetIterator.getCurrentCell();
+
+                                std::array<const multipole_t*, 342> source_multipoles {};
+                                std::transform(std::begin(neighbors), std::end(neighbors),
+                                               std::begin(source_multipoles),
+                                               [](const CellClass* c) {
+                                                   return ((c != nullptr)
+                                                           ? &(c->getMultipoleData())
+                                                           : nullptr);
+                                               });
+
+                                std::array<const symbolic_data_t*, 342> source_symbolics {};
+                                std::copy(std::begin(neighbors), std::end(neighbors),
+                                          std::begin(source_symbolics));
+
+                                myThreadkernels->M2L(
+                                    target_local_expansion,
+                                    target_symbolic,
+                                    source_multipoles.data(),
+                                    source_symbolics.data(),
+                                    neighborPositions,
+                                    counter
+                                    );
+                            }
                         }
-
-                        FAssertLF(globalReceiveMap[(idxProc * nbProcess * OctreeHeight) + idxLevel * nbProcess + idProcess] ==
-                                recvBuffer[idxLevel * nbProcess + idxProc]->tell());
+                        FinishedM2LTask(myThreadkernels, idxLevel);
                     }
                 }
+            }
 
-                // take cells from our octree only if they are
-                // linked to received data
-                int numberOfCells = 0;
-                int realCellId = 0;
+            //////////////////////////////////////////////////////////////////
+            // Wait received data and compute the remote M2L
+            //////////////////////////////////////////////////////////////////
 
-                while(octreeIterator.getCurrentGlobalIndex() <  getWorkingInterval(idxLevel , idProcess).leftIndex){
-                    octreeIterator.moveRight();
+            FLOG(receiveCounter.tic());
+            std::vector<int> recvRequestsRemaining(plan.transferNbRecvRequestsAtLevel);
+            std::vector<bool> levelIsProceeded(OctreeHeight, true);
+            int nbLevelsToProceed = 0;
+            for(int idxLevel = FAbstractAlgorithm::upperWorkingLevel ; idxLevel < FAbstractAlgorithm::lowerWorkingLevel ; ++idxLevel ){
+                if(plan.transferRemoteCells[idxLevel].size() && recvRequestsRemaining[idxLevel]){
+                    levelIsProceeded[idxLevel] = false;
+                    nbLevelsToProceed += 1;
                 }
-                // for each cells
-                do{
-                    // copy cells that need data from others
-                    if(leafsNeedOther[idxLevel]->get(realCellId++)){
-                        iterArray[numberOfCells++] = octreeIterator;
+            }
+
+            std::vector<int> completedRequests(plan.transferRecvRequests.size());
+            while(nbLevelsToProceed){
+                bool hasProgressed = false;
+
+                int nbCompletedRequests = 0;
+                FMpi::MpiAssert(MPI_Testsome(int(plan.transferRecvRequests.size()), plan.transferRecvRequests.data(),
+                                             &nbCompletedRequests, completedRequests.data(), MPI_STATUSES_IGNORE), __LINE__);
+                if(nbCompletedRequests != MPI_UNDEFINED){
+                    for(int idxCompleted = 0 ; idxCompleted < nbCompletedRequests ; ++idxCompleted){
+                        recvRequestsRemaining[plan.transferRecvRequestLevel[completedRequests[idxCompleted]]] -= 1;
                     }
-                } while(octreeIterator.moveRight());
-                avoidGotoLeftIterator.moveDown();
-                octreeIterator = avoidGotoLeftIterator;
+                    hasProgressed = (nbCompletedRequests != 0);
+                }
 
-                delete leafsNeedOther[idxLevel];
-                leafsNeedOther[idxLevel] = nullptr;
+                for(int idxLevel = FAbstractAlgorithm::upperWorkingLevel ; idxLevel < FAbstractAlgorithm::lowerWorkingLevel ; ++idxLevel ){
+                    if(levelIsProceeded[idxLevel] || recvRequestsRemaining[idxLevel]){
+                        continue;
+                    }
+                    levelIsProceeded[idxLevel] = true;
+                    nbLevelsToProceed -= 1;
+                    hasProgressed = true;
+
+                    char* const levelToken = &levelTokens[idxLevel];
+                    FCellHashMap<CellClass>* const levelCells = (plan.transferUseDatatypes ? &plan.transferReceivedCells[idxLevel] : &receivedCells[idxLevel]);
+                    // This task starts once the local M2L of the level is over
+#pragma omp task firstprivate(idxLevel, chunckSize, levelCells) depend(inout: levelToken[0])
+                    {
+                        // put the received data into the cells map, the buffers start with their number of cells
+                        FSize nbCellsAtLevel = 0;
+                        for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                            FBufferReader*const recvBuffer = plan.transferRecvBuffers[idxLevel * nbProcess + idxProc].get();
+                            if(recvBuffer){
+                                recvBuffer->seek(0);
+                                nbCellsAtLevel += recvBuffer->template getValue<int>();
+                            }
+                        }
+                        // With the datatypes the cells are already in the map
+                        if(nbCellsAtLevel){
+                            levelCells->reserve(nbCellsAtLevel);
+                        }
 
-                // Compute this cells
-                FLOG(computationCounter.tic());
-#pragma omp parallel num_threads(MaxThreads)
-                {
-                    KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
-                    MortonIndex neighborsIndex[/*189+26+1*/216] {};
-                    int neighborsPosition[/*189+26+1*/216] {};
-                    const CellClass* neighbors[342] {};
-                    int neighborPositions[342] {};
-
-#pragma omp for  schedule(dynamic, userChunkSize) nowait
-                    for(int idxCell = 0 ; idxCell < numberOfCells ; ++idxCell){
-                        // compute indexes
-                        const int counterNeighbors = iterArray[idxCell].getCurrentGlobalCoordinate().getInteractionNeighbors(idxLevel, neighborsIndex, neighborsPosition, separationCriteria);
-
-                        int counter = 0;
-                        // does we receive this index from someone?
-                        for(int idxNeig = 0 ;idxNeig < counterNeighbors ; ++idxNeig){
-                            if(neighborsIndex[idxNeig] < (getWorkingInterval(idxLevel , idProcess).leftIndex)
-                                    || (getWorkingInterval(idxLevel , idProcess).rightIndex) < neighborsIndex[idxNeig]){
-
-                                CellClass*const otherCell = tempTree.getCell(neighborsIndex[idxNeig], idxLevel);
-
-                                if(otherCell){
-                                    neighbors[counter] = otherCell;
-                                    neighborPositions[counter] = neighborsPosition[idxNeig];
-                                    ++counter;
+                        for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                            FBufferReader*const recvBuffer = plan.transferRecvBuffers[idxLevel * nbProcess + idxProc].get();
+                            if(recvBuffer){
+#pragma omp task firstprivate(idxProc, idxLevel, recvBuffer, levelCells)
+                                {
+                                    recvBuffer->seek(0);
+                                    const int toReceiveFromProcAtLevel = recvBuffer->template getValue<int>();
+
+                                    for(int idxCell = 0 ; idxCell < toReceiveFromProcAtLevel ; ++idxCell){
+                                        const FSize currentTell = recvBuffer->tell();
+                                        const FSize verifCurrentTell = recvBuffer->template getValue<FSize>();
+                                        FAssertLF(currentTell == verifCurrentTell, currentTell, " ", verifCurrentTell);
+
+                                        const MortonIndex cellIndex = recvBuffer->template getValue<MortonIndex>();
+
+                                        CellClass* const newCell = levelCells->allocateCell();
+                                        newCell->setMortonIndex(cellIndex);
+                                        newCell->deserializeUp(*recvBuffer);
+
+                                        levelCells->insertCell(cellIndex, idxLevel, newCell);
+                                    }
+
+                                    FAssertLF(plan.transferSizeToReceive[idxLevel * nbProcess + idxProc] ==
+                                            recvBuffer->tell());
                                 }
                             }
                         }
-                        // need to compute
-                        if(counter){
-                            local_expansion_t* target_local_expansion
-                                = &(iterArray[idxCell].getCurrentCell()->getLocalExpansionData());
-                            const symbolic_data_t* target_symbolic
-                                = iterArray[idxCell].getCurrentCell();
-
-                            std::array<const multipole_t*, 342> source_multipoles {};
-                            std::transform(std::begin(neighbors), std::end(neighbors),
-                                           std::begin(source_multipoles),
-                                           [](const CellClass* c) {
-                                               return ((c != nullptr)
-                                                       ? &(c->getMultipoleData())
-                                                       : nullptr);
-                                           });
-
-                            std::array<const symbolic_data_t*, 342> source_symbolics {};
-                            std::copy(std::begin(neighbors), std::end(neighbors),
-                                      std::begin(source_symbolics));
-
-                            myThreadkernels->M2L(
-                                target_local_expansion,
-                                target_symbolic,
-                                source_multipoles.data(),
-                                source_symbolics.data(),
-                                neighborPositions,
-                                counter
-                                );
+#pragma omp taskwait
+
+                        // Compute the cells linked to received data
+                        const int separationCriteria = (idxLevel != FAbstractAlgorithm::lowerWorkingLevel-1 ? 1 : leafLevelSeparationCriteria);
+                        const std::vector<typename OctreeClass::Iterator>* const remoteCells = &plan.transferRemoteCells[idxLevel];
+                        const int numberOfCells = int(remoteCells->size());
+
+                        for(int idxCell = 0 ; idxCell < numberOfCells ; idxCell += chunckSize){
+#pragma omp task firstprivate(idxCell, idxLevel, numberOfCells, chunckSize, separationCriteria, remoteCells, levelCells)
+                            {
+                                KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+                                const int nbCellToCompute = FMath::Min(chunckSize, numberOfCells-idxCell);
+                                for(int idxCellToCompute = idxCell ; idxCellToCompute < idxCell+nbCellToCompute ; ++idxCellToCompute) {
+                                    computeRemoteM2L(myThreadkernels, (*remoteCells)[idxCellToCompute], idxLevel, separationCriteria, levelCells);
+                                }
+                                FinishedM2LTask(myThreadkernels, idxLevel);
+                            }
                         }
+#pragma omp taskwait
                     }
+                }
 
-                    myThreadkernels->finishedLevelM2L(idxLevel);
+                if(hasProgressed == false){
+#pragma omp taskyield
                 }
-                FLOG(computationCounter.tac());
             }
-            FLOG(receiveCounter.tac());
-        }
 
-        for(int idxComm = 0 ; idxComm < nbProcess * OctreeHeight; ++idxComm){
-            delete sendBuffer[idxComm];
-            delete recvBuffer[idxComm];
-        }
-        for(int idxComm = 0 ; idxComm < OctreeHeight; ++idxComm){
-            delete leafsNeedOther[idxComm];
-        }
-        delete[] sendBuffer;
-        delete[] recvBuffer;
-        delete[] indexToSend;
-        delete[] leafsNeedOther;
-        delete[] globalReceiveMap;
+            // Wait the sends and the messages of the levels without remote work
+            FMpi::MpiAssert(MPI_Waitall(int(plan.transferRecvRequests.size()), plan.transferRecvRequests.data(), MPI_STATUSES_IGNORE), __LINE__);
+            FMpi::MpiAssert(MPI_Waitall(int(plan.transferSendRequests.size()), plan.transferSendRequests.data(), MPI_STATUSES_IGNORE), __LINE__);
 
+#pragma omp taskwait
+            FLOG(receiveCounter.tac());
+        }
 
         FLOG( FLog::Controller << "\tFinished (@Downward Pass (M2L) = "  << counterTime.tacAndElapsed() << " s)\n" );
-        FLOG( FLog::Controller << "\t\t Computation : " << computationCounter.cumulated() << " s\n" );
         FLOG( FLog::Controller << "\t\t Send : " << sendCounter.cumulated() << " s\n" );
-        FLOG( FLog::Controller << "\t\t Receive : " << receiveCounter.cumulated() << " s\n" );
-        FLOG( FLog::Controller << "\t\t Gather : " << gatherCounter.cumulated() << " s\n" );
+        FLOG( FLog::Controller << "\t\t Receive and remote : " << receiveCounter.cumulated() << " s\n" );
         FLOG( FLog::Controller << "\t\t Prepare : " << prepareCounter.cumulated() << " s\n" );
         FLOG( FLog::Controller.flush());
 
@@ -1234,6 +1645,10 @@ protected:
 
         // for each levels exepted leaf level
         for(int idxLevel = FAbstractAlgorithm::upperWorkingLevel ; idxLevel < heightMinusOne ; ++idxLevel ){
+            // The cells exchanged are the parents
+            sendBuffer.setPrecision(wirePrecisions[idxLevel]);
+            recvBuffer.setPrecision(wirePrecisions[idxLevel]);
+
             // If nothing to do in the next level skip the current one
             if(idProcess != 0 && !procHasWorkAtLevel(idxLevel+1, idProcess) ){
                 avoidGotoLeftIterator.moveDown();
@@ -1436,16 +1851,232 @@ protected:
         CellClass* cell;
         ContainerClass* targets;
         ContainerClass* sources;
+        int remoteLeaf;     ///< The position in plan.directRemoteLeaves, or -1
+    };
+
+
+    /**
+     * The leaves received from a process, sorted by index.
+     * isReady is set (release) once the leaves are restored, the tasks must
+     * test it (acquire) before reading the vectors.
+     */
+    struct ReceivedLeaves{
+        std::vector<MortonIndex> indexes;
+        std::vector<std::unique_ptr<ContainerClass>> containers;
+        std::atomic<bool> isReady{false};
+
+        ContainerClass* getLeaf(const MortonIndex leafIndex) const {
+            const auto iter = std::lower_bound(indexes.begin(), indexes.end(), leafIndex);
+            if(iter != indexes.end() && (*iter) == leafIndex){
+                return containers[iter - indexes.begin()].get();
+            }
+            return nullptr;
+        }
     };
 
+    /** The process that holds a leaf (from the leaf intervals) */
+    int getProcOfLeaf(const MortonIndex leafIndex) const {
+        int procToReceive = idProcess;
+        while( procToReceive != 0 && leafIndex < intervals[procToReceive].leftIndex){
+            --procToReceive; //scroll process "before" current process
+        }
+        while( procToReceive != nbProcess - 1 && (intervals[procToReceive].rightIndex) < leafIndex){
+            ++procToReceive;//scroll process "after" current process
+        }
+        return procToReceive;
+    }
 
-    /** P2P */
+    /**
+     * Build the P2P part of the plan : find the leaves needed by others and
+     * the leaves that need others (and from which processes), exchange the sizes
+     * of the messages, allocate the buffers and create the persistent requests.
+     */
+    void buildDirectPlan(){
+        plan.resetDirect();
+        plan.hasDirect = true;
+
+        plan.directToSend.reset(new FVector<typename OctreeClass::Iterator>[nbProcess]);
+        FVector<typename OctreeClass::Iterator>*const toSend = plan.directToSend.get();
+        plan.directSizeToSend.resize(nbProcess, 0);
+        FSize*const partsToSend = plan.directSizeToSend.data();
+        // The processes that hold the neighbors of each remote leaf
+        std::vector<std::vector<int>> procsOfRemoteLeaves;
+
+        // Copy leafs
+        {
+            typename OctreeClass::Iterator octreeIterator(tree);
+            octreeIterator.gotoBottomLeft();
+            int idxLeaf = 0;
+            do{
+                this->iterArray[idxLeaf++] = octreeIterator;
+            } while(octreeIterator.moveRight());
+        }
+
+        std::unique_ptr<int[]> alreadySent(new int[nbProcess]);
+
+        //Will store the indexes of the neighbors of current cell
+        MortonIndex indexesNeighbors[26];
+
+        for(int idxLeaf = 0 ; idxLeaf < this->numberOfLeafs ; ++idxLeaf){
+            memset(alreadySent.get(), 0, sizeof(int) * nbProcess);
+            bool needOther = false;
+            //Get the neighbors of current cell in indexesNeighbors, and their number in neighCount
+            const int neighCount = (iterArray[idxLeaf].getCurrentGlobalCoordinate()).getNeighborsIndexes(OctreeHeight,indexesNeighbors);
+            //Loop over the neighbor leafs
+            for(int idxNeigh = 0 ; idxNeigh < neighCount ; ++idxNeigh){
+                //Test if leaf belongs to someone else (false if it's mine)
+                if(indexesNeighbors[idxNeigh] < (intervals[idProcess].leftIndex) || (intervals[idProcess].rightIndex) < indexesNeighbors[idxNeigh]){
+                    needOther = true;
+
+                    // find the proc that will need current leaf
+                    const int procToReceive = getProcOfLeaf(indexesNeighbors[idxNeigh]);
+                    //  Test : Not Already Send && be sure someone hold this interval
+                    if( !alreadySent[procToReceive] && intervals[procToReceive].leftIndex <= indexesNeighbors[idxNeigh] && indexesNeighbors[idxNeigh] <= intervals[procToReceive].rightIndex){
+
+                        alreadySent[procToReceive] = 1;
+                        toSend[procToReceive].push( iterArray[idxLeaf] );
+                        partsToSend[procToReceive] += iterArray[idxLeaf].getCurrentListSrc()->getSavedSize();
+                        partsToSend[procToReceive] += int(sizeof(MortonIndex));
+                    }
+                }
+            }
+
+            if(needOther){ //means that something need to be sent (or received)
+                plan.directRemoteLeaves.push_back(iterArray[idxLeaf]);
+                procsOfRemoteLeaves.emplace_back();
+                for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                    if(alreadySent[idxProc]){
+                        procsOfRemoteLeaves.back().push_back(idxProc);
+                    }
+                }
+            }
+        }
+
+        // No idea why it is mandatory there, could it be a few line before,
+        for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+            if(partsToSend[idxProc]){
+                partsToSend[idxProc] += int(sizeof(FSize));
+            }
+        }
+
+        /* partsToReceive[U] == size of information needed by me and own by U,
+         * it is given by the processes that send something to me only
+         */
+        plan.directSizeToReceive.resize(nbProcess, 0);
+        FSize*const partsToReceive = plan.directSizeToReceive.data();
+        {
+            std::vector<std::pair<int,FSize>> sizesToSend;
+            for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                if(partsToSend[idxProc]){
+                    sizesToSend.push_back({idxProc, partsToSend[idxProc]});
+                }
+            }
+            const std::vector<std::pair<int,FSize>> sizesToReceive = FMpi::SparseExchange(sizesToSend, fcomCompute, FMpi::TagSparseExchangeM2L);
+            for(const auto& sizeToReceive : sizesToReceive){
+                partsToReceive[sizeToReceive.first] = sizeToReceive.second;
+            }
+        }
+
+        // A remote leaf waits only for the processes that send something
+        plan.directProcsOfRemoteLeaf.resize(plan.directRemoteLeaves.size());
+        plan.directRemoteLeavesOfProc.resize(nbProcess);
+        for(size_t idxRemote = 0 ; idxRemote < procsOfRemoteLeaves.size() ; ++idxRemote){
+            for(const int idxProc : procsOfRemoteLeaves[idxRemote]){
+                if(partsToReceive[idxProc]){
+                    plan.directProcsOfRemoteLeaf[idxRemote].push_back(idxProc);
+                    plan.directRemoteLeavesOfProc[idxProc].push_back(int(idxRemote));
+                }
+            }
+        }
+
+        plan.directRecvBuffers.resize(nbProcess);
+        plan.directSendBuffers.resize(nbProcess);
+        plan.directNbRecvRequestsOfProc.resize(nbProcess, 0);
+        //Prepare receive
+        for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+            if(partsToReceive[idxProc]){ //if idxProc has sth for me.
+                //allocate buffer of right size
+                plan.directRecvBuffers[idxProc].reset(new FBufferReader(partsToReceive[idxProc]));
+
+                const int nbRequests = FMpi::RecvInitSplit(plan.directRecvBuffers[idxProc]->data(), plan.directRecvBuffers[idxProc]->getCapacity(),
+                                                           idxProc, FMpi::TagFmmP2P, fcomCompute, &plan.directRecvRequests);
+                plan.directRecvRequestProc.insert(plan.directRecvRequestProc.end(), nbRequests, idxProc);
+                plan.directNbRecvRequestsOfProc[idxProc] = nbRequests;
+            }
+        }
+        // Prepare send
+        for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+            if(toSend[idxProc].getSize() != 0){
+                plan.directSendBuffers[idxProc].reset(new FBufferWriter(partsToSend[idxProc]));
+
+                FMpi::SendInitSplit(plan.directSendBuffers[idxProc]->data(), partsToSend[idxProc],
+                                    idxProc, FMpi::TagFmmP2P, fcomCompute, &plan.directSendRequests);
+            }
+        }
+    }
+
+    /** True if all the processes a remote leaf waits for have been received */
+    bool remoteLeafIsReady(const int idxRemote, const ReceivedLeaves receivedLeaves[]) const {
+        for(const int idxProc : plan.directProcsOfRemoteLeaf[idxRemote]){
+            if(receivedLeaves[idxProc].isReady.load(std::memory_order_acquire) == false){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * P2PRemote of a remote leaf with the received neighbors, the leaf must be ready.
+     * Only the processes of the leaf are looked at, the others may be written
+     * by the receiving thread at the same time.
+     */
+    void computeRemoteP2P(KernelClass*const myThreadkernels, const int idxRemote,
+                          const ReceivedLeaves receivedLeaves[]) const {
+        const typename OctreeClass::Iterator& leafIterator = plan.directRemoteLeaves[idxRemote];
+        const std::vector<int>& procsOfLeaf = plan.directProcsOfRemoteLeaf[idxRemote];
+        // There is a maximum of 26 neighbors
+        ContainerClass* neighbors[26];
+        MortonIndex indexesNeighbors[26];
+        int indexArray[26];
+        int neighborPositions[26];
+
+        // need the current particles and neighbors particles
+        int counter = 0;
+
+        // Take possible data
+        const int nbNeigh = leafIterator.getCurrentGlobalCoordinate().getNeighborsIndexes(OctreeHeight, indexesNeighbors, indexArray);
+
+        for(int idxNeigh = 0 ; idxNeigh < nbNeigh ; ++idxNeigh){
+            if(indexesNeighbors[idxNeigh] < (intervals[idProcess].leftIndex) || (intervals[idProcess].rightIndex) < indexesNeighbors[idxNeigh]){
+                const int procOfNeighbor = getProcOfLeaf(indexesNeighbors[idxNeigh]);
+                if(std::find(procsOfLeaf.begin(), procsOfLeaf.end(), procOfNeighbor) == procsOfLeaf.end()){
+                    continue;
+                }
+                ContainerClass*const hypotheticNeighbor = receivedLeaves[procOfNeighbor].getLeaf(indexesNeighbors[idxNeigh]);
+                if(hypotheticNeighbor){
+                    neighbors[ counter ] = hypotheticNeighbor;
+                    neighborPositions[counter] = indexArray[idxNeigh];
+                    ++counter;
+                }
+            }
+        }
+        if(counter){
+            myThreadkernels->P2PRemote( leafIterator.getCurrentCell()->getCoordinate(), leafIterator.getCurrentListTargets(),
+                                        leafIterator.getCurrentListSrc(), neighbors, neighborPositions, counter);
+        }
+    }
+
+    /**
+     * P2P : the local L2P and P2P are done in tasks (by shapes to avoid concurrent
+     * mutual interactions), the thread that has created them polls the receptions
+     * meanwhile. A task also does the P2PRemote of its leaves whose neighbor processes
+     * have already been received, the other remote leaves have their own tasks
+     * as soon as their messages are there, without waiting for the other messages.
+     */
     void directPass(const bool p2pEnabled, const bool l2pEnabled){
         FLOG( FLog::Controller.write("\tStart Direct Pass\n").write(FLog::Flush); );
         FLOG( FTic counterTime);
         FLOG( FTic prepareCounter);
-        FLOG( FTic gatherCounter);
-        FLOG( FTic waitCounter);
         FLOG(FTic computationCounter);
         FLOG(FTic computation2Counter);
 
@@ -1454,12 +2085,6 @@ protected:
         ///////////////////////////////////////////////////
         FLOG(prepareCounter.tic());
 
-        FBoolArray leafsNeedOther(this->numberOfLeafs);
-        int countNeedOther = 0;
-
-        // To store the result
-        OctreeClass otherP2Ptree( tree->getHeight(), tree->getSubHeight(), tree->getBoxWidth(), tree->getBoxCenter() );
-
         // init
         const int SizeShape = P2PExclusionClass::SizeShape;
 
@@ -1468,167 +2093,43 @@ protected:
 
         LeafData* const leafsDataArray = new LeafData[this->numberOfLeafs];
 
-        FVector<LeafData> leafsNeedOtherData(countNeedOther);
-
-        FVector<typename OctreeClass::Iterator>*const toSend = new FVector<typename OctreeClass::Iterator>[nbProcess];
-        FSize partsToSend[nbProcess];
-        memset(partsToSend, 0, sizeof(FSize) * nbProcess);
+        // To store the result
+        std::unique_ptr<ReceivedLeaves[]> receivedLeaves(new ReceivedLeaves[nbProcess]);
 
 #pragma omp parallel num_threads(MaxThreads)
         {
-#pragma omp master // MUST WAIT to fill leafsNeedOther
+#pragma omp single nowait
             if(p2pEnabled){
-                // Copy leafs
-                {
-                    typename OctreeClass::Iterator octreeIterator(tree);
-                    octreeIterator.gotoBottomLeft();
-                    int idxLeaf = 0;
-                    do{
-                        this->iterArray[idxLeaf++] = octreeIterator;
-                    } while(octreeIterator.moveRight());
+                if(plan.hasDirect == false){
+                    buildDirectPlan();
                 }
 
-                int alreadySent[nbProcess];
-
-                //Will store the indexes of the neighbors of current cell
-                MortonIndex indexesNeighbors[26];
-
-                for(int idxLeaf = 0 ; idxLeaf < this->numberOfLeafs ; ++idxLeaf){
-                    memset(alreadySent, 0, sizeof(int) * nbProcess);
-                    bool needOther = false;
-                    //Get the neighbors of current cell in indexesNeighbors, and their number in neighCount
-                    const int neighCount = (iterArray[idxLeaf].getCurrentGlobalCoordinate()).getNeighborsIndexes(OctreeHeight,indexesNeighbors);
-                    //Loop over the neighbor leafs
-                    for(int idxNeigh = 0 ; idxNeigh < neighCount ; ++idxNeigh){
-                        //Test if leaf belongs to someone else (false if it's mine)
-                        if(indexesNeighbors[idxNeigh] < (intervals[idProcess].leftIndex) || (intervals[idProcess].rightIndex) < indexesNeighbors[idxNeigh]){
-                            needOther = true;
-
-                            // find the proc that will need current leaf
-                            int procToReceive = idProcess;
-                            while( procToReceive != 0 && indexesNeighbors[idxNeigh] < intervals[procToReceive].leftIndex){
-                                --procToReceive; //scroll process "before" current process
-                            }
-
-                            while( procToReceive != nbProcess - 1 && (intervals[procToReceive].rightIndex) < indexesNeighbors[idxNeigh]){
-                                ++procToReceive;//scroll process "after" current process
-                            }
-                            //  Test : Not Already Send && be sure someone hold this interval
-                            if( !alreadySent[procToReceive] && intervals[procToReceive].leftIndex <= indexesNeighbors[idxNeigh] && indexesNeighbors[idxNeigh] <= intervals[procToReceive].rightIndex){
-
-                                alreadySent[procToReceive] = 1;
-                                toSend[procToReceive].push( iterArray[idxLeaf] );
-                                partsToSend[procToReceive] += iterArray[idxLeaf].getCurrentListSrc()->getSavedSize();
-                                partsToSend[procToReceive] += int(sizeof(MortonIndex));
-                            }
-                        }
-                    }
-
-                    if(needOther){ //means that something need to be sent (or received)
-                        leafsNeedOther.set(idxLeaf,true);
-                        ++countNeedOther;
-                    }
-                }
-
-                // No idea why it is mandatory there, could it be a few line before,
-                for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
-                    if(partsToSend[idxProc]){
-                        partsToSend[idxProc] += int(sizeof(FSize));
-                    }
-                }
-            }
-
-#pragma omp barrier
-
-#pragma omp master // nowait
-            if(p2pEnabled){
-                /* This a nbProcess x nbProcess matrix of integer
-                 * let U and V be id of processes :
-                 * globalReceiveMap[U*nbProcess + V] == size of information needed by V and own by U
-                 */
-                FSize*const globalReceiveMap = new FSize[nbProcess * nbProcess];
-                memset(globalReceiveMap, 0, sizeof(FSize) * nbProcess * nbProcess);
-
-                //Share to all processus globalReceiveMap
-                FLOG(gatherCounter.tic());
-                FMpi::MpiAssert( MPI_Allgather( partsToSend, nbProcess, FMpi::GetType(*partsToSend),
-                                                globalReceiveMap, nbProcess, FMpi::GetType(*partsToSend), fcomCompute.getComm()),  __LINE__ );
-                FLOG(gatherCounter.tac());
-
-                FBufferReader**const recvBuffer = new FBufferReader*[nbProcess];
-                memset(recvBuffer, 0, sizeof(FBufferReader*) * nbProcess);
-
-                FBufferWriter**const sendBuffer = new FBufferWriter*[nbProcess];
-                memset(sendBuffer, 0, sizeof(FBufferWriter*) * nbProcess);
-
-                // To send in asynchrone way
-                std::vector<MPI_Request> requests;
-                requests.reserve(2 * nbProcess);
-                //Prepare receive
-                for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
-                    if(globalReceiveMap[idxProc * nbProcess + idProcess]){ //if idxProc has sth for me.
-                        //allocate buffer of right size
-                        recvBuffer[idxProc] = new FBufferReader(globalReceiveMap[idxProc * nbProcess + idProcess]);
-
-                        FMpi::IRecvSplit(recvBuffer[idxProc]->data(), recvBuffer[idxProc]->getCapacity(),
-                                         idxProc, FMpi::TagFmmP2P, fcomCompute, &requests);
-                    }
+                if(plan.directRecvRequests.size()){
+                    FMpi::MpiAssert(MPI_Startall(int(plan.directRecvRequests.size()), plan.directRecvRequests.data()), __LINE__);
                 }
 
-                // Prepare send
+                // Fill the buffers with the current particles
                 for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
-                    if(toSend[idxProc].getSize() != 0){
-                        sendBuffer[idxProc] = new FBufferWriter(globalReceiveMap[idProcess*nbProcess+idxProc]);
+                    FBufferWriter*const sendBuffer = plan.directSendBuffers[idxProc].get();
+                    if(sendBuffer){
+                        const FVector<typename OctreeClass::Iterator>& toSend = plan.directToSend[idxProc];
+                        const char*const sendBufferData = sendBuffer->data();
+                        sendBuffer->reset();
                         // << is equivalent to write().
-                        (*sendBuffer[idxProc]) << toSend[idxProc].getSize();
-                        for(int idxLeaf = 0 ; idxLeaf < toSend[idxProc].getSize() ; ++idxLeaf){
-                            (*sendBuffer[idxProc]) << toSend[idxProc][idxLeaf].getCurrentGlobalIndex();
-                            toSend[idxProc][idxLeaf].getCurrentListSrc()->save(*sendBuffer[idxProc]);
+                        (*sendBuffer) << toSend.getSize();
+                        for(int idxLeaf = 0 ; idxLeaf < toSend.getSize() ; ++idxLeaf){
+                            (*sendBuffer) << toSend[idxLeaf].getCurrentGlobalIndex();
+                            toSend[idxLeaf].getCurrentListSrc()->save(*sendBuffer);
                         }
 
-                        FAssertLF(sendBuffer[idxProc]->getSize() == globalReceiveMap[idProcess*nbProcess+idxProc]);
-
-                        FMpi::ISendSplit(sendBuffer[idxProc]->data(), sendBuffer[idxProc]->getSize(),
-                                         idxProc, FMpi::TagFmmP2P, fcomCompute, &requests);
-
+                        FAssertLF(sendBuffer->getSize() == plan.directSizeToSend[idxProc]);
+                        FAssertLF(sendBuffer->data() == sendBufferData, "The persistent requests use the buffer address");
                     }
                 }
 
-                delete[] toSend;
-
-
-                //////////////////////////////////////////////////////////
-                // Waitsend receive
-                //////////////////////////////////////////////////////////
-
-                std::unique_ptr<MPI_Status[]> status(new MPI_Status[requests.size()]);
-                // Wait data
-                FLOG(waitCounter.tic());
-                MPI_Waitall(int(requests.size()), requests.data(), status.get());
-                FLOG(waitCounter.tac());
-
-                for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
-                    if(globalReceiveMap[idxProc * nbProcess + idProcess]){ //if idxProc has sth for me.
-                        FAssertLF(recvBuffer[idxProc]);
-                        FBufferReader& currentBuffer = (*recvBuffer[idxProc]);
-                        FSize nbLeaves;
-                        currentBuffer >> nbLeaves;
-                        for(FSize idxLeaf = 0 ; idxLeaf < nbLeaves ; ++idxLeaf){
-                            MortonIndex leafIndex;
-                            currentBuffer >> leafIndex;
-                            otherP2Ptree.createLeaf(leafIndex)->getSrc()->restore(currentBuffer);
-                        }
-                        // Realease memory early
-                        delete recvBuffer[idxProc];
-                        recvBuffer[idxProc] = nullptr;
-                    }
+                if(plan.directSendRequests.size()){
+                    FMpi::MpiAssert(MPI_Startall(int(plan.directSendRequests.size()), plan.directSendRequests.data()), __LINE__);
                 }
-
-                for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
-                    delete sendBuffer[idxProc];
-                    delete recvBuffer[idxProc];
-                }
-                delete[] globalReceiveMap;
             }
 
             ///////////////////////////////////////////////////
@@ -1670,7 +2171,7 @@ protected:
                     leafsDataArray[startPosAtShape[shapePosition]].cell = myLeafs[idxInArray].getCurrentCell();
                     leafsDataArray[startPosAtShape[shapePosition]].targets = myLeafs[idxInArray].getCurrentListTargets();
                     leafsDataArray[startPosAtShape[shapePosition]].sources = myLeafs[idxInArray].getCurrentListSrc();
-                    if( leafsNeedOther.get(idxLeaf) ) leafsNeedOtherData.push(leafsDataArray[startPosAtShape[shapePosition]]);
+                    leafsDataArray[startPosAtShape[shapePosition]].remoteLeaf = -1;
 
                     ++startPosAtShape[shapePosition];
                 }
@@ -1686,119 +2187,208 @@ protected:
             // Computation P2P that DO NOT need others data
             //////////////////////////////////////////////////////////
 
-            {
 #pragma omp single nowait
-                {
-                    FLOG(computationCounter.tic());
-                    int previous = 0;
+            {
+                FLOG(computationCounter.tic());
+                const int chunckSize = userChunkSize;
+
+                // The state of the receptions (proceeded by this thread only)
+                std::vector<int> recvRequestsRemaining;
+                std::vector<int> procsRemaining;
+                std::vector<bool> procIsProceeded(nbProcess, true);
+                int nbProcsToProceed = 0;
+                std::vector<int> completedRequests;
+                // The remote leaves in the order they become ready
+                std::unique_ptr<int[]> readyLeaves;
+                int nbReadyLeaves = 0;
+                // The remote leaves already computed by the local tasks
+                std::unique_ptr<bool[]> remoteIsDone;
+
+                if(p2pEnabled){
+                    recvRequestsRemaining = plan.directNbRecvRequestsOfProc;
+                    procsRemaining.resize(plan.directRemoteLeaves.size());
+                    for(size_t idxRemote = 0 ; idxRemote < plan.directRemoteLeaves.size() ; ++idxRemote){
+                        procsRemaining[idxRemote] = int(plan.directProcsOfRemoteLeaf[idxRemote].size());
+                    }
+                    for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                        if(recvRequestsRemaining[idxProc]){
+                            procIsProceeded[idxProc] = false;
+                            nbProcsToProceed += 1;
+                        }
+                    }
+                    completedRequests.resize(plan.directRecvRequests.size());
+                    readyLeaves.reset(new int[plan.directRemoteLeaves.size()]);
+                    remoteIsDone.reset(new bool[plan.directRemoteLeaves.size()]());
+
+                    // The remote leaves are in the Morton order
+                    for(int idxLeaf = 0 ; idxLeaf < this->numberOfLeafs ; ++idxLeaf){
+                        const MortonIndex leafIndex = leafsDataArray[idxLeaf].cell->getMortonIndex();
+                        const auto iter = std::lower_bound(plan.directRemoteLeaves.begin(), plan.directRemoteLeaves.end(), leafIndex,
+                                                           [](const typename OctreeClass::Iterator& remoteLeaf, const MortonIndex index){
+                            return remoteLeaf.getCurrentGlobalIndex() < index;
+                        });
+                        if(iter != plan.directRemoteLeaves.end() && (*iter).getCurrentGlobalIndex() == leafIndex){
+                            leafsDataArray[idxLeaf].remoteLeaf = int(iter - plan.directRemoteLeaves.begin());
+                        }
+                    }
+                }
+
+                // Restore the leaves of the processes whose messages are complete
+                // and publish them, return true if something has been received
+                const auto proceedReceptions = [&]() -> bool {
+                    bool hasProgressed = false;
+
+                    int nbCompletedRequests = 0;
+                    FMpi::MpiAssert(MPI_Testsome(int(plan.directRecvRequests.size()), plan.directRecvRequests.data(),
+                                                 &nbCompletedRequests, completedRequests.data(), MPI_STATUSES_IGNORE), __LINE__);
+                    if(nbCompletedRequests != MPI_UNDEFINED){
+                        for(int idxCompleted = 0 ; idxCompleted < nbCompletedRequests ; ++idxCompleted){
+                            recvRequestsRemaining[plan.directRecvRequestProc[completedRequests[idxCompleted]]] -= 1;
+                        }
+                    }
 
-                    for(int idxShape = 0 ; idxShape < SizeShape ; ++idxShape){
-                        const int endAtThisShape = shapeLeaf[idxShape] + previous;
-                        const int chunckSize = userChunkSize;
+                    for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                        if(procIsProceeded[idxProc] || recvRequestsRemaining[idxProc]){
+                            continue;
+                        }
+                        procIsProceeded[idxProc] = true;
+                        nbProcsToProceed -= 1;
+                        hasProgressed = true;
 
-                        for(int idxLeafs = previous ; idxLeafs < endAtThisShape ; idxLeafs += chunckSize){
-                            const int nbLeavesInTask = FMath::Min(endAtThisShape-idxLeafs, chunckSize);
-#pragma omp task default(none) firstprivate(nbLeavesInTask,idxLeafs) //+shared(leafsDataArray)
-                            {
-                                KernelClass* myThreadkernels = (kernels[omp_get_thread_num()]);
-                                // There is a maximum of 26 neighbors
-                                ContainerClass* neighbors[26];
-                                int neighborPositions[26];
-
-                                for(int idxTaskLeaf = idxLeafs ; idxTaskLeaf < (idxLeafs + nbLeavesInTask) ; ++idxTaskLeaf){
-                                    LeafData& currentIter = leafsDataArray[idxTaskLeaf];
-                                    if(l2pEnabled){
-
-                                        const local_expansion_t* leaf_local_expansion
-                                            = &(currentIter.cell->getLocalExpansionData());
-                                        const symbolic_data_t* leaf_symbolic
-                                            = currentIter.cell;
-
-                                        myThreadkernels->L2P(
-                                            leaf_local_expansion,
-                                            leaf_symbolic,
-                                            currentIter.targets
-                                            );
-                                    }
-                                    if(p2pEnabled){
-                                        // need the current particles and neighbors particles
-                                        const int counter = tree->getLeafsNeighbors(neighbors, neighborPositions, currentIter.coord, OctreeHeight-1);
-                                        myThreadkernels->P2P( currentIter.coord,currentIter.targets,
-                                                              currentIter.sources, neighbors, neighborPositions, counter);
+                        FBufferReader& currentBuffer = (*plan.directRecvBuffers[idxProc]);
+                        currentBuffer.seek(0);
+                        FSize nbLeaves;
+                        currentBuffer >> nbLeaves;
+                        receivedLeaves[idxProc].indexes.resize(nbLeaves);
+                        receivedLeaves[idxProc].containers.resize(nbLeaves);
+                        for(FSize idxLeaf = 0 ; idxLeaf < nbLeaves ; ++idxLeaf){
+                            currentBuffer >> receivedLeaves[idxProc].indexes[idxLeaf];
+                            FAssertLF(idxLeaf == 0 || receivedLeaves[idxProc].indexes[idxLeaf-1] < receivedLeaves[idxProc].indexes[idxLeaf]);
+                            receivedLeaves[idxProc].containers[idxLeaf].reset(new ContainerClass);
+                            receivedLeaves[idxProc].containers[idxLeaf]->restore(currentBuffer);
+                        }
+                        receivedLeaves[idxProc].isReady.store(true, std::memory_order_release);
+
+                        for(const int idxRemote : plan.directRemoteLeavesOfProc[idxProc]){
+                            procsRemaining[idxRemote] -= 1;
+                            if(procsRemaining[idxRemote] == 0){
+                                readyLeaves[nbReadyLeaves++] = idxRemote;
+                            }
+                        }
+                    }
+                    return hasProgressed;
+                };
+
+                const ReceivedLeaves*const receivedLeavesPtr = receivedLeaves.get();
+                bool*const remoteIsDonePtr = remoteIsDone.get();
+                std::atomic<int> nbShapeTasksRemaining(0);
+                int previous = 0;
+
+                for(int idxShape = 0 ; idxShape < SizeShape ; ++idxShape){
+                    const int endAtThisShape = shapeLeaf[idxShape] + previous;
+                    nbShapeTasksRemaining.store((shapeLeaf[idxShape] + chunckSize - 1) / chunckSize);
+
+                    for(int idxLeafs = previous ; idxLeafs < endAtThisShape ; idxLeafs += chunckSize){
+                        const int nbLeavesInTask = FMath::Min(endAtThisShape-idxLeafs, chunckSize);
+#pragma omp task firstprivate(nbLeavesInTask,idxLeafs,receivedLeavesPtr,remoteIsDonePtr) shared(nbShapeTasksRemaining) //+shared(leafsDataArray)
+                        {
+                            KernelClass* myThreadkernels = (kernels[omp_get_thread_num()]);
+                            // There is a maximum of 26 neighbors
+                            ContainerClass* neighbors[26];
+                            int neighborPositions[26];
+
+                            for(int idxTaskLeaf = idxLeafs ; idxTaskLeaf < (idxLeafs + nbLeavesInTask) ; ++idxTaskLeaf){
+                                LeafData& currentIter = leafsDataArray[idxTaskLeaf];
+                                if(l2pEnabled){
+
+                                    const local_expansion_t* leaf_local_expansion
+                                        = &(currentIter.cell->getLocalExpansionData());
+                                    const symbolic_data_t* leaf_symbolic
+                                        = currentIter.cell;
+
+                                    myThreadkernels->L2P(
+                                        leaf_local_expansion,
+                                        leaf_symbolic,
+                                        currentIter.targets
+                                        );
+                                }
+                                if(p2pEnabled){
+                                    // need the current particles and neighbors particles
+                                    const int counter = tree->getLeafsNeighbors(neighbors, neighborPositions, currentIter.coord, OctreeHeight-1);
+                                    myThreadkernels->P2P( currentIter.coord,currentIter.targets,
+                                                          currentIter.sources, neighbors, neighborPositions, counter);
+                                    // The leaves of the shape do not touch each other, the
+                                    // P2PRemote can be done now if the neighbors are there
+                                    if(currentIter.remoteLeaf != -1 && remoteLeafIsReady(currentIter.remoteLeaf, receivedLeavesPtr)){
+                                        computeRemoteP2P(myThreadkernels, currentIter.remoteLeaf, receivedLeavesPtr);
+                                        remoteIsDonePtr[currentIter.remoteLeaf] = true;
                                     }
                                 }
                             }
+                            nbShapeTasksRemaining -= 1;
                         }
-                        previous = endAtThisShape;
+                    }
+                    previous = endAtThisShape;
 
-#pragma omp taskwait
+                    // Restore the messages that arrive while the shape is computed
+                    while(nbProcsToProceed && nbShapeTasksRemaining.load()){
+                        if(proceedReceptions() == false){
+#pragma omp taskyield
+                        }
                     }
-                    FLOG(computationCounter.tac());
+#pragma omp taskwait
                 }
-            }
-
-            // Wait the communications to finish (and the previous computation also)
-#pragma omp barrier
+                FLOG(computationCounter.tac());
 
+                //////////////////////////////////////////////////////////
+                // Computation P2P that need others data
+                //////////////////////////////////////////////////////////
 
-            //////////////////////////////////////////////////////////
-            // Computation P2P that need others data
-            //////////////////////////////////////////////////////////
-#pragma omp master
-            { FLOG( computation2Counter.tic() ); }
+                if(p2pEnabled){
+                    FLOG( computation2Counter.tic() );
+                    // Remove the leaves that have been computed with the shapes
+                    nbReadyLeaves = int(std::remove_if(readyLeaves.get(), readyLeaves.get() + nbReadyLeaves,
+                                                       [&](const int idxRemote){ return remoteIsDone[idxRemote]; }) - readyLeaves.get());
+                    int nbSpawnedLeaves = 0;
 
-            if(p2pEnabled){
-                KernelClass& myThreadkernels = (*kernels[omp_get_thread_num()]);
-                // There is a maximum of 26 neighbors
-                ContainerClass* neighbors[26];
-                MortonIndex indexesNeighbors[26];
-                int indexArray[26];
-                int neighborPositions[26];
-                // Box limite
-                FAssertLF(leafsNeedOtherData.getSize() < std::numeric_limits<int>::max());
-                const int nbLeafToProceed = int(leafsNeedOtherData.getSize());
-
-#pragma omp for  schedule(dynamic, userChunkSize)
-                for(int idxLeafs = 0 ; idxLeafs < nbLeafToProceed ; ++idxLeafs){
-                    LeafData currentIter = leafsNeedOtherData[idxLeafs];
-
-                    // need the current particles and neighbors particles
-                    int counter = 0;
-
-                    // Take possible data
-                    const int nbNeigh = currentIter.coord.getNeighborsIndexes(OctreeHeight, indexesNeighbors, indexArray);
-
-                    for(int idxNeigh = 0 ; idxNeigh < nbNeigh ; ++idxNeigh){
-                        if(indexesNeighbors[idxNeigh] < (intervals[idProcess].leftIndex) || (intervals[idProcess].rightIndex) < indexesNeighbors[idxNeigh]){
-                            ContainerClass*const hypotheticNeighbor = otherP2Ptree.getLeafSrc(indexesNeighbors[idxNeigh]);
-                            if(hypotheticNeighbor){
-                                neighbors[ counter ] = hypotheticNeighbor;
-                                neighborPositions[counter] = indexArray[idxNeigh];
-                                ++counter;
+                    do{
+                        const bool hasProgressed = (nbProcsToProceed && proceedReceptions());
+
+                        // Create the tasks for full chunks, or for all the ready leaves at the end
+                        while(nbReadyLeaves - nbSpawnedLeaves >= chunckSize
+                              || (nbProcsToProceed == 0 && nbSpawnedLeaves != nbReadyLeaves)){
+                            const int firstLeaf = nbSpawnedLeaves;
+                            const int lastLeaf = FMath::Min(nbReadyLeaves, nbSpawnedLeaves + chunckSize);
+                            const int*const readyLeavesPtr = readyLeaves.get();
+#pragma omp task firstprivate(firstLeaf, lastLeaf, readyLeavesPtr, receivedLeavesPtr)
+                            {
+                                KernelClass*const myThreadkernels = kernels[omp_get_thread_num()];
+                                for(int idxReady = firstLeaf ; idxReady < lastLeaf ; ++idxReady){
+                                    computeRemoteP2P(myThreadkernels, readyLeavesPtr[idxReady], receivedLeavesPtr);
+                                }
                             }
+                            nbSpawnedLeaves = lastLeaf;
                         }
-                    }
-                    if(counter){
-                        myThreadkernels.P2PRemote( currentIter.cell->getCoordinate(), currentIter.targets,
-                                                   currentIter.sources, neighbors, neighborPositions, counter);
-                    }
 
-                }
+                        if(nbProcsToProceed && hasProgressed == false){
+#pragma omp taskyield
+                        }
+                    } while(nbProcsToProceed);
 
+                    FMpi::MpiAssert(MPI_Waitall(int(plan.directSendRequests.size()), plan.directSendRequests.data(), MPI_STATUSES_IGNORE), __LINE__);
+
+#pragma omp taskwait
+                    FLOG( computation2Counter.tac() );
+                }
             }
         }
 
         delete[] leafsDataArray;
 
-        FLOG(computation2Counter.tac());
-
-
         FLOG( FLog::Controller << "\tFinished (@Direct Pass (L2P + P2P) = "  << counterTime.tacAndElapsed() << " s)\n" );
         FLOG( FLog::Controller << "\t\t Computation L2P + P2P : " << computationCounter.elapsed() << " s\n" );
         FLOG( FLog::Controller << "\t\t Computation P2P 2 : " << computation2Counter.elapsed() << " s\n" );
         FLOG( FLog::Controller << "\t\t Prepare P2P : " << prepareCounter.elapsed() << " s\n" );
-        FLOG( FLog::Controller << "\t\t Gather P2P : " << gatherCounter.elapsed() << " s\n" );
-        FLOG( FLog::Controller << "\t\t Wait : " << waitCounter.elapsed() << " s\n" );
         FLOG( FLog::Controller.flush());
 
     }
@@ -25,12 +25,13 @@
 #include "Containers/FVector.hpp"
 #include "Containers/FBoolArray.hpp"
 #include "Containers/FOctree.hpp"
-#include "Containers/FLightOctree.hpp"
+#include "Containers/FCellHashMap.hpp"
 
 #include "Containers/FBufferWriter.hpp"
 #include "Containers/FBufferReader.hpp"
 
 #include "FCoreCommon.hpp"
+#include "FKernelCopies.hpp"
 #include "FP2PExclusion.hpp"
 
 #include "Utils/FAlgorithmTimers.hpp"
@@ -155,13 +156,7 @@ public:
   ///
   void setKernel(const KernelClass*const inKernels){
     this->kernels = new KernelClass*[MaxThreads];
-    #pragma omp parallel num_threads(MaxThreads)
-    {
-      #pragma omp critical (InitFFmmAlgorithmThreadProcPeriodic)
-      {
-        this->kernels[omp_get_thread_num()] = new KernelClass(*inKernels);
-      }
-    }
+    FCopyKernelPerThread(this->kernels, inKernels, MaxThreads);
   }
   ///
   /// \brief getPtrOnMortonIndexAtLeaf
@@ -685,124 +680,21 @@ protected:
     //Periodicity
     //////////////////////////////////////////////////////////////////
     ///
-    ///  Build the mutipole and the local expansion ine the root cell
+    ///  Build the mutipole and the local expansion in the root cell
+    ///
+    ///  Each process shares the level 1 cells it owns with all the others
+    ///  (at most 8 cells in total), then every process computes the root
+    ///  and the periodic levels redundantly. So there is no gather to
+    ///  process 0 and no broadcast back in the downward pass.
     ///
 
     octreeIterator = typename OctreeClass::Iterator(tree);
+    {
+        CellClass** const child = octreeIterator.getCurrentBox();
 
-    if( idProcess == 0){
-        // Build request to receive the size of the data
-        int iterRequestsSize = 0;
-//        bool receiveData = false ;
-        for(int idxProc = 1 ; idxProc < nbProcess ; ++idxProc ){
-            if( procHasWorkAtLevel(1,idxProc) ){
-   //             receiveData = true ;
-                MPI_Irecv(&recvBufferSize[iterRequestsSize], 1, FMpi::GetType(recvBufferSize[iterRequestsSize]), idxProc,
-                          FMpi::TagFmmM2MSize, comm.getComm(), &requests[iterRequestsSize]);
-                iterRequestsSize += 1;
-                FAssertLF(iterRequestsSize <= 7);
-              }
-          }
-        //if(receiveData)
-         // {
-            // Build the rootCell Level if we don't have all data
-            MPI_Waitall( iterRequestsSize, requests, MPI_STATUSES_IGNORE);
-            // Build request to receive the data
-
-            int iterRequests = 0;
-
-            for(int idxProc = 1 ; idxProc < nbProcess ; ++idxProc ){
-                if( procHasWorkAtLevel(1,idxProc) ){
-                    recvBuffer[iterRequests].cleanAndResize(recvBufferSize[iterRequests]);
-                    FAssertLF(recvBufferSize[iterRequests] < std::numeric_limits<int>::max());
-                    MPI_Irecv(recvBuffer[iterRequests].data(), int(recvBufferSize[iterRequests]), MPI_BYTE, idxProc,
-                              FMpi::TagFmmM2M, comm.getComm(), &requests[iterRequests]);
-                    iterRequests += 1;
-                    FAssertLF(iterRequests <= 7);
-                  }
-              }
-
-            MPI_Waitall( iterRequests, requests, MPI_STATUSES_IGNORE);
-
-            CellClass* currentChild[8];
-            memcpy(currentChild, octreeIterator.getCurrentBox(), 8 * sizeof(CellClass*));
-
-            // retreive data and merge my child and the child from others
-            int counterProc = 0;
-            for(int idxProc = 1 ; idxProc < nbProcess ; ++idxProc){
-                if( procHasWorkAtLevel(1,idxProc) ){
-                    recvBuffer[counterProc].seek(0);
-                    unsigned state = unsigned(recvBuffer[counterProc].getValue<unsigned char>());
-
-                    int position = 0;
-                    int positionToInsert = 0;
-                    while( state && position < 8){
-                        while(!(state & 0x1)){
-                            state >>= 1;
-                            ++position;
-                          }
-                        FAssertLF(positionToInsert < 7);
-                        FAssertLF(position < 8);
-                        FAssertLF(!currentChild[position], "Already has a cell here");
-
-                        recvBufferCells[positionToInsert].deserializeUp(recvBuffer[counterProc]);
-
-                        currentChild[position] = (CellClass*) &recvBufferCells[positionToInsert];
-
-                        state >>= 1;
-                        position += 1;
-                        positionToInsert += 1;
-                      }
-
-                    FAssertLF(recvBuffer[counterProc].tell() == recvBufferSize[counterProc]);
-                    counterProc += 1;
-                  }
-              }
-
-            // Build expansion at the rootCellFromProc
-                  multipole_t*           parent_multipole = &(rootCellFromProc.getMultipoleData());
-                  const symbolic_data_t* parent_symbolic  = &(rootCellFromProc);
-                  //
-                  std::array<const multipole_t*, 8> child_multipoles {};
-                  std::transform(currentChild, currentChild + 8,
-                                 std::begin(child_multipoles),
-                                 [](const CellClass* c) {
-                      return (c == nullptr)
-                          ? nullptr
-                          : &(c->getMultipoleData());
-                    });
-            std::array<const symbolic_data_t*, 8> child_symbolics {};
-            std::copy(currentChild, currentChild+8,
-                      std::begin(child_symbolics));
-
-            ///
-            /// // (*kernels[0]).M2M( &rootCellFromProc , currentChild, offsetRealTree);
-            ///
-            (*kernels[0]).M2M(
-                  parent_multipole,
-                  parent_symbolic,
-                  child_multipoles.data(),
-                  child_symbolics.data()
-                  );
-
-            ///  Now we have the multipole on the root level
-
-            ///
-            ///  Treat at root level the periodicity
-            ///
-        ///
-        ///  Treat at root level the periodicity
-        ///
-        this->processPeriodicLevels();
-      }
-    else {
-        //       OTHER PROCESS  (NOT 0)
-        //
         if( hasWorkAtLevel(1) ){
-            const int firstChild = getWorkingInterval(1, idProcess).leftIndex & 7;
-            const int lastChild  = getWorkingInterval(1, idProcess).rightIndex & 7;
-
-            CellClass** child = octreeIterator.getCurrentBox();
+            const int firstChild = int(getWorkingInterval(1, idProcess).leftIndex & 7);
+            const int lastChild  = int(getWorkingInterval(1, idProcess).rightIndex & 7);
 
             char state = 0;
             sendBuffer.write(state);
@@ -814,11 +706,92 @@ protected:
                   }
               }
             sendBuffer.writeAt(0,state);
-            FSize sizeToSend = sendBuffer.getSize();
-            MPI_Send(&sizeToSend, 1, MPI_LONG_LONG, 0, FMpi::TagFmmM2MSize, comm.getComm());
-            MPI_Send(sendBuffer.data(), int(sendBuffer.getSize()), MPI_BYTE, 0, FMpi::TagFmmM2M, comm.getComm());
           }
-      }
+
+        FAssertLF(sendBuffer.getSize() < std::numeric_limits<int>::max());
+        const int sizeToSend = int(sendBuffer.getSize());
+        std::unique_ptr<int[]> sizesOfProcs(new int[nbProcess]);
+        std::unique_ptr<int[]> displacementsOfProcs(new int[nbProcess + 1]);
+        FMpi::MpiAssert( MPI_Allgather( &sizeToSend, 1, MPI_INT, sizesOfProcs.get(), 1, MPI_INT, comm.getComm()), __LINE__ );
+
+        displacementsOfProcs[0] = 0;
+        for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+            FAssertLF(FSize(displacementsOfProcs[idxProc]) + sizesOfProcs[idxProc] < std::numeric_limits<int>::max());
+            displacementsOfProcs[idxProc + 1] = displacementsOfProcs[idxProc] + sizesOfProcs[idxProc];
+          }
+
+        FBufferReader rootChildrenBuffer(displacementsOfProcs[nbProcess]);
+        FMpi::MpiAssert( MPI_Allgatherv( sendBuffer.data(), sizeToSend, MPI_BYTE, rootChildrenBuffer.data(),
+                                         sizesOfProcs.get(), displacementsOfProcs.get(), MPI_BYTE, comm.getComm()), __LINE__ );
+        sendBuffer.reset();
+
+        // Merge the cells of all the processes, the ones of the current process come from the tree
+        CellClass* currentChild[8] = {};
+        CellClass rootChildrenCells[8];
+        int positionToInsert = 0;
+        for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+            if( sizesOfProcs[idxProc] == 0 ){
+                continue;
+              }
+            rootChildrenBuffer.seek(displacementsOfProcs[idxProc]);
+            unsigned state = unsigned(rootChildrenBuffer.getValue<unsigned char>());
+
+            int position = 0;
+            while( state && position < 8){
+                while(!(state & 0x1)){
+                    state >>= 1;
+                    ++position;
+                  }
+                FAssertLF(position < 8);
+                FAssertLF(!currentChild[position], "Already has a cell here");
+
+                if(idxProc == idProcess){
+                    currentChild[position] = child[position];
+                  }
+                else{
+                    FAssertLF(positionToInsert < 8);
+                    rootChildrenCells[positionToInsert].deserializeUp(rootChildrenBuffer);
+                    currentChild[position] = &rootChildrenCells[positionToInsert];
+                    positionToInsert += 1;
+                  }
+
+                state >>= 1;
+                position += 1;
+              }
+
+            if(idxProc == idProcess){
+                rootChildrenBuffer.seek(displacementsOfProcs[idxProc + 1]);
+              }
+            FAssertLF(rootChildrenBuffer.tell() == displacementsOfProcs[idxProc + 1]);
+          }
+
+        // Build expansion at the rootCellFromProc
+        multipole_t*           parent_multipole = &(rootCellFromProc.getMultipoleData());
+        const symbolic_data_t* parent_symbolic  = &(rootCellFromProc);
+        //
+        std::array<const multipole_t*, 8> child_multipoles {};
+        std::transform(currentChild, currentChild + 8,
+                       std::begin(child_multipoles),
+                       [](const CellClass* c) {
+            return (c == nullptr)
+                ? nullptr
+                : &(c->getMultipoleData());
+          });
+        std::array<const symbolic_data_t*, 8> child_symbolics {};
+        std::copy(currentChild, currentChild+8,
+                  std::begin(child_symbolics));
+
+        (*kernels[0]).M2M(
+              parent_multipole,
+              parent_symbolic,
+              child_multipoles.data(),
+              child_symbolics.data()
+              );
+    }
+    ///
+    ///  Now we have the multipole on the root level, treat the periodicity
+    ///
+    this->processPeriodicLevels();
     ///////////////////////////////////////////////////////////////////////////
   }
 
@@ -901,15 +874,17 @@ protected:
 
               leafsNeedOther[idxLevel] = new FBoolArray(numberOfCells);
 
+              const int separationCriteria = (idxLevel != OctreeHeight-1 ? 1 : leafLevelSeparationCriteria);
+
               // Which cell potentialy needs other data and in the same time
               // are potentialy needed by other
               int neighborsPosition[/*189+26+1*/216];
               MortonIndex neighborsIndexes[/*189+26+1*/216];
               for(int idxCell = 0 ; idxCell < numberOfCells ; ++idxCell){
                   // Find the M2L neigbors of a cell
-                  const int counter = getPeriodicInteractionNeighbors(iterArray[idxCell].getCurrentGlobalCoordinate(),
+                  const int counter = getPeriodicInteractionNeighbors(iterArrayLocal[idxCell].getCurrentGlobalCoordinate(),
                                                                       idxLevel,
-                                                                      neighborsIndexes, neighborsPosition, AllDirs, leafLevelSeparationCriteria);
+                                                                      neighborsIndexes, neighborsPosition, AllDirs, separationCriteria);
 
                   memset(alreadySent, false, sizeof(bool) * nbProcess);
                   bool needOther = false;
@@ -1055,7 +1030,7 @@ protected:
             {
               const int chunckSize = userChunkSize;
               for(int idxCell = 0 ; idxCell < numberOfCells ; idxCell += chunckSize){
-#pragma omp task default(none) shared(numberOfCells,idxLevel) firstprivate(idxCell) //+ shared(chunckSize)
+#pragma omp task shared(numberOfCells,idxLevel) firstprivate(idxCell) //+ shared(chunckSize)
 		  {
 		    KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
 		    const CellClass* neighbors[342];
@@ -1104,7 +1079,7 @@ protected:
 #pragma omp taskwait
 
 	    for(int idxThread = 0 ; idxThread < omp_get_num_threads() ; ++idxThread){
-#pragma omp task  default(none) firstprivate(idxThread,idxLevel)
+#pragma omp task firstprivate(idxThread,idxLevel)
 		{
 		  kernels[idxThread]->finishedLevelM2L(fakeLevel);
 		}
@@ -1127,7 +1102,7 @@ protected:
       for(int idxLevel = 1 ; idxLevel < OctreeHeight ; ++idxLevel ){
           const int fakeLevel = idxLevel + offsetRealTree;
 
-          const int separationCriteria = (fakeLevel != OctreeHeight-1 ? 1 : leafLevelSeparationCriteria);
+          const int separationCriteria = (idxLevel != OctreeHeight-1 ? 1 : leafLevelSeparationCriteria);
 
           if(!procHasWorkAtLevel(idxLevel, idProcess)){
               avoidGotoLeftIterator.moveDown();
@@ -1135,11 +1110,20 @@ protected:
               continue;
             }
 
-          // put the received data into a temporary tree
-          FLightOctree<CellClass> tempTree;
+          // put the received data into a temporary cells map, the buffers start with their number of cells
+          std::vector<int> toReceiveFromProc(nbProcess, 0);
+          FSize nbCellsAtLevel = 0;
+          for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+              if(recvBuffer[idxLevel * nbProcess + idxProc]){
+                  toReceiveFromProc[idxProc] = recvBuffer[idxLevel * nbProcess + idxProc]->template getValue<int>();
+                  nbCellsAtLevel += toReceiveFromProc[idxProc];
+              }
+          }
+          FCellHashMap<CellClass> tempTree;
+          tempTree.reserve(nbCellsAtLevel);
           for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
               if(recvBuffer[idxLevel * nbProcess + idxProc]){
-                  const int toReceiveFromProcAtLevel = recvBuffer[idxLevel * nbProcess + idxProc]->template getValue<int>();
+                  const int toReceiveFromProcAtLevel = toReceiveFromProc[idxProc];
 
                   for(int idxCell = 0 ; idxCell < toReceiveFromProcAtLevel ; ++idxCell){
                       const FSize currentTell = recvBuffer[idxLevel * nbProcess + idxProc]->tell();
@@ -1148,7 +1132,7 @@ protected:
 
                       const MortonIndex cellIndex = recvBuffer[idxLevel * nbProcess + idxProc]->template getValue<MortonIndex>();
 
-                      CellClass* const newCell = new CellClass;
+                      CellClass* const newCell = tempTree.allocateCell();
                       newCell->setMortonIndex(cellIndex);
                       newCell->deserializeUp(*recvBuffer[idxLevel * nbProcess + idxProc]);
 
@@ -1295,24 +1279,6 @@ protected:
 
     int righestProcToSendTo   = nbProcess - 1;
 
-    // Periodic
-    if( idProcess == 0){
-        rootCellFromProc.serializeDown(sendBuffer);
-        FAssertLF(sendBuffer.getSize() < std::numeric_limits<int>::max());
-        int sizeOfSerialization = int(sendBuffer.getSize());
-        FMpi::MpiAssert( MPI_Bcast( &sizeOfSerialization, 1, MPI_INT, 0, comm.getComm() ), __LINE__ );
-        FMpi::MpiAssert( MPI_Bcast( sendBuffer.data(), int(sendBuffer.getSize()), MPI_BYTE, 0, comm.getComm() ), __LINE__ );
-        sendBuffer.reset();
-      }
-    else{
-        int sizeOfSerialization = -1;
-        FMpi::MpiAssert( MPI_Bcast( &sizeOfSerialization, 1, MPI_INT, 0, comm.getComm() ), __LINE__ );
-        recvBuffer.cleanAndResize(sizeOfSerialization);
-        FMpi::MpiAssert( MPI_Bcast( recvBuffer.data(), sizeOfSerialization, MPI_BYTE, 0, comm.getComm() ), __LINE__ );
-        rootCellFromProc.deserializeDown(recvBuffer);
-        FAssertLF(recvBuffer.getSize() == sizeOfSerialization);
-        recvBuffer.seek(0);
-      }
     // all processors apply L2L(rootCellFromProc) and store the local expansion in child_local_expansions
     // That is an alias of the local expansion n the octree at level 1
     //
@@ -1826,7 +1792,7 @@ protected:
 
             for(int idxLeafs = previous ; idxLeafs < endAtThisShape ; idxLeafs += chunckSize){
                 const int nbLeavesInTask = FMath::Min(endAtThisShape-idxLeafs, chunckSize);
-#pragma omp task default(none) firstprivate(nbLeavesInTask,idxLeafs)
+#pragma omp task firstprivate(nbLeavesInTask,idxLeafs)
 		{
 		  KernelClass* myThreadkernels = (kernels[omp_get_thread_num()]);
 
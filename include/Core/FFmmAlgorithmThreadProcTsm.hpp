@@ -29,7 +29,7 @@
 
 #include "../Containers/FBoolArray.hpp"
 #include "../Containers/FOctree.hpp"
-#include "../Containers/FLightOctree.hpp"
+#include "../Containers/FCellHashMap.hpp"
 #include "../Utils/FEnv.hpp"
 
 #include "../Containers/FBufferWriter.hpp"
@@ -39,6 +39,7 @@
 #include <sys/time.h>
 
 #include "FCoreCommon.hpp"
+#include "FKernelCopies.hpp"
 #include "FP2PExclusion.hpp"
 
 #include <memory>
@@ -177,13 +178,7 @@ public:
             MaxThreads = omp_get_num_threads();
 
         this->kernels = new KernelClass*[MaxThreads];
-        #pragma omp parallel num_threads(MaxThreads)
-        {
-          #pragma omp critical (InitFFmmAlgorithmThreadProcTsm) 
-          {
-            this->kernels[omp_get_thread_num()] = new KernelClass(*inKernels);
-          }
-        }
+        FCopyKernelPerThread(this->kernels, inKernels, MaxThreads);
 
         FAbstractAlgorithm::setNbLevelsInTree(tree->getHeight());
 
@@ -1107,11 +1102,20 @@ protected:
                     continue;
                 }
 
-                // put the received data into a temporary tree
-                FLightOctree<CellClass> tempTree;
+                // put the received data into a temporary cells map, the buffers start with their number of cells
+                std::vector<int> toReceiveFromProc(nbProcess, 0);
+                FSize nbCellsAtLevel = 0;
+                for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                    if(recvBuffer[idxLevel * nbProcess + idxProc]){
+                        toReceiveFromProc[idxProc] = recvBuffer[idxLevel * nbProcess + idxProc]->template getValue<int>();
+                        nbCellsAtLevel += toReceiveFromProc[idxProc];
+                    }
+                }
+                FCellHashMap<CellClass> tempTree;
+                tempTree.reserve(nbCellsAtLevel);
                 for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
                     if(recvBuffer[idxLevel * nbProcess + idxProc]){
-                        const int toReceiveFromProcAtLevel = recvBuffer[idxLevel * nbProcess + idxProc]->template getValue<int>();
+                        const int toReceiveFromProcAtLevel = toReceiveFromProc[idxProc];
 
                         for(int idxCell = 0 ; idxCell < toReceiveFromProcAtLevel ; ++idxCell){
                             const FSize currentTell = recvBuffer[idxLevel * nbProcess + idxProc]->tell();
@@ -1120,7 +1124,7 @@ protected:
 
                             const MortonIndex cellIndex = recvBuffer[idxLevel * nbProcess + idxProc]->template getValue<MortonIndex>();
 
-                            CellClass* const newCell = new CellClass;
+                            CellClass* const newCell = tempTree.allocateCell();
                             newCell->setMortonIndex(cellIndex);
                             newCell->deserializeUp(*recvBuffer[idxLevel * nbProcess + idxProc]);
 
@@ -13,6 +13,7 @@
 #include "../Utils/FAlgorithmTimers.hpp"
 #include "../Containers/FOctree.hpp"
 #include "FCoreCommon.hpp"
+#include "FKernelCopies.hpp"
 #include "../Utils/FEnv.hpp"
 
 #include <omp.h>
@@ -70,13 +71,7 @@ public:
             MaxThreads = omp_get_num_threads();
 
         this->kernels = new KernelClass*[MaxThreads];
-        #pragma omp parallel num_threads(MaxThreads) 
-        {
-          #pragma omp critical (InitFFmmAlgorithmTsm)
-          {
-            this->kernels[omp_get_thread_num()] = new KernelClass(*inKernels);
-          }
-        }
+        FCopyKernelPerThread(this->kernels, inKernels, MaxThreads);
 
         FAbstractAlgorithm::setNbLevelsInTree(tree->getHeight());
 
@@ -0,0 +1,51 @@
+// See LICENCE file at project root
+#ifndef FKERNELCOPIES_HPP
+#define FKERNELCOPIES_HPP
+
+#include <omp.h>
+
+/**
+ * To know if a kernel declares that its copy constructor can be called
+ * by several threads at the same time, with:
+ * constexpr static bool HasThreadSafeCopy(){ return true; }
+ * Kernels that do not declare it are considered as not thread safe.
+ */
+template <class KernelClass>
+class FKernelHasThreadSafeCopy {
+    template <class K>
+    static constexpr bool Check(decltype(K::HasThreadSafeCopy())*){
+        return K::HasThreadSafeCopy();
+    }
+
+    template <class K>
+    static constexpr bool Check(...){
+        return false;
+    }
+
+public:
+    static constexpr bool value = Check<KernelClass>(nullptr);
+};
+
+/**
+ * Fill kernels[idxThread] with a copy of inKernels made by the thread idxThread,
+ * so that the memory the copy touches is local to the thread that will use it.
+ * The copies are done in parallel if the kernel has a thread safe copy
+ * constructor, else they are done one after the other.
+ */
+template <class KernelClass>
+void FCopyKernelPerThread(KernelClass** const kernels, const KernelClass* const inKernels, const int nbThreads){
+    #pragma omp parallel num_threads(nbThreads)
+    {
+        if(FKernelHasThreadSafeCopy<KernelClass>::value){
+            kernels[omp_get_thread_num()] = new KernelClass(*inKernels);
+        }
+        else{
+            #pragma omp critical (FCopyKernelPerThread)
+            {
+                kernels[omp_get_thread_num()] = new KernelClass(*inKernels);
+            }
+        }
+    }
+}
+
+#endif // FKERNELCOPIES_HPP
@@ -5,6 +5,7 @@
 #include "Utils/FMpi.hpp"
 #include "Utils/FQuickSortMpi.hpp"
 #include "Utils/FBitonicSort.hpp"
+#include "Utils/FRadixSortMpi.hpp"
 #include "Utils/FTic.hpp"
 #include "Utils/FEnv.hpp"
 
@@ -42,6 +43,7 @@ public:
     enum SortingType{
         QuickSort,
         BitonicSort,
+        RadixSort, //< Sample sort with a local radix sort and one all-to-all (FRadixSortMpi)
     };
 
 
@@ -85,6 +87,18 @@ public:
     //////////////////////////////////////////////////////////////////////////
 
 
+    /** Compute the morton index of the particles at the leaf level (see FCoordinateComputer) */
+    static void ComputeMortonIndexes(IndexedParticle particles[], const FSize nbParticles,
+                                     const FPoint<FReal>& centerOfBox, const FReal boxWidth, const int TreeHeight){
+        FCoordinateComputer::GetMortonIndexesFromPositions<FReal>(centerOfBox, boxWidth, TreeHeight, nbParticles,
+                [&](const FSize idxPart){
+                    return particles[idxPart].particle.getPosition();
+                },
+                [&](const FSize idxPart, const MortonIndex index){
+                    particles[idxPart].index = index;
+                });
+    }
+
     /** Get an array of particles sorted from their morton indexes */
     template <class LoaderClass>
     static void GetSortedParticlesFromLoader( const FMpi::FComm& communicator, LoaderClass& loader, const SortingType sortingType,
@@ -93,28 +107,23 @@ public:
         IndexedParticle*const originalParticlesUnsorted = new IndexedParticle[loader.getNumberOfParticles()];
         FMemUtils::memset(originalParticlesUnsorted, 0, sizeof(IndexedParticle) * loader.getNumberOfParticles());
 
-        FPoint<FReal> boxCorner(loader.getCenterOfBox() - (loader.getBoxWidth()/2));
-        FTreeCoordinate host;
-        const FReal boxWidthAtLeafLevel = loader.getBoxWidth() / FReal(1 << (TreeHeight - 1) );
-
-        // Fill the array and compute the morton index
+        // Fill the array
         for(FSize idxPart = 0 ; idxPart < loader.getNumberOfParticles() ; ++idxPart){
             loader.fillParticle(originalParticlesUnsorted[idxPart].particle);
-            host.setX( FCoordinateComputer::GetTreeCoordinate<FReal>( originalParticlesUnsorted[idxPart].particle.getPosition().getX() - boxCorner.getX(), loader.getBoxWidth(), boxWidthAtLeafLevel,
-                                           TreeHeight ));
-            host.setY( FCoordinateComputer::GetTreeCoordinate<FReal>( originalParticlesUnsorted[idxPart].particle.getPosition().getY() - boxCorner.getY(), loader.getBoxWidth(), boxWidthAtLeafLevel,
-                                           TreeHeight ));
-            host.setZ( FCoordinateComputer::GetTreeCoordinate<FReal>( originalParticlesUnsorted[idxPart].particle.getPosition().getZ() - boxCorner.getZ(), loader.getBoxWidth(), boxWidthAtLeafLevel,
-                                           TreeHeight ));
-
-            originalParticlesUnsorted[idxPart].index = host.getMortonIndex();
         }
+        // Compute the morton index
+        ComputeMortonIndexes(originalParticlesUnsorted, loader.getNumberOfParticles(), loader.getCenterOfBox(),
+                             loader.getBoxWidth(), TreeHeight);
 
         // Sort particles
         if(sortingType == QuickSort){
             FQuickSortMpi<IndexedParticle,MortonIndex, FSize>::QsMpi(originalParticlesUnsorted, loader.getNumberOfParticles(), *outputSortedParticles, *outputNbParticlesSorted,communicator);
             delete [] (originalParticlesUnsorted);
         }
+        else if(sortingType == RadixSort){
+            FRadixSortMpi<IndexedParticle,MortonIndex, FSize>::SortMpi(originalParticlesUnsorted, loader.getNumberOfParticles(), outputSortedParticles, outputNbParticlesSorted,communicator);
+            delete [] (originalParticlesUnsorted);
+        }
         else {
             FBitonicSort<IndexedParticle,MortonIndex, FSize>::Sort( originalParticlesUnsorted, loader.getNumberOfParticles(), communicator );
             *outputSortedParticles = originalParticlesUnsorted;
@@ -130,24 +139,13 @@ public:
         IndexedParticle*const originalParticlesUnsorted = new IndexedParticle[originalNbParticles];
         FMemUtils::memset(originalParticlesUnsorted, 0, sizeof(IndexedParticle) * originalNbParticles);
 
-        FPoint<FReal> boxCorner(centerOfBox - (boxWidth/2));
-        FTreeCoordinate host;
-        const FReal boxWidthAtLeafLevel = boxWidth / FReal(1 << (TreeHeight - 1) );
-
         FLOG(FTic counterTime);
 
         // Fill the array and compute the morton index
         for(FSize idxPart = 0 ; idxPart < originalNbParticles ; ++idxPart){
             originalParticlesUnsorted[idxPart].particle = inOriginalParticles[idxPart];
-            host.setX( FCoordinateComputer::GetTreeCoordinate<FReal>( originalParticlesUnsorted[idxPart].particle.getPosition().getX() - boxCorner.getX(), boxWidth, boxWidthAtLeafLevel,
-                                           TreeHeight ));
-            host.setY( FCoordinateComputer::GetTreeCoordinate<FReal>( originalParticlesUnsorted[idxPart].particle.getPosition().getY() - boxCorner.getY(), boxWidth, boxWidthAtLeafLevel,
-                                           TreeHeight ));
-            host.setZ( FCoordinateComputer::GetTreeCoordinate<FReal>( originalParticlesUnsorted[idxPart].particle.getPosition().getZ() - boxCorner.getZ(), boxWidth, boxWidthAtLeafLevel,
-                                           TreeHeight ));
-
-            originalParticlesUnsorted[idxPart].index = host.getMortonIndex();
         }
+        ComputeMortonIndexes(originalParticlesUnsorted, originalNbParticles, centerOfBox, boxWidth, TreeHeight);
 
         FLOG( FLog::Controller << "Particles Distribution: "  << "\tPrepare particles ("  << counterTime.tacAndElapsed() << "s)\n"; FLog::Controller.flush(); );
 
@@ -156,6 +154,10 @@ public:
             FQuickSortMpi<IndexedParticle,MortonIndex, FSize>::QsMpi(originalParticlesUnsorted, originalNbParticles, outputSortedParticles, outputNbParticlesSorted,communicator);
             delete [] (originalParticlesUnsorted);
         }
+        else if(sortingType == RadixSort){
+            FRadixSortMpi<IndexedParticle,MortonIndex, FSize>::SortMpi(originalParticlesUnsorted, originalNbParticles, outputSortedParticles, outputNbParticlesSorted,communicator);
+            delete [] (originalParticlesUnsorted);
+        }
         else {
             FBitonicSort<IndexedParticle,MortonIndex, FSize>::Sort( originalParticlesUnsorted, originalNbParticles, communicator );
             *outputSortedParticles = originalParticlesUnsorted;
@@ -169,7 +171,8 @@ public:
     //////////////////////////////////////////////////////////////////////////
 
     static void MergeSplitedLeaves(const FMpi::FComm& communicator, IndexedParticle** workingArray, FSize* workingSize,
-                                   FSize ** leavesOffsetInParticles, ParticleClass** particlesArrayInLeafOrder, FSize* const leavesSize){
+                                   FSize ** leavesOffsetInParticles, ParticleClass** particlesArrayInLeafOrder, FSize* const leavesSize,
+                                   MortonIndex** leavesIndexes = nullptr){
         const int myRank = communicator.processId();
         const int nbProcs = communicator.processCount();
 
@@ -286,6 +289,7 @@ public:
                     leavesInfo[idxLeaf].startingPoint -= offsetParticles;
                     leavesInfo[idxLeaf - 1] = leavesInfo[idxLeaf];
                 }
+                leavesInfo.pop();
                 (*workingSize) -= offsetParticles;
             }
 
@@ -312,6 +316,7 @@ public:
             (*leavesSize)    = 0; //init ptr
             (*particlesArrayInLeafOrder)   = nullptr; //init ptr
             (*leavesOffsetInParticles) = nullptr; //init ptr
+            if(leavesIndexes) (*leavesIndexes) = nullptr; //init ptr
 
             if((*workingSize)){
                 //Copy all the particles
@@ -327,6 +332,13 @@ public:
                     (*leavesOffsetInParticles)[idxLeaf] = leavesInfo[idxLeaf].startingPoint;
                 }
                 (*leavesOffsetInParticles)[leavesInfo.getSize()] = (*workingSize);
+                // Store the Morton index of each leaf
+                if(leavesIndexes){
+                    (*leavesIndexes) = new MortonIndex[leavesInfo.getSize()];
+                    for(int idxLeaf = 0 ; idxLeaf < leavesInfo.getSize() ; ++idxLeaf){
+                        (*leavesIndexes)[idxLeaf] = leavesInfo[idxLeaf].mindex;
+                    }
+                }
             }
         }
     }
@@ -341,7 +353,8 @@ public:
     static void EqualizeAndFillContainer(const FMpi::FComm& communicator,  ContainerClass* particlesSaver,
                                          const FSize leavesOffsetInParticles[], const ParticleClass particlesArrayInLeafOrder[],
                                          const FSize currentNbLeaves,
-                                         const FSize currentNbParts, FAbstractBalanceAlgorithm * balancer){
+                                         const FSize currentNbParts, FAbstractBalanceAlgorithm * balancer,
+                                         const MortonIndex leavesIndexes[] = nullptr){
         const int myRank = communicator.processId();
         const int nbProcs = communicator.processCount();
 
@@ -368,6 +381,8 @@ public:
             }
 
             const FSize totalNumberOfLeavesInSimulation  = diffNumberOfLeavesPerProc[nbProcs];
+            // Give the local leaves to the balancers that need them
+            balancer->setLocalLeaves(leavesIndexes, leavesOffsetInParticles, currentNbLeaves, diffNumberOfLeavesPerProc[myRank]);
             // Compute the objective interval
             std::vector< std::pair<size_t,size_t> > allObjectives;
             allObjectives.resize(nbProcs);
@@ -584,9 +599,11 @@ public:
 //        }
         ParticleClass* particlesArrayInLeafOrder = nullptr;
         FSize * leavesOffsetInParticles = nullptr;
+        MortonIndex * leavesIndexes = nullptr;
         FSize nbLeaves = 0;
         // Merge the leaves
-        MergeSplitedLeaves(communicator, &sortedParticlesArray, &nbParticlesInArray, &leavesOffsetInParticles, &particlesArrayInLeafOrder, &nbLeaves);
+        MergeSplitedLeaves(communicator, &sortedParticlesArray, &nbParticlesInArray, &leavesOffsetInParticles, &particlesArrayInLeafOrder, &nbLeaves,
+                           &leavesIndexes);
         delete[] sortedParticlesArray;
 
 //        for(int idx = 0 ; idx < nbParticlesInArray ; ++idx){
@@ -598,9 +615,10 @@ public:
 
         // Equalize and balance
         EqualizeAndFillContainer(communicator, particleSaver, leavesOffsetInParticles, particlesArrayInLeafOrder, nbLeaves,
-                                 nbParticlesInArray, balancer);
+                                 nbParticlesInArray, balancer, leavesIndexes);
         delete[] particlesArrayInLeafOrder;
         delete[] leavesOffsetInParticles;
+        delete[] leavesIndexes;
 
         FLOG( FLog::Controller << "["  << communicator.processId() << "] Particles Distribution: "  << "\t EqualizeAndFillContainer is over (" << timer.tacAndElapsed() << "s)\n"; FLog::Controller.flush(); );
 
@@ -5,17 +5,20 @@
 #include "Utils/FGlobal.hpp"
 
 #include "Utils/FLog.hpp"
-#include "Utils/FQuickSort.hpp"
+#include "Utils/FRadixSort.hpp"
 #include "Utils/FTic.hpp"
 #include "Utils/FAssert.hpp"
 #include "Containers/FOctree.hpp"
 #include "Containers/FTreeCoordinate.hpp"
+#include "Containers/FCoordinateComputer.hpp"
 
 #include "Components/FBasicParticleContainer.hpp"
 
 #include <omp.h>
 
+#include <array>
 #include <memory>
+#include <vector>
 
 /**
 * @author Cyrille Piacibello, Berenger Bramas
@@ -26,8 +29,10 @@
 * This class provides a way to insert efficiently large amount of particles inside a tree.
 *
 * This is a static class. It's useless to instance it.  This class use
-* the Threaded QuickSort or the output of FMpiTreeBuilder in order to
-* sort the parts and insert them.
+* the parallel radix sort (or the output of FMpiTreeBuilder) in order to
+* sort the parts, then it finds the leaves in one pass, creates them in
+* parallel (in different sub-octrees with an FOctree) and fills them with
+* their exact sizes in parallel.
 *
 */
 
@@ -38,197 +43,301 @@ private:
     struct IndexedParticle{
         MortonIndex mindex{};
         FSize particlePositionInArray{};
-//
-//        IndexedParticle(const IndexedParticle& rhs){
-//                mindex =  rhs.mindex ;
-//                particlePositionInArray = rhs.particlePositionInArray ;}
-//       IndexedParticle(const IndexedParticle&& rhs){
-//                mindex =  rhs.mindex ;
-//                particlePositionInArray = rhs.particlePositionInArray ;}
-
-       // To sort according to the mindex
-        bool operator<=(const IndexedParticle& rhs) const {
-            return this->mindex <= rhs.mindex;
-        }
-       // To sort according to the mindex
-        IndexedParticle& operator=(const IndexedParticle& rhs)  {
-        	mindex =  rhs.mindex ;
-                particlePositionInArray = rhs.particlePositionInArray ;   
-	return *this;
+
+        // To sort according to the mindex (FRadixSort)
+        operator MortonIndex() const {
+            return mindex;
         }
     };
 
     /** In order to keep all the created leaves */
     struct LeafDescriptor{
         LeafClass* leafPtr;
+        MortonIndex mindex;
         FSize offsetInArray;
         FSize nbParticlesInLeaf;
     };
 
-public:
+    /** The leaves of an FOctree can be created in parallel if they are in different sub-octrees */
+    template <class... FOctreeParameters>
+    static constexpr bool CanCreateLeavesInParallel(const FOctree<FOctreeParameters...>*){
+        return true;
+    }
 
-    /** Should be used to insert a FBasicParticleContainer class */
-    template < unsigned NbAttributes, class AttributeClass>
-    static void BuildTreeFromArray(OctreeClass*const tree, const FBasicParticleContainer<FReal, NbAttributes, AttributeClass>& particlesContainers,
-                                   bool isAlreadySorted=false){
-        const FSize numberOfParticle = particlesContainers.getNbParticles();
-        // If the parts are already sorted, no need to sort again
-        FLOG(FTic enumTimer, leavesPtr, leavesOffset );
-        FLOG(FTic insertTimer, copyTimer);
+    /** Any other tree is filled with one thread */
+    static constexpr bool CanCreateLeavesInParallel(const void*){
+        return false;
+    }
 
+    /**
+     * Compute the Morton index of each particle and sort them.
+     * @param getPosition is called as getPosition(idxParticle) and return the position of the particle
+     */
+    template <class PositionGetterClass>
+    static std::unique_ptr<IndexedParticle[]> SortParticles(OctreeClass*const tree, const FSize numberOfParticle,
+                                                            PositionGetterClass&& getPosition, const bool isAlreadySorted){
+        FLOG(FTic copyTimer);
         // General values needed
         const int NbLevels       = tree->getHeight();
         const FPoint<FReal> centerOfBox = tree->getBoxCenter();
         const FReal boxWidth     = tree->getBoxWidth();
-        const FReal boxWidthAtLeafLevel = boxWidth/FReal(1 << (NbLevels - 1));
-        const FPoint<FReal> boxCorner   = centerOfBox - boxWidth/2;
-
-        ////////////////////////////////////////////////////////////////
-        ////////////////////////////////////////////////////////////////
-        /// We need to sort it in order to insert efficiently
-        ////////////////////////////////////////////////////////////////
-
-        // First, copy datas into an array that will be sorted and
-        // set Morton index for each particle
 
-        // Temporary FTreeCoordinate
         std::unique_ptr<IndexedParticle[]> particleIndexes(new IndexedParticle[numberOfParticle]);
 
-        FLOG(copyTimer.tic());
-        #pragma omp parallel for schedule(static)
-        for(FSize idxParts=0; idxParts<numberOfParticle ; ++idxParts ){
-            // Get the Morton Index
-            const FTreeCoordinate host(
-                     FCoordinateComputer::GetTreeCoordinate<FReal>(particlesContainers.getPositions()[0][idxParts] - boxCorner.getX(),
-                                         boxWidth,boxWidthAtLeafLevel,  NbLevels),
-                     FCoordinateComputer::GetTreeCoordinate<FReal>(particlesContainers.getPositions()[1][idxParts] - boxCorner.getY(),
-                                          boxWidth,boxWidthAtLeafLevel, NbLevels ),
-                     FCoordinateComputer::GetTreeCoordinate<FReal>(particlesContainers.getPositions()[2][idxParts] - boxCorner.getZ(),
-                                          boxWidth,boxWidthAtLeafLevel, NbLevels )
-            );
-            // Store morton index and original idx
-            particleIndexes[idxParts].mindex = host.getMortonIndex();
-            particleIndexes[idxParts].particlePositionInArray = idxParts;
+        #pragma omp parallel
+        {
+            // Each thread computes the indexes of a contiguous range of particles
+            const FSize start = numberOfParticle * omp_get_thread_num() / omp_get_num_threads();
+            const FSize end   = numberOfParticle * (omp_get_thread_num() + 1) / omp_get_num_threads();
+            FCoordinateComputer::GetMortonIndexesFromPositions<FReal>(centerOfBox, boxWidth, NbLevels, end - start,
+                    [&](const FSize idxParts){
+                        return getPosition(start + idxParts);
+                    },
+                    [&](const FSize idxParts, const MortonIndex mindex){
+                        // Store morton index and original idx
+                        particleIndexes[start + idxParts].mindex = mindex;
+                        particleIndexes[start + idxParts].particlePositionInArray = start + idxParts;
+                    });
         }
 
         FLOG(copyTimer.tac());
-        FLOG(FLog::Controller<<"Time needed for copying "<< numberOfParticle<<" particles : "<<copyTimer.elapsed() << " secondes !\n");
-
-        ////////////////////////////////////////////////////////////////
-        ////////////////////////////////////////////////////////////////
-        /// Sort it needed
-        ////////////////////////////////////////////////////////////////
+        FLOG(FLog::Controller<<"Time needed for computing the indexes of "<< numberOfParticle<<" particles : "<<copyTimer.elapsed() << " secondes !\n");
 
+        // If the parts are already sorted, no need to sort again
         if(!isAlreadySorted){
-            //Sort dat array
             FLOG(FTic sortTimer);
-            FQuickSort<IndexedParticle,FSize>::QsOmp( particleIndexes.get(), numberOfParticle);
+            FRadixSort<IndexedParticle, MortonIndex, FSize>::RadixSort( particleIndexes.get(), numberOfParticle);
             FLOG(sortTimer.tac());
             FLOG(FLog::Controller << "Time needed for sorting the particles : "<< sortTimer.elapsed() << " secondes !\n");
         }
+        return particleIndexes;
+    }
 
-        ////////////////////////////////////////////////////////////////
-        ////////////////////////////////////////////////////////////////
-        /// Get the number of leaves
-        ////////////////////////////////////////////////////////////////
-
-        //Enumerate the different leaves AND copy the positions
-        unsigned int numberOfLeaves = 0;
-        FLOG(enumTimer.tic());
+    /**
+     * Find the leaves of the sorted particles in one parallel pass, and create them in the tree.
+     * With an FOctree, the leaves are grouped by the sub-octree that holds them (at the first
+     * sub-octree level that gives enough groups for the threads), the first leaf of each group
+     * is created sequentially (it creates the sub-octrees and the cells above the group),
+     * then the groups are created in parallel since they do not share any cell.
+     */
+    static std::vector<LeafDescriptor> CreateLeaves(OctreeClass*const tree, const IndexedParticle particleIndexes[],
+                                                    const FSize numberOfParticle){
+        FLOG(FTic enumTimer);
+        std::vector<LeafDescriptor> leavesDescriptor;
+        // The number of leaves starting in the interval of each thread
+        std::vector<FSize> leavesPerThread(omp_get_max_threads() + 1, 0);
+
+        #pragma omp parallel num_threads(int(leavesPerThread.size()) - 1)
         {
-            MortonIndex previousIndex = -1;
+            const int idxThread = omp_get_thread_num();
+            const int nbThreads = omp_get_num_threads();
+            const FSize begin = FSize(double(numberOfParticle) * double(idxThread) / double(nbThreads));
+            const FSize end = (idxThread == nbThreads - 1 ? numberOfParticle : FSize(double(numberOfParticle) * double(idxThread + 1) / double(nbThreads)));
+
+            FSize nbLeavesInInterval = 0;
+            for(FSize idxParts = begin ; idxParts < end ; ++idxParts){
+                if(idxParts == 0 || particleIndexes[idxParts].mindex != particleIndexes[idxParts-1].mindex){
+                    nbLeavesInInterval += 1;
+                }
+            }
+            leavesPerThread[idxThread+1] = nbLeavesInInterval;
 
-            for(FSize idxParts = 0 ; idxParts < numberOfParticle ; ++idxParts){
-                // If not the same leaf, inc the counter
-                if(particleIndexes[idxParts].mindex != previousIndex){
-                    previousIndex   = particleIndexes[idxParts].mindex;
-                    numberOfLeaves += 1;
+            #pragma omp barrier
+            #pragma omp single
+            {
+                for(int idxOtherThread = 0 ; idxOtherThread < nbThreads ; ++idxOtherThread){
+                    leavesPerThread[idxOtherThread+1] += leavesPerThread[idxOtherThread];
                 }
+                leavesDescriptor.resize(leavesPerThread[nbThreads]);
             }
+
+            FSize idxLeaf = leavesPerThread[idxThread];
+            for(FSize idxParts = begin ; idxParts < end ; ++idxParts){
+                if(idxParts == 0 || particleIndexes[idxParts].mindex != particleIndexes[idxParts-1].mindex){
+                    leavesDescriptor[idxLeaf].leafPtr = nullptr;
+                    leavesDescriptor[idxLeaf].mindex = particleIndexes[idxParts].mindex;
+                    leavesDescriptor[idxLeaf].offsetInArray = idxParts;
+                    idxLeaf += 1;
+                }
+            }
+        }
+
+        const FSize numberOfLeaves = FSize(leavesDescriptor.size());
+        for(FSize idxLeaf = 0 ; idxLeaf < numberOfLeaves ; ++idxLeaf){
+            leavesDescriptor[idxLeaf].nbParticlesInLeaf = (idxLeaf + 1 < numberOfLeaves ? leavesDescriptor[idxLeaf+1].offsetInArray : numberOfParticle)
+                    - leavesDescriptor[idxLeaf].offsetInArray;
         }
 
         FLOG(enumTimer.tac());
         FLOG(FLog::Controller << "Time needed for enumerate the leaves : "<< enumTimer.elapsed() << " secondes !\n");
         FLOG(FLog::Controller << "Found " << numberOfLeaves << " leaves differents. \n");
 
-        ////////////////////////////////////////////////////////////////
-        ////////////////////////////////////////////////////////////////
-        /// Count the number of particles per leaf
-        ////////////////////////////////////////////////////////////////
-
-        FLOG(leavesOffset.tic());
+        FLOG(FTic createTimer);
+        // The groups of leaves that are in the same sub-octree
+        std::vector<FSize> groupsOffset;
+        if(CanCreateLeavesInParallel(tree) && omp_get_max_threads() > 1){
+            const int NbLevels = tree->getHeight();
+            // The sub-octrees start at levels 1, 1 + subHeight, 1 + 2 subHeight...
+            for(int groupLevel = 1 + tree->getSubHeight() ; groupLevel <= NbLevels - 1 ; groupLevel += tree->getSubHeight()){
+                // The leaves in the same sub-octree have the same parent at groupLevel-1
+                const int shift = 3 * (NbLevels - groupLevel);
+                groupsOffset.clear();
+                for(FSize idxLeaf = 0 ; idxLeaf < numberOfLeaves ; ++idxLeaf){
+                    if(idxLeaf == 0 || (leavesDescriptor[idxLeaf].mindex >> shift) != (leavesDescriptor[idxLeaf-1].mindex >> shift)){
+                        groupsOffset.push_back(idxLeaf);
+                    }
+                }
+                if(FSize(groupsOffset.size()) >= 4 * omp_get_max_threads()){
+                    break;
+                }
+            }
+        }
 
-        // Store the size of each leaves
-        std::unique_ptr<LeafDescriptor[]> leavesDescriptor(new LeafDescriptor[numberOfLeaves]);
-        memset(leavesDescriptor.get(), 0, sizeof(LeafDescriptor)*(numberOfLeaves));
-        {
-            //Init
-            int currentLeafIndex = -1;
-            MortonIndex currentMortonIndex = -1;
-
-            for(FSize idxParts = 0 ; idxParts < numberOfParticle ; ++idxParts){
-                // If not the same leaf
-                if(particleIndexes[idxParts].mindex != currentMortonIndex){
-                    FAssertLF(FSize(currentLeafIndex) < numberOfLeaves);
-                    // Move to next descriptor
-                    currentLeafIndex  += 1;
-                    currentMortonIndex = particleIndexes[idxParts].mindex;
-                    // Fill the descriptor
-                    leavesDescriptor[currentLeafIndex].offsetInArray = idxParts;
-                    leavesDescriptor[currentLeafIndex].leafPtr = tree->createLeaf(currentMortonIndex);
-                    leavesDescriptor[currentLeafIndex].nbParticlesInLeaf = 0;
+        if(groupsOffset.size() > 1){
+            groupsOffset.push_back(numberOfLeaves);
+            const FSize nbGroups = FSize(groupsOffset.size()) - 1;
+            // The first leaf of each group creates the sub-octrees above the group
+            for(FSize idxGroup = 0 ; idxGroup < nbGroups ; ++idxGroup){
+                LeafDescriptor& descriptor = leavesDescriptor[groupsOffset[idxGroup]];
+                descriptor.leafPtr = tree->createLeaf(descriptor.mindex);
+            }
+            #pragma omp parallel for schedule(dynamic, 1)
+            for(FSize idxGroup = 0 ; idxGroup < nbGroups ; ++idxGroup){
+                for(FSize idxLeaf = groupsOffset[idxGroup] + 1 ; idxLeaf < groupsOffset[idxGroup+1] ; ++idxLeaf){
+                    leavesDescriptor[idxLeaf].leafPtr = tree->createLeaf(leavesDescriptor[idxLeaf].mindex);
                 }
-                // Inc the number of particles in the current leaf
-                leavesDescriptor[currentLeafIndex].nbParticlesInLeaf += 1;
+            }
+        }
+        else{
+            for(FSize idxLeaf = 0 ; idxLeaf < numberOfLeaves ; ++idxLeaf){
+                leavesDescriptor[idxLeaf].leafPtr = tree->createLeaf(leavesDescriptor[idxLeaf].mindex);
             }
         }
 
-        FLOG(leavesOffset.tac());
-        FLOG(FLog::Controller << "Time needed for setting the offset of each leaves : "<< leavesOffset.elapsed() << " secondes !\n");
-        //Then, we create the leaves inside the tree
+        FLOG(createTimer.tac());
+        FLOG(FLog::Controller << "Time needed for creating the leaves (" << (groupsOffset.size() > 1 ? groupsOffset.size() - 1 : 0)
+             << " parallel groups) : "<< createTimer.elapsed() << " secondes !\n");
+        return leavesDescriptor;
+    }
 
-        ////////////////////////////////////////////////////////////////
-        ////////////////////////////////////////////////////////////////
-        /// Insert multiple particles inside their corresponding leaf
-        ////////////////////////////////////////////////////////////////
+    /**
+     * Give the particles of each leaf to appendParticles, in parallel.
+     * @param appendParticles is called as appendParticles(leaf, leafParticles, nbParticlesInLeaf)
+     * where leafParticles are the IndexedParticle of the leaf
+     */
+    template <class AppendFunctionClass>
+    static void AppendToLeaves(const std::vector<LeafDescriptor>& leavesDescriptor, const IndexedParticle particleIndexes[],
+                               AppendFunctionClass&& appendParticles){
+        FLOG(FTic insertTimer);
+        const FSize numberOfLeaves = FSize(leavesDescriptor.size());
+
+        #pragma omp parallel for schedule(dynamic, 64)
+        for(FSize idxLeaf = 0 ; idxLeaf < numberOfLeaves ; ++idxLeaf ){
+            appendParticles(leavesDescriptor[idxLeaf].leafPtr, &particleIndexes[leavesDescriptor[idxLeaf].offsetInArray],
+                            leavesDescriptor[idxLeaf].nbParticlesInLeaf);
+        }
 
-        FLOG(insertTimer.tic());
+        FLOG(insertTimer.tac());
+        FLOG(FLog::Controller << "Time needed for inserting the parts into the leaves : "<< insertTimer.elapsed() << " secondes !\n");
+    }
 
-        // Copy each parts into corresponding Leaf
-        #pragma omp parallel
-        {
-            std::array<AttributeClass, NbAttributes> particleAttr;
+    /**
+     * Reserve the exact space in each leaf and push the particles, in parallel.
+     * The targets are reserved only if they are the same container as the sources
+     * (with two containers the inserter decides where each particle goes).
+     * @param pushParticle is called as pushParticle(leaf, idxParticle)
+     */
+    template <class PushFunctionClass>
+    static void FillLeaves(const std::vector<LeafDescriptor>& leavesDescriptor, const IndexedParticle particleIndexes[],
+                           PushFunctionClass&& pushParticle){
+        AppendToLeaves(leavesDescriptor, particleIndexes, [&](LeafClass*const leaf, const IndexedParticle leafParticles[],
+                                                              const FSize nbParticlesInLeaf){
+            if(leaf->getSrc() == leaf->getTargets()){
+                // Reserve the space needed for the new particles
+                leaf->getSrc()->reserve(leaf->getSrc()->getNbParticles() + nbParticlesInLeaf);
+            }
 
-            const FReal*const partX = particlesContainers.getPositions()[0];
-            const FReal*const partY = particlesContainers.getPositions()[1];
-            const FReal*const partZ = particlesContainers.getPositions()[2];
+            for(FSize idxPart = 0 ; idxPart < nbParticlesInLeaf ; ++idxPart){
+                pushParticle(leaf, leafParticles[idxPart].particlePositionInArray);
+            }
+        });
+    }
 
-            #pragma omp for schedule(static)
-            for(FSize idxLeaf = 0 ; idxLeaf < numberOfLeaves ; ++idxLeaf ){
-                const FSize nbParticlesAlreadyInLeaf = leavesDescriptor[idxLeaf].leafPtr->getSrc()->getNbParticles();
-                // Reserve the space needed for the new particles
-                leavesDescriptor[idxLeaf].leafPtr->getSrc()->reserve(nbParticlesAlreadyInLeaf + leavesDescriptor[idxLeaf].nbParticlesInLeaf);
-
-                // For all particles
-                for(FSize idxPart = 0 ; idxPart < leavesDescriptor[idxLeaf].nbParticlesInLeaf ; ++idxPart){
-                    // Get position in the original container
-                    const FSize particleOriginalPos = particleIndexes[leavesDescriptor[idxLeaf].offsetInArray + idxPart].particlePositionInArray;
-                    // Get the original position
-                    FPoint<FReal> particlePos( partX[particleOriginalPos],
-                                        partY[particleOriginalPos],
-                                        partZ[particleOriginalPos]);
-                    // Copy the attributes
+public:
+
+    /** Should be used to insert a FBasicParticleContainer class */
+    template < unsigned NbAttributes, class AttributeClass>
+    static void BuildTreeFromArray(OctreeClass*const tree, const FBasicParticleContainer<FReal, NbAttributes, AttributeClass>& particlesContainers,
+                                   bool isAlreadySorted=false){
+        const FSize numberOfParticle = particlesContainers.getNbParticles();
+        const FReal*const partX = particlesContainers.getPositions()[0];
+        const FReal*const partY = particlesContainers.getPositions()[1];
+        const FReal*const partZ = particlesContainers.getPositions()[2];
+
+        std::unique_ptr<IndexedParticle[]> particleIndexes = SortParticles(tree, numberOfParticle, [&](const FSize idxPart){
+            return FPoint<FReal>(partX[idxPart], partY[idxPart], partZ[idxPart]);
+        }, isAlreadySorted);
+
+        const std::vector<LeafDescriptor> leavesDescriptor = CreateLeaves(tree, particleIndexes.get(), numberOfParticle);
+
+        const FReal* const positions[3] = {partX, partY, partZ};
+        const AttributeClass* attributes[NbAttributes];
+        for(unsigned idxAttr = 0 ; idxAttr < NbAttributes; ++idxAttr){
+            attributes[idxAttr] = particlesContainers.getAttribute(idxAttr);
+        }
+
+        AppendToLeaves(leavesDescriptor, particleIndexes.get(), [&](LeafClass*const leaf, const IndexedParticle leafParticles[],
+                                                                    const FSize nbParticlesInLeaf){
+            static_assert(std::remove_pointer<decltype(leaf->getSrc())>::type::AttributeCount == NbAttributes,
+                          "The leaves must have the attributes of the array");
+            if(leaf->getSrc() == leaf->getTargets()){
+                // One allocation and one copy per attribute array
+                leaf->getSrc()->appendGathered(nbParticlesInLeaf, [leafParticles](const FSize idxPart){
+                    return leafParticles[idxPart].particlePositionInArray;
+                }, positions, attributes);
+            }
+            else{
+                // The leaf decides where each particle goes
+                for(FSize idxPart = 0 ; idxPart < nbParticlesInLeaf ; ++idxPart){
+                    const FSize particleOriginalPos = leafParticles[idxPart].particlePositionInArray;
+                    std::array<AttributeClass, NbAttributes> particleAttr;
                     for(unsigned idxAttr = 0 ; idxAttr < NbAttributes; ++idxAttr){
-                        particleAttr[idxAttr] = particlesContainers.getAttribute(idxAttr)[particleOriginalPos];
+                        particleAttr[idxAttr] = attributes[idxAttr][particleOriginalPos];
                     }
-                    // Push the particle in the array
-                    leavesDescriptor[idxLeaf].leafPtr->push(particlePos, particleAttr);
+                    leaf->push(FPoint<FReal>(partX[particleOriginalPos], partY[particleOriginalPos], partZ[particleOriginalPos]), particleAttr);
                 }
             }
-        }
+        });
+    }
 
-        FLOG(insertTimer.tac());
-        FLOG(FLog::Controller << "Time needed for inserting the parts into the leaves : "<< insertTimer.elapsed() << " secondes !\n");
+    /**
+     * Insert an array of particles of any type in the tree, for example the particles
+     * given by FMpiTreeBuilder::DistributeArrayToContainer. It works with any leaf and container.
+     * The particles must have a getPosition() method, and the inserter is called as
+     * inserter(leaf, particle) to push a particle with its attributes :
+     * @code
+     * FTreeBuilder<FReal, OctreeClass, LeafClass>::BuildTreeFromParticles(&tree, finalParticles.data(), finalParticles.getSize(),
+     *         [](LeafClass* leaf, const TestParticle& particle){
+     *             leaf->push(particle.position, particle.index, particle.physicalValue);
+     *         });
+     * @endcode
+     * @param particles the particles (not modified)
+     * @param nbParticles the number of particles
+     * @param inserter the function to push a particle in a leaf
+     * @param isAlreadySorted true if the particles are already in Morton order
+     */
+    template <class ParticleClass, class InserterClass>
+    static void BuildTreeFromParticles(OctreeClass*const tree, ParticleClass particles[], const FSize nbParticles,
+                                       InserterClass&& inserter, const bool isAlreadySorted = false){
+        std::unique_ptr<IndexedParticle[]> particleIndexes = SortParticles(tree, nbParticles, [&](const FSize idxPart){
+            return FPoint<FReal>(particles[idxPart].getPosition());
+        }, isAlreadySorted);
+
+        const std::vector<LeafDescriptor> leavesDescriptor = CreateLeaves(tree, particleIndexes.get(), nbParticles);
+
+        FillLeaves(leavesDescriptor, particleIndexes.get(), [&](LeafClass* leaf, const FSize particleOriginalPos){
+            inserter(leaf, particles[particleOriginalPos]);
+        });
     }
 };
 
@@ -5,6 +5,7 @@
 
 #include "Utils/FAssert.hpp"
 #include "Utils/FAlignedMemory.hpp"
+#include "Utils/FOutOfCoreMemory.hpp"
 #include "Containers/FTreeCoordinate.hpp"
 #include "../StarPUUtils/FStarPUDefaultAlign.hpp"
 
@@ -70,10 +71,10 @@ public:
                 (&cellLocals[idxCellPtr])->~LocalCellClass();
 #endif
             }
-            FAlignedMemory::DeallocBytes(memoryBuffer);
+            FOutOfCoreMemory::DeallocBytes(memoryBuffer);
 #ifndef SCALFMM_SIMGRID_NODATA
-            FAlignedMemory::DeallocBytes(cellMultipoles);
-            FAlignedMemory::DeallocBytes(cellLocals);
+            FOutOfCoreMemory::DeallocBytes(cellMultipoles);
+            FOutOfCoreMemory::DeallocBytes(cellLocals);
 #endif
         }
         // Move the pointers to the correct position
@@ -140,7 +141,7 @@ public:
         // Allocate
         FAssertLF(0 <= int(memoryToAlloc) && int(memoryToAlloc) < std::numeric_limits<int>::max());
         allocatedMemoryInByte = memoryToAlloc;
-        memoryBuffer = (unsigned char*)FAlignedMemory::AllocateBytes<32>(memoryToAlloc);
+        memoryBuffer = (unsigned char*)FOutOfCoreMemory::AllocateBytes<32>(memoryToAlloc);
         FAssertLF(memoryBuffer);
         memset(memoryBuffer, 0, memoryToAlloc);
 
@@ -161,8 +162,8 @@ public:
         blockHeader->idxGlobal             = -1;
         blockHeader->isMine                = false;
 #ifndef SCALFMM_SIMGRID_NODATA
-        cellMultipoles = (PoleCellClass*)FAlignedMemory::AllocateBytes<32>(inNumberOfCells*sizeof(PoleCellClass));
-        cellLocals     = (LocalCellClass*)FAlignedMemory::AllocateBytes<32>(inNumberOfCells*sizeof(LocalCellClass));
+        cellMultipoles = (PoleCellClass*)FOutOfCoreMemory::AllocateBytes<32>(inNumberOfCells*sizeof(PoleCellClass));
+        cellLocals     = (LocalCellClass*)FOutOfCoreMemory::AllocateBytes<32>(inNumberOfCells*sizeof(LocalCellClass));
 #endif
         for(int idxCell = 0 ; idxCell < inNumberOfCells ; ++idxCell){
 #ifndef SCALFMM_SIMGRID_NODATA
@@ -183,10 +184,10 @@ public:
                 (&cellLocals[idxCellPtr])->~LocalCellClass();
 #endif
             }
-            FAlignedMemory::DeallocBytes(memoryBuffer);
+            FOutOfCoreMemory::DeallocBytes(memoryBuffer);
 #ifndef SCALFMM_SIMGRID_NODATA
-            FAlignedMemory::DeallocBytes(cellMultipoles);
-            FAlignedMemory::DeallocBytes(cellLocals);
+            FOutOfCoreMemory::DeallocBytes(cellMultipoles);
+            FOutOfCoreMemory::DeallocBytes(cellLocals);
 #endif
         }
     }
@@ -252,6 +253,15 @@ public:
         return deleteBuffer;
     }
 
+    /** Ask to read the buffers in advance if they are out of core (see FOutOfCoreMemory) */
+    void prefetch() const {
+        FOutOfCoreMemory::Prefetch(memoryBuffer);
+#ifndef SCALFMM_SIMGRID_NODATA
+        FOutOfCoreMemory::Prefetch(cellMultipoles);
+        FOutOfCoreMemory::Prefetch(cellLocals);
+#endif
+    }
+
     /** The index of the fist cell (set from the constructor) */
     MortonIndex getStartingIndex() const {
         return blockHeader->startingIndex;
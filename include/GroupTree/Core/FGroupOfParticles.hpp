@@ -8,6 +8,7 @@
 #include "Utils/FAssert.hpp"
 #include "Containers/FTreeCoordinate.hpp"
 #include "Utils/FAlignedMemory.hpp"
+#include "Utils/FOutOfCoreMemory.hpp"
 #include "GroupTree/StarPUUtils/FStarPUDefaultAlign.hpp"
 
 #include <list>
@@ -150,7 +151,7 @@ public:
         // Allocate
         FAssertLF(0 <= int(memoryToAlloc) && int(memoryToAlloc) < std::numeric_limits<int>::max());
         allocatedMemoryInByte = memoryToAlloc;
-        memoryBuffer = (unsigned char*)FAlignedMemory::AllocateBytes<MemoryAlignementBytes>(memoryToAlloc);
+        memoryBuffer = (unsigned char*)FOutOfCoreMemory::AllocateBytes<MemoryAlignementBytes>(memoryToAlloc);
         FAssertLF(memoryBuffer);
         memset(memoryBuffer, 0, memoryToAlloc);
 
@@ -185,7 +186,7 @@ public:
             symAttributes += blockHeader->nbParticlesAllocatedInGroup;
         }
 #ifndef SCALFMM_SIMGRID_NODATA
-        attributesBuffer = (AttributeClass*)FAlignedMemory::AllocateBytes<MemoryAlignementBytes>(blockHeader->attributeLeadingDim*NbAttributesPerParticle);
+        attributesBuffer = (AttributeClass*)FOutOfCoreMemory::AllocateBytes<MemoryAlignementBytes>(blockHeader->attributeLeadingDim*NbAttributesPerParticle);
         memset(attributesBuffer, 0, blockHeader->attributeLeadingDim*NbAttributesPerParticle);
         for(unsigned idxAttribute = 0 ; idxAttribute < NbAttributesPerParticle ; ++idxAttribute){
             particleAttributes[idxAttribute+NbSymbAttributes] = &attributesBuffer[idxAttribute*nbParticlesAllocatedInGroup];
@@ -203,8 +204,8 @@ public:
     /** Call the destructor of leaves and dealloc block memory */
     ~FGroupOfParticles(){
         if(deleteBuffer){
-            FAlignedMemory::DeallocBytes(memoryBuffer);
-            FAlignedMemory::DeallocBytes(attributesBuffer);
+            FOutOfCoreMemory::DeallocBytes(memoryBuffer);
+            FOutOfCoreMemory::DeallocBytes(attributesBuffer);
         }
     }
 
@@ -238,6 +239,12 @@ public:
         return deleteBuffer;
     }
 
+    /** Ask to read the buffers in advance if they are out of core (see FOutOfCoreMemory) */
+    void prefetch() const {
+        FOutOfCoreMemory::Prefetch(memoryBuffer);
+        FOutOfCoreMemory::Prefetch(attributesBuffer);
+    }
+
     /** The index of the fist leaf (set from the constructor) */
     MortonIndex getStartingIndex() const {
         return blockHeader->startingIndex;
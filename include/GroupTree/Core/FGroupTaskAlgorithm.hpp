@@ -117,6 +117,17 @@ protected:
         Timers[P2MTimer].tac();
     }
 
+    /**
+     * Ask to read the blocks of a task in advance when the tree is out of core
+     * (see FOutOfCoreMemory), it does nothing else. It is called when the task
+     * is created, the creation of the tasks of a pass runs ahead of their execution.
+     */
+    template <class... GroupClasses>
+    static void PrefetchGroups(const GroupClasses*... groups){
+        auto l = {(groups->prefetch(), 0)...};
+        (void)l;
+    }
+
     /**
      * This function is creating the interactions vector between blocks.
      * It fills externalInteractionsAllLevel and externalInteractionsLeafLevel.
@@ -336,6 +347,7 @@ protected:
         for(int idxGroup = 0 ; idxGroup < tree->getNbParticleGroup() ; ++idxGroup){
             CellContainerClass* leafCells  = tree->getCellGroup(tree->getHeight()-1, idxGroup);
             ParticleGroupClass* containers = tree->getParticleGroup(idxGroup);
+            PrefetchGroups(leafCells, containers);
             #pragma omp task default(shared) firstprivate(leafCells, containers)
             {
                 KernelClass*const kernel = kernels[omp_get_thread_num()];
@@ -392,6 +404,10 @@ protected:
                     nbSubCellGroups += 1;
                 }
 
+                PrefetchGroups(currentCells);
+                for(int idxSubCellGroup = 0 ; idxSubCellGroup < nbSubCellGroups ; ++idxSubCellGroup){
+                    PrefetchGroups(subCellGroups[idxSubCellGroup]);
+                }
                 #pragma omp task default(none) firstprivate(idxLevel, currentCells, subCellGroups, nbSubCellGroups, kernels)
                 {
                     KernelClass*const kernel = kernels[omp_get_thread_num()];
@@ -467,6 +483,7 @@ protected:
                 while(iterCells != endCells){
                     CellContainerClass* currentCells = (*iterCells);
 
+                    PrefetchGroups(currentCells);
                     #pragma omp task default(none) firstprivate(currentCells, idxLevel, kernels)
                     {
                         const MortonIndex blockStartIdx = currentCells->getStartingIndex();
@@ -542,6 +559,7 @@ protected:
                         CellContainerClass* cellsOther = (*currentInteractions).otherBlock;
                         const std::vector<OutOfBlockInteraction>* outsideInteractions = &(*currentInteractions).interactions;
 
+                        PrefetchGroups(currentCells, cellsOther);
                         #pragma omp task default(none) firstprivate(currentCells, outsideInteractions, cellsOther, idxLevel, kernels)
                         {
                             KernelClass*const kernel = kernels[omp_get_thread_num()];
@@ -637,6 +655,10 @@ protected:
                     nbSubCellGroups += 1;
                 }
 
+                PrefetchGroups(currentCells);
+                for(int idxSubCellGroup = 0 ; idxSubCellGroup < nbSubCellGroups ; ++idxSubCellGroup){
+                    PrefetchGroups(subCellGroups[idxSubCellGroup]);
+                }
                 #pragma omp task default(none) firstprivate(idxLevel, currentCells, subCellGroups, nbSubCellGroups, kernels)
                 {
                     KernelClass*const kernel = kernels[omp_get_thread_num()];
@@ -712,6 +734,7 @@ protected:
                 // getting the height first, or making 'tree' shared both
                 // workaround it.
                 OctreeClass * const treeAlias = tree;
+                PrefetchGroups(containers);
                 #pragma omp task default(none) firstprivate(containers, kernels, treeAlias)
                 {
                     const MortonIndex blockStartIdx = containers->getStartingIndex();
@@ -768,6 +791,7 @@ protected:
                     ParticleGroupClass* containersOther = (*currentInteractions).otherBlock;
                     const std::vector<OutOfBlockInteraction>* outsideInteractions = &(*currentInteractions).interactions;
 
+                    PrefetchGroups(containers, containersOther);
                     #pragma omp task default(none) firstprivate(containers, containersOther, outsideInteractions, kernels)
                     {
                         KernelClass*const kernel = kernels[omp_get_thread_num()];
@@ -810,6 +834,7 @@ protected:
         for(int idxGroup = 0 ; idxGroup < tree->getNbParticleGroup() ; ++idxGroup){
             CellContainerClass* leafCells  = tree->getCellGroup(tree->getHeight()-1, idxGroup);
             ParticleGroupClass* containers = tree->getParticleGroup(idxGroup);
+            PrefetchGroups(leafCells, containers);
             #pragma omp task default(shared) firstprivate(leafCells, containers, kernels)
             {
                 KernelClass*const kernel = kernels[omp_get_thread_num()];
@@ -172,6 +172,17 @@ protected:
         FTIME_TASKS(taskTimeRecorder.saveToDisk("/tmp/taskstime-FGroupTaskDepAlgorithm.txt"));
     }
 
+    /**
+     * Ask to read the blocks in advance when the tree is out of core (see
+     * FOutOfCoreMemory), it does nothing else. All the tasks are created at
+     * once, so a task prefetches its own blocks and the next group of the same
+     * pass (nullptr if there is none), which is read while it works.
+     */
+    template <class... GroupClasses>
+    static void PrefetchGroups(const GroupClasses*... groups){
+        auto l = {(groups ? groups->prefetch() : void(), 0)...};
+        (void)l;
+    }
 
     /**
      * This function is creating the interactions vector between blocks.
@@ -383,8 +394,11 @@ protected:
 
             ParticleGroupClass* containers = tree->getParticleGroup(idxGroup);
 
-            #pragma omp task default(shared) firstprivate(leafCells, cellPoles, containers) depend(inout: cellPoles[0]) priority_if_supported(priorities.getInsertionPosP2M()) taskname_if_supported("P2M")
+            CellContainerClass* nextLeafCells = (idxGroup+1 < tree->getNbParticleGroup() ? tree->getCellGroup(tree->getHeight()-1, idxGroup+1) : nullptr);
+            ParticleGroupClass* nextContainers = (idxGroup+1 < tree->getNbParticleGroup() ? tree->getParticleGroup(idxGroup+1) : nullptr);
+            #pragma omp task default(shared) firstprivate(leafCells, cellPoles, containers, nextLeafCells, nextContainers) depend(inout: cellPoles[0]) priority_if_supported(priorities.getInsertionPosP2M()) taskname_if_supported("P2M")
             {
+                PrefetchGroups(leafCells, containers, nextLeafCells, nextContainers);
                 FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, leafCells->getStartingIndex() * 20 * 8, "P2M"));
                 KernelClass*const kernel = kernels[omp_get_thread_num()];
 
@@ -433,8 +447,10 @@ protected:
                     subCellGroup = (*iterChildCells);
                     subCellGroupPoles = (*iterChildCells)->getRawMultipoleBuffer();
 
-                    #pragma omp task default(none) firstprivate(idxLevel, currentCells, cellPoles, subCellGroup, subCellGroupPoles) depend(commute_if_supported: cellPoles[0]) depend(in: subCellGroupPoles[0]) priority_if_supported(priorities.getInsertionPosM2M(idxLevel)) taskname_if_supported("M2M")
+                    CellContainerClass* nextSubCellGroup = (iterChildCells+1 != endChildCells ? *(iterChildCells+1) : nullptr);
+                    #pragma omp task default(none) firstprivate(idxLevel, currentCells, cellPoles, subCellGroup, subCellGroupPoles, nextSubCellGroup) depend(commute_if_supported: cellPoles[0]) depend(in: subCellGroupPoles[0]) priority_if_supported(priorities.getInsertionPosM2M(idxLevel)) taskname_if_supported("M2M")
                     {
+                        PrefetchGroups(currentCells, subCellGroup, nextSubCellGroup);
                         KernelClass*const kernel = kernels[omp_get_thread_num()];
                         const MortonIndex firstParent = FMath::Max(currentCells->getStartingIndex(), subCellGroup->getStartingIndex()>>3);
                         const MortonIndex lastParent = FMath::Min(currentCells->getEndingIndex()-1, (subCellGroup->getEndingIndex()-1)>>3);
@@ -525,8 +541,10 @@ protected:
                     PoleCellClass* cellPoles = currentCells->getRawMultipoleBuffer();
                     LocalCellClass* cellLocals = currentCells->getRawLocalBuffer();
 
-#pragma omp task default(none) firstprivate(currentCells, cellPoles, cellLocals, idxLevel) depend(commute_if_supported: cellLocals[0]) depend(in: cellPoles[0])  priority_if_supported(priorities.getInsertionPosM2L(idxLevel)) taskname_if_supported("M2L")
+                    CellContainerClass* nextCells = (iterCells+1 != endCells ? *(iterCells+1) : nullptr);
+#pragma omp task default(none) firstprivate(currentCells, cellPoles, cellLocals, idxLevel, nextCells) depend(commute_if_supported: cellLocals[0]) depend(in: cellPoles[0])  priority_if_supported(priorities.getInsertionPosM2L(idxLevel)) taskname_if_supported("M2L")
                     {
+                        PrefetchGroups(currentCells, nextCells);
                         FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, ((currentCells->getStartingIndex() *20) + idxLevel ) * 8 + 2, "M2L"));
                         const MortonIndex blockStartIdx = currentCells->getStartingIndex();
                         const MortonIndex blockEndIdx   = currentCells->getEndingIndex();
@@ -606,6 +624,7 @@ protected:
 
                         #pragma omp task default(none) firstprivate(currentCells, cellLocals, outsideInteractions, cellsOther, cellOtherPoles, idxLevel) depend(commute_if_supported: cellLocals[0]) depend(in: cellOtherPoles[0])  priority_if_supported(priorities.getInsertionPosM2LExtern(idxLevel)) taskname_if_supported("M2L-out")
                         {
+                            PrefetchGroups(currentCells, cellsOther);
                             FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, (((currentCells->getStartingIndex()+1) * (cellsOther->getStartingIndex()+2)) * 20 + idxLevel) * 8 + 3, "M2L-ext"));
                             KernelClass*const kernel = kernels[omp_get_thread_num()];
 
@@ -640,6 +659,7 @@ protected:
 
                         #pragma omp task default(none) firstprivate(currentCells, cellPoles, outsideInteractions, cellsOther, cellOtherLocals, idxLevel) depend(commute_if_supported: cellOtherLocals[0]) depend(in: cellPoles[0])  priority_if_supported(priorities.getInsertionPosM2LExtern(idxLevel)) taskname_if_supported("M2L-out")
                         {
+                            PrefetchGroups(currentCells, cellsOther);
                             FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, (((currentCells->getStartingIndex()+1) * (cellsOther->getStartingIndex()+1)) * 20 + idxLevel) * 8 + 3, "M2L-ext"));
                             KernelClass*const kernel = kernels[omp_get_thread_num()];
 
@@ -713,10 +733,12 @@ protected:
                 while(true){
                     subCellGroup = (*iterChildCells);
                     subCellLocalGroupsLocal = (*iterChildCells)->getRawLocalBuffer();
+                    CellContainerClass* nextSubCellGroup = (iterChildCells+1 != endChildCells ? *(iterChildCells+1) : nullptr);
 
                     if(noCommuteAtLastLevel == false || idxLevel != FAbstractAlgorithm::lowerWorkingLevel - 2){
-                        #pragma omp task default(none) firstprivate(idxLevel, currentCells, cellLocals, subCellGroup, subCellLocalGroupsLocal) depend(commute_if_supported: subCellLocalGroupsLocal[0]) depend(in: cellLocals[0])  priority_if_supported(priorities.getInsertionPosL2L(idxLevel)) taskname_if_supported("L2L")
+                        #pragma omp task default(none) firstprivate(idxLevel, currentCells, cellLocals, subCellGroup, subCellLocalGroupsLocal, nextSubCellGroup) depend(commute_if_supported: subCellLocalGroupsLocal[0]) depend(in: cellLocals[0])  priority_if_supported(priorities.getInsertionPosL2L(idxLevel)) taskname_if_supported("L2L")
                         {
+                            PrefetchGroups(currentCells, subCellGroup, nextSubCellGroup);
                             KernelClass*const kernel = kernels[omp_get_thread_num()];
 
                             const MortonIndex firstParent = FMath::Max(currentCells->getStartingIndex(), subCellGroup->getStartingIndex()>>3);
@@ -778,8 +800,9 @@ protected:
                         }
                     }
                     else{
-                        #pragma omp task default(none) firstprivate(idxLevel, currentCells, cellLocals, subCellGroup, subCellLocalGroupsLocal) depend(inout: subCellLocalGroupsLocal[0]) depend(in: cellLocals[0])  priority_if_supported(priorities.getInsertionPosL2L(idxLevel)) taskname_if_supported("L2L")
+                        #pragma omp task default(none) firstprivate(idxLevel, currentCells, cellLocals, subCellGroup, subCellLocalGroupsLocal, nextSubCellGroup) depend(inout: subCellLocalGroupsLocal[0]) depend(in: cellLocals[0])  priority_if_supported(priorities.getInsertionPosL2L(idxLevel)) taskname_if_supported("L2L")
                         {
+                            PrefetchGroups(currentCells, subCellGroup, nextSubCellGroup);
                             KernelClass*const kernel = kernels[omp_get_thread_num()];
 
                             const MortonIndex firstParent = FMath::Max(currentCells->getStartingIndex(), subCellGroup->getStartingIndex()>>3);
@@ -887,6 +910,7 @@ protected:
 
 #pragma omp task default(none) firstprivate(containers, containersDown, containersOther, containersOtherDown, outsideInteractions) depend(commute_if_supported: containersOtherDown[0], containersDown[0])  priority_if_supported(priorities.getInsertionPosP2PExtern()) taskname_if_supported("P2P-out")
                     {
+                        PrefetchGroups(containers, containersOther);
                         FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, ((containersOther->getStartingIndex()+1) * (containers->getStartingIndex()+1))*20*8 + 6, "P2P-ext"));
                         KernelClass*const kernel = kernels[omp_get_thread_num()];
                         for(int outInterIdx = 0 ; outInterIdx < int(outsideInteractions->size()) ; ++outInterIdx){
@@ -923,8 +947,10 @@ protected:
                 ParticleGroupClass* containers = (*iterParticles);
                 unsigned char* containersDown = containers->getRawAttributesBuffer();
 
-                #pragma omp task default(none) firstprivate(containers, containersDown) depend(commute_if_supported: containersDown[0])  priority_if_supported(priorities.getInsertionPosP2P()) taskname_if_supported("P2P")
+                ParticleGroupClass* nextContainers = (iterParticles+1 != endParticles ? *(iterParticles+1) : nullptr);
+                #pragma omp task default(none) firstprivate(containers, containersDown, nextContainers) depend(commute_if_supported: containersDown[0])  priority_if_supported(priorities.getInsertionPosP2P()) taskname_if_supported("P2P")
                 {
+                    PrefetchGroups(containers, nextContainers);
                     FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, containers->getStartingIndex()*20*8 + 5, "P2P"));
                     const MortonIndex blockStartIdx = containers->getStartingIndex();
                     const MortonIndex blockEndIdx = containers->getEndingIndex();
@@ -978,8 +1004,11 @@ protected:
             ParticleGroupClass* containers = tree->getParticleGroup(idxGroup);
             unsigned char* containersDown = containers->getRawAttributesBuffer();
 
-            #pragma omp task default(shared) firstprivate(leafCells, cellLocals, containers, containersDown) depend(commute_if_supported: containersDown[0]) depend(in: cellLocals[0])  priority_if_supported(priorities.getInsertionPosL2P()) taskname_if_supported("L2P")
+            CellContainerClass* nextLeafCells = (idxGroup+1 < tree->getNbParticleGroup() ? tree->getCellGroup(tree->getHeight()-1, idxGroup+1) : nullptr);
+            ParticleGroupClass* nextContainers = (idxGroup+1 < tree->getNbParticleGroup() ? tree->getParticleGroup(idxGroup+1) : nullptr);
+            #pragma omp task default(shared) firstprivate(leafCells, cellLocals, containers, containersDown, nextLeafCells, nextContainers) depend(commute_if_supported: containersDown[0]) depend(in: cellLocals[0])  priority_if_supported(priorities.getInsertionPosL2P()) taskname_if_supported("L2P")
             {
+                PrefetchGroups(leafCells, containers, nextLeafCells, nextContainers);
                 FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, (leafCells->getStartingIndex()*20*8) + 7, "L2P"));
                 KernelClass*const kernel = kernels[omp_get_thread_num()];
 
@@ -40,19 +40,29 @@ public:
         }
 
         // to extend FAbstractSendable
+        // the buffer precision gives the wire format (see FBufferPrecision)
         template <class BufferWriterClass>
         void serialize(BufferWriterClass& buffer) const{
-            buffer.write(this->exp, VectorSize*NVALS*NRHS);
+            buffer.writeReals(this->exp, VectorSize*NVALS*NRHS);
         }
         template <class BufferReaderClass>
         void deserialize(BufferReaderClass& buffer){
-            buffer.fillArray(this->exp, VectorSize*NVALS*NRHS);
+            buffer.fillReals(this->exp, VectorSize*NVALS*NRHS);
         }
 
         void reset() {
             memset(this->exp, 0, sizeof(FReal) * N * NVALS * VectorSize);
         }
 
+        /// The data written by serialize in full precision, getSavedSize() bytes
+        /// (used to send the expansions in place with MPI derived datatypes)
+        const void* getContiguousData() const {
+            return this->exp;
+        }
+        void* getContiguousData() {
+            return this->exp;
+        }
+
         FSize getSavedSize() const {
             return FSize(sizeof(FReal)) * VectorSize * N * NVALS;
         }
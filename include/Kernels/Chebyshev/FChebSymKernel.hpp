@@ -68,7 +68,10 @@ protected:
 
 
     /**
-     * Allocate memory for storing locally permuted mulipole and local expansions
+     * Allocate memory for storing locally permuted mulipole and local expansions.
+     * This is the only per-kernel scratch, the interpolator and the M2L
+     * operators are shared by the copies. It is allocated at the first M2L so
+     * that the memory is touched by the thread which uses the kernel.
      */
     void allocateMemoryForPermutedExpansions()
     {
@@ -121,7 +124,6 @@ public:
           SymHandler(new SymmetryHandlerClass(MatrixKernel, Epsilon, inBoxWidth, inTreeHeight)),
           Loc(nullptr), Mul(nullptr), countExp(nullptr)
     {
-        this->allocateMemoryForPermutedExpansions();
 #ifdef LOG_TIMINGS
         t_m2l_1 = FReal(0.);
         t_m2l_2 = FReal(0.);
@@ -152,7 +154,13 @@ public:
           SymHandler(other.SymHandler),
           Loc(nullptr), Mul(nullptr), countExp(nullptr)
     {
-        this->allocateMemoryForPermutedExpansions();
+    }
+
+
+
+    /** The copies only share read-only data and allocate their scratch lazily */
+    constexpr static bool HasThreadSafeCopy(){
+        return true;
     }
 
 
@@ -160,7 +168,7 @@ public:
     /** Destructor */
     ~FChebSymKernel()
     {
-        for (unsigned int t=0; t<343; ++t) {
+        for (unsigned int t=0; Loc!=nullptr && t<343; ++t) {
             if (Loc[t]!=nullptr) delete [] Loc[t];
             if (Mul[t]!=nullptr) delete [] Mul[t];
         }
@@ -228,6 +236,8 @@ public:
              const int neighborPositions[],
              const int inSize)
     {
+        if (Loc==nullptr)
+            this->allocateMemoryForPermutedExpansions();
 #ifdef LOG_TIMINGS
         time.tic();
 #endif
@@ -3,6 +3,7 @@
 #ifndef FABSTRACTBALANCEALGORITHM_H
 #define FABSTRACTBALANCEALGORITHM_H
 
+#include "FGlobal.hpp"
 
 /**
  * @author Cyrille Piacibello
@@ -20,9 +21,9 @@ public:
    * @brief Give the right leaves (ie the min) of the interval that
    * will be handle by idxOfProc
    * @param numberOfLeaves Total number of leaves that exist.
-   * @param numberOfPartPerLeaf Array of lenght numberOfLeaves containing the number of particles in each leaf
+   * @param numberOfPartPerLeaf Array of length numberOfLeaves containing the number of particles in each leaf
    * @param numberOfPart Number of particles in the whole field
-   * @param idxOfLeaves Array of lenght numberOfLeaves containing the Morton Index of each Leaf
+   * @param idxOfLeaves Array of length numberOfLeaves containing the Morton Index of each Leaf
    * @param numberOfProc Number of MPI processus that will handle the Octree
    * @param idxOfProc Idx of the proc calling.
    */
@@ -33,15 +34,29 @@ public:
    * @brief Give the Leaft leaves (ie the max) of the interval that
    * will be handle by idxOfProc
    * @param numberOfLeaves Total number of leaves that exist.
-   * @param numberOfPartPerLeaf Array of lenght numberOfLeaves containing the number of particles in each leaf
+   * @param numberOfPartPerLeaf Array of length numberOfLeaves containing the number of particles in each leaf
    * @param numberOfPart Number of particles in the whole field
-   * @param idxOfLeaves Array of lenght numberOfLeaves containing the Morton Index of each Leaf
+   * @param idxOfLeaves Array of length numberOfLeaves containing the Morton Index of each Leaf
    * @param numberOfProc Number of MPI processus that will handle the Octree
    * @param idxOfProc Idx of the proc calling.
    */
   virtual FSize getLeft(const FSize numberOfLeaves,
                         const int numberOfProc, const int idxOfProc) = 0;
 
+  /**
+   * @brief Called by FMpiTreeBuilder::EqualizeAndFillContainer on all the
+   * processes before getLeft/getRight. The balancers that do not only use the
+   * number of leaves override it (it may use collective communications).
+   * @param leavesIndexes Array of length nbLeaves containing the Morton Index of each local leaf
+   * @param leavesOffsetInParticles Array of length nbLeaves+1, the particles of the leaf idx
+   * are [leavesOffsetInParticles[idx], leavesOffsetInParticles[idx+1][
+   * @param nbLeaves Number of local leaves
+   * @param firstLeaf Position of the first local leaf among all the leaves
+   */
+  virtual void setLocalLeaves(const MortonIndex /*leavesIndexes*/[], const FSize /*leavesOffsetInParticles*/[],
+                              const FSize /*nbLeaves*/, const FSize /*firstLeaf*/){
+  }
+
 };
 
 #endif //FABSTRACTBALANCEALGORITHM_H
@@ -10,6 +10,9 @@
 #include <sched.h>
 #include <sys/resource.h>
 #include <thread>
+#include <vector>
+
+#include <omp.h>
 
 namespace FBinding {
 
@@ -87,6 +90,63 @@ inline void BindThreadToAnyProcs(){
 #endif
 }
 
+/** Bind each OpenMP thread of the next parallel regions to one proc.
+  * The thread i is bound to the i-th proc of the current binding
+  * of the calling thread (round robin if there are more threads than procs).
+  * Return the number of threads that have been bound.
+  */
+inline int BindOmpThreads(){
+    int nbBoundThreads = 0;
+#ifdef FBINDING_ENABLE
+    const cpu_set_t mask = GetSystemBinding();
+    std::vector<int> procs;
+    for(int idxProc = 0 ; idxProc < int(sizeof(cpu_set_t)*8) ; ++idxProc){
+        if(CPU_ISSET(idxProc, &mask)){
+            procs.push_back(idxProc);
+        }
+    }
+    FAssertLF(procs.size() != 0);
+
+    #pragma omp parallel reduction(+:nbBoundThreads)
+    {
+        SetThreadBinding(procs[omp_get_thread_num() % procs.size()]);
+        nbBoundThreads += 1;
+    }
+#endif
+    return nbBoundThreads;
+}
+
+/** Return the NUMA node of the proc where the calling thread runs, -1 if unknown */
+inline int GetCurrentNumaNode(){
+#if defined(FBINDING_ENABLE) && defined(SYS_getcpu)
+    unsigned proc = 0;
+    unsigned node = 0;
+    if(syscall(SYS_getcpu, &proc, &node, nullptr) == 0){
+        return int(node);
+    }
+#endif
+    return -1;
+}
+
+/** Get the NUMA node of some pages of the process.
+  * inPages must contain page aligned addresses, outNodes receive
+  * the node of each page, or a negative value if the page has not been
+  * touched yet (-ENOENT) or cannot be queried.
+  * Return false if the system does not give this information.
+  */
+inline bool GetPagesNumaNodes(const long inNbPages, void** inPages, int* outNodes){
+#if defined(FBINDING_ENABLE) && defined(SYS_move_pages)
+    // Without target nodes move_pages does not move anything, it only gives the current nodes
+    if(inNbPages == 0 || syscall(SYS_move_pages, 0, inNbPages, inPages, nullptr, outNodes, 0) == 0){
+        return true;
+    }
+#endif
+    for(long idxPage = 0 ; idxPage < inNbPages ; ++idxPage){
+        outNodes[idxPage] = -1;
+    }
+    return false;
+}
+
 }
 
 #endif // FBINDING_HPP
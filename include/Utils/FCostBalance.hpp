@@ -0,0 +1,176 @@
+// See LICENCE file at project root
+
+#ifndef FCOSTBALANCE_H
+#define FCOSTBALANCE_H
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "./FAbstractBalanceAlgorithm.hpp"
+#include "./FMpi.hpp"
+#include "./FAssert.hpp"
+#include "./FMath.hpp"
+
+/**
+ * @class FCostBalance
+ *
+ * @brief This class inherits from FAbstractBalanceAlgorithm. It cuts the
+ * Morton curve so that each process gets the same cost, the cost of a leaf
+ * being given by a model or by measures.
+ *
+ * The model is p2pWeight*n^2 + particleWeight*n + leafWeight for a leaf of n
+ * particles : the P2P is roughly quadratic in the local density while the
+ * P2M/L2P are linear and the M2L cost of a leaf does not depend on n.
+ * The measured costs (for example the timers of the previous step) can be
+ * given with setMeasuredCosts, they replace the model for their leaves.
+ *
+ * The cuts are computed by setLocalLeaves, it is called by
+ * FMpiTreeBuilder::EqualizeAndFillContainer on all the processes.
+ */
+class FCostBalance : public FAbstractBalanceAlgorithm{
+public:
+    /** Give the cost of a leaf from its Morton index and its number of particles */
+    using CostFunction = std::function<double(const MortonIndex, const FSize)>;
+
+    /** The cost model with the given weights */
+    static CostFunction ModelCost(const double p2pWeight = 1.0, const double particleWeight = 0.0, const double leafWeight = 0.0){
+        return [=](const MortonIndex /*leafIndex*/, const FSize nbParticles){
+            return p2pWeight * double(nbParticles) * double(nbParticles) + particleWeight * double(nbParticles) + leafWeight;
+        };
+    }
+
+private:
+    const FMpi::FComm comm;
+    CostFunction costFunction;
+    std::vector<std::pair<MortonIndex,double>> measuredCosts; //< sorted by index
+    std::vector<FSize> boundaries;  //< The first leaf of each process and the number of leaves
+    double maxCostPerProc;          //< The greatest cost given to a process
+    double totalCost;
+
+    double getLeafCost(const MortonIndex leafIndex, const FSize nbParticles) const {
+        const auto measured = std::lower_bound(measuredCosts.begin(), measuredCosts.end(), std::make_pair(leafIndex, 0.0),
+                                               [](const std::pair<MortonIndex,double>& v1, const std::pair<MortonIndex,double>& v2){
+            return v1.first < v2.first;
+        });
+        if(measured != measuredCosts.end() && measured->first == leafIndex){
+            return measured->second;
+        }
+        return costFunction(leafIndex, nbParticles);
+    }
+
+public:
+    /**
+     * @param inComm the communicator of the tree builder
+     * @param inCostFunction the cost of the leaves without measure
+     */
+    explicit FCostBalance(const FMpi::FComm& inComm, CostFunction inCostFunction = ModelCost())
+        : comm(inComm), costFunction(std::move(inCostFunction)), maxCostPerProc(0), totalCost(0) {
+    }
+
+    /** Set the measured costs of some leaves, they are used instead of the cost function */
+    void setMeasuredCosts(std::vector<std::pair<MortonIndex,double>> inMeasuredCosts){
+        measuredCosts = std::move(inMeasuredCosts);
+        std::sort(measuredCosts.begin(), measuredCosts.end());
+    }
+
+    /** Compute the cut of the leaves from their costs */
+    void setLocalLeaves(const MortonIndex leavesIndexes[], const FSize leavesOffsetInParticles[],
+                        const FSize nbLeaves, const FSize firstLeaf) override {
+        FAssertLF(nbLeaves == 0 || leavesIndexes, "FCostBalance needs the Morton indexes of the leaves");
+        const int nbProcs = comm.processCount();
+
+        std::vector<double> costs(nbLeaves);
+        double localCost = 0;
+        for(FSize idxLeaf = 0 ; idxLeaf < nbLeaves ; ++idxLeaf){
+            costs[idxLeaf] = getLeafCost(leavesIndexes[idxLeaf], leavesOffsetInParticles[idxLeaf+1] - leavesOffsetInParticles[idxLeaf]);
+            FAssertLF(costs[idxLeaf] >= 0, "The cost of a leaf cannot be negative");
+            localCost += costs[idxLeaf];
+        }
+
+        // The cost before my first leaf and the total
+        double costBefore = 0;
+        FMpi::MpiAssert( MPI_Exscan(&localCost, &costBefore, 1, MPI_DOUBLE, MPI_SUM, comm.getComm()), __LINE__);
+        if(comm.processId() == 0){
+            costBefore = 0;
+        }
+        FMpi::MpiAssert( MPI_Allreduce(&localCost, &totalCost, 1, MPI_DOUBLE, MPI_SUM, comm.getComm()), __LINE__);
+        FSize totalNbLeaves = 0;
+        FMpi::MpiAssert( MPI_Allreduce(const_cast<FSize*>(&nbLeaves), &totalNbLeaves, 1, FMpi::GetType(nbLeaves), MPI_SUM, comm.getComm()), __LINE__);
+
+        // The process that owns the objective of a cut gives the leaf closest to it, others give -1
+        std::vector<FSize> localBoundaries(nbProcs + 1, -1);
+        if(totalCost == 0){
+            // Nothing to balance, divide the leaves
+            for(int idxProc = 0 ; idxProc <= nbProcs ; ++idxProc){
+                localBoundaries[idxProc] = FSize(double(totalNbLeaves) * double(idxProc) / double(nbProcs));
+            }
+        }
+        else{
+            int idxProc = 1;
+            double currentCost = costBefore;
+            auto objective = [&](const int inIdxProc){
+                return totalCost * double(inIdxProc) / double(nbProcs);
+            };
+            for(FSize idxLeaf = 0 ; idxLeaf < nbLeaves && idxProc < nbProcs ; ++idxLeaf){
+                // The objectives before my leaves are owned by the previous processes
+                while(idxProc < nbProcs && objective(idxProc) < currentCost){
+                    ++idxProc;
+                }
+                while(idxProc < nbProcs && objective(idxProc) < currentCost + costs[idxLeaf]){
+                    // Cut before or after the leaf, whichever is the closest
+                    const bool cutBefore = (objective(idxProc) - currentCost <= currentCost + costs[idxLeaf] - objective(idxProc));
+                    localBoundaries[idxProc] = firstLeaf + idxLeaf + (cutBefore ? 0 : 1);
+                    ++idxProc;
+                }
+                currentCost += costs[idxLeaf];
+            }
+            localBoundaries[0] = 0;
+            localBoundaries[nbProcs] = totalNbLeaves;
+        }
+
+        boundaries.resize(nbProcs + 1);
+        FMpi::MpiAssert( MPI_Allreduce(localBoundaries.data(), boundaries.data(), nbProcs + 1, FMpi::GetType(boundaries[0]), MPI_MAX, comm.getComm()), __LINE__);
+        for(int idxProc = 1 ; idxProc <= nbProcs ; ++idxProc){
+            // An objective that is not in a leaf (a cost of zero at the end) cuts at the end
+            if(boundaries[idxProc] == -1){
+                boundaries[idxProc] = totalNbLeaves;
+            }
+            boundaries[idxProc] = std::max(boundaries[idxProc], boundaries[idxProc-1]);
+        }
+
+        // The cost of each process with the cuts
+        std::vector<double> localCostPerProc(nbProcs, 0);
+        for(FSize idxLeaf = 0 ; idxLeaf < nbLeaves ; ++idxLeaf){
+            const int owner = int(std::upper_bound(boundaries.begin(), boundaries.end(), firstLeaf + idxLeaf) - boundaries.begin()) - 1;
+            localCostPerProc[FMath::Min(owner, nbProcs-1)] += costs[idxLeaf];
+        }
+        std::vector<double> costPerProc(nbProcs, 0);
+        FMpi::MpiAssert( MPI_Allreduce(localCostPerProc.data(), costPerProc.data(), nbProcs, MPI_DOUBLE, MPI_SUM, comm.getComm()), __LINE__);
+        maxCostPerProc = *std::max_element(costPerProc.begin(), costPerProc.end());
+    }
+
+    FSize getRight(const FSize numberOfLeaves, const int numberOfProc, const int idxOfProc) override {
+        FAssertLF(int(boundaries.size()) == numberOfProc + 1, "setLocalLeaves has not been called");
+        FAssertLF(boundaries[numberOfProc] == numberOfLeaves);
+        return boundaries[idxOfProc + 1];
+    }
+
+    FSize getLeft(const FSize numberOfLeaves, const int numberOfProc, const int idxOfProc) override {
+        FAssertLF(int(boundaries.size()) == numberOfProc + 1, "setLocalLeaves has not been called");
+        FAssertLF(boundaries[numberOfProc] == numberOfLeaves);
+        return boundaries[idxOfProc];
+    }
+
+    /** The ratio between the greatest cost of a process and the average, 1 is perfect */
+    double getImbalance() const {
+        if(totalCost == 0 || boundaries.size() < 2){
+            return 1;
+        }
+        return maxCostPerProc / (totalCost / double(boundaries.size() - 1));
+    }
+};
+
+
+#endif // FCOSTBALANCE_H
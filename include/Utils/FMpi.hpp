@@ -5,6 +5,9 @@
 
 #include <cstdio>
 #include <stdexcept>
+#include <vector>
+#include <utility>
+#include <algorithm>
 
 #include "FGlobal.hpp"
 #ifndef SCALFMM_USE_MPI
@@ -72,6 +75,7 @@ public:
         TagFmmL2L = 2000,
         TagFmmL2LSize = 2500,
         TagFmmP2P = 3000,
+        TagFmmM2LIndexes = 3500,
 
         // Bitonic,
         TagBitonicMin = 4000,
@@ -79,6 +83,14 @@ public:
         TagBitonicMinMess = 6000,
         TagBitonicMaxMess = 7000,
 
+        // Sparse exchange of the message sizes, one tag per user
+        TagSparseExchangeM2L = 7500,
+        TagSparseExchangeP2P = 7510,
+        TagSparseExchangeMigrate = 7520,
+
+        // FOctreeArrangerProc
+        TagParticlesMigration = 7600,
+
         // Last defined tag
         TagLast = 8000,
     };
@@ -517,6 +529,111 @@ public:
         return int((totalByteToRecv+MaxBytesPerDivMess-1)/MaxBytesPerDivMess);
     }
 
+    /**
+     * Same as ISendSplit but creates persistent requests (MPI_Send_init),
+     * they have to be started with MPI_Startall and freed with MPI_Request_free.
+     * The buffer must stay at the same address as long as the requests are used.
+     */
+    template <class ObjectType, class VectorType>
+    static int SendInitSplit(const ObjectType toSend[], const size_t nbItems,
+                             const int dest, const int tagBase, const FMpi::FComm& communicator,
+                             VectorType* requestVector){
+        const size_t totalByteToSend  = (nbItems*sizeof(ObjectType));
+        unsigned char*const ptrDataToSend = (unsigned char*)const_cast<ObjectType*>(toSend);
+        for(size_t idxSize = 0 ; idxSize < totalByteToSend ; idxSize += MaxBytesPerDivMess){
+            MPI_Request currentRequest;
+            const size_t nbBytesInMessage = FMath::Min(MaxBytesPerDivMess, totalByteToSend-idxSize);
+            FAssertLF(nbBytesInMessage < std::numeric_limits<int>::max());
+            FMpi::Assert( MPI_Send_init(&ptrDataToSend[idxSize], int(nbBytesInMessage), MPI_BYTE , dest,
+                          tagBase + int(idxSize/MaxBytesPerDivMess), communicator.getComm(), &currentRequest) , __LINE__);
+
+            requestVector->push_back(currentRequest);
+        }
+        return int((totalByteToSend+MaxBytesPerDivMess-1)/MaxBytesPerDivMess);
+    }
+
+    /** Same as IRecvSplit but creates persistent requests (MPI_Recv_init) */
+    template <class ObjectType, class VectorType>
+    static int RecvInitSplit(ObjectType toRecv[], const size_t nbItems,
+                             const int source, const int tagBase, const FMpi::FComm& communicator,
+                             VectorType* requestVector){
+        const size_t totalByteToRecv  = (nbItems*sizeof(ObjectType));
+        unsigned char*const ptrDataToRecv = (unsigned char*)(toRecv);
+        for(size_t idxSize = 0 ; idxSize < totalByteToRecv ; idxSize += MaxBytesPerDivMess){
+            MPI_Request currentRequest;
+            const size_t nbBytesInMessage = FMath::Min(MaxBytesPerDivMess, totalByteToRecv-idxSize);
+            FAssertLF(nbBytesInMessage < std::numeric_limits<int>::max());
+            FMpi::Assert( MPI_Recv_init(&ptrDataToRecv[idxSize], int(nbBytesInMessage), MPI_BYTE , source,
+                          tagBase + int(idxSize/MaxBytesPerDivMess), communicator.getComm(), &currentRequest) , __LINE__);
+
+            requestVector->push_back(currentRequest);
+        }
+        return int((totalByteToRecv+MaxBytesPerDivMess-1)/MaxBytesPerDivMess);
+    }
+
+    /**
+     * Sparse exchange (non-blocking consensus, NBX): each process gives the
+     * values it has to send to some processes and gets the values that have
+     * been sent to it, without knowing in advance who will send to it.
+     * It is used to exchange the sizes of the messages without an all-to-all
+     * of nbProcess integers per process.
+     * The values are sent with synchronous sends, when all of them have been
+     * matched the process enters a non blocking barrier and keeps receiving
+     * until the barrier is completed by all the processes.
+     * A process that has left the barrier can already send the values of its
+     * next exchange while the others are still probing, so two exchanges that
+     * can follow each other must use different tags (TagSparseExchange*).
+     * @param toSend pairs (destination, value)
+     * @param tag the tag of this exchange
+     * @return pairs (source, value) sorted by source
+     */
+    template <class ValueType>
+    static std::vector<std::pair<int,ValueType>> SparseExchange(const std::vector<std::pair<int,ValueType>>& toSend,
+                                                                const FMpi::FComm& communicator,
+                                                                const int tag){
+        std::vector<MPI_Request> sendRequests(toSend.size());
+        for(size_t idxSend = 0 ; idxSend < toSend.size() ; ++idxSend){
+            FMpi::Assert( MPI_Issend(const_cast<ValueType*>(&toSend[idxSend].second), int(sizeof(ValueType)), MPI_BYTE,
+                                     toSend[idxSend].first, tag, communicator.getComm(), &sendRequests[idxSend]), __LINE__);
+        }
+
+        std::vector<std::pair<int,ValueType>> received;
+        MPI_Request barrierRequest;
+        bool barrierIsActive = false;
+        while(true){
+            int hasMessage = 0;
+            MPI_Status status;
+            FMpi::Assert( MPI_Iprobe(MPI_ANY_SOURCE, tag, communicator.getComm(), &hasMessage, &status), __LINE__);
+            if(hasMessage){
+                ValueType value;
+                FMpi::Assert( MPI_Recv(&value, int(sizeof(ValueType)), MPI_BYTE, status.MPI_SOURCE, tag,
+                                       communicator.getComm(), MPI_STATUS_IGNORE), __LINE__);
+                received.emplace_back(status.MPI_SOURCE, value);
+            }
+
+            if(barrierIsActive == false){
+                int allSent = 0;
+                FMpi::Assert( MPI_Testall(int(sendRequests.size()), sendRequests.data(), &allSent, MPI_STATUSES_IGNORE), __LINE__);
+                if(allSent){
+                    FMpi::Assert( MPI_Ibarrier(communicator.getComm(), &barrierRequest), __LINE__);
+                    barrierIsActive = true;
+                }
+            }
+            else{
+                int barrierDone = 0;
+                FMpi::Assert( MPI_Test(&barrierRequest, &barrierDone, MPI_STATUS_IGNORE), __LINE__);
+                if(barrierDone){
+                    break;
+                }
+            }
+        }
+
+        std::stable_sort(received.begin(), received.end(), [](const std::pair<int,ValueType>& v1, const std::pair<int,ValueType>& v2){
+            return v1.first < v2.first;
+        });
+        return received;
+    }
+
 private:
     /// The original communicator
     FComm* communicator;
@@ -0,0 +1,417 @@
+// See LICENCE file at project root
+#ifndef FOUTOFCOREMEMORY_HPP
+#define FOUTOFCOREMEMORY_HPP
+
+#include "FGlobal.hpp"
+#include "FAssert.hpp"
+#include "FEnv.hpp"
+#include "FLog.hpp"
+#include "FNoCopyable.hpp"
+#include "FAlignedMemory.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * @brief The FOutOfCoreMemory class allocates memory blocks in a file.
+ *
+ * Each block is a part of one (unlinked) file in a shared mapping, so the
+ * system can always write it back to the disk instead of failing to
+ * allocate: a run can use more memory than the node has, it is just slower.
+ * The file is mapped by large arenas (64 MB by default) and the blocks are
+ * carved out of them, so the number of mappings stays far below the limit
+ * of the system (vm.max_map_count) whatever the number of blocks. A block
+ * larger than an arena gets its own mapping.
+ *
+ * On top of that the class keeps the blocks in a LRU list with a limit of
+ * resident bytes: prefetch() asks the system to read a block in advance
+ * (madvise WILLNEED, the call does not wait) and marks it as the most
+ * recently used. When the limit is exceeded the least recently used blocks
+ * are written to the file and their pages are released (msync, madvise
+ * DONTNEED and fadvise DONTNEED), after the lock of the blocks has been
+ * released so the other threads do not wait for the disk. The data of a
+ * released block is never lost, the next access reads it again from the
+ * file, so prefetch and eviction only change the performance.
+ *
+ * The group tree allocates its blocks with AllocateBytes, which uses the
+ * global storage if it is enabled:
+ * - SCALFMM_OUT_OF_CORE_DIR the directory of the file (enables the storage)
+ * - SCALFMM_OUT_OF_CORE_LIMIT_MB the resident limit in MB (1024 by default)
+ * - SCALFMM_OUT_OF_CORE_ARENA_MB the size of the arenas in MB (64 by default)
+ * or EnableGlobal can be called before the tree is built.
+ * If a block cannot be allocated in the file, AllocateBytes allocates it in
+ * memory: the first time is reported on the error output and each one is
+ * counted in Stats::nbFallbacks.
+ */
+class FOutOfCoreMemory : public FNoCopyable {
+public:
+    /** Counters of the storage */
+    struct Stats {
+        std::size_t mappedBytes;    //< Size of the allocated blocks
+        std::size_t residentBytes;  //< Size of the blocks in the LRU list
+        std::size_t fileBytes;      //< Size of the file
+        std::size_t nbPrefetches;
+        std::size_t nbEvictions;
+        std::size_t nbMappings;     //< Number of arenas mapped
+        std::size_t nbFallbacks;    //< Number of blocks that AllocateBytes has allocated in memory
+    };
+
+private:
+    /** A block of the file */
+    struct Region {
+        off_t offset;
+        std::size_t size;
+        bool resident;
+        std::list<unsigned char*>::iterator lruPosition;
+    };
+
+    /** A mapped part of the file, the blocks are carved out of it */
+    struct Arena {
+        unsigned char* ptr;
+        std::size_t size;
+    };
+
+    /** A block removed from the LRU list, its pages must be released */
+    struct Victim {
+        unsigned char* ptr;
+        std::size_t size;
+        off_t offset;
+    };
+
+    const std::size_t pageSize;
+    const std::size_t residentLimit;
+    const std::size_t arenaSize;
+    int fileDescriptor;
+
+    mutable std::mutex regionsMutex;
+    //< Shared while the pages of the victims are released (without regionsMutex),
+    //  exclusive to free a block so that its address cannot be reused meanwhile.
+    //  It is taken before regionsMutex.
+    std::shared_timed_mutex unmapMutex;
+    //< The blocks by address
+    std::map<unsigned char*, Region> regions;
+    //< The resident blocks, the most recently used first
+    std::list<unsigned char*> lru;
+    //< The arenas by offset in the file
+    std::map<off_t, Arena> arenas;
+    //< The free parts of the file by size (never across two arenas)
+    std::multimap<std::size_t, off_t> freeChunks;
+    off_t fileSize;
+    Stats stats;
+
+    std::size_t roundToPages(const std::size_t inSize) const {
+        return ((inSize + pageSize - 1) / pageSize) * pageSize;
+    }
+
+    /** The block that contains inPtr, must be called with the lock */
+    std::map<unsigned char*, Region>::iterator findRegion(const void* inPtr){
+        unsigned char*const ptr = const_cast<unsigned char*>(reinterpret_cast<const unsigned char*>(inPtr));
+        auto iter = regions.upper_bound(ptr);
+        if(iter == regions.begin()){
+            return regions.end();
+        }
+        --iter;
+        if(ptr < iter->first + iter->second.size){
+            return iter;
+        }
+        return regions.end();
+    }
+
+    /** Put a block at the front of the LRU list, must be called with the lock */
+    void touch(std::map<unsigned char*, Region>::iterator inRegion){
+        Region& region = inRegion->second;
+        if(region.resident){
+            lru.splice(lru.begin(), lru, region.lruPosition);
+        }
+        else{
+            lru.push_front(inRegion->first);
+            region.lruPosition = lru.begin();
+            region.resident = true;
+            stats.residentBytes += region.size;
+        }
+    }
+
+    /** Remove the least recently used blocks from the LRU list, but never inKeep,
+     * must be called with the lock, the victims are released by evict without the lock */
+    std::vector<Victim> takeVictims(const unsigned char*const inKeep){
+        std::vector<Victim> victims;
+        while(stats.residentBytes > residentLimit && lru.size() > 1){
+            unsigned char*const ptr = (lru.back() != inKeep ? lru.back() : *std::next(lru.rbegin()));
+            Region& region = regions[ptr];
+            victims.push_back({ptr, region.size, region.offset});
+            lru.erase(region.lruPosition);
+            region.resident = false;
+            stats.residentBytes -= region.size;
+            stats.nbEvictions += 1;
+        }
+        return victims;
+    }
+
+    /** Write back and release the pages of the victims, must be called with unmapMutex
+     * shared but without regionsMutex. A victim that is prefetched meanwhile only loses
+     * its pages (the mapping is shared, the data stays in the file) */
+    void evict(const std::vector<Victim>& victims) const {
+        for(const Victim& victim : victims){
+            msync(victim.ptr, victim.size, MS_SYNC);
+            madvise(victim.ptr, victim.size, MADV_DONTNEED);
+            posix_fadvise(fileDescriptor, victim.offset, off_t(victim.size), POSIX_FADV_DONTNEED);
+        }
+    }
+
+    /** Find a free part of the file (best fit) or map a new arena at the end of
+     * the file, must be called with the lock
+     * @return the address of the part, nullptr if the file cannot grow or cannot be mapped */
+    unsigned char* takeChunk(const std::size_t inSize, off_t* outOffset){
+        auto chunk = freeChunks.lower_bound(inSize);
+        if(chunk != freeChunks.end()){
+            (*outOffset) = chunk->second;
+            if(inSize < chunk->first){
+                freeChunks.emplace(chunk->first - inSize, chunk->second + off_t(inSize));
+            }
+            freeChunks.erase(chunk);
+            auto arena = std::prev(arenas.upper_bound(*outOffset));
+            return arena->second.ptr + ((*outOffset) - arena->first);
+        }
+        // The file is sparse, the disk is used when the pages are written
+        const std::size_t newArenaSize = std::max(arenaSize, inSize);
+        if(ftruncate(fileDescriptor, fileSize + off_t(newArenaSize)) != 0){
+            return nullptr;
+        }
+        void*const mapping = mmap(nullptr, newArenaSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, fileSize);
+        if(mapping == MAP_FAILED){
+            if(ftruncate(fileDescriptor, fileSize) != 0){
+                FLOG(FLog::Controller << "Cannot shrink the out of core file\n");
+            }
+            return nullptr;
+        }
+        arenas[fileSize] = Arena{reinterpret_cast<unsigned char*>(mapping), newArenaSize};
+        if(inSize < newArenaSize){
+            freeChunks.emplace(newArenaSize - inSize, fileSize + off_t(inSize));
+        }
+        (*outOffset) = fileSize;
+        fileSize += off_t(newArenaSize);
+        stats.fileBytes = std::size_t(fileSize);
+        stats.nbMappings += 1;
+        return reinterpret_cast<unsigned char*>(mapping);
+    }
+
+    /** Count a block allocated in memory instead of the file, the first one is reported */
+    void countFallback(const std::size_t inSize){
+        std::lock_guard<std::mutex> guard(regionsMutex);
+        if(stats.nbFallbacks == 0){
+            std::cerr << "[SCALFMM] Out of core allocation of " << inSize << " bytes failed, the block is "
+                      << "allocated in memory (the next ones are counted in FOutOfCoreMemory::Stats::nbFallbacks)\n";
+        }
+        stats.nbFallbacks += 1;
+    }
+
+    static FOutOfCoreMemory* CreateFromEnv(){
+        const char*const directory = FEnv::GetStr("SCALFMM_OUT_OF_CORE_DIR");
+        if(directory == nullptr){
+            return nullptr;
+        }
+        const std::size_t limitInMB = FEnv::GetValue<std::size_t>("SCALFMM_OUT_OF_CORE_LIMIT_MB", 1024);
+        const std::size_t arenaInMB = FEnv::GetValue<std::size_t>("SCALFMM_OUT_OF_CORE_ARENA_MB", 64);
+        return new FOutOfCoreMemory(directory, limitInMB * 1024 * 1024, arenaInMB * 1024 * 1024);
+    }
+
+    /** The global storage is never deleted, the blocks can be freed after the end of main */
+    static std::atomic<FOutOfCoreMemory*>& GlobalPointer(){
+        static std::atomic<FOutOfCoreMemory*> global(CreateFromEnv());
+        return global;
+    }
+
+public:
+    /**
+     * Create the file in inDirectory, it is removed from the directory at once
+     * and the disk space is released when the storage is destroyed.
+     * @param inResidentLimit the number of bytes of the blocks that can stay in memory
+     * @param inArenaSize the number of bytes mapped at once, the blocks are carved out of them
+     */
+    FOutOfCoreMemory(const char inDirectory[], const std::size_t inResidentLimit,
+                     const std::size_t inArenaSize = 64 * 1024 * 1024)
+        : pageSize(std::size_t(sysconf(_SC_PAGESIZE))), residentLimit(inResidentLimit),
+          arenaSize(roundToPages(std::max(inArenaSize, std::size_t(1)))),
+          fileDescriptor(-1), fileSize(0), stats() {
+        std::string fileName = std::string(inDirectory) + "/scalfmm-out-of-core-XXXXXX";
+        fileDescriptor = mkstemp(&fileName[0]);
+        FAssertLF(fileDescriptor != -1, "Cannot create the out of core file in ", inDirectory);
+        unlink(fileName.c_str());
+        FLOG(FLog::Controller << "Out of core storage in " << inDirectory << " (resident limit "
+                              << inResidentLimit << " bytes, arenas of " << arenaSize << " bytes)\n");
+    }
+
+    ~FOutOfCoreMemory(){
+        for(auto& arena : arenas){
+            munmap(arena.second.ptr, arena.second.size);
+        }
+        close(fileDescriptor);
+    }
+
+    /**
+     * Allocate a new block of inSize bytes (page aligned and set to zero),
+     * it is resident and the most recently used block.
+     * @return nullptr if the file cannot grow or the arena cannot be mapped
+     */
+    void* allocate(const std::size_t inSize){
+        if(inSize == 0){
+            return nullptr;
+        }
+        const std::size_t size = roundToPages(inSize);
+        unsigned char* ptr = nullptr;
+        std::vector<Victim> victims;
+        std::shared_lock<std::shared_timed_mutex> unmapGuard(unmapMutex);
+        {
+            std::lock_guard<std::mutex> guard(regionsMutex);
+            off_t offset = 0;
+            ptr = takeChunk(size, &offset);
+            if(ptr == nullptr){
+                return nullptr;
+            }
+            Region& region = regions[ptr];
+            region.offset   = offset;
+            region.size     = size;
+            region.resident = false;
+            stats.mappedBytes += size;
+            touch(regions.find(ptr));
+            victims = takeVictims(ptr);
+        }
+        evict(victims);
+        return ptr;
+    }
+
+    /**
+     * Free a block, the part of the file is reused by the next blocks
+     * (the arena stays mapped).
+     * @return false if the block has not been allocated by this storage
+     */
+    bool deallocate(const void* inPtr){
+        std::unique_lock<std::shared_timed_mutex> unmapGuard(unmapMutex);
+        std::lock_guard<std::mutex> guard(regionsMutex);
+        auto iter = findRegion(inPtr);
+        if(iter == regions.end() || iter->first != inPtr){
+            return false;
+        }
+        Region& region = iter->second;
+        if(region.resident){
+            lru.erase(region.lruPosition);
+            stats.residentBytes -= region.size;
+        }
+        // Give the disk space back, the content of the chunk is not needed anymore,
+        // but the next block must read zeros from it
+        bool hasBeenPunched = false;
+#ifdef FALLOC_FL_PUNCH_HOLE
+        hasBeenPunched = (fallocate(fileDescriptor, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, region.offset, off_t(region.size)) == 0);
+#endif
+        if(!hasBeenPunched){
+            memset(iter->first, 0, region.size);
+        }
+        madvise(iter->first, region.size, MADV_DONTNEED);
+        freeChunks.emplace(region.size, region.offset);
+        stats.mappedBytes -= region.size;
+        regions.erase(iter);
+        return true;
+    }
+
+    /** true if inPtr is inside a block of this storage */
+    bool owns(const void* inPtr) const {
+        std::lock_guard<std::mutex> guard(regionsMutex);
+        return const_cast<FOutOfCoreMemory*>(this)->findRegion(inPtr) != regions.end();
+    }
+
+    /**
+     * Ask the system to read the block that contains inPtr (it does not wait),
+     * and make it the most recently used. Nothing is done if the block is
+     * not from this storage.
+     */
+    void prefetch(const void* inPtr){
+        std::vector<Victim> victims;
+        std::shared_lock<std::shared_timed_mutex> unmapGuard(unmapMutex);
+        {
+            std::lock_guard<std::mutex> guard(regionsMutex);
+            auto iter = findRegion(inPtr);
+            if(iter == regions.end()){
+                return;
+            }
+            if(!iter->second.resident){
+                madvise(iter->first, iter->second.size, MADV_WILLNEED);
+            }
+            stats.nbPrefetches += 1;
+            touch(iter);
+            victims = takeVictims(iter->first);
+        }
+        evict(victims);
+    }
+
+    std::size_t getResidentLimit() const {
+        return residentLimit;
+    }
+
+    Stats getStats() const {
+        std::lock_guard<std::mutex> guard(regionsMutex);
+        return stats;
+    }
+
+    /** The global storage, nullptr if it is not enabled */
+    static FOutOfCoreMemory* Global(){
+        return GlobalPointer().load();
+    }
+
+    /** Enable the global storage (if it is not already enabled from the environment) */
+    static FOutOfCoreMemory* EnableGlobal(const char inDirectory[], const std::size_t inResidentLimit){
+        FOutOfCoreMemory* expected = nullptr;
+        FOutOfCoreMemory*const storage = new FOutOfCoreMemory(inDirectory, inResidentLimit);
+        if(!GlobalPointer().compare_exchange_strong(expected, storage)){
+            delete storage;
+        }
+        return Global();
+    }
+
+    /** Allocate in the global storage if it is enabled, in memory otherwise
+     * (or if the file cannot grow) */
+    template <std::size_t AlignementValue>
+    static void* AllocateBytes(const std::size_t inSize){
+        FOutOfCoreMemory*const storage = Global();
+        if(storage){
+            static_assert(AlignementValue <= 4096, "The blocks are page aligned");
+            void*const ptr = storage->allocate(inSize);
+            if(ptr || inSize == 0){
+                return ptr;
+            }
+            storage->countFallback(inSize);
+        }
+        return FAlignedMemory::AllocateBytes<AlignementValue>(inSize);
+    }
+
+    /** Free a block allocated by AllocateBytes */
+    static void DeallocBytes(const void* inPtr){
+        FOutOfCoreMemory*const storage = Global();
+        if(inPtr && !(storage && storage->deallocate(inPtr))){
+            FAlignedMemory::DeallocBytes(inPtr);
+        }
+    }
+
+    /** Prefetch a block allocated by AllocateBytes (nothing is done in memory) */
+    static void Prefetch(const void* inPtr){
+        FOutOfCoreMemory*const storage = Global();
+        if(inPtr && storage){
+            storage->prefetch(inPtr);
+        }
+    }
+};
+
+#endif // FOUTOFCOREMEMORY_HPP
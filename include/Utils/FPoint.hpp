@@ -5,6 +5,7 @@
 
 #include <array>
 #include <iterator>
+#include <istream>
 #include <ostream>
 
 #include "FMath.hpp"
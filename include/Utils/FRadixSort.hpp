@@ -0,0 +1,123 @@
+// See LICENCE file at project root
+#ifndef FRADIXSORT_HPP
+#define FRADIXSORT_HPP
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <omp.h>
+
+#include "FGlobal.hpp"
+
+/**
+ * @brief Parallel sort of elements that have an integer key
+ * (the Morton index of the particles for example).
+ *
+ * The keys are converted with KeyType(element) and must be positive.
+ * It is a LSD radix sort on 8 bits digits, the bytes that are the same
+ * for all the keys are skipped (the Morton indexes of a tree of height h
+ * have 3(h-1) bits). Each thread has its histograms, and the elements
+ * are moved only once at the end, the passes move pairs (key, index).
+ * The sort is stable.
+ *
+ * FRadixSortMpi extends it to sort the elements of several processes.
+ */
+template <class SortType, class KeyType, class IndexType = size_t>
+class FRadixSort {
+    static_assert(std::is_integral<KeyType>::value, "FRadixSort needs integer keys");
+
+protected:
+    /** Below this size the local sort is sequential */
+    static const IndexType MinSizeForThreads = 16384;
+
+    struct KeyAndIndex {
+        std::uint64_t key;
+        IndexType index;
+    };
+
+    static std::uint64_t GetKey(const SortType& value){
+        return static_cast<std::uint64_t>(KeyType(value));
+    }
+
+public:
+    /** Sort the array locally with a (parallel) LSD radix sort on the keys, the sort is stable */
+    static void RadixSort(SortType array[], const IndexType size){
+        if(size < 2){
+            return;
+        }
+        const bool useThreads = (size >= MinSizeForThreads);
+
+        std::unique_ptr<KeyAndIndex[]> keys(new KeyAndIndex[size]);
+        std::unique_ptr<KeyAndIndex[]> buffer(new KeyAndIndex[size]);
+
+        // The bits that change between the keys
+        const std::uint64_t firstKey = GetKey(array[0]);
+        std::uint64_t differentBits = 0;
+        #pragma omp parallel for reduction(|:differentBits) if(useThreads)
+        for(IndexType idx = 0 ; idx < size ; ++idx){
+            keys[idx].key = GetKey(array[idx]);
+            keys[idx].index = idx;
+            differentBits |= (keys[idx].key ^ firstKey);
+        }
+        if(differentBits == 0){
+            return;
+        }
+
+        KeyAndIndex* source = keys.get();
+        KeyAndIndex* destination = buffer.get();
+        std::vector<std::array<IndexType, 256>> histograms(useThreads ? omp_get_max_threads() : 1);
+
+        for(int shift = 0 ; shift < 64 ; shift += 8){
+            if(((differentBits >> shift) & 0xFF) == 0){
+                continue;
+            }
+            #pragma omp parallel if(useThreads) num_threads(int(histograms.size()))
+            {
+                const int idxThread = omp_get_thread_num();
+                const int nbThreads = omp_get_num_threads();
+                const IndexType begin = IndexType(double(size) * double(idxThread) / double(nbThreads));
+                const IndexType end = (idxThread == nbThreads - 1 ? size : IndexType(double(size) * double(idxThread + 1) / double(nbThreads)));
+
+                std::array<IndexType, 256>& histogram = histograms[idxThread];
+                histogram.fill(0);
+                for(IndexType idx = begin ; idx < end ; ++idx){
+                    histogram[(source[idx].key >> shift) & 0xFF] += 1;
+                }
+                #pragma omp barrier
+                #pragma omp single
+                {
+                    // The position of each thread for each digit (digit major to be stable)
+                    IndexType offset = 0;
+                    for(int idxDigit = 0 ; idxDigit < 256 ; ++idxDigit){
+                        for(int idxOtherThread = 0 ; idxOtherThread < nbThreads ; ++idxOtherThread){
+                            const IndexType count = histograms[idxOtherThread][idxDigit];
+                            histograms[idxOtherThread][idxDigit] = offset;
+                            offset += count;
+                        }
+                    }
+                }
+                for(IndexType idx = begin ; idx < end ; ++idx){
+                    destination[histogram[(source[idx].key >> shift) & 0xFF]++] = source[idx];
+                }
+            }
+            std::swap(source, destination);
+        }
+
+        // Move the elements once
+        std::unique_ptr<SortType[]> sortedArray(new SortType[size]);
+        #pragma omp parallel for if(useThreads)
+        for(IndexType idx = 0 ; idx < size ; ++idx){
+            sortedArray[idx] = std::move(array[source[idx].index]);
+        }
+        #pragma omp parallel for if(useThreads)
+        for(IndexType idx = 0 ; idx < size ; ++idx){
+            array[idx] = std::move(sortedArray[idx]);
+        }
+    }
+};
+
+#endif // FRADIXSORT_HPP
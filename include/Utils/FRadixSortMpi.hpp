@@ -0,0 +1,289 @@
+// See LICENCE file at project root
+#ifndef FRADIXSORTMPI_HPP
+#define FRADIXSORTMPI_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <omp.h>
+
+#include "FGlobal.hpp"
+#include "FRadixSort.hpp"
+#include "FMpi.hpp"
+#include "FLog.hpp"
+#include "FTic.hpp"
+#include "FAssert.hpp"
+
+/**
+ * @brief Distributed sample sort of elements that have an integer key
+ * (the Morton index of the particles for example).
+ *
+ * The keys are converted with KeyType(element) and must be positive.
+ *
+ * - Each process sorts its elements with the parallel LSD radix sort of
+ *   FRadixSort.
+ * - The splitters are found from regular samples of all the processes and
+ *   refined with global histograms : at each round the interval of each
+ *   splitter is cut in SplitterBuckets buckets and the number of keys below
+ *   each bucket is reduced, until the key of the splitter is exact. It
+ *   does not depend on the distribution of the keys (clustered sets sort as
+ *   fast as uniform ones).
+ * - The elements are exchanged with a single MPI_Alltoallv and the received
+ *   (sorted) runs are merged with a P-way merge.
+ *
+ * The result is exactly balanced : process p gets the elements of global
+ * ranks [N*p/P, N*(p+1)/P[, the equal keys can be shared by several processes.
+ */
+template <class SortType, class KeyType, class IndexType = size_t>
+class FRadixSortMpi : public FRadixSort<SortType, KeyType, IndexType> {
+    using Parent = FRadixSort<SortType, KeyType, IndexType>;
+    using Parent::GetKey;
+
+    /** Number of buckets per splitter at each refinement round */
+    static const int SplitterBuckets = 64;
+
+    /** The global number of keys strictly lower than each point */
+    static std::vector<std::uint64_t> GlobalCountBelow(const std::vector<std::uint64_t>& sortedKeys,
+                                                       const std::vector<std::uint64_t>& points, const FMpi::FComm& comm){
+        std::vector<std::uint64_t> localCounts(points.size());
+        for(size_t idxPoint = 0 ; idxPoint < points.size() ; ++idxPoint){
+            localCounts[idxPoint] = std::uint64_t(std::lower_bound(sortedKeys.begin(), sortedKeys.end(), points[idxPoint]) - sortedKeys.begin());
+        }
+        std::vector<std::uint64_t> globalCounts(points.size());
+        FMpi::MpiAssert( MPI_Allreduce(localCounts.data(), globalCounts.data(), int(points.size()), MPI_UINT64_T, MPI_SUM, comm.getComm()), __LINE__);
+        return globalCounts;
+    }
+
+    /**
+     * Merge the sorted runs [runStarts[r], runStarts[r+1][ of runs into output,
+     * a heap gives the run with the lowest current key (the lowest run for equal keys).
+     */
+    static void MergeRuns(const SortType runs[], const std::vector<int>& runStarts, SortType output[]){
+        const int nbRuns = int(runStarts.size()) - 1;
+        // The current position and key of the non empty runs
+        std::vector<int> positions(runStarts.begin(), runStarts.end() - 1);
+        std::vector<std::pair<std::uint64_t,int>> heap;
+        heap.reserve(nbRuns);
+        for(int idxRun = 0 ; idxRun < nbRuns ; ++idxRun){
+            if(runStarts[idxRun] != runStarts[idxRun+1]){
+                heap.emplace_back(GetKey(runs[runStarts[idxRun]]), idxRun);
+            }
+        }
+        // std heaps have the greatest element first
+        const auto isAfter = [](const std::pair<std::uint64_t,int>& first, const std::pair<std::uint64_t,int>& second){
+            return second < first;
+        };
+        std::make_heap(heap.begin(), heap.end(), isAfter);
+
+        IndexType idxOutput = 0;
+        while(heap.size()){
+            std::pop_heap(heap.begin(), heap.end(), isAfter);
+            const int idxRun = heap.back().second;
+            // Copy the elements of the run while they are not after the next run
+            const std::uint64_t nextKey = (heap.size() > 1 ? heap.front().first : std::numeric_limits<std::uint64_t>::max());
+            do{
+                output[idxOutput++] = runs[positions[idxRun]++];
+            } while(positions[idxRun] != runStarts[idxRun+1] && GetKey(runs[positions[idxRun]]) <= nextKey);
+
+            if(positions[idxRun] != runStarts[idxRun+1]){
+                heap.back().first = GetKey(runs[positions[idxRun]]);
+                std::push_heap(heap.begin(), heap.end(), isAfter);
+            }
+            else{
+                heap.pop_back();
+            }
+        }
+    }
+
+public:
+    using Parent::RadixSort;
+
+    /**
+     * Sort the elements of all the processes, same interface as FQuickSortMpi::QsMpi.
+     * @param originalArray the local elements (not modified)
+     * @param originalSize the number of local elements
+     * @param outputArray the sorted elements of the process (allocated with new[])
+     * @param outputSize the number of elements in outputArray
+     * @param comm the communicator
+     * @param oversampling the number of samples taken by each process to start the search of the splitters
+     */
+    static void SortMpi(const SortType originalArray[], const IndexType originalSize,
+                        SortType** outputArray, IndexType* outputSize, const FMpi::FComm& comm,
+                        const int oversampling = 16){
+        FLOG( FTic timer );
+        const int nbProcs = comm.processCount();
+        const int myRank = comm.processId();
+
+        std::unique_ptr<SortType[]> localArray(new SortType[originalSize]);
+        std::copy(originalArray, originalArray + originalSize, localArray.get());
+        RadixSort(localArray.get(), originalSize);
+        FLOG( FLog::Controller << "[" << myRank << "] FRadixSortMpi local sort (" << timer.tacAndElapsed() << "s)\n" );
+
+        if(nbProcs == 1){
+            (*outputArray) = localArray.release();
+            (*outputSize) = originalSize;
+            return;
+        }
+
+        std::vector<std::uint64_t> sortedKeys(originalSize);
+        for(IndexType idx = 0 ; idx < originalSize ; ++idx){
+            sortedKeys[idx] = GetKey(localArray[idx]);
+        }
+
+        std::uint64_t totalSize = 0;
+        {
+            const std::uint64_t localSize = originalSize;
+            FMpi::MpiAssert( MPI_Allreduce(&localSize, &totalSize, 1, MPI_UINT64_T, MPI_SUM, comm.getComm()), __LINE__);
+        }
+        std::uint64_t maxKey = 0;
+        {
+            const std::uint64_t localMaxKey = (originalSize ? sortedKeys.back() : 0);
+            FMpi::MpiAssert( MPI_Allreduce(&localMaxKey, &maxKey, 1, MPI_UINT64_T, MPI_MAX, comm.getComm()), __LINE__);
+        }
+
+        // The global rank of the first element of each process (but the first)
+        std::vector<std::uint64_t> targets(nbProcs - 1);
+        for(int idxProc = 1 ; idxProc < nbProcs ; ++idxProc){
+            targets[idxProc-1] = (totalSize / nbProcs) * idxProc + ((totalSize % nbProcs) * idxProc) / nbProcs;
+        }
+
+        // For each splitter : countBelow(lower) <= target < countBelow(upper)
+        std::vector<std::uint64_t> lowerBounds(nbProcs - 1, 0);
+        std::vector<std::uint64_t> upperBounds(nbProcs - 1, maxKey + 1);
+        std::vector<std::uint64_t> countsAtLower(nbProcs - 1, 0);
+
+        if(totalSize){
+            // First candidates from regular samples
+            std::vector<std::uint64_t> localSamples(oversampling, 0);
+            for(int idxSample = 0 ; idxSample < oversampling && originalSize ; ++idxSample){
+                localSamples[idxSample] = sortedKeys[size_t(double(originalSize) * double(idxSample + 1) / double(oversampling + 1))];
+            }
+            std::vector<std::uint64_t> candidates(size_t(oversampling) * nbProcs);
+            FMpi::MpiAssert( MPI_Allgather(localSamples.data(), oversampling, MPI_UINT64_T, candidates.data(), oversampling,
+                                        MPI_UINT64_T, comm.getComm()), __LINE__);
+            candidates.push_back(0);
+            candidates.push_back(maxKey + 1);
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+            const std::vector<std::uint64_t> counts = GlobalCountBelow(sortedKeys, candidates, comm);
+            for(int idxSplitter = 0 ; idxSplitter < nbProcs - 1 ; ++idxSplitter){
+                // The last candidate with a count <= target
+                const size_t idxCandidate = size_t(std::upper_bound(counts.begin(), counts.end(), targets[idxSplitter]) - counts.begin()) - 1;
+                lowerBounds[idxSplitter] = candidates[idxCandidate];
+                countsAtLower[idxSplitter] = counts[idxCandidate];
+                upperBounds[idxSplitter] = candidates[idxCandidate + 1];
+            }
+
+            // Refine with histograms until the splitter keys are exact
+            int nbRounds = 0;
+            while(true){
+                bool isResolved = true;
+                for(int idxSplitter = 0 ; idxSplitter < nbProcs - 1 ; ++idxSplitter){
+                    isResolved &= (upperBounds[idxSplitter] - lowerBounds[idxSplitter] <= 1);
+                }
+                if(isResolved){
+                    break;
+                }
+                nbRounds += 1;
+
+                std::vector<std::uint64_t> points(size_t(nbProcs - 1) * (SplitterBuckets - 1));
+                for(int idxSplitter = 0 ; idxSplitter < nbProcs - 1 ; ++idxSplitter){
+                    const std::uint64_t width = upperBounds[idxSplitter] - lowerBounds[idxSplitter];
+                    for(int idxBucket = 1 ; idxBucket < SplitterBuckets ; ++idxBucket){
+                        points[size_t(idxSplitter) * (SplitterBuckets - 1) + idxBucket - 1] = lowerBounds[idxSplitter]
+                                + (width / SplitterBuckets) * idxBucket + ((width % SplitterBuckets) * idxBucket) / SplitterBuckets;
+                    }
+                }
+                const std::vector<std::uint64_t> bucketCounts = GlobalCountBelow(sortedKeys, points, comm);
+                for(int idxSplitter = 0 ; idxSplitter < nbProcs - 1 ; ++idxSplitter){
+                    for(int idxBucket = 1 ; idxBucket < SplitterBuckets ; ++idxBucket){
+                        const size_t idxPoint = size_t(idxSplitter) * (SplitterBuckets - 1) + idxBucket - 1;
+                        if(points[idxPoint] <= lowerBounds[idxSplitter] || upperBounds[idxSplitter] <= points[idxPoint]){
+                            continue;
+                        }
+                        if(bucketCounts[idxPoint] <= targets[idxSplitter]){
+                            lowerBounds[idxSplitter] = points[idxPoint];
+                            countsAtLower[idxSplitter] = bucketCounts[idxPoint];
+                        }
+                        else{
+                            upperBounds[idxSplitter] = points[idxPoint];
+                            break;
+                        }
+                    }
+                }
+            }
+            FLOG( FLog::Controller << "[" << myRank << "] FRadixSortMpi splitters found in " << nbRounds << " refinement rounds ("
+                  << timer.tacAndElapsed() << "s)\n" );
+        }
+
+        // The keys equal to a splitter are shared between the processes in rank order
+        std::vector<std::uint64_t> nbEqualKeys(nbProcs - 1);
+        std::vector<std::uint64_t> nbLowerKeys(nbProcs - 1);
+        for(int idxSplitter = 0 ; idxSplitter < nbProcs - 1 ; ++idxSplitter){
+            const auto range = std::equal_range(sortedKeys.begin(), sortedKeys.end(), lowerBounds[idxSplitter]);
+            nbLowerKeys[idxSplitter] = std::uint64_t(range.first - sortedKeys.begin());
+            nbEqualKeys[idxSplitter] = std::uint64_t(range.second - range.first);
+        }
+        std::vector<std::uint64_t> nbEqualKeysBefore(nbProcs - 1, 0);
+        FMpi::MpiAssert( MPI_Exscan(nbEqualKeys.data(), nbEqualKeysBefore.data(), nbProcs - 1, MPI_UINT64_T, MPI_SUM, comm.getComm()), __LINE__);
+        if(myRank == 0){
+            std::fill(nbEqualKeysBefore.begin(), nbEqualKeysBefore.end(), 0);
+        }
+
+        std::vector<std::uint64_t> cuts(nbProcs + 1);
+        cuts[0] = 0;
+        cuts[nbProcs] = originalSize;
+        for(int idxSplitter = 0 ; idxSplitter < nbProcs - 1 ; ++idxSplitter){
+            // Number of equal keys that go before the cut (for all the processes)
+            const std::uint64_t equalKeysBeforeCut = targets[idxSplitter] - countsAtLower[idxSplitter];
+            std::uint64_t myEqualKeysBeforeCut = 0;
+            if(equalKeysBeforeCut > nbEqualKeysBefore[idxSplitter]){
+                myEqualKeysBeforeCut = std::min(equalKeysBeforeCut - nbEqualKeysBefore[idxSplitter], nbEqualKeys[idxSplitter]);
+            }
+            cuts[idxSplitter + 1] = nbLowerKeys[idxSplitter] + myEqualKeysBeforeCut;
+        }
+
+        // Exchange the elements
+        std::vector<int> sendCounts(nbProcs), sendDisplacements(nbProcs);
+        for(int idxProc = 0 ; idxProc < nbProcs ; ++idxProc){
+            FAssertLF(cuts[idxProc] <= cuts[idxProc+1]);
+            FAssertLF(cuts[idxProc] < std::uint64_t(std::numeric_limits<int>::max()) && cuts[idxProc+1] - cuts[idxProc] < std::uint64_t(std::numeric_limits<int>::max()));
+            sendDisplacements[idxProc] = int(cuts[idxProc]);
+            sendCounts[idxProc] = int(cuts[idxProc+1] - cuts[idxProc]);
+        }
+        std::vector<int> recvCounts(nbProcs), recvDisplacements(nbProcs + 1, 0);
+        FMpi::MpiAssert( MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, comm.getComm()), __LINE__);
+        for(int idxProc = 0 ; idxProc < nbProcs ; ++idxProc){
+            FAssertLF(std::int64_t(recvDisplacements[idxProc]) + recvCounts[idxProc] < std::numeric_limits<int>::max());
+            recvDisplacements[idxProc+1] = recvDisplacements[idxProc] + recvCounts[idxProc];
+        }
+
+        MPI_Datatype elementType;
+        FMpi::MpiAssert( MPI_Type_contiguous(int(sizeof(SortType)), MPI_BYTE, &elementType), __LINE__);
+        FMpi::MpiAssert( MPI_Type_commit(&elementType), __LINE__);
+
+        const IndexType nbReceived = IndexType(recvDisplacements[nbProcs]);
+        std::unique_ptr<SortType[]> receivedArray(new SortType[nbReceived]);
+        FMpi::MpiAssert( MPI_Alltoallv(localArray.get(), sendCounts.data(), sendDisplacements.data(), elementType,
+                                    receivedArray.get(), recvCounts.data(), recvDisplacements.data(), elementType, comm.getComm()), __LINE__);
+        FMpi::MpiAssert( MPI_Type_free(&elementType), __LINE__);
+        FLOG( FLog::Controller << "[" << myRank << "] FRadixSortMpi exchange (" << timer.tacAndElapsed() << "s)\n" );
+
+        // The runs received from each process are sorted
+        localArray.reset();
+        SortType*const mergedArray = new SortType[nbReceived];
+        MergeRuns(receivedArray.get(), recvDisplacements, mergedArray);
+        FLOG( FLog::Controller << "[" << myRank << "] FRadixSortMpi merge (" << timer.tacAndElapsed() << "s)\n" );
+
+        (*outputArray) = mergedArray;
+        (*outputSize) = nbReceived;
+    }
+};
+
+#endif // FRADIXSORTMPI_HPP
@@ -2,6 +2,7 @@
 #ifndef FSMARTPOINTER_HPP
 #define FSMARTPOINTER_HPP
 
+#include <atomic>
 #include <type_traits>
 
 enum FSmartPointerType{
@@ -22,11 +23,13 @@ inline typename std::enable_if<(MemoryType == FSmartPointerMemory), void>::type
 /** This class is a basic smart pointer class
   * Use as FSmartPointer<int> array = new int[5];
   * FSmartPointer<int, PointerMemory> pt = new int;
+  * The reference counter is atomic, so copies of the same pointer can be
+  * made and released by several threads at the same time.
   */
 template <class ClassType, FSmartPointerType MemoryType = FSmartArrayMemory>
 class FSmartPointer {
     ClassType* pointer; //< The pointer to the memory area
-    int* counter;       //< Reference counter
+    std::atomic<int>* counter; //< Reference counter
 
 public:
     // The type of data managed by the pointer
@@ -66,8 +69,7 @@ public:
         release();
         if( inPointer ){
             pointer = inPointer;
-            counter = new int;
-            (*counter) = 1;
+            counter = new std::atomic<int>(1);
         }
     }
 
@@ -76,14 +78,13 @@ public:
         release();
         pointer = inPointer.pointer;
         counter = inPointer.counter;
-        if(counter) (*counter) += 1;
+        if(counter) counter->fetch_add(1);
     }
 
     /** Dec counter and Release the memory last */
     void release(){
         if(counter){
-            (*counter) -= 1;
-            if( (*counter) == 0 ){
+            if( counter->fetch_sub(1) == 1 ){
                 FSmartDeletePointer<MemoryType>(pointer);
                 delete counter;
             }
@@ -124,6 +124,13 @@ private:
      */
     pointer_tuple _data_tuple = pointer_tuple{(Types*)nullptr...}; // initialized to nullptr
 
+    /** \brief Owner of the storage given by adopt_storage()
+     *
+     * When set, the sub-arrays do not come from the allocator and must not be
+     * deallocated by the vector.
+     */
+    std::shared_ptr<void> _external_storage;
+
 public:
 
     // Constructors
@@ -205,7 +212,7 @@ public:
 
     ~variadic_vector_impl() {
         this->clear();
-        if(nullptr != std::get<0>(this->data())) {
+        if(nullptr != std::get<0>(this->data()) && ! this->_external_storage) {
             this->deallocate(this->_data_tuple, this->_capacity);
         }
     }
@@ -733,10 +740,13 @@ private:
             this->move_data(this->_data_tuple, this->size(), new_data, new_cap);
             // Free old storage
             this->destroy_data(this->_data_tuple);
-            this->deallocate<Types...>(this->_data_tuple, this->_capacity);
+            if(! this->_external_storage) {
+                this->deallocate<Types...>(this->_data_tuple, this->_capacity);
+            }
         }
-        // Set new storage
+        // Set new storage, it is always owned by the vector
         this->_data_tuple = new_data;
+        this->_external_storage.reset();
 
         if(this->size() > new_cap) {
             this->_size = new_cap;
@@ -769,6 +779,43 @@ public:
     }
 
 
+    /** \brief Moves the elements into storage owned by someone else
+     *
+     * The elements are moved into the sub-arrays pointed by `storage`, which
+     * must be able to hold `storage_cap` elements, and the previous storage is
+     * freed. The vector never deallocates the adopted storage, it only keeps a
+     * reference to `owner` until it stops using it, either when it is
+     * destroyed or when it needs to grow and reallocates its own memory.
+     *
+     * This allows to place many vectors side by side in a single memory block.
+     *
+     * \param storage     Tuple of pointers to the new sub-arrays
+     * \param storage_cap Capacity of the new sub-arrays, at least size()
+     * \param owner       Owner of the memory block, kept alive by the vector
+     */
+    void adopt_storage(pointer_tuple storage, size_type storage_cap, std::shared_ptr<void> owner) {
+        assert(this->size() <= storage_cap);
+        if(nullptr != std::get<0>(this->data())) {
+            this->move_data(this->_data_tuple, this->size(), storage, storage_cap);
+            this->destroy_data(this->_data_tuple);
+            if(! this->_external_storage) {
+                this->deallocate<Types...>(this->_data_tuple, this->_capacity);
+            }
+        }
+        this->_data_tuple = storage;
+        this->_capacity = storage_cap;
+        this->_external_storage = std::move(owner);
+    }
+
+    /** \brief Tells if the storage has been given by adopt_storage()
+     *
+     * \return true if the vector does not own its memory
+     */
+    bool has_external_storage() const noexcept {
+        return bool(this->_external_storage);
+    }
+
+
     /** \brief Reduces memory usage by freeing memory
      *
      * If capacity() is greater than size(), reallocate memory with size() as
@@ -1010,6 +1057,55 @@ private:
         return p - count;
     }
 
+    /** \brief Copy an array at the end of a sub-array
+     *
+     * \warning This subfunction does not check for size / capacity. You must do
+     * it before calling it.
+     *
+     * \tparam T   Sub-array type
+     * \tparam Idx Sub-array index in the data() tuple
+     *
+     * \param source Array of `count` values, if nullptr the values are value
+     * initialized
+     * \param count  Number of values to copy
+     */
+    template<typename T, std::size_t Idx>
+    void array_append(const T* source, size_type count) {
+        T* p = std::get<Idx>(this->data()) + this->size();
+        if(source) {
+            // A single memcpy for trivially copyable types
+            std::uninitialized_copy_n(source, count, p);
+        } else {
+            std::uninitialized_fill_n(p, count, T{});
+        }
+    }
+
+    /** \brief Copy values gathered in an array at the end of a sub-array
+     *
+     * \warning This subfunction does not check for size / capacity. You must do
+     * it before calling it.
+     *
+     * \tparam T   Sub-array type
+     * \tparam Idx Sub-array index in the data() tuple
+     *
+     * \param index_of Gives the position in `source` of the i-th value to copy
+     * \param source   Array of values, if nullptr the values are value
+     * initialized
+     * \param count    Number of values to copy
+     */
+    template<typename T, std::size_t Idx, typename IndexFunction>
+    void array_append_gathered(const IndexFunction& index_of, const T* source, size_type count) {
+        if(source) {
+            typename Allocator::template rebind<T>::other alloc;
+            T* p = std::get<Idx>(this->data()) + this->size();
+            for(size_type i = 0; i < count; ++i) {
+                alloc.construct(p + i, source[index_of(i)]);
+            }
+        } else {
+            this->array_append<T, Idx>(nullptr, count);
+        }
+    }
+
     /** Trait that checks whether a type is a tuple of iterators or not */
     template<class T>
     struct is_tuple_get_like {
@@ -1204,6 +1300,42 @@ public:
     }
 
 
+    /** \brief Add elements to the end, one array per sub-array
+     *
+     * The storage grows geometrically if needed, as with push_back, so that
+     * repeated appends stay linear, and each sub-array is copied in one pass.
+     *
+     * \param count  Number of elements to add
+     * \param arrays One array of `count` values per sub-array, a nullptr array
+     * value initializes its sub-array
+     */
+    void append(size_type count, const Types*... arrays) {
+        this->check_capacity(this->size() + count);
+        noop_t{(this->array_append<Types, Indices>(arrays, count), 0)...};
+        this->_size += count;
+    }
+
+
+    /** \brief Add elements to the end, gathered from one array per sub-array
+     *
+     * Same as append() but the i-th element added is at position `index_of(i)`
+     * in the arrays.
+     *
+     * \tparam IndexFunction Callable type, `size_type(size_type)`
+     *
+     * \param count    Number of elements to add
+     * \param index_of Gives the position in the arrays of the i-th element
+     * \param arrays   One array per sub-array, a nullptr array value
+     * initializes its sub-array
+     */
+    template<typename IndexFunction>
+    void append_gathered(size_type count, const IndexFunction& index_of, const Types*... arrays) {
+        this->check_capacity(this->size() + count);
+        noop_t{(this->array_append_gathered<Types, Indices>(index_of, arrays, count), 0)...};
+        this->_size += count;
+    }
+
+
     /** \brief Change the number of elements stored
      *
      * Resizes the container to given size. If the container holds more than
@@ -1259,6 +1391,7 @@ public:
         swap(_capacity, other._capacity);
         swap(_allocator_tuple, other._allocator_tuple);
         swap(_data_tuple, other._data_tuple);
+        swap(_external_storage, other._external_storage);
     }
 
 